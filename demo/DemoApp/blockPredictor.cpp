@@ -0,0 +1,487 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "NvFlowShaderCPU.h"
+
+#include "blockPredictor.h"
+
+namespace
+{
+	// longest sweep per block, in half block steps
+	static const int maxSweepSteps = 64;
+
+	// allocation boxes are pulled in from block faces so they do not touch neighbors
+	static const float boxInset = 0.25f;
+
+	NvFlowUint64 packCoarse(int x, int y, int z)
+	{
+		return (NvFlowUint64(NvFlowUint(x) & 0x1FFFFF)) |
+			(NvFlowUint64(NvFlowUint(y) & 0x1FFFFF) << 21u) |
+			(NvFlowUint64(NvFlowUint(z) & 0x1FFFFF) << 42u);
+	}
+
+	bool sameMaterial(const NvFlowGridMaterialHandle& a, const NvFlowGridMaterialHandle& b)
+	{
+		return a.grid == b.grid && a.uid == b.uid;
+	}
+}
+
+NvFlowUint64 BlockPredictor::coarseKey(const NvFlowFloat3& worldPos) const
+{
+	int x = int(floorf((worldPos.x - m_coarseOrigin.x) / m_coarseCellSize.x));
+	int y = int(floorf((worldPos.y - m_coarseOrigin.y) / m_coarseCellSize.y));
+	int z = int(floorf((worldPos.z - m_coarseOrigin.z) / m_coarseCellSize.z));
+	return packCoarse(x, y, z);
+}
+
+void BlockPredictor::updateVelocity(NvFlowGridSummaryStateCPU* stateCPU)
+{
+	m_coarseVelocity.clear();
+
+	NvFlowUint numLayers = NvFlowGridSummaryGetNumLayers(stateCPU);
+	for (NvFlowUint layerIdx = 0u; layerIdx < numLayers; layerIdx++)
+	{
+		NvFlowGridSummaryResult* results = nullptr;
+		NvFlowUint numResults = 0u;
+
+		NvFlowGridSummaryGetSummaries(stateCPU, &results, &numResults, layerIdx);
+
+		for (NvFlowUint idx = 0u; idx < numResults; idx++)
+		{
+			if (!addCoarseVelocity(results[idx]))
+			{
+				return;
+			}
+		}
+	}
+}
+
+bool BlockPredictor::addCoarseVelocity(const NvFlowGridSummaryResult& result)
+{
+	if (m_coarseVelocity.empty())
+	{
+		// summary cells are uniform, lattice is taken from the first one
+		m_coarseCellSize = { 2.f * result.worldHalfSize.x, 2.f * result.worldHalfSize.y, 2.f * result.worldHalfSize.z };
+		m_coarseOrigin = {
+			result.worldLocation.x - result.worldHalfSize.x,
+			result.worldLocation.y - result.worldHalfSize.y,
+			result.worldLocation.z - result.worldHalfSize.z
+		};
+		if (!(m_coarseCellSize.x > 0.f && m_coarseCellSize.y > 0.f && m_coarseCellSize.z > 0.f))
+		{
+			return false;
+		}
+	}
+
+	NvFlowFloat3 worldPos = { result.worldLocation.x, result.worldLocation.y, result.worldLocation.z };
+	NvFlowUint64 key = coarseKey(worldPos);
+
+	// layers can overlap, the fastest one decides how far to reach
+	auto it = m_coarseVelocity.find(key);
+	if (it == m_coarseVelocity.end())
+	{
+		m_coarseVelocity[key] = result.averageVelocity;
+	}
+	else
+	{
+		const NvFlowFloat3& v = it->second;
+		const NvFlowFloat3& r = result.averageVelocity;
+		if (r.x * r.x + r.y * r.y + r.z * r.z > v.x * v.x + v.y * v.y + v.z * v.z)
+		{
+			it->second = r;
+		}
+	}
+	return true;
+}
+
+bool BlockPredictor::sampleVelocity(const NvFlowFloat3& worldPos, NvFlowFloat3* velocity) const
+{
+	if (m_coarseVelocity.empty())
+	{
+		return false;
+	}
+	auto it = m_coarseVelocity.find(coarseKey(worldPos));
+	if (it == m_coarseVelocity.end())
+	{
+		return false;
+	}
+	*velocity = it->second;
+	return true;
+}
+
+void BlockPredictor::updateLayers(const NvFlowGridMaterialHandle* layerMaterials, NvFlowUint numLayers)
+{
+	bool sameLayers = m_layerMaterials.size() == numLayers;
+	for (NvFlowUint layerIdx = 0u; sameLayers && layerIdx < numLayers; layerIdx++)
+	{
+		sameLayers = sameMaterial(m_layerMaterials[layerIdx], layerMaterials[layerIdx]);
+	}
+	if (sameLayers)
+	{
+		return;
+	}
+
+	// layers come and go with materials, a material keeps its holds
+	const size_t layerSize = size_t(m_gridDim.x) * size_t(m_gridDim.y) * size_t(m_gridDim.z);
+	std::vector<unsigned char> hold(numLayers * layerSize, 0u);
+	std::vector<unsigned char> active(numLayers * layerSize, 0u);
+	std::vector<unsigned char> predicted(numLayers * layerSize, 0u);
+	for (NvFlowUint layerIdx = 0u; layerIdx < numLayers; layerIdx++)
+	{
+		for (size_t oldIdx = 0u; oldIdx < m_layerMaterials.size(); oldIdx++)
+		{
+			if (sameMaterial(m_layerMaterials[oldIdx], layerMaterials[layerIdx]))
+			{
+				std::copy_n(m_hold.begin() + oldIdx * layerSize, layerSize, hold.begin() + layerIdx * layerSize);
+				std::copy_n(m_active.begin() + oldIdx * layerSize, layerSize, active.begin() + layerIdx * layerSize);
+				std::copy_n(m_predicted.begin() + oldIdx * layerSize, layerSize, predicted.begin() + layerIdx * layerSize);
+				break;
+			}
+		}
+	}
+	m_hold.swap(hold);
+	m_active.swap(active);
+	m_predicted.swap(predicted);
+	m_layerMaterials.assign(layerMaterials, layerMaterials + numLayers);
+}
+
+void BlockPredictor::shiftHold(int dx, int dy, int dz)
+{
+	shiftBlocks(m_hold, dx, dy, dz);
+	shiftBlocks(m_active, dx, dy, dz);
+	shiftBlocks(m_predicted, dx, dy, dz);
+}
+
+void BlockPredictor::shiftBlocks(std::vector<unsigned char>& blocks, int dx, int dy, int dz)
+{
+	int dimX = int(m_gridDim.x);
+	int dimY = int(m_gridDim.y);
+	int dimZ = int(m_gridDim.z);
+
+	const size_t layerSize = size_t(dimX) * size_t(dimY) * size_t(dimZ);
+	std::vector<unsigned char> shifted(blocks.size(), 0u);
+	for (size_t layerBase = 0u; layerBase < blocks.size(); layerBase += layerSize)
+	{
+		const unsigned char* src = &blocks[layerBase];
+		unsigned char* dst = &shifted[layerBase];
+		for (int k = 0; k < dimZ; k++)
+		{
+			int srcK = k + dz;
+			if (srcK < 0 || srcK >= dimZ) continue;
+			for (int j = 0; j < dimY; j++)
+			{
+				int srcJ = j + dy;
+				if (srcJ < 0 || srcJ >= dimY) continue;
+				for (int i = 0; i < dimX; i++)
+				{
+					int srcI = i + dx;
+					if (srcI < 0 || srcI >= dimX) continue;
+					dst[(k * dimY + j) * dimX + i] = src[(srcK * dimY + srcJ) * dimX + srcI];
+				}
+			}
+		}
+	}
+	blocks.swap(shifted);
+}
+
+void BlockPredictor::updateGrid(const NvFlowGridExportImportLayeredMapping& mapping, const NvFlowGridMaterialHandle* layerMaterials, NvFlowUint numLayers)
+{
+	const NvFlowShaderLinearParams& shaderParams = mapping.shaderParams;
+
+	NvFlowFloat3 gridOffset = { mapping.modelMatrix.w.x, mapping.modelMatrix.w.y, mapping.modelMatrix.w.z };
+	NvFlowFloat3 gridScale = { fabsf(mapping.modelMatrix.x.x), fabsf(mapping.modelMatrix.y.y), fabsf(mapping.modelMatrix.z.z) };
+	NvFlowFloat3 blockSize = {
+		2.f * gridScale.x * float(shaderParams.blockDim.x) * shaderParams.vdimInv.x,
+		2.f * gridScale.y * float(shaderParams.blockDim.y) * shaderParams.vdimInv.y,
+		2.f * gridScale.z * float(shaderParams.blockDim.z) * shaderParams.vdimInv.z
+	};
+	if (!(blockSize.x > 0.f && blockSize.y > 0.f && blockSize.z > 0.f))
+	{
+		invalidateGrid();
+		return;
+	}
+
+	const NvFlowUint4& gridDim = shaderParams.gridDim;
+	bool sameLayout = m_gridValid &&
+		m_gridDim.x == gridDim.x && m_gridDim.y == gridDim.y && m_gridDim.z == gridDim.z &&
+		m_blockSize.x == blockSize.x && m_blockSize.y == blockSize.y && m_blockSize.z == blockSize.z;
+	if (!sameLayout)
+	{
+		const size_t numBlocks = size_t(numLayers) * size_t(gridDim.x) * size_t(gridDim.y) * size_t(gridDim.z);
+		m_hold.assign(numBlocks, 0u);
+		m_active.assign(numBlocks, 0u);
+		m_predicted.assign(numBlocks, 0u);
+		m_layerMaterials.assign(layerMaterials, layerMaterials + numLayers);
+	}
+	else
+	{
+		updateLayers(layerMaterials, numLayers);
+		if (gridOffset.x != m_gridOffset.x || gridOffset.y != m_gridOffset.y || gridOffset.z != m_gridOffset.z)
+		{
+			// translated grid, holds follow the world
+			int dx = int(floorf((gridOffset.x - m_gridOffset.x) / blockSize.x + 0.5f));
+			int dy = int(floorf((gridOffset.y - m_gridOffset.y) / blockSize.y + 0.5f));
+			int dz = int(floorf((gridOffset.z - m_gridOffset.z) / blockSize.z + 0.5f));
+			if (dx != 0 || dy != 0 || dz != 0)
+			{
+				shiftHold(dx, dy, dz);
+			}
+		}
+	}
+
+	m_gridOffset = gridOffset;
+	m_gridScale = gridScale;
+	m_blockSize = blockSize;
+	m_gridDim = gridDim;
+	m_gridValid = true;
+
+	int dimX = int(m_gridDim.x);
+	int dimY = int(m_gridDim.y);
+	int dimZ = int(m_gridDim.z);
+	const NvFlowUint layerSize = NvFlowUint(dimX * dimY * dimZ);
+
+	// a held block new to this export was allocated by prediction, holds are still those of the emit that made it
+	m_activeNext.assign(m_hold.size(), 0u);
+	for (NvFlowUint idx = 0u; idx < mapping.layeredNumBlocks; idx++)
+	{
+		const NvFlowUint layerIdx = mapping.layeredBlockListCPU[idx].y;
+		NvFlowInt3 coord = NvFlowCPU_tableVal_to_coord(mapping.layeredBlockListCPU[idx].x);
+		if (layerIdx >= numLayers || coord.x < 0 || coord.x >= dimX || coord.y < 0 || coord.y >= dimY || coord.z < 0 || coord.z >= dimZ)
+		{
+			continue;
+		}
+		NvFlowUint blockIdx = layerIdx * layerSize + NvFlowUint((coord.z * dimY + coord.y) * dimX + coord.x);
+		if (m_hold[blockIdx] == 0u)
+		{
+			m_predicted[blockIdx] = 0u;
+		}
+		else if (!m_active[blockIdx])
+		{
+			m_predicted[blockIdx] = 1u;
+		}
+		m_activeNext[blockIdx] = 1u;
+	}
+	for (size_t blockIdx = 0u; blockIdx < m_hold.size(); blockIdx++)
+	{
+		if (!m_activeNext[blockIdx]) m_predicted[blockIdx] = 0u;
+	}
+	m_active.swap(m_activeNext);
+
+	// hysteresis, held blocks fade out over m_holdFrames
+	for (auto& hold : m_hold)
+	{
+		if (hold > 0u) hold--;
+	}
+
+	if (!m_enabled)
+	{
+		return;
+	}
+
+	unsigned char holdFrames = (unsigned char)std::min(std::max(m_holdFrames, 1u), 255u);
+
+	NvFlowFloat3 gridMin = { m_gridOffset.x - m_gridScale.x, m_gridOffset.y - m_gridScale.y, m_gridOffset.z - m_gridScale.z };
+	for (NvFlowUint idx = 0u; idx < mapping.layeredNumBlocks; idx++)
+	{
+		const NvFlowUint layerIdx = mapping.layeredBlockListCPU[idx].y;
+		NvFlowInt3 coord = NvFlowCPU_tableVal_to_coord(mapping.layeredBlockListCPU[idx].x);
+		if (layerIdx >= numLayers || coord.x < 0 || coord.x >= dimX || coord.y < 0 || coord.y >= dimY || coord.z < 0 || coord.z >= dimZ)
+		{
+			continue;
+		}
+		// blocks allocated only by prediction do not seed, held blocks the flow already filled still do
+		unsigned char* layerHold = &m_hold[layerIdx * layerSize];
+		if (m_predicted[layerIdx * layerSize + (coord.z * dimY + coord.y) * dimX + coord.x])
+		{
+			continue;
+		}
+
+		NvFlowFloat3 worldPos = {
+			gridMin.x + (float(coord.x) + 0.5f) * m_blockSize.x,
+			gridMin.y + (float(coord.y) + 0.5f) * m_blockSize.y,
+			gridMin.z + (float(coord.z) + 0.5f) * m_blockSize.z
+		};
+		NvFlowFloat3 velocity;
+		if (!sampleVelocity(worldPos, &velocity))
+		{
+			continue;
+		}
+
+		// displacement in blocks
+		float t = m_predictTime * m_velocityScale;
+		NvFlowFloat3 disp = {
+			velocity.x * t / m_blockSize.x,
+			velocity.y * t / m_blockSize.y,
+			velocity.z * t / m_blockSize.z
+		};
+		float maxDisp = fmaxf(fabsf(disp.x), fmaxf(fabsf(disp.y), fabsf(disp.z)));
+		int numSteps = std::min(int(ceilf(2.f * maxDisp)), maxSweepSteps);
+		for (int step = 1; step <= numSteps; step++)
+		{
+			float s = float(step) / float(numSteps);
+			int x = int(floorf(float(coord.x) + 0.5f + s * disp.x));
+			int y = int(floorf(float(coord.y) + 0.5f + s * disp.y));
+			int z = int(floorf(float(coord.z) + 0.5f + s * disp.z));
+			if (x < 0 || x >= dimX || y < 0 || y >= dimY || z < 0 || z >= dimZ)
+			{
+				break;
+			}
+			layerHold[(z * dimY + y) * dimX + x] = holdFrames;
+		}
+	}
+}
+
+void BlockPredictor::invalidateGrid()
+{
+	m_gridValid = false;
+	m_layerMaterials.clear();
+	m_hold.clear();
+	m_active.clear();
+	m_predicted.clear();
+	m_statHeldBlocks = 0u;
+	m_statEmitters = 0u;
+}
+
+NvFlowUint BlockPredictor::gather(float dt, const NvFlowGridMaterialHandle* emitMaterials, NvFlowUint numEmitMaterials)
+{
+	m_shapes.clear();
+	m_params.clear();
+	m_emitMaterials.assign(emitMaterials, emitMaterials + numEmitMaterials);
+	m_statHeldBlocks = 0u;
+	m_statEmitters = 0u;
+
+	if (!m_enabled || !m_gridValid)
+	{
+		return 0u;
+	}
+
+	NvFlowGridEmitParams emitParams;
+	NvFlowGridEmitParamsDefaults(&emitParams);
+	emitParams.shapeType = eNvFlowShapeTypeBox;
+	emitParams.deltaTime = dt;
+	emitParams.emitMode = eNvFlowGridEmitModeDisableVelocity | eNvFlowGridEmitModeDisableDensity;
+	emitParams.allocationScale = { 1.f, 1.f, 1.f };
+	emitParams.allocationPredict = 0.f;
+	emitParams.velocityCoupleRate = { 0.f, 0.f, 0.f };
+	emitParams.smokeCoupleRate = 0.f;
+	emitParams.temperatureCoupleRate = 0.f;
+	emitParams.fuelCoupleRate = 0.f;
+
+	int dimX = int(m_gridDim.x);
+	int dimY = int(m_gridDim.y);
+	int dimZ = int(m_gridDim.z);
+	const size_t layerSize = size_t(dimX) * size_t(dimY) * size_t(dimZ);
+	NvFlowFloat3 gridMin = { m_gridOffset.x - m_gridScale.x, m_gridOffset.y - m_gridScale.y, m_gridOffset.z - m_gridScale.z };
+	for (NvFlowUint layerIdx = 0u; layerIdx < m_layerMaterials.size(); layerIdx++)
+	{
+		// materials only enter the emit table once they have held blocks
+		NvFlowUint materialIdx = ~0u;
+		const unsigned char* layerHold = &m_hold[layerIdx * layerSize];
+		for (int k = 0; k < dimZ; k++)
+		{
+			for (int j = 0; j < dimY; j++)
+			{
+				const unsigned char* row = &layerHold[(k * dimY + j) * dimX];
+				int i = 0;
+				while (i < dimX)
+				{
+					if (row[i] == 0u)
+					{
+						i++;
+						continue;
+					}
+					// one box per run of held blocks
+					int runBegin = i;
+					while (i < dimX && row[i] > 0u) i++;
+					int runEnd = i;
+					m_statHeldBlocks += NvFlowUint(runEnd - runBegin);
+
+					if (materialIdx == ~0u)
+					{
+						materialIdx = 0u;
+						while (materialIdx < m_emitMaterials.size() && !sameMaterial(m_emitMaterials[materialIdx], m_layerMaterials[layerIdx]))
+						{
+							materialIdx++;
+						}
+						if (materialIdx == m_emitMaterials.size())
+						{
+							m_emitMaterials.push_back(m_layerMaterials[layerIdx]);
+						}
+					}
+
+					NvFlowFloat3 center = {
+						gridMin.x + 0.5f * float(runBegin + runEnd) * m_blockSize.x,
+						gridMin.y + (float(j) + 0.5f) * m_blockSize.y,
+						gridMin.z + (float(k) + 0.5f) * m_blockSize.z
+					};
+					NvFlowFloat3 halfSize = {
+						(0.5f * float(runEnd - runBegin) - boxInset) * m_blockSize.x,
+						(0.5f - boxInset) * m_blockSize.y,
+						(0.5f - boxInset) * m_blockSize.z
+					};
+
+					NvFlowShapeDesc shape;
+					shape.box.halfSize = { 1.f, 1.f, 1.f };
+
+					emitParams.shapeRangeOffset = NvFlowUint(m_shapes.size());
+					emitParams.shapeRangeSize = 1u;
+					emitParams.emitMaterialIndex = materialIdx;
+					emitParams.bounds = {
+						halfSize.x, 0.f, 0.f, 0.f,
+						0.f, halfSize.y, 0.f, 0.f,
+						0.f, 0.f, halfSize.z, 0.f,
+						center.x, center.y, center.z, 1.f
+					};
+					emitParams.localToWorld = emitParams.bounds;
+
+					m_shapes.push_back(shape);
+					m_params.push_back(emitParams);
+				}
+			}
+		}
+	}
+
+	m_statEmitters = NvFlowUint(m_params.size());
+	return m_statEmitters;
+}
+
+void BlockPredictor::emit(NvFlowGrid* grid, float dt, const NvFlowGridMaterialHandle* emitMaterials, NvFlowUint numEmitMaterials)
+{
+	if (gather(dt, emitMaterials, numEmitMaterials) > 0u)
+	{
+		// the scene's materials keep their indices, held materials it does not emit go after them
+		if (m_emitMaterials.size() > numEmitMaterials)
+		{
+			NvFlowGridUpdateEmitMaterials(grid, m_emitMaterials.data(), NvFlowUint(m_emitMaterials.size()));
+		}
+		NvFlowGridEmit(grid, m_shapes.data(), NvFlowUint(m_shapes.size()), m_params.data(), NvFlowUint(m_params.size()));
+	}
+}
@@ -0,0 +1,113 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+
+#include "NvFlow.h"
+
+// Grid level predictive allocation.
+//
+// Each active block is swept forward along the coarse velocity of the grid summary
+// for m_predictTime seconds, every block on the path is held for m_holdFrames frames.
+// Held blocks are requested with allocation only box emitters, one per run along x,
+// so allocation stays ahead of fast plumes and is released with some hysteresis.
+// Holds are kept per export layer, a block swept from one material's plume is
+// requested for that material only.
+// Blocks that first appear while held exist only because of prediction and do not sweep
+// themselves, until their hold runs out, or allocation would run down the flow forever.
+struct BlockPredictor
+{
+	bool m_enabled = false;
+	float m_predictTime = 0.25f;		//!< Seconds of motion to allocate ahead
+	NvFlowUint m_holdFrames = 8u;		//!< Frames a predicted block stays requested
+	float m_velocityScale = 1.f;		//!< Scale on the coarse velocity
+
+	// grid state, from the last export
+	bool m_gridValid = false;
+	NvFlowFloat3 m_gridOffset = { 0.f, 0.f, 0.f };
+	NvFlowFloat3 m_gridScale = { 0.f, 0.f, 0.f };
+	NvFlowFloat3 m_blockSize = { 0.f, 0.f, 0.f };
+	NvFlowUint4 m_gridDim = { 0u, 0u, 0u, 0u };
+	std::vector<NvFlowGridMaterialHandle> m_layerMaterials;	//!< Material of each export layer
+	std::vector<unsigned char> m_hold;	//!< Frames left per layer and virtual block
+	std::vector<unsigned char> m_active;	//!< Per layer and virtual block, in the last export
+	std::vector<unsigned char> m_predicted;	//!< Per layer and virtual block, allocated while held and not since seen without a hold
+	std::vector<unsigned char> m_activeNext;
+
+	// coarse velocity, hashed by summary cell
+	NvFlowFloat3 m_coarseOrigin = { 0.f, 0.f, 0.f };
+	NvFlowFloat3 m_coarseCellSize = { 0.f, 0.f, 0.f };
+	std::unordered_map<NvFlowUint64, NvFlowFloat3> m_coarseVelocity;
+
+	std::vector<NvFlowShapeDesc> m_shapes;
+	std::vector<NvFlowGridEmitParams> m_params;
+	std::vector<NvFlowGridMaterialHandle> m_emitMaterials;	//!< Emit material table the params index
+
+	NvFlowUint m_statHeldBlocks = 0u;
+	NvFlowUint m_statEmitters = 0u;
+
+	//! Samples coarse velocity, call with the summaries of every layer
+	void updateVelocity(NvFlowGridSummaryStateCPU* stateCPU);
+
+	//! Adds one summary cell to the coarse velocity, returns false if the cell has no extent
+	bool addCoarseVelocity(const NvFlowGridSummaryResult& result);
+
+	/**
+	 * Sweeps the active blocks of the export forward.
+	 *
+	 * @param[in] mapping Layered mapping of the export, blockIdx uses NvFlow_tableVal_to_coord() encoding.
+	 * @param[in] layerMaterials Material of each export layer, holds follow materials when layers are added or removed.
+	 * @param[in] numLayers Number of export layers, blocks of other layers are ignored.
+	 */
+	void updateGrid(const NvFlowGridExportImportLayeredMapping& mapping, const NvFlowGridMaterialHandle* layerMaterials, NvFlowUint numLayers);
+
+	void invalidateGrid();
+
+	/**
+	 * Builds the allocation emitters for held blocks into m_shapes and m_params.
+	 *
+	 * @param[in] dt The emit deltaTime.
+	 * @param[in] emitMaterials Emit material table of the grid, layer materials it lacks are appended in m_emitMaterials.
+	 * @param[in] numEmitMaterials Number of materials in emitMaterials.
+	 *
+	 * @return Returns the number of emitters.
+	 */
+	NvFlowUint gather(float dt, const NvFlowGridMaterialHandle* emitMaterials, NvFlowUint numEmitMaterials);
+
+	//! Requests allocation for held blocks, call between emit and grid update, emitMaterials as for gather()
+	void emit(NvFlowGrid* grid, float dt, const NvFlowGridMaterialHandle* emitMaterials, NvFlowUint numEmitMaterials);
+
+protected:
+	bool sampleVelocity(const NvFlowFloat3& worldPos, NvFlowFloat3* velocity) const;
+	NvFlowUint64 coarseKey(const NvFlowFloat3& worldPos) const;
+	void updateLayers(const NvFlowGridMaterialHandle* layerMaterials, NvFlowUint numLayers);
+	void shiftHold(int dx, int dy, int dz);
+	void shiftBlocks(std::vector<unsigned char>& blocks, int dx, int dy, int dz);
+};
@@ -0,0 +1,1776 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <math.h>
+#include <string.h>
+
+#include <vector>
+#include <algorithm>
+
+#include "NvFlowShaderCPU.h"
+
+#include "cpuGrid.h"
+#include "taskDispatch.h"
+
+// combustion and pressure run four cells per instruction on level 0 rows, define as 0 for the scalar path
+#ifndef CPU_GRID_SIMD
+#define CPU_GRID_SIMD NV_FLOW_SHADER_CPU_SSE2
+#endif
+
+namespace
+{
+	// ****************** Math ************************
+
+	NvFlowFloat3 operator+(const NvFlowFloat3& a, const NvFlowFloat3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+	NvFlowFloat3 operator-(const NvFlowFloat3& a, const NvFlowFloat3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	NvFlowFloat3 operator*(const NvFlowFloat3& a, float b) { return { a.x * b, a.y * b, a.z * b }; }
+
+	float length(const NvFlowFloat3& a) { return sqrtf(a.x * a.x + a.y * a.y + a.z * a.z); }
+
+	NvFlowFloat3 cross(const NvFlowFloat3& a, const NvFlowFloat3& b)
+	{
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	// row vector convention, matching DirectXMath usage in the scenes
+	NvFlowFloat3 transformPoint(const NvFlowFloat4x4& m, const NvFlowFloat3& p)
+	{
+		return {
+			p.x * m.x.x + p.y * m.y.x + p.z * m.z.x + m.w.x,
+			p.x * m.x.y + p.y * m.y.y + p.z * m.z.y + m.w.y,
+			p.x * m.x.z + p.y * m.y.z + p.z * m.z.z + m.w.z
+		};
+	}
+
+	NvFlowFloat4x4 affineInverse(const NvFlowFloat4x4& m)
+	{
+		const float a = m.x.x, b = m.x.y, c = m.x.z;
+		const float d = m.y.x, e = m.y.y, f = m.y.z;
+		const float g = m.z.x, h = m.z.y, k = m.z.z;
+		const float det = a * (e * k - f * h) - b * (d * k - f * g) + c * (d * h - e * g);
+		const float detInv = (det != 0.f) ? 1.f / det : 0.f;
+
+		NvFlowFloat4x4 r;
+		r.x = { (e * k - f * h) * detInv, (c * h - b * k) * detInv, (b * f - c * e) * detInv, 0.f };
+		r.y = { (f * g - d * k) * detInv, (a * k - c * g) * detInv, (c * d - a * f) * detInv, 0.f };
+		r.z = { (d * h - e * g) * detInv, (b * g - a * h) * detInv, (a * e - b * d) * detInv, 0.f };
+		r.w = { 0.f, 0.f, 0.f, 1.f };
+		NvFlowFloat3 t = transformPoint(r, { m.w.x, m.w.y, m.w.z });
+		r.w = { -t.x, -t.y, -t.z, 1.f };
+		return r;
+	}
+
+	float clampf(float v, float minV, float maxV) { return v < minV ? minV : (v > maxV ? maxV : v); }
+
+	// fraction of the way to the target after dt, rate of inf is instantaneous
+	float coupleBlend(float rate, float dt)
+	{
+		return 1.f - expf(-rate * dt);
+	}
+
+	float fadeToward0(float v, float amount)
+	{
+		if (v > 0.f) return (v > amount) ? v - amount : 0.f;
+		return (v < -amount) ? v + amount : 0.f;
+	}
+
+	NvFlowUint tableVal(NvFlowUint x, NvFlowUint y, NvFlowUint z)
+	{
+		return NvFlowCPU_coord_to_tableVal(x, y, z);
+	}
+
+	void tableValToCoord(NvFlowUint val, NvFlowUint* x, NvFlowUint* y, NvFlowUint* z)
+	{
+		NvFlowInt3 coord = NvFlowCPU_tableVal_to_coord(val);
+		*x = NvFlowUint(coord.x);
+		*y = NvFlowUint(coord.y);
+		*z = NvFlowUint(coord.z);
+	}
+
+	void lerpAccum(NvFlowFloat4& dst, const NvFlowFloat4& src, float w)
+	{
+		dst.x += w * src.x;
+		dst.y += w * src.y;
+		dst.z += w * src.z;
+		dst.w += w * src.w;
+	}
+
+#if CPU_GRID_SIMD
+	// SSE2 forms of the scalar helpers, same operations in the same order, so both paths give the same bits
+
+	__m128 fadeToward0(__m128 v, __m128 amount)
+	{
+		const __m128 signMask = _mm_set1_ps(-0.f);
+		const __m128 zero = _mm_setzero_ps();
+		__m128 mag = _mm_max_ps(_mm_sub_ps(_mm_andnot_ps(signMask, v), amount), zero);
+		__m128 sign = _mm_and_ps(_mm_and_ps(v, signMask), _mm_cmpgt_ps(mag, zero));
+		return _mm_or_ps(mag, sign);
+	}
+
+	//! Four NvFlowFloat4 cells to one register per component
+	void loadTransposed(const NvFlowFloat4* src, __m128* x, __m128* y, __m128* z, __m128* w)
+	{
+		__m128 r0 = _mm_loadu_ps(&src[0].x);
+		__m128 r1 = _mm_loadu_ps(&src[1].x);
+		__m128 r2 = _mm_loadu_ps(&src[2].x);
+		__m128 r3 = _mm_loadu_ps(&src[3].x);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		*x = r0;
+		*y = r1;
+		*z = r2;
+		*w = r3;
+	}
+
+	void storeTransposed(NvFlowFloat4* dst, __m128 x, __m128 y, __m128 z, __m128 w)
+	{
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(&dst[0].x, x);
+		_mm_storeu_ps(&dst[1].x, y);
+		_mm_storeu_ps(&dst[2].x, z);
+		_mm_storeu_ps(&dst[3].x, w);
+	}
+#endif
+
+	struct CpuGridEmitItem
+	{
+		NvFlowGridEmitParams params;
+		NvFlowFloat4x4 worldToLocal;
+		NvFlowFloat3 centerOfMass;
+		int vmin[3];
+		int vmax[3];
+	};
+
+	// ****************** Snapshot ************************
+
+	// header, CpuGridSnapshotBlock[numBlocks], then velocity, density and pressure sections,
+	// each the stored cells of every block in block order, so like values sit together
+	const NvFlowUint CpuGridSnapshotMagic = 0x5347434E;	// "NCGS"
+	const NvFlowUint CpuGridSnapshotVersion = 1u;
+
+	struct CpuGridSnapshotHeader
+	{
+		NvFlowUint magic;
+		NvFlowUint version;
+		NvFlowUint numBlocks;
+		NvFlowUint numCells;			//!< Stored cells over all blocks
+		NvFlowDim tableDim;
+		NvFlowUint pad;
+		NvFlowGridParams params;
+		NvFlowGridMaterialParams materialParams;
+		CpuGridLodParams lodParams;
+	};
+
+	struct CpuGridSnapshotBlock
+	{
+		NvFlowUint blockIdx;			//!< Virtual block, NvFlow_tableVal_to_coord() encoded
+		NvFlowUint level;
+		NvFlowUint live;
+		float detail;
+	};
+
+	size_t snapshotSizeInBytes(NvFlowUint numBlocks, NvFlowUint numCells)
+	{
+		return sizeof(CpuGridSnapshotHeader) + numBlocks * sizeof(CpuGridSnapshotBlock) +
+			size_t(numCells) * (2u * sizeof(NvFlowFloat4) + sizeof(float));
+	}
+}
+
+// ****************** CPU Grid ************************
+
+struct CpuGrid
+{
+	CpuGridDesc m_desc;
+	NvFlowGridParams m_params;
+	NvFlowGridMaterialParams m_materialParams;
+	CpuGridLodParams m_lodParams;
+
+	// own pool unless the desc provides a dispatch interface
+	TaskPool* m_taskPool = nullptr;
+	TaskDispatchInterface m_taskDispatch = {};
+
+	NvFlowDim m_tableDim = { 0u, 0u, 0u };
+	NvFlowDim m_poolGridDim = { 0u, 0u, 0u };
+	NvFlowDim m_poolDim = { 0u, 0u, 0u };
+	NvFlowUint m_maxBlocks = 0u;
+	NvFlowUint m_maxLevel = 0u;
+
+	NvFlowFloat3 m_cellSize = { 0.f, 0.f, 0.f };
+	NvFlowFloat3 m_gridMin = { 0.f, 0.f, 0.f };
+
+	std::vector<NvFlowUint> m_blockTable;
+	std::vector<NvFlowUint> m_blockList;
+	std::vector<NvFlowUint2> m_layeredBlockList;
+	std::vector<NvFlowUint> m_freeList;
+	std::vector<unsigned char> m_blockRequest;
+	std::vector<unsigned char> m_blockLive;
+	std::vector<float> m_blockDetail;
+
+	// level l blocks take one of 8^l slots of a pool block
+	std::vector<NvFlowUint64> m_poolBlockUsed;
+	std::vector<NvFlowUint> m_partialList[CpuGridMaxLevel + 1u];
+	NvFlowUint m_numBlocksPerLevel[CpuGridMaxLevel + 1u] = {};
+
+	std::vector<NvFlowFloat4> m_velocity[2];
+	std::vector<NvFlowFloat4> m_density[2];
+	std::vector<float> m_pressure[2];
+	std::vector<float> m_divergence;
+	int m_current = 0;
+
+	std::vector<NvFlowShapeDesc> m_shapes;
+	std::vector<CpuGridEmitItem> m_emits;
+
+	void init(const CpuGridDesc* desc);
+	void release();
+	void reset();
+
+	//! Each item runs on one task, blocks are owned by the task running them
+	template <typename F>
+	void parallelFor(NvFlowUint numItems, F task)
+	{
+		TaskDispatchRange(&m_taskDispatch, numItems, 1u, [&](NvFlowUint begin, NvFlowUint end)
+		{
+			for (NvFlowUint itemIdx = begin; itemIdx < end; itemIdx++)
+			{
+				task(itemIdx);
+			}
+		});
+	}
+
+	NvFlowUint numStoredCells() const;
+	bool snapshot(void* data, size_t sizeInBytes) const;
+	bool restore(const void* data, size_t sizeInBytes);
+
+	NvFlowUint tableIdx(NvFlowUint bx, NvFlowUint by, NvFlowUint bz) const
+	{
+		return (bz * m_tableDim.y + by) * m_tableDim.x + bx;
+	}
+
+	NvFlowUint poolBlockVal(NvFlowUint poolBlockIdx) const
+	{
+		NvFlowUint px = poolBlockIdx % m_poolGridDim.x;
+		NvFlowUint py = (poolBlockIdx / m_poolGridDim.x) % m_poolGridDim.y;
+		NvFlowUint pz = poolBlockIdx / (m_poolGridDim.x * m_poolGridDim.y);
+		return tableVal(px, py, pz);
+	}
+
+	//! Virtual cell to pool cell, cells outside allocated blocks resolve to the null block
+	NvFlowUint virtualToReal(int vx, int vy, int vz) const
+	{
+		const int bd = int(CpuGridBlockDim);
+		NvFlowUint rx = 0u, ry = 0u, rz = 0u;
+		if (vx >= 0 && vy >= 0 && vz >= 0 &&
+			vx < int(m_desc.gridDesc.virtualDim.x) &&
+			vy < int(m_desc.gridDesc.virtualDim.y) &&
+			vz < int(m_desc.gridDesc.virtualDim.z))
+		{
+			NvFlowUint val = m_blockTable[tableIdx(vx >> CpuGridBlockDimBits, vy >> CpuGridBlockDimBits, vz >> CpuGridBlockDimBits)];
+			NvFlowUint level = NvFlowCPU_tableVal_to_level(val);
+			NvFlowUint bits = CpuGridBlockDimBits - level;
+			tableValToCoord(val, &rx, &ry, &rz);
+			rx = (rx << bits) | ((vx & (bd - 1)) >> level);
+			ry = (ry << bits) | ((vy & (bd - 1)) >> level);
+			rz = (rz << bits) | ((vz & (bd - 1)) >> level);
+		}
+		return (rz * m_poolDim.y + ry) * m_poolDim.x + rx;
+	}
+
+	//! Pool cell of a block, i, j, k in cells of the block level
+	NvFlowUint levelCellIdx(NvFlowUint val, NvFlowUint i, NvFlowUint j, NvFlowUint k) const
+	{
+		NvFlowUint bits = CpuGridBlockDimBits - NvFlowCPU_tableVal_to_level(val);
+		NvFlowUint rx, ry, rz;
+		tableValToCoord(val, &rx, &ry, &rz);
+		rx = (rx << bits) + i;
+		ry = (ry << bits) + j;
+		rz = (rz << bits) + k;
+		return (rz * m_poolDim.y + ry) * m_poolDim.x + rx;
+	}
+
+	//! Pool cells of the x-, x+, y-, y+, z-, z+ neighbors of each cell of row j, k of a level 0 block
+	void rowNeighbors(NvFlowUint blockIdx, NvFlowUint j, NvFlowUint k, NvFlowUint nbr[6][CpuGridBlockDim]) const
+	{
+		NvFlowUint bx, by, bz;
+		tableValToCoord(m_blockList[blockIdx], &bx, &by, &bz);
+		const NvFlowUint rowIdx = levelCellIdx(m_blockTable[tableIdx(bx, by, bz)], 0u, j, k);
+		const NvFlowUint last = CpuGridBlockDim - 1u;
+		const NvFlowUint slice = m_poolDim.x * m_poolDim.y;
+		const int x = int(bx << CpuGridBlockDimBits);
+		const int y = int((by << CpuGridBlockDimBits) + j);
+		const int z = int((bz << CpuGridBlockDimBits) + k);
+		// inside the block neighbors are fixed pool offsets, across its faces they go through the table
+		for (NvFlowUint i = 0u; i < CpuGridBlockDim; i++)
+		{
+			nbr[0][i] = (i > 0u) ? rowIdx + i - 1u : virtualToReal(x - 1, y, z);
+			nbr[1][i] = (i < last) ? rowIdx + i + 1u : virtualToReal(x + int(CpuGridBlockDim), y, z);
+			nbr[2][i] = (j > 0u) ? rowIdx + i - m_poolDim.x : virtualToReal(x + int(i), y - 1, z);
+			nbr[3][i] = (j < last) ? rowIdx + i + m_poolDim.x : virtualToReal(x + int(i), y + 1, z);
+			nbr[4][i] = (k > 0u) ? rowIdx + i - slice : virtualToReal(x + int(i), y, z - 1);
+			nbr[5][i] = (k < last) ? rowIdx + i + slice : virtualToReal(x + int(i), y, z + 1);
+		}
+	}
+
+	NvFlowUint blockLevel(NvFlowUint blockIdx) const
+	{
+		NvFlowUint bx, by, bz;
+		tableValToCoord(m_blockList[blockIdx], &bx, &by, &bz);
+		return NvFlowCPU_tableVal_to_level(m_blockTable[tableIdx(bx, by, bz)]);
+	}
+
+	//! Calls func(rowIdx, nbr) per row of a level 0 block, rowIdx is the pool cell of the row start, see rowNeighbors()
+	template <typename F>
+	void forEachRow(NvFlowUint blockIdx, F func) const
+	{
+		NvFlowUint bx, by, bz;
+		tableValToCoord(m_blockList[blockIdx], &bx, &by, &bz);
+		const NvFlowUint val = m_blockTable[tableIdx(bx, by, bz)];
+		NvFlowUint nbr[6][CpuGridBlockDim];
+		for (NvFlowUint k = 0u; k < CpuGridBlockDim; k++)
+		{
+			for (NvFlowUint j = 0u; j < CpuGridBlockDim; j++)
+			{
+				rowNeighbors(blockIdx, j, k, nbr);
+				func(levelCellIdx(val, 0u, j, k), nbr);
+			}
+		}
+	}
+
+	//! Calls func(x, y, z, s, ridx) per cell, x, y, z is the first virtual cell covered and s the cells covered per axis
+	template <typename F>
+	void forEachCell(NvFlowUint blockIdx, F func) const
+	{
+		NvFlowUint bx, by, bz;
+		tableValToCoord(m_blockList[blockIdx], &bx, &by, &bz);
+		const NvFlowUint val = m_blockTable[tableIdx(bx, by, bz)];
+		const NvFlowUint level = NvFlowCPU_tableVal_to_level(val);
+		const NvFlowUint n = CpuGridBlockDim >> level;
+		const int s = 1 << level;
+		for (NvFlowUint k = 0u; k < n; k++)
+		{
+			for (NvFlowUint j = 0u; j < n; j++)
+			{
+				for (NvFlowUint i = 0u; i < n; i++)
+				{
+					int x = int((bx << CpuGridBlockDimBits) + (i << level));
+					int y = int((by << CpuGridBlockDimBits) + (j << level));
+					int z = int((bz << CpuGridBlockDimBits) + (k << level));
+					func(x, y, z, s, levelCellIdx(val, i, j, k));
+				}
+			}
+		}
+	}
+
+	template <typename T>
+	T sampleLinear(const std::vector<T>& data, float px, float py, float pz) const;
+
+	void worldToVirtual(const NvFlowFloat3& p, float* v) const
+	{
+		v[0] = (p.x - m_gridMin.x) / m_cellSize.x;
+		v[1] = (p.y - m_gridMin.y) / m_cellSize.y;
+		v[2] = (p.z - m_gridMin.z) / m_cellSize.z;
+	}
+
+	NvFlowFloat3 virtualToWorld(int vx, int vy, int vz, int s = 1) const
+	{
+		const float h = 0.5f * float(s);
+		return {
+			m_gridMin.x + (float(vx) + h) * m_cellSize.x,
+			m_gridMin.y + (float(vy) + h) * m_cellSize.y,
+			m_gridMin.z + (float(vz) + h) * m_cellSize.z
+		};
+	}
+
+	void worldBoundsToCells(const NvFlowFloat4x4& bounds, NvFlowFloat3 ndcScale, NvFlowFloat3 offset, int* vmin, int* vmax) const;
+
+	float shapeDistance(const CpuGridEmitItem& emit, const NvFlowFloat3& local) const;
+
+	//! Emitter opacity at a world position, 0 outside the active distance range
+	float emitOpacity(const CpuGridEmitItem& emit, const NvFlowFloat3& world) const;
+
+	bool allocBlock(NvFlowUint level, NvFlowUint* val);
+	void freeBlock(NvFlowUint val);
+	void clearBlock(NvFlowUint val);
+	void resampleBlock(NvFlowUint srcVal, NvFlowUint dstVal);
+	NvFlowUint chooseLevel(NvFlowUint bx, NvFlowUint by, NvFlowUint bz) const;
+
+	void updateAllocation(float dt);
+	void updateEmit(float dt);
+	void updateAdvection(float dt);
+	void updateCombustion(float dt);
+	void updatePressure();
+	void updateLiveness();
+	void update(float dt);
+};
+
+template <typename T>
+T CpuGrid::sampleLinear(const std::vector<T>& data, float px, float py, float pz) const
+{
+	// cell centers are at +0.5
+	px -= 0.5f;
+	py -= 0.5f;
+	pz -= 0.5f;
+	const float fx0 = floorf(px), fy0 = floorf(py), fz0 = floorf(pz);
+	const int x0 = int(fx0), y0 = int(fy0), z0 = int(fz0);
+	const float fx = px - fx0, fy = py - fy0, fz = pz - fz0;
+
+	T sum = {};
+	for (int k = 0; k < 8; k++)
+	{
+		const int dx = k & 1, dy = (k >> 1) & 1, dz = (k >> 2) & 1;
+		const float w = (dx ? fx : 1.f - fx) * (dy ? fy : 1.f - fy) * (dz ? fz : 1.f - fz);
+		lerpAccum(sum, data[virtualToReal(x0 + dx, y0 + dy, z0 + dz)], w);
+	}
+	return sum;
+}
+
+void CpuGrid::init(const CpuGridDesc* desc)
+{
+	m_desc = *desc;
+	CpuGridParamsDefaults(&m_params);
+	CpuGridMaterialParamsDefaults(&m_materialParams);
+	CpuGridLodParamsDefaults(&m_lodParams);
+
+	const NvFlowGridDesc& gridDesc = m_desc.gridDesc;
+
+	m_tableDim.x = (gridDesc.virtualDim.x + CpuGridBlockDim - 1u) >> CpuGridBlockDimBits;
+	m_tableDim.y = (gridDesc.virtualDim.y + CpuGridBlockDim - 1u) >> CpuGridBlockDimBits;
+	m_tableDim.z = (gridDesc.virtualDim.z + CpuGridBlockDim - 1u) >> CpuGridBlockDimBits;
+	const NvFlowUint numVirtualBlocks = m_tableDim.x * m_tableDim.y * m_tableDim.z;
+
+	m_maxBlocks = NvFlowUint(float(numVirtualBlocks) * gridDesc.residentScale);
+	if (m_maxBlocks < 1u) m_maxBlocks = 1u;
+	if (m_maxBlocks > numVirtualBlocks) m_maxBlocks = numVirtualBlocks;
+
+	// pool block 0 is the null block, always zero, so lookups never branch
+	const NvFlowUint numPoolBlocks = m_maxBlocks + 1u;
+	m_poolGridDim.x = m_tableDim.x;
+	m_poolGridDim.y = m_tableDim.y;
+	m_poolGridDim.z = (numPoolBlocks + m_tableDim.x * m_tableDim.y - 1u) / (m_tableDim.x * m_tableDim.y);
+	m_poolDim.x = m_poolGridDim.x << CpuGridBlockDimBits;
+	m_poolDim.y = m_poolGridDim.y << CpuGridBlockDimBits;
+	m_poolDim.z = m_poolGridDim.z << CpuGridBlockDimBits;
+	const size_t numPoolCells = size_t(m_poolDim.x) * m_poolDim.y * m_poolDim.z;
+
+	// sub block coordinates of the finest level must fit the 10 bit table fields
+	m_maxLevel = m_desc.maxLevel < CpuGridMaxLevel ? m_desc.maxLevel : CpuGridMaxLevel;
+	while (m_maxLevel > 0u &&
+		((m_poolGridDim.x << m_maxLevel) > 1024u || (m_poolGridDim.y << m_maxLevel) > 1024u || (m_poolGridDim.z << m_maxLevel) > 1024u))
+	{
+		m_maxLevel--;
+	}
+
+	m_cellSize.x = 2.f * gridDesc.halfSize.x / float(gridDesc.virtualDim.x);
+	m_cellSize.y = 2.f * gridDesc.halfSize.y / float(gridDesc.virtualDim.y);
+	m_cellSize.z = 2.f * gridDesc.halfSize.z / float(gridDesc.virtualDim.z);
+	m_gridMin = gridDesc.initialLocation - gridDesc.halfSize;
+
+	m_blockTable.resize(numVirtualBlocks);
+	m_blockRequest.resize(numVirtualBlocks);
+	m_blockLive.resize(numVirtualBlocks);
+	m_blockDetail.resize(numVirtualBlocks);
+	m_poolBlockUsed.resize(size_t(m_poolGridDim.x) * m_poolGridDim.y * m_poolGridDim.z);
+	for (int i = 0; i < 2; i++)
+	{
+		m_velocity[i].resize(numPoolCells);
+		m_density[i].resize(numPoolCells);
+		m_pressure[i].resize(numPoolCells);
+	}
+	m_divergence.resize(numPoolCells);
+
+	reset();
+
+	if (m_desc.taskDispatch)
+	{
+		m_taskDispatch = *m_desc.taskDispatch;
+	}
+	else
+	{
+		m_taskPool = TaskPoolCreate(m_desc.numWorkers);
+		TaskPoolGetInterface(m_taskPool, &m_taskDispatch);
+	}
+}
+
+void CpuGrid::release()
+{
+	TaskPoolRelease(m_taskPool);
+	m_taskPool = nullptr;
+}
+
+void CpuGrid::reset()
+{
+	for (auto& val : m_blockTable) val = ~0u;
+	for (auto& val : m_blockLive) val = 0u;
+	for (auto& val : m_blockDetail) val = 0.f;
+	for (auto& val : m_poolBlockUsed) val = 0u;
+	m_blockList.clear();
+	m_layeredBlockList.clear();
+	m_freeList.clear();
+	for (NvFlowUint level = 0u; level <= CpuGridMaxLevel; level++)
+	{
+		m_partialList[level].clear();
+		m_numBlocksPerLevel[level] = 0u;
+	}
+	for (NvFlowUint idx = m_maxBlocks; idx >= 1u; idx--)
+	{
+		m_freeList.push_back(idx);
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		memset(m_velocity[i].data(), 0, m_velocity[i].size() * sizeof(NvFlowFloat4));
+		memset(m_density[i].data(), 0, m_density[i].size() * sizeof(NvFlowFloat4));
+		memset(m_pressure[i].data(), 0, m_pressure[i].size() * sizeof(float));
+	}
+	memset(m_divergence.data(), 0, m_divergence.size() * sizeof(float));
+	m_current = 0;
+	m_emits.clear();
+	m_shapes.clear();
+}
+
+bool CpuGrid::allocBlock(NvFlowUint level, NvFlowUint* val)
+{
+	if (level == 0u)
+	{
+		if (m_freeList.size() == 0u)
+		{
+			return false;
+		}
+		*val = poolBlockVal(m_freeList.back());
+		m_freeList.pop_back();
+		return true;
+	}
+
+	std::vector<NvFlowUint>& partial = m_partialList[level];
+	if (partial.size() == 0u)
+	{
+		if (m_freeList.size() == 0u)
+		{
+			return false;
+		}
+		partial.push_back(m_freeList.back());
+		m_freeList.pop_back();
+		m_poolBlockUsed[partial.back()] = 0u;
+	}
+
+	const NvFlowUint numSlots = 1u << (3u * level);
+	const NvFlowUint64 fullMask = (numSlots == 64u) ? ~0ull : ((1ull << numSlots) - 1ull);
+	const NvFlowUint poolBlockIdx = partial.back();
+	NvFlowUint64& used = m_poolBlockUsed[poolBlockIdx];
+	NvFlowUint slot = 0u;
+	while (used & (1ull << slot)) slot++;
+	used |= 1ull << slot;
+	if (used == fullMask)
+	{
+		partial.pop_back();
+	}
+
+	const NvFlowUint n = 1u << level;
+	NvFlowUint px, py, pz;
+	tableValToCoord(poolBlockVal(poolBlockIdx), &px, &py, &pz);
+	*val = NvFlowCPU_coord_to_tableValLevel(
+		(px << level) + slot % n,
+		(py << level) + (slot / n) % n,
+		(pz << level) + slot / (n * n),
+		level);
+	return true;
+}
+
+void CpuGrid::freeBlock(NvFlowUint val)
+{
+	const NvFlowUint level = NvFlowCPU_tableVal_to_level(val);
+	const NvFlowUint n = 1u << level;
+	NvFlowUint rx, ry, rz;
+	tableValToCoord(val, &rx, &ry, &rz);
+	const NvFlowUint poolBlockIdx = ((rz >> level) * m_poolGridDim.y + (ry >> level)) * m_poolGridDim.x + (rx >> level);
+	if (level == 0u)
+	{
+		m_freeList.push_back(poolBlockIdx);
+		return;
+	}
+
+	const NvFlowUint numSlots = 1u << (3u * level);
+	const NvFlowUint64 fullMask = (numSlots == 64u) ? ~0ull : ((1ull << numSlots) - 1ull);
+	const NvFlowUint slot = ((rz & (n - 1u)) * n + (ry & (n - 1u))) * n + (rx & (n - 1u));
+	std::vector<NvFlowUint>& partial = m_partialList[level];
+	NvFlowUint64& used = m_poolBlockUsed[poolBlockIdx];
+	if (used == fullMask)
+	{
+		partial.push_back(poolBlockIdx);
+	}
+	used &= ~(1ull << slot);
+	if (used == 0u)
+	{
+		// pool block is whole again, any level can take it
+		partial.erase(std::find(partial.begin(), partial.end(), poolBlockIdx));
+		m_freeList.push_back(poolBlockIdx);
+	}
+}
+
+void CpuGrid::clearBlock(NvFlowUint val)
+{
+	const NvFlowUint n = CpuGridBlockDim >> NvFlowCPU_tableVal_to_level(val);
+	for (NvFlowUint k = 0u; k < n; k++)
+	{
+		for (NvFlowUint j = 0u; j < n; j++)
+		{
+			NvFlowUint rowIdx = levelCellIdx(val, 0u, j, k);
+			memset(&m_velocity[m_current][rowIdx], 0, n * sizeof(NvFlowFloat4));
+			memset(&m_density[m_current][rowIdx], 0, n * sizeof(NvFlowFloat4));
+			memset(&m_pressure[0][rowIdx], 0, n * sizeof(float));
+			memset(&m_pressure[1][rowIdx], 0, n * sizeof(float));
+		}
+	}
+}
+
+void CpuGrid::resampleBlock(NvFlowUint srcVal, NvFlowUint dstVal)
+{
+	// box filter going coarse, nearest going fine
+	const NvFlowUint srcLevel = NvFlowCPU_tableVal_to_level(srcVal);
+	const NvFlowUint dstLevel = NvFlowCPU_tableVal_to_level(dstVal);
+	const float w = 1.f / float(1u << (3u * dstLevel));
+
+	clearBlock(dstVal);
+	for (NvFlowUint k = 0u; k < CpuGridBlockDim; k++)
+	{
+		for (NvFlowUint j = 0u; j < CpuGridBlockDim; j++)
+		{
+			for (NvFlowUint i = 0u; i < CpuGridBlockDim; i++)
+			{
+				NvFlowUint src = levelCellIdx(srcVal, i >> srcLevel, j >> srcLevel, k >> srcLevel);
+				NvFlowUint dst = levelCellIdx(dstVal, i >> dstLevel, j >> dstLevel, k >> dstLevel);
+				lerpAccum(m_velocity[m_current][dst], m_velocity[m_current][src], w);
+				lerpAccum(m_density[m_current][dst], m_density[m_current][src], w);
+				m_pressure[0][dst] += w * m_pressure[0][src];
+			}
+		}
+	}
+}
+
+NvFlowUint CpuGrid::chooseLevel(NvFlowUint bx, NvFlowUint by, NvFlowUint bz) const
+{
+	if (m_maxLevel == 0u)
+	{
+		return 0u;
+	}
+
+	NvFlowUint level = 0u;
+	if (m_lodParams.levelDistance > 0.f)
+	{
+		const int half = int(CpuGridBlockDim >> 1u);
+		NvFlowFloat3 center = virtualToWorld(int(bx << CpuGridBlockDimBits) + half, int(by << CpuGridBlockDimBits) + half, int(bz << CpuGridBlockDimBits) + half, 0);
+		float dist = length(center - m_lodParams.cameraPosition);
+		while (level < m_maxLevel && dist >= m_lodParams.levelDistance * float(1u << level))
+		{
+			level++;
+		}
+	}
+
+	const NvFlowUint val = m_blockTable[tableIdx(bx, by, bz)];
+	const float threshold = m_lodParams.detailThreshold;
+	if (threshold > 0.f && val != ~0u)
+	{
+		// refine above the threshold, coarsen well below it, hold in between
+		const NvFlowUint current = NvFlowCPU_tableVal_to_level(val);
+		const float detail = m_blockDetail[tableIdx(bx, by, bz)];
+		if (detail > threshold)
+		{
+			level = 0u;
+		}
+		else if (detail < 0.25f * threshold && level == 0u)
+		{
+			level = 1u;
+		}
+		else if (level > current && detail > 0.5f * threshold)
+		{
+			level = current;
+		}
+	}
+	return level;
+}
+
+void CpuGrid::worldBoundsToCells(const NvFlowFloat4x4& bounds, NvFlowFloat3 ndcScale, NvFlowFloat3 offset, int* vmin, int* vmax) const
+{
+	float fmin[3] = { +INFINITY, +INFINITY, +INFINITY };
+	float fmax[3] = { -INFINITY, -INFINITY, -INFINITY };
+	for (int k = 0; k < 8; k++)
+	{
+		NvFlowFloat3 ndc = {
+			(k & 1) ? +ndcScale.x : -ndcScale.x,
+			(k & 2) ? +ndcScale.y : -ndcScale.y,
+			(k & 4) ? +ndcScale.z : -ndcScale.z
+		};
+		NvFlowFloat3 world = transformPoint(bounds, ndc);
+		for (int pass = 0; pass < 2; pass++)
+		{
+			float v[3];
+			worldToVirtual(pass ? world + offset : world, v);
+			for (int c = 0; c < 3; c++)
+			{
+				if (v[c] < fmin[c]) fmin[c] = v[c];
+				if (v[c] > fmax[c]) fmax[c] = v[c];
+			}
+		}
+	}
+	const NvFlowUint* vdim = &m_desc.gridDesc.virtualDim.x;
+	for (int c = 0; c < 3; c++)
+	{
+		vmin[c] = int(clampf(floorf(fmin[c]), 0.f, float(vdim[c])));
+		vmax[c] = int(clampf(ceilf(fmax[c]), 0.f, float(vdim[c])));
+	}
+}
+
+float CpuGrid::shapeDistance(const CpuGridEmitItem& emit, const NvFlowFloat3& local) const
+{
+	float dist = INFINITY;
+	for (NvFlowUint shapeIdx = 0u; shapeIdx < emit.params.shapeRangeSize; shapeIdx++)
+	{
+		const NvFlowShapeDesc& shape = m_shapes[emit.params.shapeRangeOffset + shapeIdx];
+		float d = INFINITY;
+		if (emit.params.shapeType == eNvFlowShapeTypeSphere)
+		{
+			d = length(local) - shape.sphere.radius;
+		}
+		else if (emit.params.shapeType == eNvFlowShapeTypeBox)
+		{
+			NvFlowFloat3 q = {
+				fabsf(local.x) - shape.box.halfSize.x,
+				fabsf(local.y) - shape.box.halfSize.y,
+				fabsf(local.z) - shape.box.halfSize.z
+			};
+			NvFlowFloat3 qpos = { fmaxf(q.x, 0.f), fmaxf(q.y, 0.f), fmaxf(q.z, 0.f) };
+			d = length(qpos) + fminf(fmaxf(q.x, fmaxf(q.y, q.z)), 0.f);
+		}
+		else if (emit.params.shapeType == eNvFlowShapeTypeCapsule)
+		{
+			const float halfLength = 0.5f * shape.capsule.length;
+			NvFlowFloat3 q = { local.x - clampf(local.x, -halfLength, +halfLength), local.y, local.z };
+			d = length(q) - shape.capsule.radius;
+		}
+		else if (emit.params.shapeType == eNvFlowShapeTypePlane)
+		{
+			const NvFlowFloat3& n = shape.plane.normal;
+			d = n.x * local.x + n.y * local.y + n.z * local.z - shape.plane.distance;
+		}
+		dist = fminf(dist, d);
+	}
+	return dist * emit.params.shapeDistScale;
+}
+
+float CpuGrid::emitOpacity(const CpuGridEmitItem& emit, const NvFlowFloat3& world) const
+{
+	const NvFlowGridEmitParams& params = emit.params;
+	float dist = shapeDistance(emit, transformPoint(emit.worldToLocal, world));
+	if (dist < params.minActiveDist || dist > params.maxActiveDist)
+	{
+		return 0.f;
+	}
+	float opacity = 1.f;
+	if (params.minEdgeDist > 0.f)
+	{
+		opacity = fminf(opacity, (dist - params.minActiveDist) / params.minEdgeDist);
+	}
+	if (params.maxEdgeDist > 0.f)
+	{
+		opacity = fminf(opacity, (params.maxActiveDist - dist) / params.maxEdgeDist);
+	}
+	return opacity;
+}
+
+void CpuGrid::updateAllocation(float dt)
+{
+	memset(m_blockRequest.data(), 0, m_blockRequest.size());
+
+	// keep live blocks, and their neighbors so content can advect into them
+	for (NvFlowUint val : m_blockList)
+	{
+		NvFlowUint bx, by, bz;
+		tableValToCoord(val, &bx, &by, &bz);
+		if (!m_blockLive[tableIdx(bx, by, bz)])
+		{
+			continue;
+		}
+		for (int k = -1; k <= 1; k++)
+		{
+			for (int j = -1; j <= 1; j++)
+			{
+				for (int i = -1; i <= 1; i++)
+				{
+					int x = int(bx) + i, y = int(by) + j, z = int(bz) + k;
+					if (x >= 0 && y >= 0 && z >= 0 && x < int(m_tableDim.x) && y < int(m_tableDim.y) && z < int(m_tableDim.z))
+					{
+						m_blockRequest[tableIdx(x, y, z)] = 1u;
+					}
+				}
+			}
+		}
+	}
+
+	// emitter bounds
+	for (const CpuGridEmitItem& emit : m_emits)
+	{
+		const NvFlowGridEmitParams& params = emit.params;
+		if ((params.emitMode & eNvFlowGridEmitModeDisableAlloc) ||
+			params.allocationScale.x <= 0.f || params.allocationScale.y <= 0.f || params.allocationScale.z <= 0.f)
+		{
+			continue;
+		}
+		const float w = params.predictVelocityWeight;
+		NvFlowFloat3 velocity = params.velocityLinear * (1.f - w) + params.predictVelocity * w;
+		int vmin[3], vmax[3];
+		worldBoundsToCells(params.bounds, params.allocationScale, velocity * (params.allocationPredict * dt), vmin, vmax);
+		// bounds entirely past a face clamp to an empty range, which would still round out to the partial edge block
+		if (vmin[0] >= vmax[0] || vmin[1] >= vmax[1] || vmin[2] >= vmax[2])
+		{
+			continue;
+		}
+		for (int z = vmin[2] >> CpuGridBlockDimBits; z < ((vmax[2] + int(CpuGridBlockDim) - 1) >> CpuGridBlockDimBits); z++)
+		{
+			for (int y = vmin[1] >> CpuGridBlockDimBits; y < ((vmax[1] + int(CpuGridBlockDim) - 1) >> CpuGridBlockDimBits); y++)
+			{
+				for (int x = vmin[0] >> CpuGridBlockDimBits; x < ((vmax[0] + int(CpuGridBlockDim) - 1) >> CpuGridBlockDimBits); x++)
+				{
+					m_blockRequest[tableIdx(x, y, z)] = 1u;
+				}
+			}
+		}
+	}
+
+	// free blocks no longer requested
+	for (NvFlowUint val : m_blockList)
+	{
+		NvFlowUint bx, by, bz;
+		tableValToCoord(val, &bx, &by, &bz);
+		NvFlowUint idx = tableIdx(bx, by, bz);
+		if (!m_blockRequest[idx])
+		{
+			freeBlock(m_blockTable[idx]);
+			m_blockTable[idx] = ~0u;
+			m_blockDetail[idx] = 0.f;
+		}
+	}
+
+	// coarsen first, so the memory it returns is there for refinement and new blocks
+	if (m_maxLevel > 0u)
+	{
+		for (NvFlowUint val : m_blockList)
+		{
+			NvFlowUint bx, by, bz;
+			tableValToCoord(val, &bx, &by, &bz);
+			NvFlowUint idx = tableIdx(bx, by, bz);
+			NvFlowUint oldVal = m_blockTable[idx];
+			if (oldVal == ~0u)
+			{
+				continue;
+			}
+			NvFlowUint level = chooseLevel(bx, by, bz);
+			NvFlowUint newVal;
+			if (level > NvFlowCPU_tableVal_to_level(oldVal) && allocBlock(level, &newVal))
+			{
+				resampleBlock(oldVal, newVal);
+				freeBlock(oldVal);
+				m_blockTable[idx] = newVal;
+			}
+		}
+	}
+
+	// allocate in virtual order, so results do not depend on request order
+	m_blockList.clear();
+	m_layeredBlockList.clear();
+	for (NvFlowUint level = 0u; level <= CpuGridMaxLevel; level++)
+	{
+		m_numBlocksPerLevel[level] = 0u;
+	}
+	for (NvFlowUint bz = 0u; bz < m_tableDim.z; bz++)
+	{
+		for (NvFlowUint by = 0u; by < m_tableDim.y; by++)
+		{
+			for (NvFlowUint bx = 0u; bx < m_tableDim.x; bx++)
+			{
+				NvFlowUint idx = tableIdx(bx, by, bz);
+				m_blockLive[idx] = 0u;
+				if (m_blockRequest[idx])
+				{
+					NvFlowUint level = chooseLevel(bx, by, bz);
+					NvFlowUint oldVal = m_blockTable[idx];
+					NvFlowUint newVal;
+					if (oldVal == ~0u)
+					{
+						// a coarse block beats no block when the pool is tight
+						while (level <= m_maxLevel && !allocBlock(level, &newVal))
+						{
+							level++;
+						}
+						if (level <= m_maxLevel)
+						{
+							m_blockTable[idx] = newVal;
+							clearBlock(newVal);
+						}
+					}
+					else if (level < NvFlowCPU_tableVal_to_level(oldVal) && allocBlock(level, &newVal))
+					{
+						resampleBlock(oldVal, newVal);
+						freeBlock(oldVal);
+						m_blockTable[idx] = newVal;
+					}
+				}
+				if (m_blockTable[idx] != ~0u)
+				{
+					NvFlowUint val = tableVal(bx, by, bz);
+					m_blockList.push_back(val);
+					m_layeredBlockList.push_back({ val, 0u });
+					m_numBlocksPerLevel[NvFlowCPU_tableVal_to_level(m_blockTable[idx])]++;
+				}
+			}
+		}
+	}
+}
+
+void CpuGrid::updateEmit(float dt)
+{
+	std::vector<NvFlowFloat4>& velocityData = m_velocity[m_current];
+	std::vector<NvFlowFloat4>& densityData = m_density[m_current];
+
+	parallelFor(NvFlowUint(m_blockList.size()), [&](NvFlowUint blockIdx)
+	{
+		NvFlowUint bx, by, bz;
+		tableValToCoord(m_blockList[blockIdx], &bx, &by, &bz);
+		const int bmin[3] = { int(bx << CpuGridBlockDimBits), int(by << CpuGridBlockDimBits), int(bz << CpuGridBlockDimBits) };
+		const int bmax[3] = { bmin[0] + int(CpuGridBlockDim), bmin[1] + int(CpuGridBlockDim), bmin[2] + int(CpuGridBlockDim) };
+
+		// coarse blocks emit once per level cell, sampled at its center
+		const int level = int(NvFlowCPU_tableVal_to_level(m_blockTable[tableIdx(bx, by, bz)]));
+		const int s = 1 << level;
+
+		// emitters apply in submission order, each block is owned by one worker
+		for (const CpuGridEmitItem& emit : m_emits)
+		{
+			int vmin[3], vmax[3];
+			for (int c = 0; c < 3; c++)
+			{
+				vmin[c] = emit.vmin[c] > bmin[c] ? emit.vmin[c] : bmin[c];
+				vmax[c] = emit.vmax[c] < bmax[c] ? emit.vmax[c] : bmax[c];
+			}
+			if (vmin[0] >= vmax[0] || vmin[1] >= vmax[1] || vmin[2] >= vmax[2])
+			{
+				continue;
+			}
+			for (int c = 0; c < 3; c++)
+			{
+				vmin[c] = (vmin[c] >> level) << level;
+			}
+
+			const NvFlowGridEmitParams& params = emit.params;
+			// sub stepped emitters couple over their own slice of the update
+			const float emitDt = params.deltaTime > 0.f ? params.deltaTime : dt;
+			const float velocityBlend[3] = {
+				coupleBlend(params.velocityCoupleRate.x, emitDt),
+				coupleBlend(params.velocityCoupleRate.y, emitDt),
+				coupleBlend(params.velocityCoupleRate.z, emitDt)
+			};
+			const float smokeBlend = coupleBlend(params.smokeCoupleRate, emitDt);
+			const float temperatureBlend = coupleBlend(params.temperatureCoupleRate, emitDt);
+			const float fuelBlend = coupleBlend(params.fuelCoupleRate, emitDt);
+
+			for (int z = vmin[2]; z < vmax[2]; z += s)
+			{
+				for (int y = vmin[1]; y < vmax[1]; y += s)
+				{
+					for (int x = vmin[0]; x < vmax[0]; x += s)
+					{
+						NvFlowFloat3 world = virtualToWorld(x, y, z, s);
+						float opacity = 0.f;
+						if (s == 1)
+						{
+							opacity = emitOpacity(emit, world);
+						}
+						else
+						{
+							// coarse cells take the coverage of the fine cells they stand for,
+							// so emitters smaller than a coarse cell do not vanish
+							for (int k = 0; k < s; k++)
+							{
+								for (int j = 0; j < s; j++)
+								{
+									for (int i = 0; i < s; i++)
+									{
+										opacity += emitOpacity(emit, virtualToWorld(x + i, y + j, z + k));
+									}
+								}
+							}
+							opacity /= float(s * s * s);
+						}
+						if (opacity <= 0.f)
+						{
+							continue;
+						}
+
+						NvFlowUint ridx = virtualToReal(x, y, z);
+						if (!(params.emitMode & eNvFlowGridEmitModeDisableVelocity))
+						{
+							NvFlowFloat3 target = params.velocityLinear + cross(params.velocityAngular, world - emit.centerOfMass);
+							NvFlowFloat4& v = velocityData[ridx];
+							v.x += (target.x - v.x) * velocityBlend[0] * opacity;
+							v.y += (target.y - v.y) * velocityBlend[1] * opacity;
+							v.z += (target.z - v.z) * velocityBlend[2] * opacity;
+						}
+						if (!(params.emitMode & eNvFlowGridEmitModeDisableDensity))
+						{
+							NvFlowFloat4& d = densityData[ridx];
+							d.x += (params.temperature - d.x) * temperatureBlend * opacity;
+							d.y += (params.fuel - d.y) * fuelBlend * opacity;
+							d.w += (params.smoke - d.w) * smokeBlend * opacity;
+							if (d.x > params.fuelReleaseTemp)
+							{
+								d.y += params.fuelRelease * emitDt * opacity;
+							}
+						}
+					}
+				}
+			}
+		}
+	});
+}
+
+void CpuGrid::updateAdvection(float dt)
+{
+	const std::vector<NvFlowFloat4>& velocitySrc = m_velocity[m_current];
+	const std::vector<NvFlowFloat4>& densitySrc = m_density[m_current];
+	std::vector<NvFlowFloat4>& velocityDst = m_velocity[m_current ^ 1];
+	std::vector<NvFlowFloat4>& densityDst = m_density[m_current ^ 1];
+
+	const float scale[3] = { dt / m_cellSize.x, dt / m_cellSize.y, dt / m_cellSize.z };
+
+	parallelFor(NvFlowUint(m_blockList.size()), [&](NvFlowUint blockIdx)
+	{
+		forEachCell(blockIdx, [&](int x, int y, int z, int s, NvFlowUint ridx)
+		{
+			const NvFlowFloat4 v = velocitySrc[ridx];
+
+			// semi-Lagrangian backtrace, in cell units
+			const float h = 0.5f * float(s);
+			float px = float(x) + h - v.x * scale[0];
+			float py = float(y) + h - v.y * scale[1];
+			float pz = float(z) + h - v.z * scale[2];
+
+			velocityDst[ridx] = sampleLinear(velocitySrc, px, py, pz);
+			densityDst[ridx] = sampleLinear(densitySrc, px, py, pz);
+		});
+	});
+
+	m_current ^= 1;
+}
+
+void CpuGrid::updateCombustion(float dt)
+{
+	std::vector<NvFlowFloat4>& velocityData = m_velocity[m_current];
+	std::vector<NvFlowFloat4>& densityData = m_density[m_current];
+	const NvFlowGridMaterialParams& mat = m_materialParams;
+
+	const float velocityDamping = expf(-mat.velocity.damping * dt);
+	const float temperatureDamping = expf(-mat.temperature.damping * dt);
+	const float fuelDamping = expf(-mat.fuel.damping * dt);
+	const float smokeDamping = expf(-mat.smoke.damping * dt);
+	const float cooling = expf(-mat.coolingRate * dt);
+	const NvFlowFloat3 buoyancy = m_params.gravity * (-mat.buoyancyPerTemp * dt);
+
+	parallelFor(NvFlowUint(m_blockList.size()), [&](NvFlowUint blockIdx)
+	{
+		NvFlowUint bx, by, bz;
+		tableValToCoord(m_blockList[blockIdx], &bx, &by, &bz);
+		const NvFlowUint val = m_blockTable[tableIdx(bx, by, bz)];
+		const NvFlowUint n = CpuGridBlockDim >> NvFlowCPU_tableVal_to_level(val);
+		for (NvFlowUint k = 0u; k < n; k++)
+		{
+			for (NvFlowUint j = 0u; j < n; j++)
+			{
+				// rows of a block are contiguous in the pool
+				NvFlowUint rowIdx = levelCellIdx(val, 0u, j, k);
+				NvFlowFloat4* v = &velocityData[rowIdx];
+				NvFlowFloat4* d = &densityData[rowIdx];
+				float* divergence = &m_divergence[rowIdx];
+				NvFlowUint i = 0u;
+#if CPU_GRID_SIMD
+				for (; i + 4u <= n; i += 4u)
+				{
+					__m128 temperature, fuel, burn, smoke;
+					loadTransposed(d + i, &temperature, &fuel, &burn, &smoke);
+
+					burn = _mm_mul_ps(_mm_mul_ps(_mm_max_ps(_mm_sub_ps(temperature, _mm_set1_ps(mat.ignitionTemp)), _mm_setzero_ps()), _mm_set1_ps(mat.burnPerTemp)), _mm_set1_ps(dt));
+					if (mat.fuelPerBurn > 0.f)
+					{
+						burn = _mm_min_ps(burn, _mm_div_ps(_mm_max_ps(fuel, _mm_setzero_ps()), _mm_set1_ps(mat.fuelPerBurn)));
+					}
+					fuel = _mm_sub_ps(fuel, _mm_mul_ps(_mm_set1_ps(mat.fuelPerBurn), burn));
+					temperature = _mm_add_ps(temperature, _mm_mul_ps(_mm_set1_ps(mat.tempPerBurn), burn));
+					smoke = _mm_add_ps(smoke, _mm_mul_ps(_mm_set1_ps(mat.smokePerBurn), burn));
+					_mm_storeu_ps(divergence + i, _mm_mul_ps(_mm_set1_ps(-mat.divergencePerBurn), burn));
+
+					temperature = fadeToward0(_mm_mul_ps(_mm_mul_ps(temperature, _mm_set1_ps(cooling)), _mm_set1_ps(temperatureDamping)), _mm_set1_ps(mat.temperature.fade * dt));
+					fuel = fadeToward0(_mm_mul_ps(fuel, _mm_set1_ps(fuelDamping)), _mm_set1_ps(mat.fuel.fade * dt));
+					smoke = fadeToward0(_mm_mul_ps(smoke, _mm_set1_ps(smokeDamping)), _mm_set1_ps(mat.smoke.fade * dt));
+					storeTransposed(d + i, temperature, fuel, burn, smoke);
+
+					__m128 vx, vy, vz, vw;
+					loadTransposed(v + i, &vx, &vy, &vz, &vw);
+					const __m128 damping = _mm_set1_ps(velocityDamping);
+					const __m128 fade = _mm_set1_ps(mat.velocity.fade * dt);
+					vx = fadeToward0(_mm_mul_ps(_mm_add_ps(vx, _mm_mul_ps(_mm_set1_ps(buoyancy.x), temperature)), damping), fade);
+					vy = fadeToward0(_mm_mul_ps(_mm_add_ps(vy, _mm_mul_ps(_mm_set1_ps(buoyancy.y), temperature)), damping), fade);
+					vz = fadeToward0(_mm_mul_ps(_mm_add_ps(vz, _mm_mul_ps(_mm_set1_ps(buoyancy.z), temperature)), damping), fade);
+					storeTransposed(v + i, vx, vy, vz, vw);
+				}
+#endif
+				for (; i < n; i++)
+				{
+					float temperature = d[i].x;
+					float fuel = d[i].y;
+					float smoke = d[i].w;
+
+					float burn = fmaxf(temperature - mat.ignitionTemp, 0.f) * mat.burnPerTemp * dt;
+					if (mat.fuelPerBurn > 0.f)
+					{
+						burn = fminf(burn, fmaxf(fuel, 0.f) / mat.fuelPerBurn);
+					}
+					fuel -= mat.fuelPerBurn * burn;
+					temperature += mat.tempPerBurn * burn;
+					smoke += mat.smokePerBurn * burn;
+					divergence[i] = -mat.divergencePerBurn * burn;
+
+					temperature = fadeToward0(temperature * cooling * temperatureDamping, mat.temperature.fade * dt);
+					fuel = fadeToward0(fuel * fuelDamping, mat.fuel.fade * dt);
+					smoke = fadeToward0(smoke * smokeDamping, mat.smoke.fade * dt);
+
+					d[i].x = temperature;
+					d[i].y = fuel;
+					d[i].z = burn;
+					d[i].w = smoke;
+
+					v[i].x = fadeToward0((v[i].x + buoyancy.x * temperature) * velocityDamping, mat.velocity.fade * dt);
+					v[i].y = fadeToward0((v[i].y + buoyancy.y * temperature) * velocityDamping, mat.velocity.fade * dt);
+					v[i].z = fadeToward0((v[i].z + buoyancy.z * temperature) * velocityDamping, mat.velocity.fade * dt);
+				}
+			}
+		}
+	});
+}
+
+void CpuGrid::updatePressure()
+{
+	std::vector<NvFlowFloat4>& velocityData = m_velocity[m_current];
+	const NvFlowUint numBlocks = NvFlowUint(m_blockList.size());
+
+	const float halfInvCell[3] = { 0.5f / m_cellSize.x, 0.5f / m_cellSize.y, 0.5f / m_cellSize.z };
+	const float invCell2[3] = {
+		1.f / (m_cellSize.x * m_cellSize.x),
+		1.f / (m_cellSize.y * m_cellSize.y),
+		1.f / (m_cellSize.z * m_cellSize.z)
+	};
+	const float diagInv = 1.f / (2.f * (invCell2[0] + invCell2[1] + invCell2[2]));
+
+	// divergence, on top of the combustion expansion term
+	parallelFor(numBlocks, [&](NvFlowUint blockIdx)
+	{
+#if CPU_GRID_SIMD
+		if (blockLevel(blockIdx) == 0u)
+		{
+			forEachRow(blockIdx, [&](NvFlowUint rowIdx, const NvFlowUint nbr[6][CpuGridBlockDim])
+			{
+				float xm[CpuGridBlockDim], xp[CpuGridBlockDim], ym[CpuGridBlockDim], yp[CpuGridBlockDim], zm[CpuGridBlockDim], zp[CpuGridBlockDim];
+				for (NvFlowUint i = 0u; i < CpuGridBlockDim; i++)
+				{
+					xm[i] = velocityData[nbr[0][i]].x;
+					xp[i] = velocityData[nbr[1][i]].x;
+					ym[i] = velocityData[nbr[2][i]].y;
+					yp[i] = velocityData[nbr[3][i]].y;
+					zm[i] = velocityData[nbr[4][i]].z;
+					zp[i] = velocityData[nbr[5][i]].z;
+				}
+				for (NvFlowUint i = 0u; i < CpuGridBlockDim; i += 4u)
+				{
+					__m128 div = _mm_add_ps(
+						_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(xp + i), _mm_loadu_ps(xm + i)), _mm_set1_ps(halfInvCell[0])),
+						_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(yp + i), _mm_loadu_ps(ym + i)), _mm_set1_ps(halfInvCell[1])));
+					div = _mm_add_ps(div, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(zp + i), _mm_loadu_ps(zm + i)), _mm_set1_ps(halfInvCell[2])));
+					float* dst = &m_divergence[rowIdx + i];
+					_mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst), div));
+				}
+			});
+			return;
+		}
+#endif
+		// coarse cells difference across their own width
+		forEachCell(blockIdx, [&](int x, int y, int z, int s, NvFlowUint ridx)
+		{
+			float div =
+				(velocityData[virtualToReal(x + s, y, z)].x - velocityData[virtualToReal(x - s, y, z)].x) * halfInvCell[0] +
+				(velocityData[virtualToReal(x, y + s, z)].y - velocityData[virtualToReal(x, y - s, z)].y) * halfInvCell[1] +
+				(velocityData[virtualToReal(x, y, z + s)].z - velocityData[virtualToReal(x, y, z - s)].z) * halfInvCell[2];
+			m_divergence[ridx] += div / float(s);
+		});
+	});
+
+	// Jacobi, unallocated neighbors read the null block as zero pressure
+	int src = 0;
+	for (NvFlowUint iteration = 0u; iteration < m_desc.pressureIterations; iteration++)
+	{
+		const std::vector<float>& pressureSrc = m_pressure[src];
+		std::vector<float>& pressureDst = m_pressure[src ^ 1];
+		parallelFor(numBlocks, [&](NvFlowUint blockIdx)
+		{
+#if CPU_GRID_SIMD
+			if (blockLevel(blockIdx) == 0u)
+			{
+				forEachRow(blockIdx, [&](NvFlowUint rowIdx, const NvFlowUint nbr[6][CpuGridBlockDim])
+				{
+					float p[6][CpuGridBlockDim];
+					for (NvFlowUint c = 0u; c < 6u; c++)
+					{
+						for (NvFlowUint i = 0u; i < CpuGridBlockDim; i++)
+						{
+							p[c][i] = pressureSrc[nbr[c][i]];
+						}
+					}
+					for (NvFlowUint i = 0u; i < CpuGridBlockDim; i += 4u)
+					{
+						__m128 sum = _mm_add_ps(
+							_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(p[1] + i), _mm_loadu_ps(p[0] + i)), _mm_set1_ps(invCell2[0])),
+							_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(p[3] + i), _mm_loadu_ps(p[2] + i)), _mm_set1_ps(invCell2[1])));
+						sum = _mm_add_ps(sum, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(p[5] + i), _mm_loadu_ps(p[4] + i)), _mm_set1_ps(invCell2[2])));
+						_mm_storeu_ps(&pressureDst[rowIdx + i], _mm_mul_ps(_mm_sub_ps(sum, _mm_loadu_ps(&m_divergence[rowIdx + i])), _mm_set1_ps(diagInv)));
+					}
+				});
+				return;
+			}
+#endif
+			forEachCell(blockIdx, [&](int x, int y, int z, int s, NvFlowUint ridx)
+			{
+				float sum =
+					(pressureSrc[virtualToReal(x + s, y, z)] + pressureSrc[virtualToReal(x - s, y, z)]) * invCell2[0] +
+					(pressureSrc[virtualToReal(x, y + s, z)] + pressureSrc[virtualToReal(x, y - s, z)]) * invCell2[1] +
+					(pressureSrc[virtualToReal(x, y, z + s)] + pressureSrc[virtualToReal(x, y, z - s)]) * invCell2[2];
+				const float s2 = float(s * s);
+				pressureDst[ridx] = (sum - m_divergence[ridx] * s2) * diagInv;
+			});
+		});
+		src ^= 1;
+	}
+	if (src != 0)
+	{
+		m_pressure[0].swap(m_pressure[1]);
+	}
+
+	// subtract gradient
+	const std::vector<float>& pressure = m_pressure[0];
+	parallelFor(numBlocks, [&](NvFlowUint blockIdx)
+	{
+#if CPU_GRID_SIMD
+		if (blockLevel(blockIdx) == 0u)
+		{
+			forEachRow(blockIdx, [&](NvFlowUint rowIdx, const NvFlowUint nbr[6][CpuGridBlockDim])
+			{
+				float p[6][CpuGridBlockDim];
+				for (NvFlowUint c = 0u; c < 6u; c++)
+				{
+					for (NvFlowUint i = 0u; i < CpuGridBlockDim; i++)
+					{
+						p[c][i] = pressure[nbr[c][i]];
+					}
+				}
+				for (NvFlowUint i = 0u; i < CpuGridBlockDim; i += 4u)
+				{
+					__m128 vx, vy, vz, vw;
+					loadTransposed(&velocityData[rowIdx + i], &vx, &vy, &vz, &vw);
+					vx = _mm_sub_ps(vx, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(p[1] + i), _mm_loadu_ps(p[0] + i)), _mm_set1_ps(halfInvCell[0])));
+					vy = _mm_sub_ps(vy, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(p[3] + i), _mm_loadu_ps(p[2] + i)), _mm_set1_ps(halfInvCell[1])));
+					vz = _mm_sub_ps(vz, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(p[5] + i), _mm_loadu_ps(p[4] + i)), _mm_set1_ps(halfInvCell[2])));
+					storeTransposed(&velocityData[rowIdx + i], vx, vy, vz, vw);
+				}
+			});
+			return;
+		}
+#endif
+		forEachCell(blockIdx, [&](int x, int y, int z, int s, NvFlowUint ridx)
+		{
+			NvFlowFloat4& v = velocityData[ridx];
+			const float sInv = 1.f / float(s);
+			v.x -= (pressure[virtualToReal(x + s, y, z)] - pressure[virtualToReal(x - s, y, z)]) * halfInvCell[0] * sInv;
+			v.y -= (pressure[virtualToReal(x, y + s, z)] - pressure[virtualToReal(x, y - s, z)]) * halfInvCell[1] * sInv;
+			v.z -= (pressure[virtualToReal(x, y, z + s)] - pressure[virtualToReal(x, y, z - s)]) * halfInvCell[2] * sInv;
+		});
+	});
+}
+
+void CpuGrid::updateLiveness()
+{
+	const std::vector<NvFlowFloat4>& velocityData = m_velocity[m_current];
+	const std::vector<NvFlowFloat4>& densityData = m_density[m_current];
+	const NvFlowGridMaterialParams& mat = m_materialParams;
+
+	auto relevant = [](const NvFlowGridMaterialPerComponent& comp, float value)
+	{
+		return comp.allocWeight > 0.f && comp.allocWeight * fabsf(value) > comp.allocThreshold;
+	};
+
+	// detail drives spatial LOD, it needs every cell so it is only measured with levels enabled
+	const bool measureDetail = m_maxLevel > 0u;
+	const NvFlowGridMaterialPerComponent* components[4] = { &mat.velocity, &mat.temperature, &mat.fuel, &mat.smoke };
+
+	parallelFor(NvFlowUint(m_blockList.size()), [&](NvFlowUint blockIdx)
+	{
+		NvFlowUint bx, by, bz;
+		tableValToCoord(m_blockList[blockIdx], &bx, &by, &bz);
+		const NvFlowUint val = m_blockTable[tableIdx(bx, by, bz)];
+		const NvFlowUint n = CpuGridBlockDim >> NvFlowCPU_tableVal_to_level(val);
+		unsigned char live = 0u;
+		float minValue[4] = { +INFINITY, +INFINITY, +INFINITY, +INFINITY };
+		float maxValue[4] = { -INFINITY, -INFINITY, -INFINITY, -INFINITY };
+		for (NvFlowUint k = 0u; k < n && (!live || measureDetail); k++)
+		{
+			for (NvFlowUint j = 0u; j < n && (!live || measureDetail); j++)
+			{
+				NvFlowUint rowIdx = levelCellIdx(val, 0u, j, k);
+				for (NvFlowUint i = 0u; i < n; i++)
+				{
+					const NvFlowFloat4& v = velocityData[rowIdx + i];
+					const NvFlowFloat4& d = densityData[rowIdx + i];
+					const float values[4] = { length({ v.x, v.y, v.z }), d.x, d.y, d.w };
+					if (relevant(mat.velocity, values[0]) ||
+						relevant(mat.temperature, values[1]) ||
+						relevant(mat.fuel, values[2]) ||
+						relevant(mat.smoke, values[3]))
+					{
+						live = 1u;
+						if (!measureDetail)
+						{
+							break;
+						}
+					}
+					for (int c = 0; c < 4; c++)
+					{
+						minValue[c] = fminf(minValue[c], values[c]);
+						maxValue[c] = fmaxf(maxValue[c], values[c]);
+					}
+				}
+			}
+		}
+		m_blockLive[tableIdx(bx, by, bz)] = live;
+
+		if (measureDetail)
+		{
+			float detail = 0.f;
+			for (int c = 0; c < 4; c++)
+			{
+				detail = fmaxf(detail, components[c]->allocWeight * (maxValue[c] - minValue[c]));
+			}
+			m_blockDetail[tableIdx(bx, by, bz)] = detail;
+		}
+	});
+}
+
+void CpuGrid::update(float dt)
+{
+	updateAllocation(dt);
+	updateEmit(dt);
+	updateAdvection(dt);
+	updateCombustion(dt);
+	updatePressure();
+	updateLiveness();
+
+	m_emits.clear();
+	m_shapes.clear();
+}
+
+NvFlowUint CpuGrid::numStoredCells() const
+{
+	NvFlowUint numCells = 0u;
+	for (NvFlowUint level = 0u; level <= CpuGridMaxLevel; level++)
+	{
+		numCells += m_numBlocksPerLevel[level] * (CpuGridBlockDim >> level) * (CpuGridBlockDim >> level) * (CpuGridBlockDim >> level);
+	}
+	return numCells;
+}
+
+bool CpuGrid::snapshot(void* data, size_t sizeInBytes) const
+{
+	const NvFlowUint numBlocks = NvFlowUint(m_blockList.size());
+	const NvFlowUint numCells = numStoredCells();
+	if (sizeInBytes < snapshotSizeInBytes(numBlocks, numCells))
+	{
+		return false;
+	}
+
+	unsigned char* dst = (unsigned char*)data;
+	CpuGridSnapshotHeader header = {};
+	header.magic = CpuGridSnapshotMagic;
+	header.version = CpuGridSnapshotVersion;
+	header.numBlocks = numBlocks;
+	header.numCells = numCells;
+	header.tableDim = m_tableDim;
+	header.params = m_params;
+	header.materialParams = m_materialParams;
+	header.lodParams = m_lodParams;
+	memcpy(dst, &header, sizeof(header));
+	dst += sizeof(header);
+
+	for (NvFlowUint val : m_blockList)
+	{
+		NvFlowUint bx, by, bz;
+		tableValToCoord(val, &bx, &by, &bz);
+		const NvFlowUint idx = tableIdx(bx, by, bz);
+		CpuGridSnapshotBlock block = { val, NvFlowCPU_tableVal_to_level(m_blockTable[idx]), m_blockLive[idx], m_blockDetail[idx] };
+		memcpy(dst, &block, sizeof(block));
+		dst += sizeof(block);
+	}
+
+	// pressure is the warm start of the next solve, without it the restored run drifts
+	const void* channels[3] = { m_velocity[m_current].data(), m_density[m_current].data(), m_pressure[0].data() };
+	const size_t cellSize[3] = { sizeof(NvFlowFloat4), sizeof(NvFlowFloat4), sizeof(float) };
+	for (int c = 0; c < 3; c++)
+	{
+		for (NvFlowUint val : m_blockList)
+		{
+			NvFlowUint bx, by, bz;
+			tableValToCoord(val, &bx, &by, &bz);
+			const NvFlowUint rVal = m_blockTable[tableIdx(bx, by, bz)];
+			const NvFlowUint n = CpuGridBlockDim >> NvFlowCPU_tableVal_to_level(rVal);
+			for (NvFlowUint k = 0u; k < n; k++)
+			{
+				for (NvFlowUint j = 0u; j < n; j++)
+				{
+					memcpy(dst, (const unsigned char*)channels[c] + levelCellIdx(rVal, 0u, j, k) * cellSize[c], n * cellSize[c]);
+					dst += n * cellSize[c];
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool CpuGrid::restore(const void* data, size_t sizeInBytes)
+{
+	const unsigned char* src = (const unsigned char*)data;
+	CpuGridSnapshotHeader header;
+	if (sizeInBytes < sizeof(header))
+	{
+		return false;
+	}
+	memcpy(&header, src, sizeof(header));
+	if (header.magic != CpuGridSnapshotMagic || header.version != CpuGridSnapshotVersion ||
+		memcmp(&header.tableDim, &m_tableDim, sizeof(NvFlowDim)) != 0 ||
+		sizeInBytes < snapshotSizeInBytes(header.numBlocks, header.numCells))
+	{
+		return false;
+	}
+	src += sizeof(header);
+
+	reset();
+	m_params = header.params;
+	m_materialParams = header.materialParams;
+	m_lodParams = header.lodParams;
+
+	// blocks get fresh pool slots, data is addressed virtually so placement does not change results
+	NvFlowUint numCells = 0u;
+	for (NvFlowUint blockIdx = 0u; blockIdx < header.numBlocks; blockIdx++)
+	{
+		CpuGridSnapshotBlock block;
+		memcpy(&block, src + blockIdx * sizeof(block), sizeof(block));
+		NvFlowUint bx, by, bz;
+		tableValToCoord(block.blockIdx, &bx, &by, &bz);
+		NvFlowUint val;
+		if (bx >= m_tableDim.x || by >= m_tableDim.y || bz >= m_tableDim.z ||
+			block.level > m_maxLevel || m_blockTable[tableIdx(bx, by, bz)] != ~0u ||
+			!allocBlock(block.level, &val))
+		{
+			reset();
+			return false;
+		}
+		const NvFlowUint idx = tableIdx(bx, by, bz);
+		m_blockTable[idx] = val;
+		m_blockLive[idx] = block.live ? 1u : 0u;
+		m_blockDetail[idx] = block.detail;
+		m_blockList.push_back(block.blockIdx);
+		m_layeredBlockList.push_back({ block.blockIdx, 0u });
+		m_numBlocksPerLevel[block.level]++;
+
+		const NvFlowUint n = CpuGridBlockDim >> block.level;
+		numCells += n * n * n;
+	}
+	if (numCells != header.numCells)
+	{
+		reset();
+		return false;
+	}
+	src += header.numBlocks * sizeof(CpuGridSnapshotBlock);
+
+	void* channels[3] = { m_velocity[m_current].data(), m_density[m_current].data(), m_pressure[0].data() };
+	const size_t cellSize[3] = { sizeof(NvFlowFloat4), sizeof(NvFlowFloat4), sizeof(float) };
+	for (int c = 0; c < 3; c++)
+	{
+		for (NvFlowUint val : m_blockList)
+		{
+			NvFlowUint bx, by, bz;
+			tableValToCoord(val, &bx, &by, &bz);
+			const NvFlowUint rVal = m_blockTable[tableIdx(bx, by, bz)];
+			const NvFlowUint n = CpuGridBlockDim >> NvFlowCPU_tableVal_to_level(rVal);
+			for (NvFlowUint k = 0u; k < n; k++)
+			{
+				for (NvFlowUint j = 0u; j < n; j++)
+				{
+					memcpy((unsigned char*)channels[c] + levelCellIdx(rVal, 0u, j, k) * cellSize[c], src, n * cellSize[c]);
+					src += n * cellSize[c];
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// ****************** CPU Grid Public ************************
+
+void CpuGridDescDefaults(CpuGridDesc* desc)
+{
+	NvFlowGridDesc& gridDesc = desc->gridDesc;
+	gridDesc.initialLocation = { 0.f, 0.f, 0.f };
+	gridDesc.halfSize = { 2.f, 2.f, 2.f };
+	gridDesc.virtualDim = { 128u, 128u, 128u };
+	gridDesc.densityMultiRes = eNvFlowMultiRes1x1x1;
+	gridDesc.residentScale = 0.25f;
+	gridDesc.coarseResidentScaleFactor = 1.f;
+	gridDesc.enableVTR = false;
+	gridDesc.lowLatencyMapping = false;
+
+	desc->numWorkers = 0u;
+	desc->taskDispatch = nullptr;
+	desc->pressureIterations = 20u;
+	desc->maxLevel = 0u;
+}
+
+void CpuGridParamsDefaults(NvFlowGridParams* params)
+{
+	params->gravity = { 0.f, -1.f, 0.f };
+	params->singlePassAdvection = true;
+	params->pressureLegacyMode = false;
+	params->bigEffectMode = false;
+	params->bigEffectPredictTime = 0.1f;
+	params->debugVisFlags = eNvFlowGridDebugVisDisabled;
+}
+
+void CpuGridMaterialParamsDefaults(NvFlowGridMaterialParams* params)
+{
+	NvFlowGridMaterialPerComponent comp;
+	comp.damping = 0.f;
+	comp.fade = 0.f;
+	comp.macCormackBlendFactor = 0.f;
+	comp.macCormackBlendThreshold = 0.f;
+	comp.allocWeight = 0.f;
+	comp.allocThreshold = 0.05f;
+
+	params->velocity = comp;
+	params->smoke = comp;
+	params->temperature = comp;
+	params->fuel = comp;
+
+	params->velocity.damping = 0.01f;
+	params->smoke.damping = 0.3f;
+	params->smoke.fade = 0.65f;
+	params->temperature.allocWeight = 1.f;
+	params->fuel.allocWeight = 1.f;
+	params->smoke.allocWeight = 1.f;
+
+	params->vorticityStrength = 0.f;
+	params->vorticityVelocityMask = 0.f;
+	params->vorticityTemperatureMask = 0.f;
+	params->vorticitySmokeMask = 0.f;
+	params->vorticityFuelMask = 0.f;
+	params->vorticityConstantMask = 0.f;
+
+	params->ignitionTemp = 0.05f;
+	params->burnPerTemp = 4.f;
+	params->fuelPerBurn = 0.25f;
+	params->tempPerBurn = 5.f;
+	params->smokePerBurn = 3.f;
+	params->divergencePerBurn = 0.f;
+	params->buoyancyPerTemp = 2.f;
+	params->coolingRate = 1.5f;
+}
+
+void CpuGridEmitParamsDefaults(NvFlowGridEmitParams* params)
+{
+	memset(params, 0, sizeof(NvFlowGridEmitParams));
+
+	const NvFlowFloat4x4 identity = {
+		{ 1.f, 0.f, 0.f, 0.f },
+		{ 0.f, 1.f, 0.f, 0.f },
+		{ 0.f, 0.f, 1.f, 0.f },
+		{ 0.f, 0.f, 0.f, 1.f }
+	};
+
+	params->shapeRangeSize = 1u;
+	params->shapeType = eNvFlowShapeTypeSphere;
+	params->shapeDistScale = 1.f;
+	params->bounds = identity;
+	params->localToWorld = identity;
+	params->deltaTime = 1.f / 60.f;
+	params->allocationScale = { 1.f, 1.f, 1.f };
+	params->minActiveDist = -1.f;
+	params->maxActiveDist = 0.f;
+	params->velocityCoupleRate = { 2.f, 2.f, 2.f };
+	params->smokeCoupleRate = 2.f;
+	params->temperatureCoupleRate = 2.f;
+	params->fuelCoupleRate = 2.f;
+	params->fuelReleaseTemp = 0.f;
+	params->fuelRelease = 0.f;
+}
+
+void CpuGridLodParamsDefaults(CpuGridLodParams* params)
+{
+	// no distance and no detail threshold, every block stays at level 0
+	params->cameraPosition = { 0.f, 0.f, 0.f };
+	params->levelDistance = 0.f;
+	params->detailThreshold = 0.f;
+}
+
+CpuGrid* CpuGridCreate(const CpuGridDesc* desc)
+{
+	CpuGrid* grid = new CpuGrid;
+	grid->init(desc);
+	return grid;
+}
+
+void CpuGridRelease(CpuGrid* grid)
+{
+	if (grid == nullptr) return;
+
+	grid->release();
+	delete grid;
+}
+
+void CpuGridReset(CpuGrid* grid)
+{
+	grid->reset();
+}
+
+void CpuGridSetParams(CpuGrid* grid, const NvFlowGridParams* params)
+{
+	grid->m_params = *params;
+}
+
+void CpuGridSetMaterialParams(CpuGrid* grid, const NvFlowGridMaterialParams* params)
+{
+	grid->m_materialParams = *params;
+}
+
+void CpuGridSetLodParams(CpuGrid* grid, const CpuGridLodParams* params)
+{
+	grid->m_lodParams = *params;
+}
+
+void CpuGridEmit(CpuGrid* grid, const NvFlowShapeDesc* shapes, NvFlowUint numShapes, const NvFlowGridEmitParams* params, NvFlowUint numParams)
+{
+	// shape ranges are relative to this call, rebase onto the accumulated shapes
+	const NvFlowUint shapeBase = NvFlowUint(grid->m_shapes.size());
+	grid->m_shapes.insert(grid->m_shapes.end(), shapes, shapes + numShapes);
+
+	for (NvFlowUint paramIdx = 0u; paramIdx < numParams; paramIdx++)
+	{
+		const NvFlowGridEmitParams& src = params[paramIdx];
+		if (src.shapeType == eNvFlowShapeTypeSDF || src.shapeRangeOffset + src.shapeRangeSize > numShapes)
+		{
+			continue;
+		}
+
+		CpuGridEmitItem emit;
+		emit.params = src;
+		emit.params.shapeRangeOffset += shapeBase;
+		emit.worldToLocal = affineInverse(src.localToWorld);
+		emit.centerOfMass = transformPoint(src.localToWorld, src.centerOfMass);
+		grid->worldBoundsToCells(src.bounds, { 1.f, 1.f, 1.f }, { 0.f, 0.f, 0.f }, emit.vmin, emit.vmax);
+
+		grid->m_emits.push_back(emit);
+	}
+}
+
+void CpuGridUpdate(CpuGrid* grid, float dt)
+{
+	grid->update(dt);
+}
+
+size_t CpuGridGetSnapshotSize(CpuGrid* grid)
+{
+	return snapshotSizeInBytes(NvFlowUint(grid->m_blockList.size()), grid->numStoredCells());
+}
+
+bool CpuGridSnapshot(CpuGrid* grid, void* data, size_t sizeInBytes)
+{
+	return grid->snapshot(data, sizeInBytes);
+}
+
+bool CpuGridRestore(CpuGrid* grid, const void* data, size_t sizeInBytes)
+{
+	return grid->restore(data, sizeInBytes);
+}
+
+void CpuGridGetExport(CpuGrid* grid, CpuGridExport* gridExport)
+{
+	const NvFlowGridDesc& gridDesc = grid->m_desc.gridDesc;
+	NvFlowGridExportImportLayeredMapping& mapping = gridExport->mapping;
+	NvFlowShaderLinearParams& shaderParams = mapping.shaderParams;
+
+	shaderParams.isVTR = { 0u, 0u, 0u, 0u };
+	shaderParams.blockDim = { CpuGridBlockDim, CpuGridBlockDim, CpuGridBlockDim, CpuGridBlockDim * CpuGridBlockDim * CpuGridBlockDim };
+	shaderParams.blockDimBits = { CpuGridBlockDimBits, CpuGridBlockDimBits, CpuGridBlockDimBits, 0u };
+	shaderParams.poolGridDim = { grid->m_poolGridDim.x, grid->m_poolGridDim.y, grid->m_poolGridDim.z, 0u };
+	shaderParams.gridDim = { grid->m_tableDim.x, grid->m_tableDim.y, grid->m_tableDim.z, 0u };
+	shaderParams.blockDimInv = { 1.f / float(CpuGridBlockDim), 1.f / float(CpuGridBlockDim), 1.f / float(CpuGridBlockDim), 0.f };
+	// no apron on the CPU, linear blocks match point blocks
+	shaderParams.linearBlockDim = shaderParams.blockDim;
+	shaderParams.linearBlockOffset = { 0u, 0u, 0u, 0u };
+	shaderParams.dimInv = { 1.f / float(grid->m_poolDim.x), 1.f / float(grid->m_poolDim.y), 1.f / float(grid->m_poolDim.z), 0.f };
+	shaderParams.vdim = { float(gridDesc.virtualDim.x), float(gridDesc.virtualDim.y), float(gridDesc.virtualDim.z), 0.f };
+	shaderParams.vdimInv = { 1.f / shaderParams.vdim.x, 1.f / shaderParams.vdim.y, 1.f / shaderParams.vdim.z, 0.f };
+
+	mapping.maxBlocks = grid->m_maxBlocks;
+	mapping.layeredBlockListCPU = grid->m_layeredBlockList.data();
+	mapping.layeredNumBlocks = NvFlowUint(grid->m_layeredBlockList.size());
+	mapping.modelMatrix = {
+		{ gridDesc.halfSize.x, 0.f, 0.f, 0.f },
+		{ 0.f, gridDesc.halfSize.y, 0.f, 0.f },
+		{ 0.f, 0.f, gridDesc.halfSize.z, 0.f },
+		{ gridDesc.initialLocation.x, gridDesc.initialLocation.y, gridDesc.initialLocation.z, 1.f }
+	};
+
+	gridExport->tableParams.format = { NV_FLOW_TABLE_FORMAT_32, NvFlowUint(grid->m_maxLevel > 0u ? NV_FLOW_TABLE_LEVELS_ON : NV_FLOW_TABLE_LEVELS_OFF), 0u, 0u };
+
+	gridExport->blockTable = grid->m_blockTable.data();
+	gridExport->blockList = grid->m_blockList.data();
+	gridExport->numBlocks = NvFlowUint(grid->m_blockList.size());
+	gridExport->velocity = grid->m_velocity[grid->m_current].data();
+	gridExport->density = grid->m_density[grid->m_current].data();
+	gridExport->poolDim = grid->m_poolDim;
+	for (NvFlowUint level = 0u; level <= CpuGridMaxLevel; level++)
+	{
+		gridExport->numBlocksPerLevel[level] = grid->m_numBlocksPerLevel[level];
+	}
+}
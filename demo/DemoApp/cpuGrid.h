@@ -0,0 +1,147 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "NvFlow.h"
+
+struct TaskDispatchInterface;
+
+/// ****************** CPU Grid Public *******************************
+
+// CPU reference implementation of the Flow sparse grid.
+// Runs allocation, emit, advection, combustion and pressure on worker threads or an engine job system,
+// with no NvFlowContext, so grids can be simulated on machines without a GPU.
+// Data is laid out like the GPU export, a block table into a pool of blocks,
+// addressed with the same NvFlowShaderLinearParams.
+// SDF shapes are not supported, emitters using them are ignored.
+// Updates are deterministic: blocks are allocated and listed in virtual order, each worker
+// owns whole blocks and nothing is reduced across workers, so the same emit sequence gives
+// bit identical data for any numWorkers, see GridChecksumCpuGrid().
+// Combustion and the pressure passes run SSE2 kernels over the rows of level 0 blocks, with
+// the operations of the scalar path in the same order, so the data does not depend on SIMD support either.
+//
+// With maxLevel above 0, blocks far from the camera or without detail are stored and
+// simulated at blockDim >> level cells per axis. The block table then carries the level,
+// see NV_FLOW_VIRTUAL_TO_REAL_LOD, and format.y of the export table params is NV_FLOW_TABLE_LEVELS_ON.
+
+struct CpuGrid;
+
+static const NvFlowUint CpuGridBlockDimBits = 3u;
+static const NvFlowUint CpuGridBlockDim = 1u << CpuGridBlockDimBits;
+static const NvFlowUint CpuGridMaxLevel = NV_FLOW_TABLE_MAX_LEVEL;
+
+struct CpuGridDesc
+{
+	NvFlowGridDesc gridDesc;			//!< Bounding box, virtual dimension and resident scale, as for NvFlowCreateGrid()
+	NvFlowUint numWorkers;				//!< Worker threads to use, 0 selects the hardware concurrency
+	const TaskDispatchInterface* taskDispatch;	//!< Engine job system to run on instead of own workers, nullptr uses numWorkers
+	NvFlowUint pressureIterations;		//!< Jacobi iterations per pressure solve
+	NvFlowUint maxLevel;				//!< Coarsest block level, 0 disables spatial LOD, at most CpuGridMaxLevel
+};
+
+struct CpuGridLodParams
+{
+	NvFlowFloat3 cameraPosition;		//!< Distance to blocks is measured from here
+	float levelDistance;				//!< Blocks drop to level 1 beyond this distance, level 2 beyond twice it, 0 disables
+	float detailThreshold;				//!< Blocks with more variation than this stay at level 0
+};
+
+struct CpuGridExport
+{
+	NvFlowGridExportImportLayeredMapping mapping;	//!< Same mapping as a single layer GPU export
+	NvFlowShaderTableParams tableParams;	//!< 32 bit table, with levels when maxLevel is above 0
+
+	const NvFlowUint* blockTable;		//!< Virtual block to pool block, NvFlow_tableVal_to_coord() encoded
+	const NvFlowUint* blockList;		//!< Active virtual blocks, NvFlow_tableVal_to_coord() encoded
+	NvFlowUint numBlocks;				//!< Number of active blocks
+
+	const NvFlowFloat4* velocity;		//!< Velocity pool, xyz world units per second
+	const NvFlowFloat4* density;		//!< Density pool, (temperature, fuel, burn, smoke)
+	NvFlowDim poolDim;					//!< Pool dimension in cells
+
+	NvFlowUint numBlocksPerLevel[CpuGridMaxLevel + 1u];	//!< Active blocks at each level
+};
+
+void CpuGridDescDefaults(CpuGridDesc* desc);
+
+void CpuGridParamsDefaults(NvFlowGridParams* params);
+
+void CpuGridMaterialParamsDefaults(NvFlowGridMaterialParams* params);
+
+void CpuGridEmitParamsDefaults(NvFlowGridEmitParams* params);
+
+void CpuGridLodParamsDefaults(CpuGridLodParams* params);
+
+CpuGrid* CpuGridCreate(const CpuGridDesc* desc);
+
+void CpuGridRelease(CpuGrid* grid);
+
+void CpuGridReset(CpuGrid* grid);
+
+void CpuGridSetParams(CpuGrid* grid, const NvFlowGridParams* params);
+
+void CpuGridSetMaterialParams(CpuGrid* grid, const NvFlowGridMaterialParams* params);
+
+void CpuGridSetLodParams(CpuGrid* grid, const CpuGridLodParams* params);
+
+void CpuGridEmit(CpuGrid* grid, const NvFlowShapeDesc* shapes, NvFlowUint numShapes, const NvFlowGridEmitParams* params, NvFlowUint numParams);
+
+void CpuGridUpdate(CpuGrid* grid, float dt);
+
+//! Bytes CpuGridSnapshot() needs for the current state
+size_t CpuGridGetSnapshotSize(CpuGrid* grid);
+
+/**
+ * Capture the grid state for a later CpuGridRestore().
+ *
+ * Only active blocks are written, at their stored level, with velocity, density and pressure
+ * in separate sections so the buffer compresses well. Params, material and LOD params are included.
+ *
+ * @param[in] grid The CPU grid.
+ * @param[out] data Destination of at least CpuGridGetSnapshotSize() bytes.
+ * @param[in] sizeInBytes Size of data.
+ *
+ * @return Returns false if data is too small.
+ */
+bool CpuGridSnapshot(CpuGrid* grid, void* data, size_t sizeInBytes);
+
+/**
+ * Replace the grid state with a snapshot, pending emits are dropped.
+ *
+ * Updates after a restore match the run the snapshot was taken from bit for bit.
+ * The grid must have the same virtual dimension, and room in its pool for the blocks.
+ *
+ * @param[in] grid The CPU grid.
+ * @param[in] data Snapshot written by CpuGridSnapshot().
+ * @param[in] sizeInBytes Size of data.
+ *
+ * @return Returns false if the snapshot does not fit this grid, a partially restored grid is reset.
+ */
+bool CpuGridRestore(CpuGrid* grid, const void* data, size_t sizeInBytes);
+
+void CpuGridGetExport(CpuGrid* grid, CpuGridExport* gridExport);
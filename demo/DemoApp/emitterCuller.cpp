@@ -0,0 +1,300 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <math.h>
+
+#include <algorithm>
+#include <mutex>
+
+#include "NvFlowShaderCPU.h"
+
+#include "emitterCuller.h"
+#include "taskDispatch.h"
+
+namespace
+{
+	// emitters spanning more hash cells than this are tested against every active block
+	static const int hugeEmitterCells = 64;
+
+	// fewest emitters and blocks per task
+	static const NvFlowUint emitterGrainSize = 256u;
+	static const NvFlowUint blockGrainSize = 64u;
+
+	enum EmitterClass : unsigned char
+	{
+		eEmitterOutside = 0,
+		eEmitterAllocates = 1,
+		eEmitterHuge = 2,
+		eEmitterHashed = 3
+	};
+
+	bool overlaps(const NvFlowFloat3& aMin, const NvFlowFloat3& aMax, const NvFlowFloat3& bMin, const NvFlowFloat3& bMax)
+	{
+		return aMin.x <= bMax.x && aMin.y <= bMax.y && aMin.z <= bMax.z &&
+			bMin.x <= aMax.x && bMin.y <= aMax.y && bMin.z <= aMax.z;
+	}
+
+	void tableValToCoord(NvFlowUint val, int* x, int* y, int* z)
+	{
+		NvFlowInt3 coord = NvFlowCPU_tableVal_to_coord(val);
+		*x = coord.x;
+		*y = coord.y;
+		*z = coord.z;
+	}
+}
+
+void EmitterCuller::updateGrid(const NvFlowGridExportImportLayeredMapping& mapping)
+{
+	const NvFlowShaderLinearParams& shaderParams = mapping.shaderParams;
+
+	// grid NDC to world is axis aligned scale and offset
+	m_gridOffset = { mapping.modelMatrix.w.x, mapping.modelMatrix.w.y, mapping.modelMatrix.w.z };
+	m_gridScale = { fabsf(mapping.modelMatrix.x.x), fabsf(mapping.modelMatrix.y.y), fabsf(mapping.modelMatrix.z.z) };
+	m_gridDim = shaderParams.gridDim;
+	m_blockSize.x = 2.f * m_gridScale.x * float(shaderParams.blockDim.x) * shaderParams.vdimInv.x;
+	m_blockSize.y = 2.f * m_gridScale.y * float(shaderParams.blockDim.y) * shaderParams.vdimInv.y;
+	m_blockSize.z = 2.f * m_gridScale.z * float(shaderParams.blockDim.z) * shaderParams.vdimInv.z;
+
+	m_activeBlocks.resize(mapping.layeredNumBlocks);
+	for (NvFlowUint idx = 0u; idx < mapping.layeredNumBlocks; idx++)
+	{
+		m_activeBlocks[idx] = mapping.layeredBlockListCPU[idx].x;
+	}
+	// layers can share blocks
+	std::sort(m_activeBlocks.begin(), m_activeBlocks.end());
+	m_activeBlocks.erase(std::unique(m_activeBlocks.begin(), m_activeBlocks.end()), m_activeBlocks.end());
+
+	m_gridValid = m_blockSize.x > 0.f && m_blockSize.y > 0.f && m_blockSize.z > 0.f;
+}
+
+void EmitterCuller::invalidateGrid()
+{
+	m_gridValid = false;
+	m_activeBlocks.clear();
+}
+
+bool EmitterCuller::allocates(const NvFlowGridEmitParams& params) const
+{
+	// a zero scale on any axis gives empty allocation bounds, as in the grid
+	return !(params.emitMode & eNvFlowGridEmitModeDisableAlloc) &&
+		params.allocationScale.x > 0.f && params.allocationScale.y > 0.f && params.allocationScale.z > 0.f;
+}
+
+void EmitterCuller::computeBounds(const NvFlowGridEmitParams& params, NvFlowFloat3* boundsMin, NvFlowFloat3* boundsMax) const
+{
+	// allocating emitters reach as far as their allocation bounds
+	NvFlowFloat3 s = { 1.f, 1.f, 1.f };
+	if (allocates(params))
+	{
+		s.x = fmaxf(s.x, params.allocationScale.x);
+		s.y = fmaxf(s.y, params.allocationScale.y);
+		s.z = fmaxf(s.z, params.allocationScale.z);
+	}
+
+	const NvFlowFloat4x4& m = params.bounds;
+	NvFlowFloat3 center = { m.w.x, m.w.y, m.w.z };
+	NvFlowFloat3 extent = {
+		s.x * fabsf(m.x.x) + s.y * fabsf(m.y.x) + s.z * fabsf(m.z.x),
+		s.x * fabsf(m.x.y) + s.y * fabsf(m.y.y) + s.z * fabsf(m.z.y),
+		s.x * fabsf(m.x.z) + s.y * fabsf(m.y.z) + s.z * fabsf(m.z.z)
+	};
+	*boundsMin = { center.x - extent.x, center.y - extent.y, center.z - extent.z };
+	*boundsMax = { center.x + extent.x, center.y + extent.y, center.z + extent.z };
+}
+
+NvFlowUint EmitterCuller::hashCell(int x, int y, int z) const
+{
+	return NvFlowUint(x) * 73856093u ^ NvFlowUint(y) * 19349663u ^ NvFlowUint(z) * 83492791u;
+}
+
+void EmitterCuller::cellRange(const NvFlowFloat3& boundsMin, const NvFlowFloat3& boundsMax, int* cmin, int* cmax) const
+{
+	// cells line up with grid blocks
+	NvFlowFloat3 gridMin = { m_gridOffset.x - m_gridScale.x, m_gridOffset.y - m_gridScale.y, m_gridOffset.z - m_gridScale.z };
+	const float* bmin = &boundsMin.x;
+	const float* bmax = &boundsMax.x;
+	const float* gmin = &gridMin.x;
+	const float* size = &m_blockSize.x;
+	const NvFlowUint* dim = &m_gridDim.x;
+	for (int c = 0; c < 3; c++)
+	{
+		cmin[c] = std::max(int(floorf((bmin[c] - gmin[c]) / size[c])), 0);
+		cmax[c] = std::min(int(floorf((bmax[c] - gmin[c]) / size[c])), int(dim[c]) - 1);
+	}
+}
+
+NvFlowUint EmitterCuller::cull(const NvFlowGridEmitParams* params, NvFlowUint numParams, std::vector<unsigned char>& visible)
+{
+	visible.assign(numParams, 0u);
+
+	if (!m_enabled || !m_gridValid)
+	{
+		visible.assign(numParams, 1u);
+		m_statSubmitted = numParams;
+		m_statCulled = 0u;
+		return numParams;
+	}
+
+	NvFlowFloat3 gridMin = { m_gridOffset.x - m_gridScale.x, m_gridOffset.y - m_gridScale.y, m_gridOffset.z - m_gridScale.z };
+	NvFlowFloat3 gridMax = { m_gridOffset.x + m_gridScale.x, m_gridOffset.y + m_gridScale.y, m_gridOffset.z + m_gridScale.z };
+
+	m_emitterMin.resize(numParams);
+	m_emitterMax.resize(numParams);
+	m_emitterClass.resize(numParams);
+	m_entries.clear();
+	m_hugeEmitters.clear();
+
+	// bounds are independent per emitter
+	TaskDispatchRange(m_taskDispatch, numParams, emitterGrainSize, [&](NvFlowUint begin, NvFlowUint end)
+	{
+		for (NvFlowUint emitterIdx = begin; emitterIdx < end; emitterIdx++)
+		{
+			computeBounds(params[emitterIdx], &m_emitterMin[emitterIdx], &m_emitterMax[emitterIdx]);
+			if (!overlaps(m_emitterMin[emitterIdx], m_emitterMax[emitterIdx], gridMin, gridMax))
+			{
+				m_emitterClass[emitterIdx] = eEmitterOutside;
+			}
+			// allocating emitters create blocks, so only the grid bounds apply
+			else if (allocates(params[emitterIdx]))
+			{
+				m_emitterClass[emitterIdx] = eEmitterAllocates;
+			}
+			else
+			{
+				int cmin[3], cmax[3];
+				cellRange(m_emitterMin[emitterIdx], m_emitterMax[emitterIdx], cmin, cmax);
+				int numCells = (cmax[0] - cmin[0] + 1) * (cmax[1] - cmin[1] + 1) * (cmax[2] - cmin[2] + 1);
+				m_emitterClass[emitterIdx] = (numCells > hugeEmitterCells) ? eEmitterHuge : eEmitterHashed;
+			}
+		}
+	});
+
+	NvFlowUint numVisible = 0u;
+	for (NvFlowUint emitterIdx = 0u; emitterIdx < numParams; emitterIdx++)
+	{
+		if (m_emitterClass[emitterIdx] == eEmitterAllocates)
+		{
+			visible[emitterIdx] = 1u;
+			numVisible++;
+		}
+		else if (m_emitterClass[emitterIdx] == eEmitterHuge)
+		{
+			m_hugeEmitters.push_back(emitterIdx);
+		}
+		else if (m_emitterClass[emitterIdx] == eEmitterHashed)
+		{
+			int cmin[3], cmax[3];
+			cellRange(m_emitterMin[emitterIdx], m_emitterMax[emitterIdx], cmin, cmax);
+			for (int z = cmin[2]; z <= cmax[2]; z++)
+			{
+				for (int y = cmin[1]; y <= cmax[1]; y++)
+				{
+					for (int x = cmin[0]; x <= cmax[0]; x++)
+					{
+						m_entries.push_back({ hashCell(x, y, z), emitterIdx });
+					}
+				}
+			}
+		}
+	}
+
+	// bucket entries with a counting sort
+	NvFlowUint numBuckets = 1u;
+	while (numBuckets < 2u * NvFlowUint(m_entries.size()))
+	{
+		numBuckets *= 2u;
+	}
+	const NvFlowUint bucketMask = numBuckets - 1u;
+	m_bucketBegin.assign(numBuckets + 1u, 0u);
+	for (const Entry& entry : m_entries)
+	{
+		m_bucketBegin[(entry.hash & bucketMask) + 1u]++;
+	}
+	for (NvFlowUint bucketIdx = 0u; bucketIdx < numBuckets; bucketIdx++)
+	{
+		m_bucketBegin[bucketIdx + 1u] += m_bucketBegin[bucketIdx];
+	}
+	m_bucketEntries.resize(m_entries.size());
+	m_bucketCursor.assign(m_bucketBegin.begin(), m_bucketBegin.end() - 1);
+	for (const Entry& entry : m_entries)
+	{
+		m_bucketEntries[m_bucketCursor[entry.hash & bucketMask]++] = entry.emitterIdx;
+	}
+
+	// query with each active block, tasks collect hits and visibility is applied after
+	m_hits.clear();
+	std::mutex hitsMutex;
+	TaskDispatchRange(m_taskDispatch, NvFlowUint(m_activeBlocks.size()), blockGrainSize, [&](NvFlowUint begin, NvFlowUint end)
+	{
+		std::vector<NvFlowUint> hits;
+		std::vector<unsigned char> hugeHit(m_hugeEmitters.size(), 0u);
+		for (NvFlowUint activeIdx = begin; activeIdx < end; activeIdx++)
+		{
+			int bx, by, bz;
+			tableValToCoord(m_activeBlocks[activeIdx], &bx, &by, &bz);
+			NvFlowFloat3 blockMin = {
+				gridMin.x + float(bx) * m_blockSize.x,
+				gridMin.y + float(by) * m_blockSize.y,
+				gridMin.z + float(bz) * m_blockSize.z
+			};
+			NvFlowFloat3 blockMax = { blockMin.x + m_blockSize.x, blockMin.y + m_blockSize.y, blockMin.z + m_blockSize.z };
+
+			NvFlowUint bucketIdx = hashCell(bx, by, bz) & bucketMask;
+			for (NvFlowUint entryIdx = m_bucketBegin[bucketIdx]; entryIdx < m_bucketBegin[bucketIdx + 1u]; entryIdx++)
+			{
+				NvFlowUint emitterIdx = m_bucketEntries[entryIdx];
+				if (overlaps(m_emitterMin[emitterIdx], m_emitterMax[emitterIdx], blockMin, blockMax))
+				{
+					hits.push_back(emitterIdx);
+				}
+			}
+			for (NvFlowUint hugeIdx = 0u; hugeIdx < m_hugeEmitters.size(); hugeIdx++)
+			{
+				NvFlowUint emitterIdx = m_hugeEmitters[hugeIdx];
+				if (!hugeHit[hugeIdx] && overlaps(m_emitterMin[emitterIdx], m_emitterMax[emitterIdx], blockMin, blockMax))
+				{
+					hugeHit[hugeIdx] = 1u;
+					hits.push_back(emitterIdx);
+				}
+			}
+		}
+		std::lock_guard<std::mutex> lock(hitsMutex);
+		m_hits.insert(m_hits.end(), hits.begin(), hits.end());
+	});
+	for (NvFlowUint emitterIdx : m_hits)
+	{
+		if (!visible[emitterIdx])
+		{
+			visible[emitterIdx] = 1u;
+			numVisible++;
+		}
+	}
+
+	m_statSubmitted = numVisible;
+	m_statCulled = numParams - numVisible;
+	return numVisible;
+}
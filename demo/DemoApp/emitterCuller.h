@@ -0,0 +1,86 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include <vector>
+
+#include "NvFlow.h"
+
+struct TaskDispatchInterface;
+
+// Culls emitters against the grid bounds and the active block set of the last grid export.
+// Emitter bounds are indexed with a uniform hash in world space, with cells the size of a
+// grid block, so each active block only tests the emitters hashed near it.
+struct EmitterCuller
+{
+	bool m_enabled = true;
+
+	// bounds and block queries split into tasks when set
+	const TaskDispatchInterface* m_taskDispatch = nullptr;
+
+	// grid state, from the last export
+	bool m_gridValid = false;
+	NvFlowFloat3 m_gridOffset = { 0.f, 0.f, 0.f };
+	NvFlowFloat3 m_gridScale = { 0.f, 0.f, 0.f };
+	NvFlowFloat3 m_blockSize = { 0.f, 0.f, 0.f };
+	NvFlowUint4 m_gridDim = { 0u, 0u, 0u, 0u };
+	std::vector<NvFlowUint> m_activeBlocks;
+
+	// emitter hash
+	struct Entry
+	{
+		NvFlowUint hash;
+		NvFlowUint emitterIdx;
+	};
+	std::vector<Entry> m_entries;
+	std::vector<NvFlowUint> m_bucketBegin;
+	std::vector<NvFlowUint> m_bucketEntries;
+	std::vector<NvFlowUint> m_bucketCursor;
+	std::vector<NvFlowFloat3> m_emitterMin;
+	std::vector<NvFlowFloat3> m_emitterMax;
+	std::vector<NvFlowUint> m_hugeEmitters;
+	std::vector<unsigned char> m_emitterClass;
+	std::vector<NvFlowUint> m_hits;
+
+	NvFlowUint m_statSubmitted = 0u;
+	NvFlowUint m_statCulled = 0u;
+
+	//! Captures grid bounds and active blocks, blockIdx in layeredBlockListCPU uses NvFlow_tableVal_to_coord() encoding
+	void updateGrid(const NvFlowGridExportImportLayeredMapping& mapping);
+
+	void invalidateGrid();
+
+	//! Writes one visibility flag per emitter, returns number visible
+	NvFlowUint cull(const NvFlowGridEmitParams* params, NvFlowUint numParams, std::vector<unsigned char>& visible);
+
+protected:
+	bool allocates(const NvFlowGridEmitParams& params) const;
+	void computeBounds(const NvFlowGridEmitParams& params, NvFlowFloat3* boundsMin, NvFlowFloat3* boundsMax) const;
+	NvFlowUint hashCell(int x, int y, int z) const;
+	void cellRange(const NvFlowFloat3& boundsMin, const NvFlowFloat3& boundsMax, int* cmin, int* cmax) const;
+};
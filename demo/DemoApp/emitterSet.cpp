@@ -0,0 +1,264 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include "emitterSet.h"
+#include "emitterCuller.h"
+
+EmitterHandle EmitterSet::add(const NvFlowShapeDesc& shape, const NvFlowGridEmitParams& params)
+{
+	NvFlowUint slot;
+	if (m_freeSlots.size() > 0u)
+	{
+		slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else
+	{
+		slot = NvFlowUint(m_slotToDense.size());
+		m_slotToDense.push_back(~0u);
+		m_slotGeneration.push_back(0u);
+	}
+
+	NvFlowUint denseIdx = NvFlowUint(m_params.size());
+	m_slotToDense[slot] = denseIdx;
+	m_denseToSlot.push_back(slot);
+	m_shapes.push_back(shape);
+	m_params.push_back(params);
+	m_dirtyMask.push_back(0u);
+
+	m_structureDirty = true;
+
+	EmitterHandle handle;
+	handle.slot = slot;
+	handle.generation = m_slotGeneration[slot];
+	return handle;
+}
+
+bool EmitterSet::isValid(EmitterHandle handle) const
+{
+	return handle.slot < m_slotToDense.size() &&
+		m_slotGeneration[handle.slot] == handle.generation &&
+		m_slotToDense[handle.slot] != ~0u;
+}
+
+bool EmitterSet::remove(EmitterHandle handle)
+{
+	if (!isValid(handle))
+	{
+		return false;
+	}
+
+	// swap with the last emitter to keep arrays dense
+	NvFlowUint denseIdx = m_slotToDense[handle.slot];
+	NvFlowUint lastIdx = NvFlowUint(m_params.size()) - 1u;
+	if (denseIdx != lastIdx)
+	{
+		m_shapes[denseIdx] = m_shapes[lastIdx];
+		m_params[denseIdx] = m_params[lastIdx];
+		m_denseToSlot[denseIdx] = m_denseToSlot[lastIdx];
+		m_slotToDense[m_denseToSlot[denseIdx]] = denseIdx;
+	}
+	m_shapes.pop_back();
+	m_params.pop_back();
+	m_denseToSlot.pop_back();
+	m_dirtyMask.pop_back();
+
+	m_slotToDense[handle.slot] = ~0u;
+	m_slotGeneration[handle.slot]++;
+	m_freeSlots.push_back(handle.slot);
+
+	m_structureDirty = true;
+	return true;
+}
+
+bool EmitterSet::update(EmitterHandle handle, const NvFlowShapeDesc* shape, const NvFlowGridEmitParams* params)
+{
+	if (!isValid(handle))
+	{
+		return false;
+	}
+
+	NvFlowUint denseIdx = m_slotToDense[handle.slot];
+	if (shape)
+	{
+		m_shapes[denseIdx] = *shape;
+	}
+	if (params)
+	{
+		m_params[denseIdx] = *params;
+	}
+	markDirty(denseIdx);
+	return true;
+}
+
+const NvFlowGridEmitParams* EmitterSet::getParams(EmitterHandle handle) const
+{
+	return isValid(handle) ? &m_params[m_slotToDense[handle.slot]] : nullptr;
+}
+
+void EmitterSet::markDirty(NvFlowUint denseIdx)
+{
+	if (!m_structureDirty && !m_dirtyMask[denseIdx])
+	{
+		m_dirtyMask[denseIdx] = 1u;
+		m_dirty.push_back(denseIdx);
+	}
+}
+
+void EmitterSet::clear()
+{
+	m_shapes.clear();
+	m_params.clear();
+	m_denseToSlot.clear();
+	m_dirtyMask.clear();
+	m_dirty.clear();
+
+	// bump generations so outstanding handles go stale
+	m_freeSlots.clear();
+	for (NvFlowUint slot = NvFlowUint(m_slotToDense.size()); slot > 0u; slot--)
+	{
+		m_slotToDense[slot - 1u] = ~0u;
+		m_slotGeneration[slot - 1u]++;
+		m_freeSlots.push_back(slot - 1u);
+	}
+
+	m_transientShapes.clear();
+	m_transientParams.clear();
+
+	m_structureDirty = true;
+}
+
+void EmitterSet::emitTransient(const NvFlowShapeDesc& shape, const NvFlowGridEmitParams& params)
+{
+	m_transientShapes.push_back(shape);
+	m_transientParams.push_back(params);
+}
+
+NvFlowUint EmitterSet::gather(float dt, EmitterCuller* culler, const NvFlowShapeDesc** pShapes, const NvFlowGridEmitParams** pParams)
+{
+	const NvFlowUint numPersistent = NvFlowUint(m_params.size());
+	const NvFlowUint numTransient = NvFlowUint(m_transientParams.size());
+
+	if (m_structureDirty)
+	{
+		m_submitShapes.assign(m_shapes.begin(), m_shapes.end());
+		m_submitParams.assign(m_params.begin(), m_params.end());
+		for (NvFlowUint idx = 0u; idx < numPersistent; idx++)
+		{
+			m_submitParams[idx].shapeRangeOffset = idx;
+			m_submitParams[idx].shapeRangeSize = 1u;
+			m_submitParams[idx].deltaTime = dt;
+		}
+	}
+	else
+	{
+		// transients from the last submit sit past the persistent range
+		m_submitShapes.resize(numPersistent);
+		m_submitParams.resize(numPersistent);
+		for (NvFlowUint idx : m_dirty)
+		{
+			m_submitShapes[idx] = m_shapes[idx];
+			m_submitParams[idx] = m_params[idx];
+			m_submitParams[idx].shapeRangeOffset = idx;
+			m_submitParams[idx].shapeRangeSize = 1u;
+			m_submitParams[idx].deltaTime = dt;
+		}
+		if (m_submitDeltaTime != dt)
+		{
+			for (NvFlowUint idx = 0u; idx < numPersistent; idx++)
+			{
+				m_submitParams[idx].deltaTime = dt;
+			}
+		}
+	}
+	for (NvFlowUint idx : m_dirty)
+	{
+		if (idx < numPersistent)
+		{
+			m_dirtyMask[idx] = 0u;
+		}
+	}
+	m_dirty.clear();
+	m_structureDirty = false;
+	m_submitDeltaTime = dt;
+	m_numPersistent = numPersistent;
+
+	for (NvFlowUint idx = 0u; idx < numTransient; idx++)
+	{
+		m_submitShapes.push_back(m_transientShapes[idx]);
+		m_submitParams.push_back(m_transientParams[idx]);
+		m_submitParams.back().shapeRangeOffset = numPersistent + idx;
+		m_submitParams.back().shapeRangeSize = 1u;
+	}
+	m_transientShapes.clear();
+	m_transientParams.clear();
+
+	const NvFlowShapeDesc* shapes = m_submitShapes.data();
+	const NvFlowGridEmitParams* params = m_submitParams.data();
+	m_numSubmitted = NvFlowUint(m_submitParams.size());
+
+	if (culler && culler->cull(params, m_numSubmitted, m_visible) < m_numSubmitted)
+	{
+		m_culledShapes.clear();
+		m_culledParams.clear();
+		for (NvFlowUint idx = 0u; idx < m_numSubmitted; idx++)
+		{
+			if (m_visible[idx])
+			{
+				m_culledParams.push_back(params[idx]);
+				m_culledParams.back().shapeRangeOffset = NvFlowUint(m_culledShapes.size());
+				m_culledShapes.push_back(shapes[idx]);
+			}
+		}
+		shapes = m_culledShapes.data();
+		params = m_culledParams.data();
+		m_numSubmitted = NvFlowUint(m_culledParams.size());
+	}
+
+	*pShapes = shapes;
+	*pParams = params;
+	return m_numSubmitted;
+}
+
+void EmitterSet::submit(NvFlowGrid* grid, float dt, EmitterCuller* culler)
+{
+	const NvFlowShapeDesc* shapes = nullptr;
+	const NvFlowGridEmitParams* params = nullptr;
+	NvFlowUint numEmitters = gather(dt, culler, &shapes, &params);
+	if (numEmitters > 0u)
+	{
+		NvFlowGridEmit(grid, shapes, numEmitters, params, numEmitters);
+	}
+}
+
+void EmitterSet::release()
+{
+	clear();
+	m_submitShapes.clear();
+	m_submitParams.clear();
+	m_numSubmitted = 0u;
+}
@@ -0,0 +1,111 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include <vector>
+
+#include "NvFlow.h"
+
+struct EmitterCuller;
+
+//! Stable reference to an emitter in an EmitterSet
+struct EmitterHandle
+{
+	NvFlowUint slot = ~0u;
+	NvFlowUint generation = 0u;
+};
+
+// Persistent set of emitters, submitted to the grid with a single NvFlowGridEmit() call.
+// Emitter state is kept densely packed, one shape per emitter, so the submit arrays
+// can be handed to Flow directly. Edits go to the edit arrays, and only changed entries
+// are copied to the submit arrays, which stay untouched between submits.
+//
+// The arrays are arrays of NvFlowGridEmitParams rather than one array per field, because
+// NvFlowGridEmit() takes them that way: split fields would have to be interleaved again
+// on every submit, touching every emitter, where now a frame costs only what changed.
+// The one field written for all emitters, deltaTime, is patched in place when dt changes.
+struct EmitterSet
+{
+	// edit state, dense
+	std::vector<NvFlowShapeDesc> m_shapes;
+	std::vector<NvFlowGridEmitParams> m_params;
+	std::vector<NvFlowUint> m_denseToSlot;
+
+	// handle slots
+	std::vector<NvFlowUint> m_slotToDense;
+	std::vector<NvFlowUint> m_slotGeneration;
+	std::vector<NvFlowUint> m_freeSlots;
+
+	// submit state
+	std::vector<NvFlowShapeDesc> m_submitShapes;
+	std::vector<NvFlowGridEmitParams> m_submitParams;
+	std::vector<NvFlowUint> m_dirty;
+	std::vector<unsigned char> m_dirtyMask;
+	bool m_structureDirty = false;
+	float m_submitDeltaTime = 0.f;
+	NvFlowUint m_numPersistent = 0u;
+
+	// emitters valid for one submit only
+	std::vector<NvFlowShapeDesc> m_transientShapes;
+	std::vector<NvFlowGridEmitParams> m_transientParams;
+
+	// emitters surviving culling
+	std::vector<unsigned char> m_visible;
+	std::vector<NvFlowShapeDesc> m_culledShapes;
+	std::vector<NvFlowGridEmitParams> m_culledParams;
+
+	NvFlowUint m_numSubmitted = 0u;
+
+	EmitterHandle add(const NvFlowShapeDesc& shape, const NvFlowGridEmitParams& params);
+
+	bool remove(EmitterHandle handle);
+
+	bool update(EmitterHandle handle, const NvFlowShapeDesc* shape, const NvFlowGridEmitParams* params);
+
+	bool isValid(EmitterHandle handle) const;
+
+	const NvFlowGridEmitParams* getParams(EmitterHandle handle) const;
+
+	NvFlowUint size() const { return NvFlowUint(m_params.size()); }
+
+	void clear();
+
+	//! Adds an emitter for the next submit only, deltaTime is kept as provided
+	void emitTransient(const NvFlowShapeDesc& shape, const NvFlowGridEmitParams& params);
+
+	//! Builds the submit arrays as submit() would, without emitting, returns the number of emitters
+	NvFlowUint gather(float dt, EmitterCuller* culler, const NvFlowShapeDesc** pShapes, const NvFlowGridEmitParams** pParams);
+
+	//! Submits all emitters, persistent emitters get deltaTime set to dt, culler is optional
+	void submit(NvFlowGrid* grid, float dt, EmitterCuller* culler = nullptr);
+
+	void release();
+
+protected:
+	void markDirty(NvFlowUint denseIdx);
+};
@@ -0,0 +1,179 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <math.h>
+
+#include "gridBudget.h"
+
+namespace
+{
+	// velocity and density are stored as fp16 float4
+	static const float bytesPerVelocityCell = 8.f;
+	static const float bytesPerDensityCell = 8.f;
+
+	static const float minResidentScale = 1.f / 4096.f;
+
+	// components with a zero threshold still need one to scale
+	static const float minAllocThreshold = 0.01f;
+
+	// occupancy that counts as a full pool
+	static const float saturatedOccupancy = 0.99f;
+
+	float clamp01(float v)
+	{
+		return v < 0.f ? 0.f : (v > 1.f ? 1.f : v);
+	}
+}
+
+void GridBudgetPolicyDefaults(GridBudgetPolicy* policy)
+{
+	// smoke is what is seen, fuel and temperature give way first
+	policy->priority[eGridBudgetVelocity] = 2.f;
+	policy->priority[eGridBudgetSmoke] = 3.f;
+	policy->priority[eGridBudgetTemperature] = 1.f;
+	policy->priority[eGridBudgetFuel] = 0.f;
+	policy->highWater = 0.9f;
+	policy->lowWater = 0.7f;
+	policy->response = 0.5f;
+	policy->maxThresholdScale = 16.f;
+	policy->minWeightScale = 0.25f;
+}
+
+GridBudget::GridBudget()
+{
+	GridBudgetPolicyDefaults(&m_policy);
+}
+
+float GridBudget::bytesPerCell(const NvFlowGridDesc& gridDesc) const
+{
+	float densityCells = (gridDesc.densityMultiRes == eNvFlowMultiRes2x2x2) ? 8.f : 1.f;
+	return m_overheadFactor * (bytesPerVelocityCell + densityCells * bytesPerDensityCell);
+}
+
+float GridBudget::residentScale(const NvFlowGridDesc& gridDesc) const
+{
+	double virtualCells = double(gridDesc.virtualDim.x) * double(gridDesc.virtualDim.y) * double(gridDesc.virtualDim.z);
+	if (virtualCells <= 0.0)
+	{
+		return minResidentScale;
+	}
+	double scale = double(m_budgetBytes) / (virtualCells * double(bytesPerCell(gridDesc)));
+	if (scale < minResidentScale) scale = minResidentScale;
+	if (scale > 1.0) scale = 1.0;
+	return float(scale);
+}
+
+size_t GridBudget::poolBytes(const NvFlowGridDesc& gridDesc, float residentScale) const
+{
+	double virtualCells = double(gridDesc.virtualDim.x) * double(gridDesc.virtualDim.y) * double(gridDesc.virtualDim.z);
+	return size_t(virtualCells * double(residentScale) * double(bytesPerCell(gridDesc)));
+}
+
+void GridBudget::updateOccupancy(NvFlowUint numBlocks, NvFlowUint maxBlocks)
+{
+	float occupancy = maxBlocks > 0u ? float(numBlocks) / float(maxBlocks) : 0.f;
+	// velocity and density are fed separately, the fuller one wins until the next update
+	if (occupancy > m_occupancy)
+	{
+		m_occupancy = occupancy;
+	}
+}
+
+void GridBudget::update(float dt)
+{
+	if (!m_enabled)
+	{
+		reset();
+		return;
+	}
+
+	if (m_occupancy > m_policy.highWater)
+	{
+		float over = (m_occupancy - m_policy.highWater) / fmaxf(1.f - m_policy.highWater, 0.01f);
+		m_pressure = clamp01(m_pressure + m_policy.response * dt * fmaxf(over, 0.25f));
+	}
+	else if (m_occupancy < m_policy.lowWater)
+	{
+		m_pressure = clamp01(m_pressure - m_policy.response * dt);
+	}
+
+	m_statSaturated = m_occupancy >= saturatedOccupancy && m_pressure >= 1.f;
+	m_statSaturatedFrames = m_statSaturated ? m_statSaturatedFrames + 1u : 0u;
+
+	m_occupancy = 0.f;
+}
+
+float GridBudget::componentShare(int component) const
+{
+	// pressure is spent on components from lowest priority up
+	int rank = 0;
+	for (int idx = 0; idx < eGridBudgetComponentCount; idx++)
+	{
+		float p = m_policy.priority[idx];
+		float q = m_policy.priority[component];
+		if (p < q || (p == q && idx < component))
+		{
+			rank++;
+		}
+	}
+	return clamp01(m_pressure * float(eGridBudgetComponentCount) - float(rank));
+}
+
+void GridBudget::apply(NvFlowGridMaterialParams* params) const
+{
+	if (!m_enabled || m_pressure <= 0.f)
+	{
+		return;
+	}
+
+	NvFlowGridMaterialPerComponent* components[eGridBudgetComponentCount] = {
+		&params->velocity,
+		&params->smoke,
+		&params->temperature,
+		&params->fuel
+	};
+	for (int idx = 0; idx < eGridBudgetComponentCount; idx++)
+	{
+		float share = componentShare(idx);
+		if (share <= 0.f)
+		{
+			continue;
+		}
+		NvFlowGridMaterialPerComponent& component = *components[idx];
+		float threshold = fmaxf(component.allocThreshold, minAllocThreshold);
+		component.allocThreshold = threshold * (1.f + share * (m_policy.maxThresholdScale - 1.f));
+		component.allocWeight *= 1.f - share * (1.f - m_policy.minWeightScale);
+	}
+}
+
+void GridBudget::reset()
+{
+	m_pressure = 0.f;
+	m_occupancy = 0.f;
+	m_statSaturated = false;
+	m_statSaturatedFrames = 0u;
+}
@@ -0,0 +1,99 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "NvFlow.h"
+
+//! Material components in the order of NvFlowGridMaterialParams
+enum GridBudgetComponent
+{
+	eGridBudgetVelocity = 0,
+	eGridBudgetSmoke = 1,
+	eGridBudgetTemperature = 2,
+	eGridBudgetFuel = 3,
+
+	eGridBudgetComponentCount = 4
+};
+
+//! Decides which blocks give way first when the pool fills up
+struct GridBudgetPolicy
+{
+	float priority[eGridBudgetComponentCount];	//!< Higher priority components keep their blocks longer
+	float highWater;							//!< Occupancy above which pressure builds
+	float lowWater;								//!< Occupancy below which pressure releases
+	float response;								//!< Pressure change per second
+	float maxThresholdScale;					//!< allocThreshold multiplier at full pressure
+	float minWeightScale;						//!< allocWeight multiplier at full pressure
+};
+
+void GridBudgetPolicyDefaults(GridBudgetPolicy* policy);
+
+// Residency manager for a grid with a byte budget.
+//
+// The block pool is sized from the budget when the grid is created, see residentScale().
+// At runtime occupancy from the grid stats drives a pressure value that raises allocThreshold
+// and lowers allocWeight of the lowest priority components first, so the least important blocks
+// are released before Flow starts refusing allocation.
+struct GridBudget
+{
+	bool m_enabled = true;
+	size_t m_budgetBytes = 256ull * 1024ull * 1024ull;
+	float m_overheadFactor = 4.f;		//!< Estimated texture copies per channel, ping pong and temporaries
+	GridBudgetPolicy m_policy;
+
+	float m_pressure = 0.f;
+	float m_occupancy = 0.f;
+
+	bool m_statSaturated = false;		//!< Pool full at full pressure, allocation is being dropped
+	NvFlowUint m_statSaturatedFrames = 0u;
+
+	GridBudget();
+
+	//! Estimated bytes per resident velocity cell, including density
+	float bytesPerCell(const NvFlowGridDesc& gridDesc) const;
+
+	//! Resident scale that fits the budget, clamped to the range Flow accepts
+	float residentScale(const NvFlowGridDesc& gridDesc) const;
+
+	//! Estimated pool size for a resident scale
+	size_t poolBytes(const NvFlowGridDesc& gridDesc, float residentScale) const;
+
+	//! Feeds latest occupancy, in active blocks over max blocks
+	void updateOccupancy(NvFlowUint numBlocks, NvFlowUint maxBlocks);
+
+	//! Integrates pressure, call once per simulation step
+	void update(float dt);
+
+	//! Applies pressure to a copy of the user material params
+	void apply(NvFlowGridMaterialParams* params) const;
+
+	void reset();
+
+protected:
+	float componentShare(int component) const;
+};
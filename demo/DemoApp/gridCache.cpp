@@ -0,0 +1,646 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "NvFlowShaderCPU.h"
+
+#include "gridCache.h"
+#include "cpuGrid.h"
+
+namespace
+{
+	FILE* openFile(const char* filename, const char* mode)
+	{
+#if defined(_WIN32)
+		FILE* file = nullptr;
+		fopen_s(&file, filename, mode);
+		return file;
+#else
+		return fopen(filename, mode);
+#endif
+	}
+
+	NvFlowUint64 align8(NvFlowUint64 v)
+	{
+		return (v + 7u) & ~NvFlowUint64(7u);
+	}
+
+	bool sameCell(const NvFlowFloat4& a, const NvFlowFloat4& b)
+	{
+		return memcmp(&a, &b, sizeof(NvFlowFloat4)) == 0;
+	}
+
+	void tableValToCoord(NvFlowUint val, NvFlowUint* x, NvFlowUint* y, NvFlowUint* z)
+	{
+		NvFlowInt3 coord = NvFlowCPU_tableVal_to_coord(val);
+		*x = NvFlowUint(coord.x);
+		*y = NvFlowUint(coord.y);
+		*z = NvFlowUint(coord.z);
+	}
+
+	struct RunHeader
+	{
+		NvFlowUint count;
+	};
+}
+
+// ****************** Writer ************************
+
+struct GridCacheWriter
+{
+	FILE* m_file = nullptr;
+	NvFlowUint64 m_offset = 0u;
+	bool m_failed = false;				// a write failed, the file is never finalized
+	GridCacheFileHeader m_header;
+	std::vector<GridCacheFrameIndexEntry> m_frameIndex;
+
+	// per frame scratch
+	std::vector<unsigned char> m_frame;
+	std::vector<NvFlowFloat4> m_cells;
+
+	bool write(const void* data, NvFlowUint64 sizeInBytes)
+	{
+		if (!m_failed && fwrite(data, 1u, size_t(sizeInBytes), m_file) != size_t(sizeInBytes))
+		{
+			m_failed = true;
+		}
+		m_offset += sizeInBytes;
+		return !m_failed;
+	}
+
+	template <typename T>
+	NvFlowUint64 append(const T* data, NvFlowUint64 count)
+	{
+		NvFlowUint64 offset = m_frame.size();
+		m_frame.resize(size_t(offset + count * sizeof(T)));
+		memcpy(m_frame.data() + offset, data, size_t(count * sizeof(T)));
+		return offset;
+	}
+
+	void pad8()
+	{
+		m_frame.resize(size_t(align8(m_frame.size())));
+	}
+
+	void encodeBlock(const NvFlowFloat4* cells, NvFlowUint numCells);
+};
+
+void GridCacheWriter::encodeBlock(const NvFlowFloat4* cells, NvFlowUint numCells)
+{
+	NvFlowUint numRuns = 1u;
+	for (NvFlowUint idx = 1u; idx < numCells; idx++)
+	{
+		if (!sameCell(cells[idx], cells[idx - 1u]))
+		{
+			numRuns++;
+		}
+	}
+
+	GridCacheBlockHeader blockHeader;
+	if (numRuns == 1u)
+	{
+		blockHeader.codec = eGridCacheCodecConstant;
+		blockHeader.sizeInBytes = sizeof(NvFlowFloat4);
+		append(&blockHeader, 1u);
+		append(cells, 1u);
+	}
+	else if (numRuns * (sizeof(RunHeader) + sizeof(NvFlowFloat4)) < numCells * sizeof(NvFlowFloat4) * 3u / 4u)
+	{
+		blockHeader.codec = eGridCacheCodecRLE;
+		blockHeader.sizeInBytes = numRuns * (sizeof(RunHeader) + sizeof(NvFlowFloat4));
+		append(&blockHeader, 1u);
+		NvFlowUint runStart = 0u;
+		for (NvFlowUint idx = 1u; idx <= numCells; idx++)
+		{
+			if (idx == numCells || !sameCell(cells[idx], cells[runStart]))
+			{
+				RunHeader run = { idx - runStart };
+				append(&run, 1u);
+				append(&cells[runStart], 1u);
+				runStart = idx;
+			}
+		}
+	}
+	else
+	{
+		blockHeader.codec = eGridCacheCodecRaw;
+		blockHeader.sizeInBytes = numCells * sizeof(NvFlowFloat4);
+		append(&blockHeader, 1u);
+		append(cells, numCells);
+	}
+	pad8();
+}
+
+GridCacheWriter* GridCacheWriterCreate(const char* filename, const GridCacheDesc* desc)
+{
+	if (desc->numChannels == 0u || desc->numChannels > GridCacheMaxChannels)
+	{
+		return nullptr;
+	}
+
+	FILE* file = openFile(filename, "wb");
+	if (file == nullptr)
+	{
+		return nullptr;
+	}
+
+	GridCacheWriter* writer = new GridCacheWriter;
+	writer->m_file = file;
+
+	GridCacheFileHeader& header = writer->m_header;
+	memset(&header, 0, sizeof(header));
+	header.magic = GridCacheMagic;
+	header.version = GridCacheVersion;
+	header.numChannels = desc->numChannels;
+	header.numFrames = 0u;
+	header.blockDim = { desc->blockDim[0], desc->blockDim[1], desc->blockDim[2], desc->blockDim[0] * desc->blockDim[1] * desc->blockDim[2] };
+	header.gridDim = { desc->gridDim[0], desc->gridDim[1], desc->gridDim[2], 0u };
+	header.frameIndexOffset = 0u;
+
+	// patched on release
+	if (!writer->write(&header, sizeof(header)))
+	{
+		fclose(file);
+		delete writer;
+		return nullptr;
+	}
+
+	return writer;
+}
+
+bool GridCacheWriterAddFrame(GridCacheWriter* writer, const GridCacheFrameSource* frame)
+{
+	if (writer->m_failed || frame->numLayers > GridCacheMaxLayers)
+	{
+		return false;
+	}
+
+	const GridCacheFileHeader& header = writer->m_header;
+	const NvFlowUint numCells = header.blockDim.w;
+	const NvFlowUint numChannels = header.numChannels;
+
+	// order blocks by layer, so each layer is a contiguous range
+	std::vector<NvFlowUint2> blockList;
+	std::vector<GridCacheLayer> layers(frame->numLayers);
+	blockList.reserve(frame->numBlocks);
+	for (NvFlowUint layerIdx = 0u; layerIdx < frame->numLayers; layerIdx++)
+	{
+		layers[layerIdx].layerIdx = layerIdx;
+		layers[layerIdx].blockOffset = NvFlowUint(blockList.size());
+		layers[layerIdx].materialIdx = frame->layers[layerIdx].materialIdx;
+		for (NvFlowUint blockIdx = 0u; blockIdx < frame->numBlocks; blockIdx++)
+		{
+			if (frame->blockList[blockIdx].y == layerIdx)
+			{
+				blockList.push_back(frame->blockList[blockIdx]);
+			}
+		}
+		layers[layerIdx].numBlocks = NvFlowUint(blockList.size()) - layers[layerIdx].blockOffset;
+	}
+	const NvFlowUint numBlocks = NvFlowUint(blockList.size());
+
+	GridCacheFrameHeader frameHeader;
+	frameHeader.frameIdx = header.numFrames;
+	frameHeader.numLayers = frame->numLayers;
+	frameHeader.numBlocks = numBlocks;
+	frameHeader.time = frame->time;
+	frameHeader.modelMatrix = frame->modelMatrix;
+
+	writer->m_frame.clear();
+	writer->append(&frameHeader, 1u);
+	writer->append(layers.data(), layers.size());
+	writer->append(blockList.data(), blockList.size());
+	writer->pad8();
+	std::vector<NvFlowUint> blockOffsets(numChannels * numBlocks);
+	NvFlowUint64 blockOffsetsOffset = writer->append(blockOffsets.data(), blockOffsets.size());
+	writer->pad8();
+
+	writer->m_cells.resize(numCells);
+	for (NvFlowUint channelIdx = 0u; channelIdx < numChannels; channelIdx++)
+	{
+		for (NvFlowUint blockIdx = 0u; blockIdx < numBlocks; blockIdx++)
+		{
+			const GridCacheLayerSource& layer = frame->layers[blockList[blockIdx].y];
+			const NvFlowFloat4* pool = layer.channelData[channelIdx];
+
+			NvFlowUint vx, vy, vz;
+			tableValToCoord(blockList[blockIdx].x, &vx, &vy, &vz);
+			NvFlowUint tableValue = layer.blockTable[(vz * header.gridDim.y + vy) * header.gridDim.x + vx];
+			NvFlowUint level = NvFlowCPU_tableVal_to_level(tableValue);
+			NvFlowUint px, py, pz;
+			tableValToCoord(tableValue, &px, &py, &pz);
+
+			// coarse blocks are stored at full resolution, cells repeat
+			NvFlowUint cellIdx = 0u;
+			for (NvFlowUint k = 0u; k < header.blockDim.z; k++)
+			{
+				for (NvFlowUint j = 0u; j < header.blockDim.y; j++)
+				{
+					NvFlowUint rz = pz * (header.blockDim.z >> level) + (k >> level);
+					NvFlowUint ry = py * (header.blockDim.y >> level) + (j >> level);
+					NvFlowUint rx = px * (header.blockDim.x >> level);
+					const NvFlowFloat4* row = &pool[(size_t(rz) * frame->poolDim.y + ry) * frame->poolDim.x + rx];
+					if (level == 0u)
+					{
+						memcpy(&writer->m_cells[cellIdx], row, header.blockDim.x * sizeof(NvFlowFloat4));
+					}
+					else
+					{
+						for (NvFlowUint i = 0u; i < header.blockDim.x; i++)
+						{
+							writer->m_cells[cellIdx + i] = row[i >> level];
+						}
+					}
+					cellIdx += header.blockDim.x;
+				}
+			}
+
+			// payload offsets are 32 bit, a frame may hold at most 4 GB before its last payload
+			if (writer->m_frame.size() > NvFlowUint64(0xFFFFFFFFu))
+			{
+				return false;
+			}
+			blockOffsets[channelIdx * numBlocks + blockIdx] = NvFlowUint(writer->m_frame.size());
+			writer->encodeBlock(writer->m_cells.data(), numCells);
+		}
+	}
+	memcpy(writer->m_frame.data() + blockOffsetsOffset, blockOffsets.data(), blockOffsets.size() * sizeof(NvFlowUint));
+
+	GridCacheFrameIndexEntry entry;
+	entry.offset = writer->m_offset;
+	entry.sizeInBytes = writer->m_frame.size();
+	entry.time = frame->time;
+	entry.frameIdx = frameHeader.frameIdx;
+
+	if (!writer->write(writer->m_frame.data(), writer->m_frame.size()))
+	{
+		return false;
+	}
+	writer->m_frameIndex.push_back(entry);
+	writer->m_header.numFrames++;
+
+	return true;
+}
+
+bool GridCacheWriterAddCpuGridFrame(GridCacheWriter* writer, const CpuGridExport* gridExport, float time)
+{
+	GridCacheLayerSource layer = {};
+	layer.materialIdx = 0u;
+	layer.blockTable = gridExport->blockTable;
+	layer.channelData[0] = gridExport->velocity;
+	layer.channelData[1] = gridExport->density;
+
+	GridCacheFrameSource frame = {};
+	frame.time = time;
+	frame.modelMatrix = gridExport->mapping.modelMatrix;
+	frame.poolDim = gridExport->poolDim;
+	frame.blockList = gridExport->mapping.layeredBlockListCPU;
+	frame.numBlocks = gridExport->mapping.layeredNumBlocks;
+	frame.layers = &layer;
+	frame.numLayers = 1u;
+
+	return GridCacheWriterAddFrame(writer, &frame);
+}
+
+bool GridCacheWriterRelease(GridCacheWriter* writer)
+{
+	if (writer == nullptr) return false;
+
+	// the header on disk keeps frameIndexOffset 0 unless every write landed, readers reject that
+	GridCacheFileHeader& header = writer->m_header;
+	header.frameIndexOffset = writer->m_offset;
+	bool succeeded = writer->write(writer->m_frameIndex.data(), writer->m_frameIndex.size() * sizeof(GridCacheFrameIndexEntry));
+	if (succeeded)
+	{
+		succeeded = fseek(writer->m_file, 0, SEEK_SET) == 0 &&
+			fwrite(&header, sizeof(header), 1u, writer->m_file) == 1u;
+	}
+	succeeded = (fclose(writer->m_file) == 0) && succeeded;
+
+	delete writer;
+	return succeeded;
+}
+
+// ****************** Reader ************************
+
+struct GridCacheReader
+{
+#if defined(_WIN32)
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+#else
+	int m_file = -1;
+#endif
+	const unsigned char* m_data = nullptr;
+	NvFlowUint64 m_sizeInBytes = 0u;
+
+	const GridCacheFileHeader* m_header = nullptr;
+	const GridCacheFrameIndexEntry* m_frameIndex = nullptr;
+
+	bool map(const char* filename);
+	void unmap();
+	bool validate();
+};
+
+bool GridCacheReader::map(const char* filename)
+{
+#if defined(_WIN32)
+	m_file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+	{
+		return false;
+	}
+	m_sizeInBytes = NvFlowUint64(size.QuadPart);
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0u, 0u, nullptr);
+	if (m_mapping == nullptr)
+	{
+		return false;
+	}
+	m_data = (const unsigned char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0u, 0u, 0u);
+	return m_data != nullptr;
+#else
+	m_file = open(filename, O_RDONLY);
+	if (m_file < 0)
+	{
+		return false;
+	}
+	struct stat fileStat;
+	if (fstat(m_file, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		return false;
+	}
+	m_sizeInBytes = NvFlowUint64(fileStat.st_size);
+	void* data = mmap(nullptr, size_t(m_sizeInBytes), PROT_READ, MAP_SHARED, m_file, 0);
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+	m_data = (const unsigned char*)data;
+	return true;
+#endif
+}
+
+void GridCacheReader::unmap()
+{
+#if defined(_WIN32)
+	if (m_data) UnmapViewOfFile(m_data);
+	if (m_mapping) CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	if (m_data) munmap((void*)m_data, size_t(m_sizeInBytes));
+	if (m_file >= 0) close(m_file);
+	m_file = -1;
+#endif
+	m_data = nullptr;
+	m_sizeInBytes = 0u;
+}
+
+bool GridCacheReader::validate()
+{
+	if (m_sizeInBytes < sizeof(GridCacheFileHeader))
+	{
+		return false;
+	}
+	m_header = (const GridCacheFileHeader*)m_data;
+	if (m_header->magic != GridCacheMagic ||
+		m_header->version != GridCacheVersion ||
+		m_header->numChannels == 0u ||
+		m_header->numChannels > GridCacheMaxChannels ||
+		m_header->blockDim.w == 0u ||
+		m_header->blockDim.w != m_header->blockDim.x * m_header->blockDim.y * m_header->blockDim.z ||
+		m_header->frameIndexOffset == 0u ||
+		m_header->frameIndexOffset + NvFlowUint64(m_header->numFrames) * sizeof(GridCacheFrameIndexEntry) > m_sizeInBytes)
+	{
+		return false;
+	}
+	m_frameIndex = (const GridCacheFrameIndexEntry*)(m_data + m_header->frameIndexOffset);
+	for (NvFlowUint frameIdx = 0u; frameIdx < m_header->numFrames; frameIdx++)
+	{
+		if (m_frameIndex[frameIdx].offset + m_frameIndex[frameIdx].sizeInBytes > m_header->frameIndexOffset)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+GridCacheReader* GridCacheReaderOpen(const char* filename)
+{
+	GridCacheReader* reader = new GridCacheReader;
+	if (!reader->map(filename) || !reader->validate())
+	{
+		reader->unmap();
+		delete reader;
+		return nullptr;
+	}
+	return reader;
+}
+
+void GridCacheReaderRelease(GridCacheReader* reader)
+{
+	if (reader == nullptr) return;
+
+	reader->unmap();
+	delete reader;
+}
+
+const GridCacheFileHeader* GridCacheReaderGetHeader(GridCacheReader* reader)
+{
+	return reader->m_header;
+}
+
+NvFlowUint GridCacheReaderGetNumFrames(GridCacheReader* reader)
+{
+	return reader->m_header->numFrames;
+}
+
+const GridCacheFrameIndexEntry* GridCacheReaderGetFrameIndex(GridCacheReader* reader, NvFlowUint frameIdx)
+{
+	return frameIdx < reader->m_header->numFrames ? &reader->m_frameIndex[frameIdx] : nullptr;
+}
+
+bool GridCacheReaderGetFrame(GridCacheReader* reader, NvFlowUint frameIdx, GridCacheFrameView* view)
+{
+	const GridCacheFrameIndexEntry* entry = GridCacheReaderGetFrameIndex(reader, frameIdx);
+	if (entry == nullptr || entry->sizeInBytes < sizeof(GridCacheFrameHeader))
+	{
+		return false;
+	}
+
+	const unsigned char* base = reader->m_data + entry->offset;
+	const GridCacheFrameHeader* header = (const GridCacheFrameHeader*)base;
+
+	NvFlowUint64 offset = sizeof(GridCacheFrameHeader);
+	const GridCacheLayer* layers = (const GridCacheLayer*)(base + offset);
+	offset += header->numLayers * sizeof(GridCacheLayer);
+	const NvFlowUint2* blockList = (const NvFlowUint2*)(base + offset);
+	offset = align8(offset + header->numBlocks * sizeof(NvFlowUint2));
+	const NvFlowUint* blockOffsets = (const NvFlowUint*)(base + offset);
+	offset = align8(offset + NvFlowUint64(reader->m_header->numChannels) * header->numBlocks * sizeof(NvFlowUint));
+	if (header->numLayers > GridCacheMaxLayers || offset > entry->sizeInBytes)
+	{
+		return false;
+	}
+	for (NvFlowUint layerIdx = 0u; layerIdx < header->numLayers; layerIdx++)
+	{
+		if (NvFlowUint64(layers[layerIdx].blockOffset) + layers[layerIdx].numBlocks > header->numBlocks)
+		{
+			return false;
+		}
+	}
+	// players index block tables of gridDim with these coordinates
+	const NvFlowUint4 gridDim = reader->m_header->gridDim;
+	for (NvFlowUint blockIdx = 0u; blockIdx < header->numBlocks; blockIdx++)
+	{
+		NvFlowUint vx, vy, vz;
+		tableValToCoord(blockList[blockIdx].x, &vx, &vy, &vz);
+		if (vx >= gridDim.x || vy >= gridDim.y || vz >= gridDim.z || blockList[blockIdx].y >= header->numLayers)
+		{
+			return false;
+		}
+	}
+
+	view->header = header;
+	view->layers = layers;
+	view->blockList = blockList;
+	view->blockOffsets = blockOffsets;
+	view->base = base;
+	view->sizeInBytes = entry->sizeInBytes;
+	return true;
+}
+
+namespace
+{
+	//! Resolves a payload, checking the offset, header and encoded size against the frame
+	const GridCacheBlockHeader* blockPayload(GridCacheReader* reader, const GridCacheFrameView* view, NvFlowUint channelIdx, NvFlowUint blockIdx)
+	{
+		const NvFlowUint numBlocks = view->header->numBlocks;
+		const NvFlowUint numCells = reader->m_header->blockDim.w;
+		if (channelIdx >= reader->m_header->numChannels || blockIdx >= numBlocks)
+		{
+			return nullptr;
+		}
+		const NvFlowUint64 offset = view->blockOffsets[size_t(channelIdx) * numBlocks + blockIdx];
+		if (offset % sizeof(NvFlowUint) != 0u || offset + sizeof(GridCacheBlockHeader) > view->sizeInBytes)
+		{
+			return nullptr;
+		}
+		const GridCacheBlockHeader* blockHeader = (const GridCacheBlockHeader*)(view->base + offset);
+		if (offset + sizeof(GridCacheBlockHeader) + blockHeader->sizeInBytes > view->sizeInBytes)
+		{
+			return nullptr;
+		}
+		const NvFlowUint sizeInBytes = blockHeader->sizeInBytes;
+		const NvFlowUint runSize = sizeof(RunHeader) + sizeof(NvFlowFloat4);
+		if ((blockHeader->codec == eGridCacheCodecRaw && sizeInBytes == numCells * sizeof(NvFlowFloat4)) ||
+			(blockHeader->codec == eGridCacheCodecConstant && sizeInBytes == sizeof(NvFlowFloat4)) ||
+			(blockHeader->codec == eGridCacheCodecRLE && sizeInBytes % runSize == 0u && sizeInBytes / runSize <= numCells))
+		{
+			return blockHeader;
+		}
+		return nullptr;
+	}
+}
+
+const NvFlowFloat4* GridCacheReaderGetBlockRaw(GridCacheReader* reader, const GridCacheFrameView* view, NvFlowUint channelIdx, NvFlowUint blockIdx)
+{
+	const GridCacheBlockHeader* blockHeader = blockPayload(reader, view, channelIdx, blockIdx);
+	if (blockHeader == nullptr || blockHeader->codec != eGridCacheCodecRaw)
+	{
+		return nullptr;
+	}
+	return (const NvFlowFloat4*)(blockHeader + 1u);
+}
+
+bool GridCacheReaderDecodeBlock(GridCacheReader* reader, const GridCacheFrameView* view, NvFlowUint channelIdx, NvFlowUint blockIdx, NvFlowFloat4* dst)
+{
+	const NvFlowUint numCells = reader->m_header->blockDim.w;
+	const GridCacheBlockHeader* blockHeader = blockPayload(reader, view, channelIdx, blockIdx);
+	if (blockHeader == nullptr)
+	{
+		return false;
+	}
+	const unsigned char* data = (const unsigned char*)(blockHeader + 1u);
+
+	if (blockHeader->codec == eGridCacheCodecRaw)
+	{
+		memcpy(dst, data, numCells * sizeof(NvFlowFloat4));
+		return true;
+	}
+	else if (blockHeader->codec == eGridCacheCodecConstant)
+	{
+		const NvFlowFloat4 value = *(const NvFlowFloat4*)data;
+		for (NvFlowUint idx = 0u; idx < numCells; idx++)
+		{
+			dst[idx] = value;
+		}
+		return true;
+	}
+	else if (blockHeader->codec == eGridCacheCodecRLE)
+	{
+		const unsigned char* dataEnd = data + blockHeader->sizeInBytes;
+		NvFlowUint cellIdx = 0u;
+		while (data < dataEnd)
+		{
+			const RunHeader* run = (const RunHeader*)data;
+			const NvFlowFloat4 value = *(const NvFlowFloat4*)(data + sizeof(RunHeader));
+			data += sizeof(RunHeader) + sizeof(NvFlowFloat4);
+			if (run->count == 0u || run->count > numCells - cellIdx)
+			{
+				return false;
+			}
+			for (NvFlowUint idx = 0u; idx < run->count; idx++)
+			{
+				dst[cellIdx++] = value;
+			}
+		}
+		return cellIdx == numCells;
+	}
+	return false;
+}
@@ -0,0 +1,174 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "NvFlow.h"
+
+/// ****************** Grid Cache Public *******************************
+
+// On disk cache of sparse grid frames.
+//
+// File layout, little endian, all sections 8 byte aligned:
+//   GridCacheFileHeader
+//   frames, each a GridCacheFrameHeader followed by
+//     GridCacheLayer[numLayers]
+//     NvFlowUint2 blockList[numBlocks], (blockIdx, layerIdx) as in layeredBlockListCPU
+//     NvFlowUint blockOffsets[numChannels * numBlocks], payload offsets from the frame start
+//     payloads, each a GridCacheBlockHeader followed by the encoded cells
+//   GridCacheFrameIndexEntry[numFrames]
+//
+// Layer tables are stored sparse, each layer owns a contiguous range of the block list,
+// and payload i belongs to block list entry i. Cells are NvFlowFloat4, x fastest.
+
+static const NvFlowUint GridCacheMagic = 0x4347464E;	// "NFGC"
+static const NvFlowUint GridCacheVersion = 1u;
+static const NvFlowUint GridCacheMaxChannels = 4u;
+static const NvFlowUint GridCacheMaxLayers = 64u;
+
+enum GridCacheCodec
+{
+	eGridCacheCodecRaw = 0,			//!< Cells as stored
+	eGridCacheCodecConstant = 1,	//!< One value for the whole block
+	eGridCacheCodecRLE = 2,			//!< Runs of (count, value)
+};
+
+struct GridCacheFileHeader
+{
+	NvFlowUint magic;
+	NvFlowUint version;
+	NvFlowUint numChannels;
+	NvFlowUint numFrames;
+	NvFlowUint4 blockDim;				//!< Cells per block, w is cells per block
+	NvFlowUint4 gridDim;				//!< Virtual blocks per axis
+	NvFlowUint64 frameIndexOffset;		//!< Offset of the frame index, 0 until the writer is released
+};
+
+struct GridCacheFrameHeader
+{
+	NvFlowUint frameIdx;
+	NvFlowUint numLayers;
+	NvFlowUint numBlocks;
+	float time;
+	NvFlowFloat4x4 modelMatrix;			//!< Transform from grid NDC to world
+};
+
+struct GridCacheLayer
+{
+	NvFlowUint layerIdx;
+	NvFlowUint blockOffset;				//!< First entry in the block list
+	NvFlowUint numBlocks;
+	NvFlowUint materialIdx;
+};
+
+struct GridCacheBlockHeader
+{
+	NvFlowUint codec;
+	NvFlowUint sizeInBytes;				//!< Encoded size, excluding this header
+};
+
+struct GridCacheFrameIndexEntry
+{
+	NvFlowUint64 offset;
+	NvFlowUint64 sizeInBytes;
+	float time;
+	NvFlowUint frameIdx;
+};
+
+struct GridCacheDesc
+{
+	NvFlowUint numChannels;				//!< Channels per frame, e.g. velocity and density
+	NvFlowUint blockDim[3];
+	NvFlowUint gridDim[3];
+};
+
+//! One layer of source data for the writer, blocks resolve through the block table into the pools
+struct GridCacheLayerSource
+{
+	NvFlowUint materialIdx;
+	const NvFlowUint* blockTable;		//!< Virtual block to pool block, NvFlow_tableVal_to_coord() encoded, levelled blocks are expanded
+	const NvFlowFloat4* channelData[GridCacheMaxChannels];
+};
+
+struct GridCacheFrameSource
+{
+	float time;
+	NvFlowFloat4x4 modelMatrix;
+	NvFlowDim poolDim;					//!< Pool dimension in cells, shared by all layers and channels
+
+	const NvFlowUint2* blockList;		//!< (blockIdx, layerIdx) pairs, blockIdx NvFlow_tableVal_to_coord() encoded
+	NvFlowUint numBlocks;
+
+	const GridCacheLayerSource* layers;
+	NvFlowUint numLayers;
+};
+
+struct GridCacheWriter;
+struct CpuGridExport;
+
+GridCacheWriter* GridCacheWriterCreate(const char* filename, const GridCacheDesc* desc);
+
+//! Returns false if the frame was not written, after a failed write every later add fails too
+bool GridCacheWriterAddFrame(GridCacheWriter* writer, const GridCacheFrameSource* frame);
+
+//! Convenience for baking CpuGrid frames, channel 0 is velocity, channel 1 is density
+bool GridCacheWriterAddCpuGridFrame(GridCacheWriter* writer, const CpuGridExport* gridExport, float time);
+
+//! Writes the frame index and closes the file, returns false if any write of the cache failed
+bool GridCacheWriterRelease(GridCacheWriter* writer);
+
+//! A frame in a mapped cache, pointers are into the mapping
+struct GridCacheFrameView
+{
+	const GridCacheFrameHeader* header;
+	const GridCacheLayer* layers;
+	const NvFlowUint2* blockList;
+	const NvFlowUint* blockOffsets;
+	const unsigned char* base;
+	NvFlowUint64 sizeInBytes;			//!< Bytes from base, payloads are checked against it
+};
+
+struct GridCacheReader;
+
+GridCacheReader* GridCacheReaderOpen(const char* filename);
+
+void GridCacheReaderRelease(GridCacheReader* reader);
+
+const GridCacheFileHeader* GridCacheReaderGetHeader(GridCacheReader* reader);
+
+NvFlowUint GridCacheReaderGetNumFrames(GridCacheReader* reader);
+
+const GridCacheFrameIndexEntry* GridCacheReaderGetFrameIndex(GridCacheReader* reader, NvFlowUint frameIdx);
+
+//! Returns false if the frame is malformed, including block coordinates outside the header gridDim
+bool GridCacheReaderGetFrame(GridCacheReader* reader, NvFlowUint frameIdx, GridCacheFrameView* view);
+
+//! Returns the cells of a raw block in place, or nullptr if the block is encoded or out of bounds
+const NvFlowFloat4* GridCacheReaderGetBlockRaw(GridCacheReader* reader, const GridCacheFrameView* view, NvFlowUint channelIdx, NvFlowUint blockIdx);
+
+//! Decodes a block into dst, which holds blockDim.w cells, returns false if the payload is malformed
+bool GridCacheReaderDecodeBlock(GridCacheReader* reader, const GridCacheFrameView* view, NvFlowUint channelIdx, NvFlowUint blockIdx, NvFlowFloat4* dst);
@@ -0,0 +1,384 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "gridCacheCapture.h"
+#include "gridCache.h"
+#include "halfFloat.h"
+
+namespace
+{
+	static const NvFlowUint numCaptureChannels = 2u;
+
+	const NvFlowGridTextureChannel captureChannels[numCaptureChannels] = {
+		eNvFlowGridTextureChannelVelocity,
+		eNvFlowGridTextureChannelDensity
+	};
+
+	struct CaptureLayer
+	{
+		NvFlowUint materialIdx = 0u;
+		NvFlowTexture3D* blockTable = nullptr;
+		NvFlowTexture3D* data[numCaptureChannels] = { nullptr, nullptr };
+		NvFlowDim blockTableDim = { 0u, 0u, 0u };
+		NvFlowDim dataDim = { 0u, 0u, 0u };
+	};
+
+	struct Slot
+	{
+		bool pending = false;
+		NvFlowUint64 pushIdx = 0u;
+		NvFlowUint64 fenceValue = 0u;
+		float time = 0.f;
+		NvFlowFloat4x4 modelMatrix;
+		NvFlowShaderLinearParams shaderParams;
+		std::vector<NvFlowUint2> blockList;
+		std::vector<CaptureLayer> layers;
+		NvFlowUint numLayers = 0u;
+	};
+
+	bool sameLayout(const NvFlowShaderLinearParams& a, const NvFlowShaderLinearParams& b)
+	{
+		return memcmp(&a.blockDim, &b.blockDim, sizeof(a.blockDim)) == 0 &&
+			memcmp(&a.gridDim, &b.gridDim, sizeof(a.gridDim)) == 0 &&
+			memcmp(&a.poolGridDim, &b.poolGridDim, sizeof(a.poolGridDim)) == 0 &&
+			memcmp(&a.linearBlockDim, &b.linearBlockDim, sizeof(a.linearBlockDim)) == 0 &&
+			memcmp(&a.linearBlockOffset, &b.linearBlockOffset, sizeof(a.linearBlockOffset)) == 0;
+	}
+}
+
+struct GridCacheCapture
+{
+	GridCacheCaptureDesc m_desc;
+	std::string m_filename;
+	GridCacheWriter* m_writer = nullptr;
+	std::vector<Slot> m_slots;
+	NvFlowUint64 m_pushIdx = 0u;
+	GridCacheCaptureStats m_stats = {};
+
+	// write scratch, pools are repacked to blockDim strides as the writer expects
+	std::vector<NvFlowUint> m_blockTables;
+	std::vector<NvFlowFloat4> m_pools;
+	std::vector<GridCacheLayerSource> m_layerSources;
+
+	void releaseSlot(Slot& slot);
+	bool writeSlot(Slot& slot, NvFlowContext* context);
+};
+
+void GridCacheCaptureDescDefaults(GridCacheCaptureDesc* desc)
+{
+	desc->ringDepth = 3u;
+	desc->format = eNvFlowFormat_r16g16b16a16_float;
+}
+
+GridCacheCapture* GridCacheCaptureCreate(const char* filename, const GridCacheCaptureDesc* desc)
+{
+	GridCacheCapture* capture = new GridCacheCapture;
+	capture->m_desc = *desc;
+	if (capture->m_desc.ringDepth < 2u)
+	{
+		capture->m_desc.ringDepth = 2u;
+	}
+	capture->m_filename = filename;
+	capture->m_slots.resize(capture->m_desc.ringDepth);
+	return capture;
+}
+
+void GridCacheCapture::releaseSlot(Slot& slot)
+{
+	for (auto& layer : slot.layers)
+	{
+		if (layer.blockTable) NvFlowReleaseTexture3D(layer.blockTable);
+		for (auto& data : layer.data)
+		{
+			if (data) NvFlowReleaseTexture3D(data);
+		}
+	}
+	slot.layers.clear();
+}
+
+bool GridCacheCaptureRelease(GridCacheCapture* capture)
+{
+	if (capture == nullptr) return false;
+
+	for (auto& slot : capture->m_slots)
+	{
+		capture->releaseSlot(slot);
+	}
+	// no writer means no frame was ever pushed, there is no file to complete
+	bool succeeded = capture->m_writer == nullptr || GridCacheWriterRelease(capture->m_writer);
+	delete capture;
+	return succeeded;
+}
+
+bool GridCacheCapturePush(GridCacheCapture* capture, NvFlowContext* context, NvFlowGridExport* gridExport, float time, NvFlowUint64 fenceValue)
+{
+	capture->m_stats.numPushed++;
+
+	NvFlowGridExportHandle handles[numCaptureChannels];
+	NvFlowGridExportLayeredView layeredViews[numCaptureChannels];
+	for (NvFlowUint channelIdx = 0u; channelIdx < numCaptureChannels; channelIdx++)
+	{
+		handles[channelIdx] = NvFlowGridExportGetHandle(gridExport, context, captureChannels[channelIdx]);
+		layeredViews[channelIdx] = {};
+		NvFlowGridExportGetLayeredView(handles[channelIdx], &layeredViews[channelIdx]);
+	}
+	const NvFlowGridExportImportLayeredMapping& mapping = layeredViews[0].mapping;
+
+	// tiled resource pools are the size of the virtual space, too large to download
+	if (mapping.layeredBlockListCPU == nullptr ||
+		mapping.shaderParams.isVTR.x != 0u ||
+		handles[0].numLayerViews != handles[1].numLayerViews ||
+		handles[0].numLayerViews > GridCacheMaxLayers ||
+		!sameLayout(mapping.shaderParams, layeredViews[1].mapping.shaderParams))
+	{
+		capture->m_stats.numDropped++;
+		return false;
+	}
+
+	Slot& slot = capture->m_slots[capture->m_pushIdx % capture->m_slots.size()];
+	if (slot.pending)
+	{
+		capture->m_stats.numDropped++;
+	}
+	slot.pending = true;
+	slot.pushIdx = capture->m_pushIdx++;
+	slot.fenceValue = fenceValue;
+	slot.time = time;
+	slot.modelMatrix = mapping.modelMatrix;
+	slot.shaderParams = mapping.shaderParams;
+	slot.blockList.assign(mapping.layeredBlockListCPU, mapping.layeredBlockListCPU + mapping.layeredNumBlocks);
+	slot.numLayers = handles[0].numLayerViews;
+
+	const NvFlowShaderLinearParams& shaderParams = mapping.shaderParams;
+	const NvFlowDim blockTableDim = { shaderParams.gridDim.x, shaderParams.gridDim.y, shaderParams.gridDim.z };
+	const NvFlowDim dataDim = {
+		shaderParams.poolGridDim.x * shaderParams.linearBlockDim.x,
+		shaderParams.poolGridDim.y * shaderParams.linearBlockDim.y,
+		shaderParams.poolGridDim.z * shaderParams.linearBlockDim.z
+	};
+
+	if (slot.layers.size() < slot.numLayers)
+	{
+		slot.layers.resize(slot.numLayers);
+	}
+	for (NvFlowUint layerIdx = 0u; layerIdx < slot.numLayers; layerIdx++)
+	{
+		CaptureLayer& layer = slot.layers[layerIdx];
+		if (layer.blockTable == nullptr || memcmp(&layer.blockTableDim, &blockTableDim, sizeof(NvFlowDim)) != 0)
+		{
+			if (layer.blockTable) NvFlowReleaseTexture3D(layer.blockTable);
+			NvFlowTexture3DDesc texDesc = {};
+			texDesc.format = eNvFlowFormat_r32_uint;
+			texDesc.dim = blockTableDim;
+			texDesc.uploadAccess = false;
+			texDesc.downloadAccess = true;
+			layer.blockTable = NvFlowCreateTexture3D(context, &texDesc);
+			layer.blockTableDim = blockTableDim;
+		}
+		if (layer.data[0] == nullptr || memcmp(&layer.dataDim, &dataDim, sizeof(NvFlowDim)) != 0)
+		{
+			for (auto& data : layer.data)
+			{
+				if (data) NvFlowReleaseTexture3D(data);
+				NvFlowTexture3DDesc texDesc = {};
+				texDesc.format = capture->m_desc.format;
+				texDesc.dim = dataDim;
+				texDesc.uploadAccess = false;
+				texDesc.downloadAccess = true;
+				data = NvFlowCreateTexture3D(context, &texDesc);
+			}
+			layer.dataDim = dataDim;
+		}
+
+		// both channels share the layout, so one block table serves both
+		for (NvFlowUint channelIdx = 0u; channelIdx < numCaptureChannels; channelIdx++)
+		{
+			NvFlowGridExportLayerView layerView = {};
+			NvFlowGridExportGetLayerView(handles[channelIdx], layerIdx, &layerView);
+			if (channelIdx == 0u)
+			{
+				layer.materialIdx = NvFlowUint(layerView.mapping.material.uid);
+				NvFlowContextCopyResource(context, NvFlowTexture3DGetResourceRW(layer.blockTable), layerView.mapping.blockTable);
+				NvFlowTexture3DDownload(context, layer.blockTable);
+			}
+			NvFlowContextCopyResource(context, NvFlowTexture3DGetResourceRW(layer.data[channelIdx]), layerView.data);
+			NvFlowTexture3DDownload(context, layer.data[channelIdx]);
+		}
+	}
+	return true;
+}
+
+bool GridCacheCapture::writeSlot(Slot& slot, NvFlowContext* context)
+{
+	const NvFlowShaderLinearParams& shaderParams = slot.shaderParams;
+	const bool isHalf = m_desc.format == eNvFlowFormat_r16g16b16a16_float;
+	const NvFlowUint elementSize = isHalf ? 8u : 16u;
+
+	if (m_writer == nullptr)
+	{
+		GridCacheDesc cacheDesc = {};
+		cacheDesc.numChannels = numCaptureChannels;
+		cacheDesc.blockDim[0] = shaderParams.blockDim.x;
+		cacheDesc.blockDim[1] = shaderParams.blockDim.y;
+		cacheDesc.blockDim[2] = shaderParams.blockDim.z;
+		cacheDesc.gridDim[0] = shaderParams.gridDim.x;
+		cacheDesc.gridDim[1] = shaderParams.gridDim.y;
+		cacheDesc.gridDim[2] = shaderParams.gridDim.z;
+		m_writer = GridCacheWriterCreate(m_filename.c_str(), &cacheDesc);
+		if (m_writer == nullptr)
+		{
+			return false;
+		}
+	}
+
+	const NvFlowDim poolDim = {
+		shaderParams.poolGridDim.x * shaderParams.blockDim.x,
+		shaderParams.poolGridDim.y * shaderParams.blockDim.y,
+		shaderParams.poolGridDim.z * shaderParams.blockDim.z
+	};
+	const size_t tableSize = size_t(shaderParams.gridDim.x) * shaderParams.gridDim.y * shaderParams.gridDim.z;
+	const size_t poolSize = size_t(poolDim.x) * poolDim.y * poolDim.z;
+	m_blockTables.resize(tableSize * slot.numLayers);
+	m_pools.resize(poolSize * numCaptureChannels * slot.numLayers);
+	m_layerSources.resize(slot.numLayers);
+
+	for (NvFlowUint layerIdx = 0u; layerIdx < slot.numLayers; layerIdx++)
+	{
+		CaptureLayer& layer = slot.layers[layerIdx];
+		GridCacheLayerSource& layerSource = m_layerSources[layerIdx];
+		layerSource = {};
+		layerSource.materialIdx = layer.materialIdx;
+
+		NvFlowUint* blockTable = &m_blockTables[tableSize * layerIdx];
+		NvFlowMappedData tableMapped = NvFlowTexture3DMapDownload(context, layer.blockTable);
+		for (NvFlowUint k = 0u; k < shaderParams.gridDim.z; k++)
+		{
+			for (NvFlowUint j = 0u; j < shaderParams.gridDim.y; j++)
+			{
+				memcpy(&blockTable[(k * shaderParams.gridDim.y + j) * shaderParams.gridDim.x],
+					(const unsigned char*)tableMapped.data + k * tableMapped.depthPitch + j * tableMapped.rowPitch,
+					shaderParams.gridDim.x * sizeof(NvFlowUint));
+			}
+		}
+		NvFlowTexture3DUnmapDownload(context, layer.blockTable);
+		layerSource.blockTable = blockTable;
+
+		for (NvFlowUint channelIdx = 0u; channelIdx < numCaptureChannels; channelIdx++)
+		{
+			NvFlowFloat4* pool = &m_pools[poolSize * (layerIdx * numCaptureChannels + channelIdx)];
+			NvFlowMappedData dataMapped = NvFlowTexture3DMapDownload(context, layer.data[channelIdx]);
+			for (NvFlowUint k = 0u; k < poolDim.z; k++)
+			{
+				NvFlowUint srcZ = (k / shaderParams.blockDim.z) * shaderParams.linearBlockDim.z + shaderParams.linearBlockOffset.z + k % shaderParams.blockDim.z;
+				for (NvFlowUint j = 0u; j < poolDim.y; j++)
+				{
+					NvFlowUint srcY = (j / shaderParams.blockDim.y) * shaderParams.linearBlockDim.y + shaderParams.linearBlockOffset.y + j % shaderParams.blockDim.y;
+					const unsigned char* srcRow = (const unsigned char*)dataMapped.data + srcZ * dataMapped.depthPitch + srcY * dataMapped.rowPitch;
+					NvFlowFloat4* dstRow = &pool[(size_t(k) * poolDim.y + j) * poolDim.x];
+					for (NvFlowUint i = 0u; i < poolDim.x; i++)
+					{
+						NvFlowUint srcX = (i / shaderParams.blockDim.x) * shaderParams.linearBlockDim.x + shaderParams.linearBlockOffset.x + i % shaderParams.blockDim.x;
+						const unsigned char* src = srcRow + srcX * elementSize;
+						if (isHalf)
+						{
+							const unsigned short* srcHalf = (const unsigned short*)src;
+							dstRow[i] = { HalfFloatToFloat(srcHalf[0]), HalfFloatToFloat(srcHalf[1]), HalfFloatToFloat(srcHalf[2]), HalfFloatToFloat(srcHalf[3]) };
+						}
+						else
+						{
+							memcpy(&dstRow[i], src, sizeof(NvFlowFloat4));
+						}
+					}
+				}
+			}
+			NvFlowTexture3DUnmapDownload(context, layer.data[channelIdx]);
+			layerSource.channelData[channelIdx] = pool;
+		}
+	}
+
+	GridCacheFrameSource frame = {};
+	frame.time = slot.time;
+	frame.modelMatrix = slot.modelMatrix;
+	frame.poolDim = poolDim;
+	frame.blockList = slot.blockList.data();
+	frame.numBlocks = NvFlowUint(slot.blockList.size());
+	frame.layers = m_layerSources.data();
+	frame.numLayers = slot.numLayers;
+
+	return GridCacheWriterAddFrame(m_writer, &frame);
+}
+
+NvFlowUint GridCacheCapturePoll(GridCacheCapture* capture, NvFlowContext* context, NvFlowUint64 lastFenceCompleted)
+{
+	const NvFlowUint64 latency = capture->m_slots.size() - 1u;
+	NvFlowUint numWritten = 0u;
+	// slots retire in push order, write them in that order so frames stay in time order
+	for (NvFlowUint64 idx = 0u; idx < capture->m_slots.size(); idx++)
+	{
+		Slot* oldest = nullptr;
+		for (auto& slot : capture->m_slots)
+		{
+			if (slot.pending && (oldest == nullptr || slot.pushIdx < oldest->pushIdx))
+			{
+				oldest = &slot;
+			}
+		}
+		if (oldest == nullptr)
+		{
+			break;
+		}
+		bool completed = oldest->fenceValue != 0u ?
+			oldest->fenceValue <= lastFenceCompleted :
+			oldest->pushIdx + latency < capture->m_pushIdx;
+		if (!completed)
+		{
+			break;
+		}
+		oldest->pending = false;
+		if (capture->writeSlot(*oldest, context))
+		{
+			capture->m_stats.numWritten++;
+			numWritten++;
+		}
+		else
+		{
+			capture->m_stats.numDropped++;
+		}
+	}
+	return numWritten;
+}
+
+void GridCacheCaptureGetStats(GridCacheCapture* capture, GridCacheCaptureStats* stats)
+{
+	*stats = capture->m_stats;
+}
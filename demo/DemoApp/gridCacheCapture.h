@@ -0,0 +1,95 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+
+#pragma once
+
+#include "NvFlow.h"
+#include "NvFlowContextExt.h"
+
+struct GridCacheWriter;
+
+/// ****************** Grid Cache Capture Public *******************************
+
+// Records GPU grid exports into a grid cache, see gridCache.h.
+//
+// Each push copies the block tables and data of velocity and density into a ring slot of
+// download textures and tags it with the grid queue fence the copies complete with. Polling
+// maps only slots whose fence completed and writes them through GridCacheWriterAddFrame(),
+// so recording never waits on the GPU. A slot still pending when its turn comes round again
+// is dropped, so a slow queue loses frames rather than stalling the simulation.
+// Channel 0 is velocity and channel 1 density, as for GridCacheWriterAddCpuGridFrame(). Both
+// must share one block layout, exports with multires density are not recorded.
+
+struct GridCacheCapture;
+
+struct GridCacheCaptureDesc
+{
+	NvFlowUint ringDepth;				//!< Frames in flight between push and write
+	NvFlowFormat format;				//!< Export data format, r16g16b16a16_float or r32g32b32a32_float
+};
+
+struct GridCacheCaptureStats
+{
+	NvFlowUint numPushed;
+	NvFlowUint numWritten;
+	NvFlowUint numDropped;				//!< Pushes overwritten before their fence completed, or rejected
+};
+
+void GridCacheCaptureDescDefaults(GridCacheCaptureDesc* desc);
+
+//! The writer is created with the first pushed frame, from its block layout
+GridCacheCapture* GridCacheCaptureCreate(const char* filename, const GridCacheCaptureDesc* desc);
+
+//! Writes the frame index and closes the file, frames still in flight are dropped, returns false if the file is incomplete
+bool GridCacheCaptureRelease(GridCacheCapture* capture);
+
+/**
+ * Queue copies and downloads of the export, on the grid context after the simulation update.
+ *
+ * @param[in] capture The capture.
+ * @param[in] context The context the export is valid on.
+ * @param[in] gridExport The export to record.
+ * @param[in] time Frame time stored in the cache.
+ * @param[in] fenceValue Grid queue fence signaled by the flush carrying the copies, 0 if the grid shares the app context.
+ *
+ * @return Returns false if the export cannot be downloaded, tiled pools or mismatched channel layouts.
+ */
+bool GridCacheCapturePush(GridCacheCapture* capture, NvFlowContext* context, NvFlowGridExport* gridExport, float time, NvFlowUint64 fenceValue);
+
+/**
+ * Write every slot whose copies completed, oldest first.
+ *
+ * @param[in] capture The capture.
+ * @param[in] context The context pushes were made on.
+ * @param[in] lastFenceCompleted Last grid queue fence completed, slots pushed with fence 0 complete after ringDepth - 1 pushes.
+ *
+ * @return Returns the number of frames written.
+ */
+NvFlowUint GridCacheCapturePoll(GridCacheCapture* capture, NvFlowContext* context, NvFlowUint64 lastFenceCompleted);
+
+void GridCacheCaptureGetStats(GridCacheCapture* capture, GridCacheCaptureStats* stats);
@@ -0,0 +1,585 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <string.h>
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "NvFlowShaderCPU.h"
+
+#include "gridCachePlayer.h"
+#include "halfFloat.h"
+
+namespace
+{
+	void tableValToCoord(NvFlowUint val, NvFlowUint* x, NvFlowUint* y, NvFlowUint* z)
+	{
+		NvFlowInt3 coord = NvFlowCPU_tableVal_to_coord(val);
+		*x = NvFlowUint(coord.x);
+		*y = NvFlowUint(coord.y);
+		*z = NvFlowUint(coord.z);
+	}
+
+	struct DecodedFrame
+	{
+		NvFlowUint frameIdx = ~0u;
+		bool ready = false;
+		bool uploading = false;				//!< Read by GridCachePlayerUpload() outside the lock, not to be decoded into
+
+		GridCacheFrameHeader header;
+		std::vector<GridCacheLayer> layers;
+		std::vector<NvFlowUint2> blockList;
+		std::vector<unsigned char> cells[GridCacheMaxChannels];		//!< Per block, in upload format
+	};
+
+	struct Staging
+	{
+		NvFlowTexture3D* blockTable = nullptr;
+		NvFlowBuffer* blockList = nullptr;
+		NvFlowTexture3D* data = nullptr;
+
+		NvFlowDim blockTableDim = { 0u, 0u, 0u };
+		NvFlowUint blockListDim = 0u;
+		NvFlowDim dataDim = { 0u, 0u, 0u };
+	};
+}
+
+struct GridCachePlayer
+{
+	GridCachePlayerDesc m_desc;
+	GridCacheReader* m_reader = nullptr;
+	NvFlowUint m_elementSize = 16u;
+
+	// prefetch, frame i lives in slot i % m_frames.size()
+	std::vector<DecodedFrame> m_frames;
+	NvFlowUint m_playhead = 0u;
+	bool m_stop = false;
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_requestCond;
+	std::condition_variable m_readyCond;
+
+	std::vector<Staging> m_staging[eNvFlowGridTextureChannelCount];
+	NvFlowFloat4x4 m_modelMatrix;
+	GridCachePlayerStats m_stats = {};
+
+	bool findWork(NvFlowUint* frameIdx);
+	void decode(DecodedFrame& frame, NvFlowUint frameIdx);
+	void threadMain();
+
+	bool uploadChannel(NvFlowContext* context, NvFlowGridImport* gridImport, NvFlowGridImportStateCPU* stateCPU, NvFlowUint cacheChannel, const DecodedFrame& frame,
+		NvFlowUint* numBlocksUploaded, NvFlowUint* numBlocksDropped);
+};
+
+void GridCachePlayerDescDefaults(GridCachePlayerDesc* desc)
+{
+	desc->numPrefetchFrames = 4u;
+	desc->loop = true;
+	desc->dataFormat = eNvFlowFormat_r16g16b16a16_float;
+	desc->channelMap[0] = eNvFlowGridTextureChannelVelocity;
+	desc->channelMap[1] = eNvFlowGridTextureChannelDensity;
+	for (NvFlowUint idx = 2u; idx < GridCacheMaxChannels; idx++)
+	{
+		desc->channelMap[idx] = eNvFlowGridTextureChannelCount;
+	}
+}
+
+bool GridCachePlayer::findWork(NvFlowUint* frameIdx)
+{
+	const NvFlowUint numFrames = GridCacheReaderGetNumFrames(m_reader);
+	const NvFlowUint numSlots = NvFlowUint(m_frames.size());
+	// past a loop point frames can map to a slot nearer the playhead, the window ends there
+	NvFlowUint64 claimedSlots = 0u;
+	for (NvFlowUint offset = 0u; offset < numSlots && offset < numFrames; offset++)
+	{
+		NvFlowUint idx = m_playhead + offset;
+		if (idx >= numFrames)
+		{
+			if (!m_desc.loop) break;
+			idx -= numFrames;
+		}
+		const NvFlowUint slotIdx = idx % numSlots;
+		if (claimedSlots & (NvFlowUint64(1u) << slotIdx))
+		{
+			break;
+		}
+		claimedSlots |= NvFlowUint64(1u) << slotIdx;
+
+		const DecodedFrame& frame = m_frames[slotIdx];
+		if (frame.frameIdx != idx && !frame.uploading)
+		{
+			*frameIdx = idx;
+			return true;
+		}
+	}
+	return false;
+}
+
+void GridCachePlayer::decode(DecodedFrame& frame, NvFlowUint frameIdx)
+{
+	GridCacheFrameView view;
+	if (!GridCacheReaderGetFrame(m_reader, frameIdx, &view))
+	{
+		frame.header = {};
+		frame.layers.clear();
+		frame.blockList.clear();
+		return;
+	}
+
+	const GridCacheFileHeader* fileHeader = GridCacheReaderGetHeader(m_reader);
+	const NvFlowUint numCells = fileHeader->blockDim.w;
+	const NvFlowUint numBlocks = view.header->numBlocks;
+
+	frame.header = *view.header;
+	frame.layers.assign(view.layers, view.layers + view.header->numLayers);
+	frame.blockList.assign(view.blockList, view.blockList + numBlocks);
+
+	std::vector<NvFlowFloat4> cells(numCells);
+	for (NvFlowUint channelIdx = 0u; channelIdx < fileHeader->numChannels; channelIdx++)
+	{
+		std::vector<unsigned char>& dst = frame.cells[channelIdx];
+		if (m_desc.channelMap[channelIdx] >= eNvFlowGridTextureChannelCount)
+		{
+			dst.clear();
+			continue;
+		}
+		dst.resize(size_t(numBlocks) * numCells * m_elementSize);
+		for (NvFlowUint blockIdx = 0u; blockIdx < numBlocks; blockIdx++)
+		{
+			unsigned char* dstBlock = dst.data() + size_t(blockIdx) * numCells * m_elementSize;
+			if (m_elementSize == sizeof(NvFlowFloat4))
+			{
+				if (!GridCacheReaderDecodeBlock(m_reader, &view, channelIdx, blockIdx, (NvFlowFloat4*)dstBlock))
+				{
+					memset(dstBlock, 0, numCells * m_elementSize);
+				}
+			}
+			else
+			{
+				if (!GridCacheReaderDecodeBlock(m_reader, &view, channelIdx, blockIdx, cells.data()))
+				{
+					memset(cells.data(), 0, numCells * sizeof(NvFlowFloat4));
+				}
+				unsigned short* dstHalf = (unsigned short*)dstBlock;
+				const float* src = &cells[0].x;
+				for (NvFlowUint idx = 0u; idx < 4u * numCells; idx++)
+				{
+					dstHalf[idx] = HalfFloatFromFloat(src[idx]);
+				}
+			}
+		}
+	}
+}
+
+void GridCachePlayer::threadMain()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (!m_stop)
+	{
+		NvFlowUint frameIdx = 0u;
+		if (!findWork(&frameIdx))
+		{
+			m_requestCond.wait(lock);
+			continue;
+		}
+
+		// findWork() skips slots being uploaded, so a seek during an upload cannot overwrite its frame
+		DecodedFrame& frame = m_frames[frameIdx % m_frames.size()];
+		frame.frameIdx = frameIdx;
+		frame.ready = false;
+
+		lock.unlock();
+		decode(frame, frameIdx);
+		lock.lock();
+
+		frame.ready = true;
+		m_stats.numFramesDecoded++;
+		m_readyCond.notify_all();
+	}
+}
+
+GridCachePlayer* GridCachePlayerCreate(const char* filename, const GridCachePlayerDesc* desc)
+{
+	if (desc->dataFormat != eNvFlowFormat_r32g32b32a32_float &&
+		desc->dataFormat != eNvFlowFormat_r16g16b16a16_float)
+	{
+		return nullptr;
+	}
+
+	GridCacheReader* reader = GridCacheReaderOpen(filename);
+	if (reader == nullptr)
+	{
+		return nullptr;
+	}
+
+	GridCachePlayer* player = new GridCachePlayer;
+	player->m_desc = *desc;
+	player->m_reader = reader;
+	player->m_elementSize = (desc->dataFormat == eNvFlowFormat_r32g32b32a32_float) ? 16u : 8u;
+	player->m_frames.resize((desc->numPrefetchFrames < 63u ? desc->numPrefetchFrames : 63u) + 1u);
+	player->m_modelMatrix = {};
+
+	player->m_thread = std::thread([player]() { player->threadMain(); });
+
+	return player;
+}
+
+void GridCachePlayerRelease(GridCachePlayer* player)
+{
+	if (player == nullptr) return;
+
+	{
+		std::lock_guard<std::mutex> lock(player->m_mutex);
+		player->m_stop = true;
+	}
+	player->m_requestCond.notify_all();
+	player->m_thread.join();
+
+	GridCachePlayerReleaseResources(player);
+	GridCacheReaderRelease(player->m_reader);
+
+	delete player;
+}
+
+NvFlowUint GridCachePlayerGetNumFrames(GridCachePlayer* player)
+{
+	return GridCacheReaderGetNumFrames(player->m_reader);
+}
+
+NvFlowUint GridCachePlayerFindFrame(GridCachePlayer* player, float time)
+{
+	NvFlowUint lo = 0u;
+	NvFlowUint hi = GridCacheReaderGetNumFrames(player->m_reader);
+	while (lo + 1u < hi)
+	{
+		NvFlowUint mid = (lo + hi) / 2u;
+		if (GridCacheReaderGetFrameIndex(player->m_reader, mid)->time <= time)
+		{
+			lo = mid;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+void GridCachePlayerSeek(GridCachePlayer* player, NvFlowUint frameIdx)
+{
+	const NvFlowUint numFrames = GridCacheReaderGetNumFrames(player->m_reader);
+	if (numFrames == 0u) return;
+	{
+		std::lock_guard<std::mutex> lock(player->m_mutex);
+		player->m_playhead = player->m_desc.loop ? (frameIdx % numFrames) : (frameIdx < numFrames ? frameIdx : numFrames - 1u);
+	}
+	player->m_requestCond.notify_all();
+}
+
+NvFlowUint GridCachePlayerGetFrame(GridCachePlayer* player)
+{
+	std::lock_guard<std::mutex> lock(player->m_mutex);
+	return player->m_playhead;
+}
+
+bool GridCachePlayerIsFrameReady(GridCachePlayer* player)
+{
+	std::lock_guard<std::mutex> lock(player->m_mutex);
+	const DecodedFrame& frame = player->m_frames[player->m_playhead % player->m_frames.size()];
+	return frame.frameIdx == player->m_playhead && frame.ready;
+}
+
+bool GridCachePlayer::uploadChannel(NvFlowContext* context, NvFlowGridImport* gridImport, NvFlowGridImportStateCPU* stateCPU, NvFlowUint cacheChannel, const DecodedFrame& frame,
+	NvFlowUint* numBlocksUploaded, NvFlowUint* numBlocksDropped)
+{
+	const GridCacheFileHeader* fileHeader = GridCacheReaderGetHeader(m_reader);
+	const NvFlowGridTextureChannel channel = m_desc.channelMap[cacheChannel];
+
+	NvFlowGridImportStateCPUParams params = {};
+	params.stateCPU = stateCPU;
+	params.channel = channel;
+	params.importMode = eNvFlowGridImportModePoint;
+	NvFlowGridImportHandle handle = NvFlowGridImportStateCPUGetHandle(gridImport, context, &params);
+
+	NvFlowGridImportLayeredView layeredView;
+	NvFlowGridImportGetLayeredView(handle, &layeredView);
+	const NvFlowShaderLinearParams& shaderParams = layeredView.mapping.shaderParams;
+
+	// tiled resource pools have no block table to write
+	if (shaderParams.isVTR.x != 0u)
+	{
+		return false;
+	}
+	if (shaderParams.blockDim.x != fileHeader->blockDim.x ||
+		shaderParams.blockDim.y != fileHeader->blockDim.y ||
+		shaderParams.blockDim.z != fileHeader->blockDim.z ||
+		shaderParams.gridDim.x != fileHeader->gridDim.x ||
+		shaderParams.gridDim.y != fileHeader->gridDim.y ||
+		shaderParams.gridDim.z != fileHeader->gridDim.z)
+	{
+		return false;
+	}
+
+	const NvFlowUint4 blockDim = shaderParams.blockDim;
+	const NvFlowUint4 poolGridDim = shaderParams.poolGridDim;
+	const NvFlowUint4 gridDim = shaderParams.gridDim;
+	const NvFlowUint numCells = fileHeader->blockDim.w;
+	const NvFlowUint rowSize = blockDim.x * m_elementSize;
+	// pool block 0 stays zero, unallocated table entries resolve to it
+	const NvFlowUint numPoolBlocks = poolGridDim.x * poolGridDim.y * poolGridDim.z;
+
+	std::vector<Staging>& stagingLayers = m_staging[channel];
+	if (stagingLayers.size() < handle.numLayerViews)
+	{
+		stagingLayers.resize(handle.numLayerViews);
+	}
+
+	for (NvFlowUint layerIdx = 0u; layerIdx < handle.numLayerViews; layerIdx++)
+	{
+		NvFlowGridImportLayerView layerView;
+		NvFlowGridImportGetLayerView(handle, layerIdx, &layerView);
+		if (layerView.blockTableRW == nullptr || layerView.blockListRW == nullptr)
+		{
+			return false;
+		}
+
+		Staging& staging = stagingLayers[layerIdx];
+		const NvFlowDim blockTableDim = { gridDim.x, gridDim.y, gridDim.z };
+		const NvFlowDim dataDim = { poolGridDim.x * blockDim.x, poolGridDim.y * blockDim.y, poolGridDim.z * blockDim.z };
+		// the list holds as many blocks as the pool, unused entries point at an empty block
+		const NvFlowUint blockListDim = layeredView.mapping.maxBlocks > 0u ? layeredView.mapping.maxBlocks : numPoolBlocks - 1u;
+
+		if (staging.blockTable == nullptr || memcmp(&staging.blockTableDim, &blockTableDim, sizeof(NvFlowDim)) != 0)
+		{
+			if (staging.blockTable) NvFlowReleaseTexture3D(staging.blockTable);
+			NvFlowTexture3DDesc texDesc = {};
+			texDesc.format = eNvFlowFormat_r32_uint;
+			texDesc.dim = blockTableDim;
+			texDesc.uploadAccess = true;
+			texDesc.downloadAccess = false;
+			staging.blockTable = NvFlowCreateTexture3D(context, &texDesc);
+			staging.blockTableDim = blockTableDim;
+		}
+		if (staging.blockList == nullptr || staging.blockListDim != blockListDim)
+		{
+			if (staging.blockList) NvFlowReleaseBuffer(staging.blockList);
+			NvFlowBufferDesc bufDesc = {};
+			bufDesc.format = eNvFlowFormat_r32_uint;
+			bufDesc.dim = blockListDim;
+			bufDesc.uploadAccess = true;
+			bufDesc.downloadAccess = false;
+			staging.blockList = NvFlowCreateBuffer(context, &bufDesc);
+			staging.blockListDim = blockListDim;
+		}
+		if (staging.data == nullptr || memcmp(&staging.dataDim, &dataDim, sizeof(NvFlowDim)) != 0)
+		{
+			if (staging.data) NvFlowReleaseTexture3D(staging.data);
+			NvFlowTexture3DDesc texDesc = {};
+			texDesc.format = m_desc.dataFormat;
+			texDesc.dim = dataDim;
+			texDesc.uploadAccess = true;
+			texDesc.downloadAccess = false;
+			staging.data = NvFlowCreateTexture3D(context, &texDesc);
+			staging.dataDim = dataDim;
+		}
+
+		// blocks of this layer
+		NvFlowUint blockOffset = 0u;
+		NvFlowUint numBlocks = 0u;
+		if (layerIdx < frame.layers.size())
+		{
+			blockOffset = frame.layers[layerIdx].blockOffset;
+			numBlocks = frame.layers[layerIdx].numBlocks;
+		}
+		NvFlowUint maxBlocks = blockListDim < numPoolBlocks - 1u ? blockListDim : numPoolBlocks - 1u;
+		if (numBlocks > maxBlocks)
+		{
+			*numBlocksDropped += numBlocks - maxBlocks;
+			numBlocks = maxBlocks;
+		}
+
+		NvFlowMappedData tableMapped = NvFlowTexture3DMap(context, staging.blockTable);
+		NvFlowMappedData dataMapped = NvFlowTexture3DMap(context, staging.data);
+		NvFlowUint* listMapped = (NvFlowUint*)NvFlowBufferMap(context, staging.blockList);
+
+		for (NvFlowUint k = 0u; k < gridDim.z; k++)
+		{
+			for (NvFlowUint j = 0u; j < gridDim.y; j++)
+			{
+				NvFlowUint* row = (NvFlowUint*)((unsigned char*)tableMapped.data + k * tableMapped.depthPitch + j * tableMapped.rowPitch);
+				memset(row, 0xFF, gridDim.x * sizeof(NvFlowUint));
+			}
+		}
+		for (NvFlowUint k = 0u; k < blockDim.z; k++)
+		{
+			for (NvFlowUint j = 0u; j < blockDim.y; j++)
+			{
+				memset((unsigned char*)dataMapped.data + k * dataMapped.depthPitch + j * dataMapped.rowPitch, 0, rowSize);
+			}
+		}
+
+		const unsigned char* cells = frame.cells[cacheChannel].data();
+		for (NvFlowUint blockIdx = 0u; blockIdx < numBlocks; blockIdx++)
+		{
+			const NvFlowUint virtualVal = frame.blockList[blockOffset + blockIdx].x;
+			NvFlowUint vx, vy, vz;
+			tableValToCoord(virtualVal, &vx, &vy, &vz);
+
+			const NvFlowUint poolIdx = blockIdx + 1u;
+			const NvFlowUint px = poolIdx % poolGridDim.x;
+			const NvFlowUint py = (poolIdx / poolGridDim.x) % poolGridDim.y;
+			const NvFlowUint pz = poolIdx / (poolGridDim.x * poolGridDim.y);
+
+			NvFlowUint* tableRow = (NvFlowUint*)((unsigned char*)tableMapped.data + vz * tableMapped.depthPitch + vy * tableMapped.rowPitch);
+			tableRow[vx] = NvFlowCPU_coord_to_tableVal(px, py, pz);
+			listMapped[blockIdx] = virtualVal;
+
+			const unsigned char* src = cells + size_t(blockOffset + blockIdx) * numCells * m_elementSize;
+			for (NvFlowUint k = 0u; k < blockDim.z; k++)
+			{
+				for (NvFlowUint j = 0u; j < blockDim.y; j++)
+				{
+					unsigned char* dst = (unsigned char*)dataMapped.data +
+						(pz * blockDim.z + k) * dataMapped.depthPitch +
+						(py * blockDim.y + j) * dataMapped.rowPitch +
+						px * rowSize;
+					memcpy(dst, src, rowSize);
+					src += rowSize;
+				}
+			}
+		}
+		*numBlocksUploaded += numBlocks;
+
+		// pad the list with a virtual block left unallocated, reads see the zero block
+		if (numBlocks < blockListDim)
+		{
+			NvFlowUint padVal = NvFlowCPU_coord_to_tableVal(0u, 0u, 0u);
+			for (NvFlowUint idx = 0u; idx < gridDim.x * gridDim.y * gridDim.z; idx++)
+			{
+				NvFlowUint vx = idx % gridDim.x;
+				NvFlowUint vy = (idx / gridDim.x) % gridDim.y;
+				NvFlowUint vz = idx / (gridDim.x * gridDim.y);
+				const NvFlowUint* tableRow = (const NvFlowUint*)((unsigned char*)tableMapped.data + vz * tableMapped.depthPitch + vy * tableMapped.rowPitch);
+				if (tableRow[vx] == ~0u)
+				{
+					padVal = NvFlowCPU_coord_to_tableVal(vx, vy, vz);
+					break;
+				}
+			}
+			for (NvFlowUint idx = numBlocks; idx < blockListDim; idx++)
+			{
+				listMapped[idx] = padVal;
+			}
+		}
+
+		NvFlowBufferUnmap(context, staging.blockList);
+		NvFlowTexture3DUnmap(context, staging.data);
+		NvFlowTexture3DUnmap(context, staging.blockTable);
+
+		NvFlowContextCopyResource(context, layerView.blockTableRW, NvFlowTexture3DGetResource(staging.blockTable));
+		NvFlowContextCopyResource(context, layerView.blockListRW, NvFlowBufferGetResource(staging.blockList));
+		NvFlowContextCopyResource(context, layerView.dataRW, NvFlowTexture3DGetResource(staging.data));
+	}
+	return true;
+}
+
+NvFlowGridExport* GridCachePlayerUpload(GridCachePlayer* player, NvFlowContext* context, NvFlowGridImport* gridImport, NvFlowGridImportStateCPU* stateCPU)
+{
+	if (GridCacheReaderGetNumFrames(player->m_reader) == 0u)
+	{
+		return nullptr;
+	}
+
+	// the slot is pinned while it is read outside the lock, the prefetch thread decodes around it
+	DecodedFrame* frame = nullptr;
+	{
+		std::unique_lock<std::mutex> lock(player->m_mutex);
+		const NvFlowUint playhead = player->m_playhead;
+		DecodedFrame& slot = player->m_frames[playhead % player->m_frames.size()];
+		if (!(slot.frameIdx == playhead && slot.ready))
+		{
+			player->m_stats.numStalls++;
+			player->m_requestCond.notify_all();
+			player->m_readyCond.wait(lock, [&]() { return slot.frameIdx == playhead && slot.ready; });
+		}
+		slot.uploading = true;
+		frame = &slot;
+	}
+
+	// counted locally, the stats are only touched under the lock
+	NvFlowUint numBlocksUploaded = 0u;
+	NvFlowUint numBlocksDropped = 0u;
+	bool uploaded = true;
+	const GridCacheFileHeader* fileHeader = GridCacheReaderGetHeader(player->m_reader);
+	for (NvFlowUint channelIdx = 0u; channelIdx < fileHeader->numChannels && uploaded; channelIdx++)
+	{
+		if (player->m_desc.channelMap[channelIdx] >= eNvFlowGridTextureChannelCount)
+		{
+			continue;
+		}
+		uploaded = player->uploadChannel(context, gridImport, stateCPU, channelIdx, *frame, &numBlocksUploaded, &numBlocksDropped);
+	}
+	player->m_modelMatrix = frame->header.modelMatrix;
+
+	{
+		std::lock_guard<std::mutex> lock(player->m_mutex);
+		frame->uploading = false;
+		player->m_stats.numBlocksUploaded = numBlocksUploaded;
+		player->m_stats.numBlocksDropped = numBlocksDropped;
+	}
+	player->m_requestCond.notify_all();
+
+	return uploaded ? NvFlowGridImportGetGridExport(gridImport, context) : nullptr;
+}
+
+NvFlowFloat4x4 GridCachePlayerGetModelMatrix(GridCachePlayer* player)
+{
+	return player->m_modelMatrix;
+}
+
+void GridCachePlayerGetStats(GridCachePlayer* player, GridCachePlayerStats* stats)
+{
+	std::lock_guard<std::mutex> lock(player->m_mutex);
+	*stats = player->m_stats;
+}
+
+void GridCachePlayerReleaseResources(GridCachePlayer* player)
+{
+	for (auto& stagingLayers : player->m_staging)
+	{
+		for (auto& staging : stagingLayers)
+		{
+			if (staging.blockTable) NvFlowReleaseTexture3D(staging.blockTable);
+			if (staging.blockList) NvFlowReleaseBuffer(staging.blockList);
+			if (staging.data) NvFlowReleaseTexture3D(staging.data);
+		}
+		stagingLayers.clear();
+	}
+}
@@ -0,0 +1,103 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "NvFlow.h"
+#include "NvFlowContextExt.h"
+
+#include "gridCache.h"
+
+/// ****************** Grid Cache Player Public *******************************
+
+// Replays a grid cache through a grid import driven by NvFlowGridImportStateCPU.
+//
+// Frames ahead of the playhead are decoded on a background thread into upload ready
+// block arrays, so playback only pays for the staging copy and the GPU upload.
+// The StateCPU is captured once from a template export with the same grid description
+// as the bake, it fixes the pool allocation, the player then writes block table,
+// block list and data for every layer of each bound channel.
+
+struct GridCachePlayer;
+
+struct GridCachePlayerDesc
+{
+	NvFlowUint numPrefetchFrames;								//!< Frames decoded ahead of the playhead, at most 63
+	bool loop;													//!< Prefetch wraps to frame 0 past the end
+	NvFlowFormat dataFormat;									//!< Import data format, r32g32b32a32_float or r16g16b16a16_float
+	NvFlowGridTextureChannel channelMap[GridCacheMaxChannels];	//!< Grid channel per cache channel, eNvFlowGridTextureChannelCount to skip
+};
+
+struct GridCachePlayerStats
+{
+	NvFlowUint numFramesDecoded;		//!< Frames decoded by the background thread
+	NvFlowUint numStalls;				//!< Uploads that waited on the background thread
+	NvFlowUint numBlocksUploaded;		//!< Blocks uploaded by the last upload
+	NvFlowUint numBlocksDropped;		//!< Blocks that did not fit the import pool on the last upload
+};
+
+void GridCachePlayerDescDefaults(GridCachePlayerDesc* desc);
+
+GridCachePlayer* GridCachePlayerCreate(const char* filename, const GridCachePlayerDesc* desc);
+
+void GridCachePlayerRelease(GridCachePlayer* player);
+
+NvFlowUint GridCachePlayerGetNumFrames(GridCachePlayer* player);
+
+//! Last frame with time <= time, through the frame index
+NvFlowUint GridCachePlayerFindFrame(GridCachePlayer* player, float time);
+
+//! Moves the playhead, prefetch restarts from frameIdx
+void GridCachePlayerSeek(GridCachePlayer* player, NvFlowUint frameIdx);
+
+NvFlowUint GridCachePlayerGetFrame(GridCachePlayer* player);
+
+//! True if the playhead frame is decoded, upload will not block
+bool GridCachePlayerIsFrameReady(GridCachePlayer* player);
+
+/**
+ * Upload the playhead frame into the grid import.
+ *
+ * Uploads are made from one thread at a time, seeks may come from others. The frame being
+ * uploaded is pinned, prefetch decodes around it until the upload returns.
+ *
+ * @param[in] player The grid cache player.
+ * @param[in] context The context used to create the grid import.
+ * @param[in] gridImport The grid import to write.
+ * @param[in] stateCPU Import CPU state captured from a template export.
+ *
+ * @return Returns the grid export of the import, nullptr on failure.
+ */
+NvFlowGridExport* GridCachePlayerUpload(GridCachePlayer* player, NvFlowContext* context, NvFlowGridImport* gridImport, NvFlowGridImportStateCPU* stateCPU);
+
+//! Transform from grid NDC to world of the last uploaded frame
+NvFlowFloat4x4 GridCachePlayerGetModelMatrix(GridCachePlayer* player);
+
+void GridCachePlayerGetStats(GridCachePlayer* player, GridCachePlayerStats* stats);
+
+//! Releases staging resources, call before releasing the context
+void GridCachePlayerReleaseResources(GridCachePlayer* player);
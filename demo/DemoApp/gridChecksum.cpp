@@ -0,0 +1,129 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "NvFlowShaderCPU.h"
+
+#include "cpuGrid.h"
+#include "gridChecksum.h"
+
+namespace
+{
+	const NvFlowUint64 checksumPrime = 0x100000001b3ull;
+
+	// z, y, x packed high to low, the level bits of the table value are dropped
+	NvFlowUint blockSortKey(NvFlowUint tableVal)
+	{
+		return (~tableVal) & 0x3FFFFFFFu;
+	}
+
+	NvFlowUint64 hashBlock(NvFlowUint64 hash, const NvFlowFloat4* pool, const CpuGridExport* gridExport, NvFlowUint tableVal)
+	{
+		const NvFlowShaderLinearParams& params = gridExport->mapping.shaderParams;
+		const NvFlowInt3 vBlockIdx = NvFlowCPU_tableVal_to_coord(tableVal);
+		const NvFlowUint rTableVal = NvFlowCPU_blockTableLoad(gridExport->blockTable, params, vBlockIdx.x, vBlockIdx.y, vBlockIdx.z);
+		const NvFlowUint level = NvFlowCPU_hasTableLevels(gridExport->tableParams) ? NvFlowCPU_tableVal_to_level(rTableVal) : 0u;
+		const int stride = 1 << level;
+
+		// coordinate and level first, so moving data between blocks changes the hash
+		const NvFlowUint header[4] = { NvFlowUint(vBlockIdx.x), NvFlowUint(vBlockIdx.y), NvFlowUint(vBlockIdx.z), level };
+		hash = GridChecksumAppend(hash, header, sizeof(header));
+
+		const int baseX = vBlockIdx.x << params.blockDimBits.x;
+		const int baseY = vBlockIdx.y << params.blockDimBits.y;
+		const int baseZ = vBlockIdx.z << params.blockDimBits.z;
+		for (int k = 0; k < int(params.blockDim.z); k += stride)
+		{
+			for (int j = 0; j < int(params.blockDim.y); j += stride)
+			{
+				// a row of stored cells is contiguous in the pool
+				NvFlowInt3 ridx = NvFlowCPU_virtualToRealLod(gridExport->blockTable, params, NvFlowInt3{ baseX, baseY + j, baseZ + k });
+				const NvFlowFloat4* row = &pool[(size_t(ridx.z) * gridExport->poolDim.y + ridx.y) * gridExport->poolDim.x + ridx.x];
+				hash = GridChecksumAppend(hash, row, (params.blockDim.x >> level) * sizeof(NvFlowFloat4));
+			}
+		}
+		return hash;
+	}
+}
+
+NvFlowUint64 GridChecksumAppend(NvFlowUint64 hash, const void* data, NvFlowUint64 sizeInBytes)
+{
+	// FNV-1a over 64 bit words, then the tail bytes
+	const unsigned char* ptr = (const unsigned char*)data;
+	NvFlowUint64 idx = 0u;
+	for (; idx + 8u <= sizeInBytes; idx += 8u)
+	{
+		NvFlowUint64 word;
+		memcpy(&word, ptr + idx, sizeof(word));
+		hash = (hash ^ word) * checksumPrime;
+	}
+	for (; idx < sizeInBytes; idx++)
+	{
+		hash = (hash ^ ptr[idx]) * checksumPrime;
+	}
+	return hash;
+}
+
+void GridChecksumSortLayeredBlockList(NvFlowUint2* blockList, NvFlowUint numBlocks)
+{
+	std::sort(blockList, blockList + numBlocks, [](const NvFlowUint2& a, const NvFlowUint2& b)
+	{
+		if (a.y != b.y)
+		{
+			return a.y < b.y;
+		}
+		return blockSortKey(a.x) < blockSortKey(b.x);
+	});
+}
+
+void GridChecksumSortBlockList(NvFlowUint* blockList, NvFlowUint numBlocks)
+{
+	std::sort(blockList, blockList + numBlocks, [](NvFlowUint a, NvFlowUint b)
+	{
+		return blockSortKey(a) < blockSortKey(b);
+	});
+}
+
+void GridChecksumCpuGrid(const CpuGridExport* gridExport, NvFlowUint64* velocity, NvFlowUint64* density)
+{
+	std::vector<NvFlowUint> blockList(gridExport->blockList, gridExport->blockList + gridExport->numBlocks);
+	GridChecksumSortBlockList(blockList.data(), NvFlowUint(blockList.size()));
+
+	NvFlowUint64 velocityHash = GridChecksumSeed;
+	NvFlowUint64 densityHash = GridChecksumSeed;
+	for (NvFlowUint tableVal : blockList)
+	{
+		velocityHash = hashBlock(velocityHash, gridExport->velocity, gridExport, tableVal);
+		densityHash = hashBlock(densityHash, gridExport->density, gridExport, tableVal);
+	}
+	if (velocity) *velocity = velocityHash;
+	if (density) *density = densityHash;
+}
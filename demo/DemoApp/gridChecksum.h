@@ -0,0 +1,54 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "NvFlow.h"
+
+struct CpuGridExport;
+
+/// ****************** Grid Checksum Public *******************************
+
+// Order independent checksums of exported grid data.
+//
+// Blocks are visited in virtual block order, never pool or block list order, so two runs
+// holding the same values hash the same even if the allocator placed blocks differently.
+// Cells are hashed as raw bits, a change in the last place of any component shows up.
+
+static const NvFlowUint64 GridChecksumSeed = 0xcbf29ce484222325ull;
+
+//! Folds sizeInBytes of data into hash
+NvFlowUint64 GridChecksumAppend(NvFlowUint64 hash, const void* data, NvFlowUint64 sizeInBytes);
+
+//! Sorts a layered block list by layer, then virtual z, y, x
+void GridChecksumSortLayeredBlockList(NvFlowUint2* blockList, NvFlowUint numBlocks);
+
+//! Sorts a block list by virtual z, y, x
+void GridChecksumSortBlockList(NvFlowUint* blockList, NvFlowUint numBlocks);
+
+//! Velocity and density checksums of a CPU grid export, levelled blocks hash their stored cells
+void GridChecksumCpuGrid(const CpuGridExport* gridExport, NvFlowUint64* velocity, NvFlowUint64* density);
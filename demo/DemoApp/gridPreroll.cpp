@@ -0,0 +1,155 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "gridPreroll.h"
+
+struct GridPreroll
+{
+	GridPrerollDesc m_desc;
+	std::vector<NvFlowShapeDesc> m_shapes;
+	std::vector<NvFlowGridEmitParams> m_emitParams;
+	std::vector<unsigned char> m_snapshot;
+
+	std::atomic<NvFlowUint> m_progress;
+	std::atomic<bool> m_cancel;
+	bool m_done = false;
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_doneCond;
+
+	void threadMain();
+};
+
+void GridPreroll::threadMain()
+{
+	CpuGridDesc gridDesc = m_desc.gridDesc;
+	gridDesc.pressureIterations = m_desc.pressureIterations;
+
+	CpuGrid* grid = CpuGridCreate(&gridDesc);
+	CpuGridSetParams(grid, &m_desc.params);
+	CpuGridSetMaterialParams(grid, &m_desc.materialParams);
+
+	for (NvFlowUint stepIdx = 0u; stepIdx < m_desc.numSteps && !m_cancel; stepIdx++)
+	{
+		CpuGridEmit(grid, m_shapes.data(), NvFlowUint(m_shapes.size()), m_emitParams.data(), NvFlowUint(m_emitParams.size()));
+		CpuGridUpdate(grid, m_desc.stepDt);
+		m_progress = stepIdx + 1u;
+	}
+
+	std::vector<unsigned char> snapshot;
+	if (!m_cancel)
+	{
+		snapshot.resize(CpuGridGetSnapshotSize(grid));
+		CpuGridSnapshot(grid, snapshot.data(), snapshot.size());
+	}
+	CpuGridRelease(grid);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_snapshot.swap(snapshot);
+	m_done = true;
+	m_doneCond.notify_all();
+}
+
+void GridPrerollDescDefaults(GridPrerollDesc* desc)
+{
+	CpuGridDescDefaults(&desc->gridDesc);
+	// leave most cores to the frame
+	desc->gridDesc.numWorkers = 2u;
+	desc->numSteps = 120u;
+	desc->stepDt = 1.f / 15.f;
+	desc->pressureIterations = 6u;
+	CpuGridParamsDefaults(&desc->params);
+	CpuGridMaterialParamsDefaults(&desc->materialParams);
+
+	desc->shapes = nullptr;
+	desc->numShapes = 0u;
+	desc->emitParams = nullptr;
+	desc->numEmitParams = 0u;
+}
+
+GridPreroll* GridPrerollStart(const GridPrerollDesc* desc)
+{
+	GridPreroll* preroll = new GridPreroll;
+	preroll->m_desc = *desc;
+	preroll->m_shapes.assign(desc->shapes, desc->shapes + desc->numShapes);
+	preroll->m_emitParams.assign(desc->emitParams, desc->emitParams + desc->numEmitParams);
+	for (auto& params : preroll->m_emitParams)
+	{
+		params.deltaTime = 0.f;
+	}
+	preroll->m_desc.shapes = nullptr;
+	preroll->m_desc.emitParams = nullptr;
+	preroll->m_progress = 0u;
+	preroll->m_cancel = false;
+
+	preroll->m_thread = std::thread([preroll]() { preroll->threadMain(); });
+
+	return preroll;
+}
+
+void GridPrerollRelease(GridPreroll* preroll)
+{
+	if (preroll == nullptr) return;
+
+	preroll->m_cancel = true;
+	preroll->m_thread.join();
+
+	delete preroll;
+}
+
+NvFlowUint GridPrerollGetProgress(GridPreroll* preroll)
+{
+	return preroll->m_progress;
+}
+
+bool GridPrerollIsDone(GridPreroll* preroll)
+{
+	std::lock_guard<std::mutex> lock(preroll->m_mutex);
+	return preroll->m_done;
+}
+
+const void* GridPrerollGetSnapshot(GridPreroll* preroll, bool wait, size_t* sizeInBytes)
+{
+	std::unique_lock<std::mutex> lock(preroll->m_mutex);
+	if (wait)
+	{
+		preroll->m_doneCond.wait(lock, [preroll]() { return preroll->m_done; });
+	}
+	if (!preroll->m_done)
+	{
+		*sizeInBytes = 0u;
+		return nullptr;
+	}
+	*sizeInBytes = preroll->m_snapshot.size();
+	return preroll->m_snapshot.data();
+}
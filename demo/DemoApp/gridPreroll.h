@@ -0,0 +1,81 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "NvFlow.h"
+
+#include "cpuGrid.h"
+
+/// ****************** Grid Preroll Public *******************************
+
+// Fast forwards a CPU grid on a background thread, so effects can start warm.
+//
+// The preroll owns its grid and worker pool, nothing is rendered or exported while it runs.
+// Steps use a larger dt and a relaxed pressure solve, then the state is handed back
+// as a CpuGridSnapshot() buffer for CpuGridRestore() into the runtime grid.
+
+struct GridPreroll;
+
+struct GridPrerollDesc
+{
+	CpuGridDesc gridDesc;					//!< Must match the grid the result is restored into
+	NvFlowUint numSteps;
+	float stepDt;							//!< Typically a few runtime steps long
+	NvFlowUint pressureIterations;			//!< Replaces gridDesc.pressureIterations while prerolling
+	NvFlowGridParams params;
+	NvFlowGridMaterialParams materialParams;
+
+	const NvFlowShapeDesc* shapes;			//!< Emitters applied every step, copied at start
+	NvFlowUint numShapes;
+	const NvFlowGridEmitParams* emitParams;	//!< deltaTime is ignored, emitters follow stepDt
+	NvFlowUint numEmitParams;
+};
+
+void GridPrerollDescDefaults(GridPrerollDesc* desc);
+
+//! Starts the preroll thread, returns immediately
+GridPreroll* GridPrerollStart(const GridPrerollDesc* desc);
+
+//! Cancels a running preroll and waits for its thread
+void GridPrerollRelease(GridPreroll* preroll);
+
+//! Steps completed so far
+NvFlowUint GridPrerollGetProgress(GridPreroll* preroll);
+
+bool GridPrerollIsDone(GridPreroll* preroll);
+
+/**
+ * Snapshot of the final state, for CpuGridRestore().
+ *
+ * @param[in] preroll The preroll.
+ * @param[in] wait If true, blocks until the preroll is done.
+ * @param[out] sizeInBytes Size of the snapshot.
+ *
+ * @return Returns the snapshot, owned by the preroll, nullptr if it is not done yet.
+ */
+const void* GridPrerollGetSnapshot(GridPreroll* preroll, bool wait, size_t* sizeInBytes);
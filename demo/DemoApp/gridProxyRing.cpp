@@ -0,0 +1,403 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <vector>
+#include <mutex>
+
+#include "gridProxyRing.h"
+
+namespace
+{
+	// resources of one written import layer, the render context copies from them
+	struct SlotLayer
+	{
+		NvFlowResource* data = nullptr;
+		NvFlowResource* blockTable = nullptr;
+		NvFlowResource* blockList = nullptr;
+	};
+
+	struct RingSlot
+	{
+		NvFlowGridImport* gridImport = nullptr;
+		NvFlowGridImportStateCPU* stateCPU = nullptr;
+		NvFlowGridExport* gridExport = nullptr;			// grid context export, only read if the contexts are shared
+		NvFlowGridImportStateCPU* renderStateCPU = nullptr;	// same capture, against the render import
+		std::vector<SlotLayer> layers[2];				// per ring channel
+		NvFlowUint64 renderFenceValue = 0u;	// signaled by the last reader, 0 if never read
+	};
+
+	const NvFlowGridTextureChannel ringChannels[2] = {
+		eNvFlowGridTextureChannelVelocity,
+		eNvFlowGridTextureChannelDensity
+	};
+
+	const NvFlowUint noSlot = GridProxyRingVersions::noSlot;
+}
+
+struct GridProxyRing
+{
+	std::vector<RingSlot> m_slots;
+	bool m_sharedContext = false;
+
+	// render context copy of the acquired version, the slots belong to the grid context
+	NvFlowGridImport* m_renderImport = nullptr;
+	NvFlowGridExport* m_renderExport = nullptr;
+	NvFlowUint64 m_renderVersion = 0u;
+
+	// render fence, created on the render context, shared to the grid context
+	NvFlowFence* m_renderFence = nullptr;
+	NvFlowFence* m_renderFenceGrid = nullptr;
+	NvFlowUint64 m_renderFenceNext = 0u;
+
+	std::mutex m_mutex;
+	GridProxyRingVersions m_versions;
+
+	void endRender(NvFlowContext* renderContext);
+	void copyChannel(RingSlot& slot, NvFlowContext* gridContext, NvFlowGridExport* gridExport, NvFlowUint channelIdx);
+	void copyToRender(const RingSlot& slot, NvFlowContext* renderContext);
+};
+
+void GridProxyRingVersions::reset(NvFlowUint ringDepth)
+{
+	m_slots.assign(ringDepth < 2u ? 2u : ringDepth, Slot());
+	m_nextVersion = 1u;
+	m_acquired = noSlot;
+	m_numPushed = 0u;
+	m_numSuperseded = 0u;
+}
+
+NvFlowUint GridProxyRingVersions::latestCompleted() const
+{
+	NvFlowUint latest = noSlot;
+	for (NvFlowUint idx = 0u; idx < m_slots.size(); idx++)
+	{
+		if (m_slots[idx].completed && (latest == noSlot || m_slots[idx].version > m_slots[latest].version))
+		{
+			latest = idx;
+		}
+	}
+	return latest;
+}
+
+NvFlowUint GridProxyRingVersions::beginPush()
+{
+	const NvFlowUint latest = latestCompleted();
+	NvFlowUint oldest = noSlot;
+	NvFlowUint oldestSpared = noSlot;
+	for (NvFlowUint idx = 0u; idx < m_slots.size(); idx++)
+	{
+		if (idx == m_acquired)
+		{
+			continue;
+		}
+		if (oldest == noSlot || m_slots[idx].version < m_slots[oldest].version)
+		{
+			oldest = idx;
+		}
+		if (idx != latest && (oldestSpared == noSlot || m_slots[idx].version < m_slots[oldestSpared].version))
+		{
+			oldestSpared = idx;
+		}
+	}
+	const NvFlowUint slotIdx = oldestSpared != noSlot ? oldestSpared : oldest;
+
+	Slot& slot = m_slots[slotIdx];
+	if (slot.version != 0u && !slot.completed)
+	{
+		m_numSuperseded++;
+	}
+	// invisible to acquire until the new copies complete
+	slot.completed = false;
+	slot.version = 0u;
+	return slotIdx;
+}
+
+NvFlowUint64 GridProxyRingVersions::endPush(NvFlowUint slotIdx, NvFlowUint64 fenceValue, bool completed)
+{
+	Slot& slot = m_slots[slotIdx];
+	slot.version = m_nextVersion++;
+	slot.gridFenceValue = fenceValue;
+	slot.completed = completed;
+	m_numPushed++;
+	return slot.version;
+}
+
+void GridProxyRingVersions::update(NvFlowUint64 lastFenceCompleted)
+{
+	for (Slot& slot : m_slots)
+	{
+		if (slot.version != 0u && !slot.completed && slot.gridFenceValue <= lastFenceCompleted)
+		{
+			slot.completed = true;
+		}
+	}
+}
+
+NvFlowUint GridProxyRingVersions::acquireLatest()
+{
+	m_acquired = latestCompleted();
+	return m_acquired;
+}
+
+void GridProxyRingVersions::getStats(GridProxyRingStats* stats) const
+{
+	stats->numPushed = m_numPushed;
+	stats->numSuperseded = m_numSuperseded;
+	NvFlowUint latest = latestCompleted();
+	stats->latestCompleted = latest != noSlot ? m_slots[latest].version : 0u;
+	stats->numPending = 0u;
+	for (const Slot& slot : m_slots)
+	{
+		if (slot.version != 0u && !slot.completed)
+		{
+			stats->numPending++;
+		}
+	}
+}
+
+void GridProxyRing::copyChannel(RingSlot& slot, NvFlowContext* gridContext, NvFlowGridExport* gridExport, NvFlowUint channelIdx)
+{
+	const NvFlowGridTextureChannel channel = ringChannels[channelIdx];
+	NvFlowGridExportHandle exportHandle = NvFlowGridExportGetHandle(gridExport, gridContext, channel);
+
+	// export data carries the linear apron, linear import keeps the layout
+	NvFlowGridImportStateCPUParams params = {};
+	params.stateCPU = slot.stateCPU;
+	params.channel = channel;
+	params.importMode = eNvFlowGridImportModeLinear;
+	NvFlowGridImportHandle importHandle = NvFlowGridImportStateCPUGetHandle(slot.gridImport, gridContext, &params);
+
+	const NvFlowUint numLayers = exportHandle.numLayerViews < importHandle.numLayerViews ? exportHandle.numLayerViews : importHandle.numLayerViews;
+	std::vector<SlotLayer>& layers = slot.layers[channelIdx];
+	layers.resize(numLayers);
+	for (NvFlowUint layerIdx = 0u; layerIdx < numLayers; layerIdx++)
+	{
+		NvFlowGridExportLayerView exportView = {};
+		NvFlowGridExportGetLayerView(exportHandle, layerIdx, &exportView);
+		NvFlowGridImportLayerView importView = {};
+		NvFlowGridImportGetLayerView(importHandle, layerIdx, &importView);
+
+		SlotLayer& layer = layers[layerIdx];
+		layer = SlotLayer();
+		NvFlowContextCopyResource(gridContext, importView.dataRW, exportView.data);
+		layer.data = NvFlowResourceRWGetResource(importView.dataRW);
+		if (importView.blockTableRW)
+		{
+			NvFlowContextCopyResource(gridContext, importView.blockTableRW, exportView.mapping.blockTable);
+			layer.blockTable = NvFlowResourceRWGetResource(importView.blockTableRW);
+		}
+		if (importView.blockListRW)
+		{
+			NvFlowContextCopyResource(gridContext, importView.blockListRW, exportView.mapping.blockList);
+			layer.blockList = NvFlowResourceRWGetResource(importView.blockListRW);
+		}
+	}
+}
+
+void GridProxyRing::copyToRender(const RingSlot& slot, NvFlowContext* renderContext)
+{
+	// the grid queue finished writing the slot, both contexts are on one device
+	for (NvFlowUint channelIdx = 0u; channelIdx < 2u; channelIdx++)
+	{
+		NvFlowGridImportStateCPUParams params = {};
+		params.stateCPU = slot.renderStateCPU;
+		params.channel = ringChannels[channelIdx];
+		params.importMode = eNvFlowGridImportModeLinear;
+		NvFlowGridImportHandle importHandle = NvFlowGridImportStateCPUGetHandle(m_renderImport, renderContext, &params);
+
+		const std::vector<SlotLayer>& layers = slot.layers[channelIdx];
+		const NvFlowUint numLayers = NvFlowUint(layers.size()) < importHandle.numLayerViews ? NvFlowUint(layers.size()) : importHandle.numLayerViews;
+		for (NvFlowUint layerIdx = 0u; layerIdx < numLayers; layerIdx++)
+		{
+			NvFlowGridImportLayerView importView = {};
+			NvFlowGridImportGetLayerView(importHandle, layerIdx, &importView);
+
+			const SlotLayer& layer = layers[layerIdx];
+			NvFlowContextCopyResource(renderContext, importView.dataRW, layer.data);
+			if (importView.blockTableRW && layer.blockTable)
+			{
+				NvFlowContextCopyResource(renderContext, importView.blockTableRW, layer.blockTable);
+			}
+			if (importView.blockListRW && layer.blockList)
+			{
+				NvFlowContextCopyResource(renderContext, importView.blockListRW, layer.blockList);
+			}
+		}
+	}
+	m_renderExport = NvFlowGridImportGetGridExport(m_renderImport, renderContext);
+}
+
+void GridProxyRingDescDefaults(GridProxyRingDesc* desc)
+{
+	desc->ringDepth = 3u;
+	desc->gridExport = nullptr;
+}
+
+GridProxyRing* GridProxyRingCreate(NvFlowContext* gridContext, NvFlowContext* renderContext, const GridProxyRingDesc* desc)
+{
+	GridProxyRing* ring = new GridProxyRing;
+	ring->m_versions.reset(desc->ringDepth);
+	ring->m_slots.resize(ring->m_versions.m_slots.size());
+	ring->m_sharedContext = (gridContext == renderContext);
+
+	NvFlowGridImportDesc importDesc = {};
+	importDesc.gridExport = desc->gridExport;
+	if (!ring->m_sharedContext)
+	{
+		ring->m_renderImport = NvFlowCreateGridImport(renderContext, &importDesc);
+	}
+	for (RingSlot& slot : ring->m_slots)
+	{
+		slot.gridImport = NvFlowCreateGridImport(gridContext, &importDesc);
+		slot.stateCPU = NvFlowCreateGridImportStateCPU(slot.gridImport);
+		if (ring->m_renderImport)
+		{
+			slot.renderStateCPU = NvFlowCreateGridImportStateCPU(ring->m_renderImport);
+		}
+	}
+
+	if (!ring->m_sharedContext)
+	{
+		NvFlowFenceDesc fenceDesc = {};
+		fenceDesc.crossAdapterShared = false;
+		ring->m_renderFence = NvFlowCreateFence(renderContext, &fenceDesc);
+		ring->m_renderFenceGrid = NvFlowShareFence(gridContext, ring->m_renderFence);
+	}
+
+	return ring;
+}
+
+void GridProxyRingRelease(GridProxyRing* ring)
+{
+	if (ring == nullptr) return;
+
+	for (RingSlot& slot : ring->m_slots)
+	{
+		if (slot.renderStateCPU) NvFlowReleaseGridImportStateCPU(slot.renderStateCPU);
+		NvFlowReleaseGridImportStateCPU(slot.stateCPU);
+		NvFlowReleaseGridImport(slot.gridImport);
+	}
+	if (ring->m_renderImport) NvFlowReleaseGridImport(ring->m_renderImport);
+	if (ring->m_renderFenceGrid) NvFlowReleaseFence(ring->m_renderFenceGrid);
+	if (ring->m_renderFence) NvFlowReleaseFence(ring->m_renderFence);
+
+	delete ring;
+}
+
+NvFlowUint64 GridProxyRingPush(GridProxyRing* ring, NvFlowContext* gridContext, NvFlowGridExport* gridExport, NvFlowUint64 fenceValue)
+{
+	NvFlowUint slotIdx;
+	NvFlowUint64 renderFenceValue;
+	{
+		std::lock_guard<std::mutex> lock(ring->m_mutex);
+		slotIdx = ring->m_versions.beginPush();
+		renderFenceValue = ring->m_slots[slotIdx].renderFenceValue;
+	}
+
+	RingSlot& slot = ring->m_slots[slotIdx];
+
+	// the last reader of this slot may still be rendering it
+	if (ring->m_renderFenceGrid && renderFenceValue != 0u)
+	{
+		NvFlowContextWaitOnFence(gridContext, ring->m_renderFenceGrid, renderFenceValue);
+	}
+
+	NvFlowGridImportUpdateStateCPU(slot.stateCPU, gridContext, gridExport);
+	if (slot.renderStateCPU)
+	{
+		NvFlowGridImportUpdateStateCPU(slot.renderStateCPU, gridContext, gridExport);
+	}
+	for (NvFlowUint channelIdx = 0u; channelIdx < 2u; channelIdx++)
+	{
+		ring->copyChannel(slot, gridContext, gridExport, channelIdx);
+	}
+	slot.gridExport = NvFlowGridImportGetGridExport(slot.gridImport, gridContext);
+
+	std::lock_guard<std::mutex> lock(ring->m_mutex);
+	return ring->m_versions.endPush(slotIdx, fenceValue, ring->m_sharedContext || fenceValue == 0u);
+}
+
+void GridProxyRingUpdate(GridProxyRing* ring, NvFlowUint64 lastFenceCompleted)
+{
+	std::lock_guard<std::mutex> lock(ring->m_mutex);
+	ring->m_versions.update(lastFenceCompleted);
+}
+
+void GridProxyRing::endRender(NvFlowContext* renderContext)
+{
+	if (m_versions.m_acquired == noSlot)
+	{
+		return;
+	}
+	const RingSlot& slot = m_slots[m_versions.m_acquired];
+	if (m_renderFence && slot.renderFenceValue != 0u)
+	{
+		NvFlowContextSignalFence(renderContext, m_renderFence, slot.renderFenceValue);
+	}
+	m_versions.m_acquired = noSlot;
+}
+
+NvFlowGridExport* GridProxyRingAcquireLatest(GridProxyRing* ring, NvFlowContext* renderContext, NvFlowUint64* version)
+{
+	std::lock_guard<std::mutex> lock(ring->m_mutex);
+	// a missed GridProxyRingRenderEnd() would stall the grid queue on the old slot
+	ring->endRender(renderContext);
+	NvFlowUint latest = ring->m_versions.acquireLatest();
+	if (latest == noSlot)
+	{
+		if (version) *version = 0u;
+		return nullptr;
+	}
+	RingSlot& slot = ring->m_slots[latest];
+	const NvFlowUint64 slotVersion = ring->m_versions.m_slots[latest].version;
+	slot.renderFenceValue = ring->m_renderFence ? ++ring->m_renderFenceNext : 0u;
+	if (version) *version = slotVersion;
+	if (ring->m_sharedContext)
+	{
+		return slot.gridExport;
+	}
+
+	// one copy per version, the render fence signaled at render end covers it
+	if (ring->m_renderVersion != slotVersion)
+	{
+		ring->copyToRender(slot, renderContext);
+		ring->m_renderVersion = slotVersion;
+	}
+	return ring->m_renderExport;
+}
+
+void GridProxyRingRenderEnd(GridProxyRing* ring, NvFlowContext* renderContext)
+{
+	std::lock_guard<std::mutex> lock(ring->m_mutex);
+	ring->endRender(renderContext);
+}
+
+void GridProxyRingGetStats(GridProxyRing* ring, GridProxyRingStats* stats)
+{
+	std::lock_guard<std::mutex> lock(ring->m_mutex);
+	ring->m_versions.getStats(stats);
+}
@@ -0,0 +1,130 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include <vector>
+
+#include "NvFlow.h"
+#include "NvFlowContextExt.h"
+
+/// ****************** Grid Proxy Ring Public *******************************
+
+// Versioned grid exports for a renderer on another queue of the same device.
+//
+// Each push copies block tables, block lists and data of velocity and density into a ring
+// slot, a grid import driven by NvFlowGridImportStateCPU, and tags the version with the grid
+// queue fence its copies complete with. The renderer acquires the newest completed version,
+// so it never waits on the simulation queue. Slots belong to the grid context, so an acquired
+// version is copied once on the render context into an import created there, whose export the
+// renderer reads. An acquired slot is guarded by a render fence, the grid queue waits on it on
+// the GPU before the slot is written again.
+// Push and acquire may be called from different threads.
+
+struct GridProxyRing;
+
+struct GridProxyRingDesc
+{
+	NvFlowUint ringDepth;				//!< Versions kept, 3 lets the simulation run a version ahead of the renderer
+	NvFlowGridExport* gridExport;		//!< Template for import allocation
+};
+
+struct GridProxyRingStats
+{
+	NvFlowUint64 numPushed;
+	NvFlowUint64 numSuperseded;			//!< Versions overwritten before they completed
+	NvFlowUint64 latestCompleted;		//!< Newest completed version, 0 if none
+	NvFlowUint numPending;				//!< Versions waiting on the grid queue
+};
+
+// Version bookkeeping of the ring slots, no device work, the ring calls it under its mutex.
+struct GridProxyRingVersions
+{
+	static const NvFlowUint noSlot = ~0u;
+
+	struct Slot
+	{
+		NvFlowUint64 version = 0u;			//!< 0 if never written or being written
+		NvFlowUint64 gridFenceValue = 0u;
+		bool completed = false;
+	};
+
+	std::vector<Slot> m_slots;
+	NvFlowUint64 m_nextVersion = 1u;
+	NvFlowUint m_acquired = noSlot;		//!< Slot the renderer holds
+	NvFlowUint64 m_numPushed = 0u;
+	NvFlowUint64 m_numSuperseded = 0u;
+
+	//! Resets to ringDepth empty slots, at least 2
+	void reset(NvFlowUint ringDepth);
+
+	//! Newest completed slot, noSlot if none
+	NvFlowUint latestCompleted() const;
+
+	//! Picks the oldest slot the renderer does not hold, sparing the newest completed version if possible, and hides it from acquire
+	NvFlowUint beginPush();
+
+	//! Publishes the written slot, completed if its copies need no fence wait, returns the version
+	NvFlowUint64 endPush(NvFlowUint slotIdx, NvFlowUint64 fenceValue, bool completed);
+
+	//! Marks versions with a fence at or below lastFenceCompleted as completed
+	void update(NvFlowUint64 lastFenceCompleted);
+
+	//! Holds the newest completed slot for the renderer, noSlot if none
+	NvFlowUint acquireLatest();
+
+	void getStats(GridProxyRingStats* stats) const;
+};
+
+void GridProxyRingDescDefaults(GridProxyRingDesc* desc);
+
+GridProxyRing* GridProxyRingCreate(NvFlowContext* gridContext, NvFlowContext* renderContext, const GridProxyRingDesc* desc);
+
+void GridProxyRingRelease(GridProxyRing* ring);
+
+/**
+ * Copy the export into the next version, on the grid context after the simulation update.
+ *
+ * @param[in] ring The proxy ring.
+ * @param[in] gridContext The context the export is valid on.
+ * @param[in] gridExport The export to version.
+ * @param[in] fenceValue Grid queue fence signaled by the flush carrying the copies, 0 if grid and render share a context.
+ *
+ * @return Returns the version number, starting at 1.
+ */
+NvFlowUint64 GridProxyRingPush(GridProxyRing* ring, NvFlowContext* gridContext, NvFlowGridExport* gridExport, NvFlowUint64 fenceValue);
+
+//! Marks versions with a fence at or below lastFenceCompleted as completed
+void GridProxyRingUpdate(GridProxyRing* ring, NvFlowUint64 lastFenceCompleted);
+
+//! Newest completed version as a render context export, held until GridProxyRingRenderEnd(), nullptr if none completed yet
+NvFlowGridExport* GridProxyRingAcquireLatest(GridProxyRing* ring, NvFlowContext* renderContext, NvFlowUint64* version);
+
+//! Call after the last use of the acquired export on the render context, releases it to the grid queue
+void GridProxyRingRenderEnd(GridProxyRing* ring, NvFlowContext* renderContext);
+
+void GridProxyRingGetStats(GridProxyRing* ring, GridProxyRingStats* stats);
@@ -0,0 +1,414 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <string.h>
+#include <float.h>
+
+#include <vector>
+
+#include "NvFlowShaderCPU.h"
+
+#include "gridStats.h"
+#include "gridChecksum.h"
+#include "halfFloat.h"
+
+namespace
+{
+	struct ComponentLayer
+	{
+		NvFlowTexture3D* blockTable = nullptr;
+		NvFlowTexture3D* data = nullptr;
+		NvFlowDim blockTableDim = { 0u, 0u, 0u };
+		NvFlowDim dataDim = { 0u, 0u, 0u };
+	};
+
+	struct Slot
+	{
+		bool pending = false;
+		bool hasComponents = false;
+		NvFlowUint64 fenceValue = 0u;
+		GridStatsResult result;
+
+		NvFlowShaderLinearParams shaderParams[GridStatsNumChannels];
+		std::vector<NvFlowUint2> blockList[GridStatsNumChannels];
+		std::vector<ComponentLayer> layers[GridStatsNumChannels];
+	};
+
+	const NvFlowGridTextureChannel statsChannels[GridStatsNumChannels] = {
+		eNvFlowGridTextureChannelVelocity,
+		eNvFlowGridTextureChannelDensity
+	};
+}
+
+struct GridStatsQuery
+{
+	GridStatsQueryDesc m_desc;
+	std::vector<Slot> m_slots;
+	NvFlowUint64 m_frameIdx = 0u;
+
+	void pushComponents(Slot& slot, NvFlowContext* context, NvFlowUint channelIdx, NvFlowGridExportHandle handle);
+	void reduceComponents(Slot& slot, NvFlowContext* context, NvFlowUint channelIdx);
+	void releaseSlot(Slot& slot);
+};
+
+void GridStatsQueryDescDefaults(GridStatsQueryDesc* desc)
+{
+	desc->latency = 3u;
+	desc->enableComponents = false;
+	desc->componentInterval = 8u;
+	desc->componentFormat = eNvFlowFormat_r16g16b16a16_float;
+}
+
+GridStatsQuery* GridStatsQueryCreate(const GridStatsQueryDesc* desc)
+{
+	GridStatsQuery* query = new GridStatsQuery;
+	query->m_desc = *desc;
+	if (query->m_desc.componentInterval == 0u)
+	{
+		query->m_desc.componentInterval = 1u;
+	}
+	query->m_slots.resize(desc->latency + 1u);
+	return query;
+}
+
+void GridStatsQuery::releaseSlot(Slot& slot)
+{
+	for (auto& layers : slot.layers)
+	{
+		for (auto& layer : layers)
+		{
+			if (layer.blockTable) NvFlowReleaseTexture3D(layer.blockTable);
+			if (layer.data) NvFlowReleaseTexture3D(layer.data);
+		}
+		layers.clear();
+	}
+}
+
+void GridStatsQueryRelease(GridStatsQuery* query)
+{
+	if (query == nullptr) return;
+
+	for (auto& slot : query->m_slots)
+	{
+		query->releaseSlot(slot);
+	}
+	delete query;
+}
+
+void GridStatsQuerySetComponentsEnabled(GridStatsQuery* query, bool enabled)
+{
+	query->m_desc.enableComponents = enabled;
+	if (!enabled)
+	{
+		for (auto& slot : query->m_slots)
+		{
+			slot.hasComponents = false;
+			query->releaseSlot(slot);
+		}
+	}
+}
+
+void GridStatsQuery::pushComponents(Slot& slot, NvFlowContext* context, NvFlowUint channelIdx, NvFlowGridExportHandle handle)
+{
+	const NvFlowShaderLinearParams& shaderParams = slot.shaderParams[channelIdx];
+	const NvFlowDim blockTableDim = { shaderParams.gridDim.x, shaderParams.gridDim.y, shaderParams.gridDim.z };
+	const NvFlowDim dataDim = {
+		shaderParams.poolGridDim.x * shaderParams.linearBlockDim.x,
+		shaderParams.poolGridDim.y * shaderParams.linearBlockDim.y,
+		shaderParams.poolGridDim.z * shaderParams.linearBlockDim.z
+	};
+
+	std::vector<ComponentLayer>& layers = slot.layers[channelIdx];
+	if (layers.size() < handle.numLayerViews)
+	{
+		layers.resize(handle.numLayerViews);
+	}
+	for (NvFlowUint layerIdx = 0u; layerIdx < handle.numLayerViews; layerIdx++)
+	{
+		NvFlowGridExportLayerView layerView = {};
+		NvFlowGridExportGetLayerView(handle, layerIdx, &layerView);
+
+		ComponentLayer& layer = layers[layerIdx];
+		if (layer.blockTable == nullptr || memcmp(&layer.blockTableDim, &blockTableDim, sizeof(NvFlowDim)) != 0)
+		{
+			if (layer.blockTable) NvFlowReleaseTexture3D(layer.blockTable);
+			NvFlowTexture3DDesc texDesc = {};
+			texDesc.format = eNvFlowFormat_r32_uint;
+			texDesc.dim = blockTableDim;
+			texDesc.uploadAccess = false;
+			texDesc.downloadAccess = true;
+			layer.blockTable = NvFlowCreateTexture3D(context, &texDesc);
+			layer.blockTableDim = blockTableDim;
+		}
+		if (layer.data == nullptr || memcmp(&layer.dataDim, &dataDim, sizeof(NvFlowDim)) != 0)
+		{
+			if (layer.data) NvFlowReleaseTexture3D(layer.data);
+			NvFlowTexture3DDesc texDesc = {};
+			texDesc.format = m_desc.componentFormat;
+			texDesc.dim = dataDim;
+			texDesc.uploadAccess = false;
+			texDesc.downloadAccess = true;
+			layer.data = NvFlowCreateTexture3D(context, &texDesc);
+			layer.dataDim = dataDim;
+		}
+
+		NvFlowContextCopyResource(context, NvFlowTexture3DGetResourceRW(layer.blockTable), layerView.mapping.blockTable);
+		NvFlowContextCopyResource(context, NvFlowTexture3DGetResourceRW(layer.data), layerView.data);
+		NvFlowTexture3DDownload(context, layer.blockTable);
+		NvFlowTexture3DDownload(context, layer.data);
+	}
+}
+
+void GridStatsQueryPush(GridStatsQuery* query, NvFlowContext* context, NvFlowGridExport* gridExport, NvFlowUint numEmitters, NvFlowUint64 fenceValue)
+{
+	const NvFlowUint64 frameIdx = query->m_frameIdx++;
+	Slot& slot = query->m_slots[frameIdx % query->m_slots.size()];
+
+	// an unpolled result in this slot is dropped
+	slot.pending = true;
+	slot.fenceValue = fenceValue;
+	slot.hasComponents = query->m_desc.enableComponents && (frameIdx % query->m_desc.componentInterval) == 0u;
+	memset(&slot.result, 0, sizeof(slot.result));
+	slot.result.frameIdx = frameIdx;
+	slot.result.numEmitters = numEmitters;
+
+	for (NvFlowUint channelIdx = 0u; channelIdx < GridStatsNumChannels; channelIdx++)
+	{
+		GridStatsChannel& channel = slot.result.channels[channelIdx];
+
+		NvFlowGridExportHandle handle = NvFlowGridExportGetHandle(gridExport, context, statsChannels[channelIdx]);
+		NvFlowGridExportLayeredView layeredView = {};
+		NvFlowGridExportGetLayeredView(handle, &layeredView);
+
+		const NvFlowUint numCellsPerBlock = layeredView.mapping.shaderParams.blockDim.w;
+		channel.numLayers = handle.numLayerViews;
+		channel.maxBlocks = layeredView.mapping.maxBlocks;
+
+		// the layered block list carries the layer of every block, no need to visit each layer view
+		if (layeredView.mapping.layeredBlockListCPU)
+		{
+			for (NvFlowUint idx = 0u; idx < layeredView.mapping.layeredNumBlocks; idx++)
+			{
+				NvFlowUint layerIdx = layeredView.mapping.layeredBlockListCPU[idx].y;
+				if (layerIdx < GridStatsMaxLayers)
+				{
+					channel.layers[layerIdx].numBlocks++;
+				}
+			}
+			channel.numBlocks = layeredView.mapping.layeredNumBlocks;
+		}
+		else
+		{
+			for (NvFlowUint layerIdx = 0u; layerIdx < handle.numLayerViews; layerIdx++)
+			{
+				NvFlowGridExportLayerView layerView = {};
+				NvFlowGridExportGetLayerView(handle, layerIdx, &layerView);
+				if (layerIdx < GridStatsMaxLayers)
+				{
+					channel.layers[layerIdx].numBlocks = layerView.mapping.numBlocks;
+				}
+				channel.numBlocks += layerView.mapping.numBlocks;
+			}
+		}
+		for (NvFlowUint layerIdx = 0u; layerIdx < GridStatsMaxLayers; layerIdx++)
+		{
+			channel.layers[layerIdx].numCells = channel.layers[layerIdx].numBlocks * numCellsPerBlock;
+		}
+		channel.numCells = channel.numBlocks * numCellsPerBlock;
+
+		slot.shaderParams[channelIdx] = layeredView.mapping.shaderParams;
+		slot.blockList[channelIdx].clear();
+
+		// tiled resource pools are the size of the virtual space, too large to download
+		bool canDownload = layeredView.mapping.layeredBlockListCPU != nullptr &&
+			layeredView.mapping.shaderParams.isVTR.x == 0u;
+		if (slot.hasComponents && canDownload)
+		{
+			slot.blockList[channelIdx].assign(layeredView.mapping.layeredBlockListCPU, layeredView.mapping.layeredBlockListCPU + layeredView.mapping.layeredNumBlocks);
+			// reduce in virtual order, so sums and checksums do not depend on where blocks were allocated
+			GridChecksumSortLayeredBlockList(slot.blockList[channelIdx].data(), NvFlowUint(slot.blockList[channelIdx].size()));
+			query->pushComponents(slot, context, channelIdx, handle);
+			channel.hasComponents = true;
+		}
+	}
+}
+
+void GridStatsComponentsReset(GridStatsComponents* components)
+{
+	for (int c = 0; c < 4; c++)
+	{
+		components->minVal[c] = FLT_MAX;
+		components->maxVal[c] = -FLT_MAX;
+		components->sum[c] = 0.0;
+	}
+	components->count = 0u;
+	components->checksum = GridChecksumSeed;
+}
+
+void GridStatsComponentsAddLayer(GridStatsComponents* components, const NvFlowShaderLinearParams& shaderParams,
+	const NvFlowUint2* blockList, NvFlowUint numBlocks, NvFlowUint layerIdx,
+	const NvFlowMappedData& blockTable, const NvFlowMappedData& data, NvFlowFormat format)
+{
+	const bool isHalf = format == eNvFlowFormat_r16g16b16a16_float;
+	const NvFlowUint elementSize = isHalf ? 8u : 16u;
+
+	NvFlowUint64 checksum = components->checksum;
+	for (NvFlowUint blockIdx = 0u; blockIdx < numBlocks; blockIdx++)
+	{
+		const NvFlowUint2& entry = blockList[blockIdx];
+		if (entry.y != layerIdx)
+		{
+			continue;
+		}
+		NvFlowInt3 vBlockIdx = NvFlowCPU_tableVal_to_coord(entry.x);
+		const NvFlowUint* tableRow = (const NvFlowUint*)((const unsigned char*)blockTable.data +
+			vBlockIdx.z * blockTable.depthPitch + vBlockIdx.y * blockTable.rowPitch);
+		NvFlowInt3 rBlockIdx = NvFlowCPU_tableVal_to_coord(tableRow[vBlockIdx.x]);
+
+		const NvFlowUint baseX = rBlockIdx.x * shaderParams.linearBlockDim.x + shaderParams.linearBlockOffset.x;
+		const NvFlowUint baseY = rBlockIdx.y * shaderParams.linearBlockDim.y + shaderParams.linearBlockOffset.y;
+		const NvFlowUint baseZ = rBlockIdx.z * shaderParams.linearBlockDim.z + shaderParams.linearBlockOffset.z;
+
+		const NvFlowUint header[4] = { layerIdx, NvFlowUint(vBlockIdx.x), NvFlowUint(vBlockIdx.y), NvFlowUint(vBlockIdx.z) };
+		checksum = GridChecksumAppend(checksum, header, sizeof(header));
+		for (NvFlowUint k = 0u; k < shaderParams.blockDim.z; k++)
+		{
+			for (NvFlowUint j = 0u; j < shaderParams.blockDim.y; j++)
+			{
+				const unsigned char* row = (const unsigned char*)data.data +
+					(baseZ + k) * data.depthPitch + (baseY + j) * data.rowPitch + baseX * elementSize;
+				checksum = GridChecksumAppend(checksum, row, shaderParams.blockDim.x * elementSize);
+				for (NvFlowUint i = 0u; i < shaderParams.blockDim.x; i++)
+				{
+					float value[4];
+					if (isHalf)
+					{
+						const unsigned short* src = (const unsigned short*)(row + i * elementSize);
+						for (int c = 0; c < 4; c++) value[c] = HalfFloatToFloat(src[c]);
+					}
+					else
+					{
+						memcpy(value, row + i * elementSize, sizeof(value));
+					}
+					for (int c = 0; c < 4; c++)
+					{
+						if (value[c] < components->minVal[c]) components->minVal[c] = value[c];
+						if (value[c] > components->maxVal[c]) components->maxVal[c] = value[c];
+						components->sum[c] += value[c];
+					}
+				}
+			}
+		}
+		components->count += shaderParams.blockDim.w;
+	}
+	components->checksum = checksum;
+}
+
+void GridStatsComponentsResolve(const GridStatsComponents* components, GridStatsChannel* channel)
+{
+	channel->checksum = components->checksum;
+	if (components->count == 0u)
+	{
+		channel->componentMin = { 0.f, 0.f, 0.f, 0.f };
+		channel->componentMax = { 0.f, 0.f, 0.f, 0.f };
+		channel->componentMean = { 0.f, 0.f, 0.f, 0.f };
+		return;
+	}
+	const float* minVal = components->minVal;
+	const float* maxVal = components->maxVal;
+	const double* sum = components->sum;
+	const double count = double(components->count);
+	channel->componentMin = { minVal[0], minVal[1], minVal[2], minVal[3] };
+	channel->componentMax = { maxVal[0], maxVal[1], maxVal[2], maxVal[3] };
+	channel->componentMean = {
+		float(sum[0] / count),
+		float(sum[1] / count),
+		float(sum[2] / count),
+		float(sum[3] / count)
+	};
+}
+
+void GridStatsQuery::reduceComponents(Slot& slot, NvFlowContext* context, NvFlowUint channelIdx)
+{
+	const std::vector<NvFlowUint2>& blockList = slot.blockList[channelIdx];
+	std::vector<ComponentLayer>& layers = slot.layers[channelIdx];
+
+	GridStatsComponents components;
+	GridStatsComponentsReset(&components);
+	for (NvFlowUint layerIdx = 0u; layerIdx < layers.size(); layerIdx++)
+	{
+		ComponentLayer& layer = layers[layerIdx];
+		NvFlowMappedData tableMapped = NvFlowTexture3DMapDownload(context, layer.blockTable);
+		NvFlowMappedData dataMapped = NvFlowTexture3DMapDownload(context, layer.data);
+
+		GridStatsComponentsAddLayer(&components, slot.shaderParams[channelIdx], blockList.data(), NvFlowUint(blockList.size()),
+			layerIdx, tableMapped, dataMapped, m_desc.componentFormat);
+
+		NvFlowTexture3DUnmapDownload(context, layer.data);
+		NvFlowTexture3DUnmapDownload(context, layer.blockTable);
+	}
+	GridStatsComponentsResolve(&components, &slot.result.channels[channelIdx]);
+}
+
+bool GridStatsQueryPoll(GridStatsQuery* query, NvFlowContext* context, NvFlowUint64 lastFenceCompleted, GridStatsResult* result)
+{
+	const NvFlowUint64 latency = query->m_desc.latency;
+	Slot* newest = nullptr;
+	for (auto& slot : query->m_slots)
+	{
+		// a shared context has no grid queue fence, fall back to frame latency
+		bool completed = slot.fenceValue != 0u ?
+			slot.fenceValue <= lastFenceCompleted :
+			slot.result.frameIdx + latency < query->m_frameIdx;
+		if (slot.pending && completed)
+		{
+			slot.pending = false;
+			if (newest == nullptr || slot.result.frameIdx > newest->result.frameIdx)
+			{
+				newest = &slot;
+			}
+		}
+	}
+	if (newest == nullptr)
+	{
+		return false;
+	}
+
+	if (newest->hasComponents)
+	{
+		for (NvFlowUint channelIdx = 0u; channelIdx < GridStatsNumChannels; channelIdx++)
+		{
+			if (newest->result.channels[channelIdx].hasComponents)
+			{
+				query->reduceComponents(*newest, context, channelIdx);
+			}
+		}
+	}
+
+	*result = newest->result;
+	return true;
+}
@@ -0,0 +1,144 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "NvFlow.h"
+#include "NvFlowContextExt.h"
+
+/// ****************** Grid Stats Public *******************************
+
+// Ring buffered grid statistics.
+//
+// Each push records the layout of the export and, if enabled, queues GPU copies
+// and downloads of the block tables and data. A result comes back once the grid queue fence
+// of its push has completed, or latency frames later when the grid shares the app context,
+// so polling never waits on the GPU.
+// Components are reduced in virtual block order, so they match between runs that hold the same data.
+
+static const NvFlowUint GridStatsMaxLayers = 16u;
+static const NvFlowUint GridStatsNumChannels = 2u;		//!< Velocity and density
+
+struct GridStatsQuery;
+
+struct GridStatsQueryDesc
+{
+	NvFlowUint latency;					//!< Frames between push and result without a fence, also the ring size
+	bool enableComponents;				//!< Download data for per component min/max/mean
+	NvFlowUint componentInterval;		//!< Frames between component downloads
+	NvFlowFormat componentFormat;		//!< Export data format, r16g16b16a16_float or r32g32b32a32_float
+};
+
+struct GridStatsLayer
+{
+	NvFlowUint numBlocks;
+	NvFlowUint numCells;
+};
+
+struct GridStatsChannel
+{
+	NvFlowUint numLayers;
+	NvFlowUint numBlocks;				//!< Sum over layers
+	NvFlowUint numCells;				//!< Sum over layers
+	NvFlowUint maxBlocks;
+	GridStatsLayer layers[GridStatsMaxLayers];
+
+	bool hasComponents;					//!< min/max/mean and checksum are valid
+	NvFlowFloat4 componentMin;
+	NvFlowFloat4 componentMax;
+	NvFlowFloat4 componentMean;
+	NvFlowUint64 checksum;				//!< Raw bits of every cell in virtual block order, see gridChecksum.h
+};
+
+struct GridStatsResult
+{
+	NvFlowUint64 frameIdx;				//!< Frame the result was pushed in
+	NvFlowUint numEmitters;
+	GridStatsChannel channels[GridStatsNumChannels];
+};
+
+void GridStatsQueryDescDefaults(GridStatsQueryDesc* desc);
+
+GridStatsQuery* GridStatsQueryCreate(const GridStatsQueryDesc* desc);
+
+void GridStatsQueryRelease(GridStatsQuery* query);
+
+void GridStatsQuerySetComponentsEnabled(GridStatsQuery* query, bool enabled);
+
+/**
+ * Records stats for this frame.
+ *
+ * @param[in] query The query.
+ * @param[in] context The context gridExport is valid on.
+ * @param[in] gridExport The export to record.
+ * @param[in] numEmitters Emitters submitted this frame, stored in the result.
+ * @param[in] fenceValue Grid queue fence signaled by the flush carrying the copies, 0 if the grid shares the app context.
+ */
+void GridStatsQueryPush(GridStatsQuery* query, NvFlowContext* context, NvFlowGridExport* gridExport, NvFlowUint numEmitters, NvFlowUint64 fenceValue);
+
+/**
+ * Newest completed result, older completed results are dropped.
+ *
+ * @param[in] query The query.
+ * @param[in] context The context pushes were made on.
+ * @param[in] lastFenceCompleted Last grid queue fence completed, results pushed with fence 0 complete after latency pushes.
+ * @param[out] result The result.
+ *
+ * @return Returns false if none completed since the last poll.
+ */
+bool GridStatsQueryPoll(GridStatsQuery* query, NvFlowContext* context, NvFlowUint64 lastFenceCompleted, GridStatsResult* result);
+
+//! Running per component reduction of downloaded channel data
+struct GridStatsComponents
+{
+	float minVal[4];
+	float maxVal[4];
+	double sum[4];
+	NvFlowUint64 count;
+	NvFlowUint64 checksum;
+};
+
+void GridStatsComponentsReset(GridStatsComponents* components);
+
+/**
+ * Folds the downloaded blocks of one layer into the reduction.
+ *
+ * @param[in] components The reduction.
+ * @param[in] shaderParams Linear params of the export the data was copied from.
+ * @param[in] blockList Layered block list sorted by GridChecksumSortLayeredBlockList(), blocks of other layers are skipped.
+ * @param[in] numBlocks Number of entries in blockList.
+ * @param[in] layerIdx Layer the block table and data were copied from.
+ * @param[in] blockTable Mapped block table, r32_uint.
+ * @param[in] data Mapped data, in format.
+ * @param[in] format r16g16b16a16_float or r32g32b32a32_float.
+ */
+void GridStatsComponentsAddLayer(GridStatsComponents* components, const NvFlowShaderLinearParams& shaderParams,
+	const NvFlowUint2* blockList, NvFlowUint numBlocks, NvFlowUint layerIdx,
+	const NvFlowMappedData& blockTable, const NvFlowMappedData& data, NvFlowFormat format);
+
+//! Writes min/max/mean and the checksum to channel, min/max/mean are zero if no cell was added
+void GridStatsComponentsResolve(const GridStatsComponents* components, GridStatsChannel* channel);
@@ -0,0 +1,313 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <math.h>
+#include <string.h>
+
+#include <vector>
+
+#include "NvFlowShaderCPU.h"
+
+#include "gridStepper.h"
+
+namespace
+{
+	// full resolution copy of the active blocks of one export
+	struct StepperState
+	{
+		std::vector<NvFlowUint> blockIdx;		//!< Per virtual block, index into the data, ~0u if inactive
+		std::vector<NvFlowFloat4> velocity;
+		std::vector<NvFlowFloat4> density;
+		NvFlowUint numBlocks = 0u;
+	};
+
+	// b is the newest state, a block it lacks samples as the null block there
+	void blendCell(NvFlowFloat4& dst, const NvFlowFloat4* a, const NvFlowFloat4* b, float t)
+	{
+		const NvFlowFloat4 zero = { 0.f, 0.f, 0.f, 0.f };
+		const NvFlowFloat4& vb = b ? *b : zero;
+		const NvFlowFloat4& va = a ? *a : vb;
+		dst.x = va.x + (vb.x - va.x) * t;
+		dst.y = va.y + (vb.y - va.y) * t;
+		dst.z = va.z + (vb.z - va.z) * t;
+		dst.w = va.w + (vb.w - va.w) * t;
+	}
+}
+
+struct GridStepper
+{
+	GridStepperDesc m_desc;
+	CpuGrid* m_grid = nullptr;
+
+	float m_timeError = 0.f;
+	float m_catchUpTime = 0.f;
+	NvFlowUint m_numStates = 0u;
+	StepperState m_states[2];
+	int m_newest = 0;
+
+	// render export storage
+	NvFlowShaderLinearParams m_shaderParams;
+	NvFlowFloat4x4 m_modelMatrix;
+	NvFlowUint m_maxBlocks = 0u;
+	std::vector<NvFlowUint> m_blockTable;
+	std::vector<NvFlowUint> m_blockList;
+	std::vector<NvFlowUint2> m_layeredBlockList;
+	std::vector<NvFlowFloat4> m_velocity;
+	std::vector<NvFlowFloat4> m_density;
+
+	void capture();
+};
+
+void GridStepper::capture()
+{
+	CpuGridExport gridExport;
+	CpuGridGetExport(m_grid, &gridExport);
+	m_shaderParams = gridExport.mapping.shaderParams;
+	m_modelMatrix = gridExport.mapping.modelMatrix;
+	m_maxBlocks = gridExport.mapping.maxBlocks;
+
+	m_newest ^= 1;
+	m_numStates = m_numStates < 2u ? m_numStates + 1u : 2u;
+	StepperState& state = m_states[m_newest];
+
+	const NvFlowShaderLinearParams& params = m_shaderParams;
+	const NvFlowUint numCellsPerBlock = params.blockDim.x * params.blockDim.y * params.blockDim.z;
+	state.blockIdx.assign(params.gridDim.x * params.gridDim.y * params.gridDim.z, ~0u);
+	state.velocity.resize(size_t(gridExport.numBlocks) * numCellsPerBlock);
+	state.density.resize(size_t(gridExport.numBlocks) * numCellsPerBlock);
+	state.numBlocks = gridExport.numBlocks;
+
+	for (NvFlowUint blockIdx = 0u; blockIdx < gridExport.numBlocks; blockIdx++)
+	{
+		const NvFlowInt3 vBlockIdx = NvFlowCPU_tableVal_to_coord(gridExport.blockList[blockIdx]);
+		state.blockIdx[(vBlockIdx.z * params.gridDim.y + vBlockIdx.y) * params.gridDim.x + vBlockIdx.x] = blockIdx;
+
+		// levelled blocks are expanded, so both states share one layout
+		size_t dst = size_t(blockIdx) * numCellsPerBlock;
+		for (NvFlowUint k = 0u; k < params.blockDim.z; k++)
+		{
+			for (NvFlowUint j = 0u; j < params.blockDim.y; j++)
+			{
+				for (NvFlowUint i = 0u; i < params.blockDim.x; i++)
+				{
+					NvFlowInt3 vidx = {
+						int((vBlockIdx.x << params.blockDimBits.x) + i),
+						int((vBlockIdx.y << params.blockDimBits.y) + j),
+						int((vBlockIdx.z << params.blockDimBits.z) + k)
+					};
+					NvFlowInt3 ridx = NvFlowCPU_virtualToRealLod(gridExport.blockTable, params, vidx);
+					size_t src = (size_t(ridx.z) * gridExport.poolDim.y + ridx.y) * gridExport.poolDim.x + ridx.x;
+					state.velocity[dst] = gridExport.velocity[src];
+					state.density[dst] = gridExport.density[src];
+					dst++;
+				}
+			}
+		}
+	}
+}
+
+void GridStepperDescDefaults(GridStepperDesc* desc)
+{
+	desc->fixedDt = 1.f / 30.f;
+	desc->maxSteps = 2u;
+	desc->maxCatchUpTime = 0.25f;
+	desc->mode = eGridStepperModeInterpolate;
+}
+
+GridStepper* GridStepperCreate(CpuGrid* grid, const GridStepperDesc* desc)
+{
+	GridStepper* stepper = new GridStepper;
+	stepper->m_desc = *desc;
+	stepper->m_grid = grid;
+	return stepper;
+}
+
+void GridStepperRelease(GridStepper* stepper)
+{
+	delete stepper;
+}
+
+void GridStepperReset(GridStepper* stepper)
+{
+	stepper->m_timeError = 0.f;
+	stepper->m_catchUpTime = 0.f;
+	stepper->m_numStates = 0u;
+}
+
+NvFlowUint GridStepperAdvance(GridStepper* stepper, float frameDt, GridStepperEmitFunc emitFunc, void* userdata)
+{
+	const float fixedDt = stepper->m_desc.fixedDt;
+	stepper->m_timeError += frameDt;
+
+	NvFlowUint numSteps = NvFlowUint(fmaxf(floorf(stepper->m_timeError / fixedDt), 0.f));
+	stepper->m_timeError -= fixedDt * float(numSteps);
+	const NvFlowUint maxSteps = stepper->m_desc.maxSteps;
+	if (numSteps > maxSteps)
+	{
+		// whole steps are owed, the remainder stays in the accumulator to keep the blend continuous
+		const float maxCatchUpTime = fixedDt * floorf(stepper->m_desc.maxCatchUpTime / fixedDt);
+		stepper->m_catchUpTime = fminf(stepper->m_catchUpTime + fixedDt * float(numSteps - maxSteps), maxCatchUpTime);
+		numSteps = maxSteps;
+	}
+	else if (stepper->m_catchUpTime >= fixedDt)
+	{
+		// owed steps fill the steps this advance leaves spare
+		NvFlowUint numOwed = NvFlowUint(floorf(stepper->m_catchUpTime / fixedDt));
+		if (numOwed > maxSteps - numSteps) numOwed = maxSteps - numSteps;
+		stepper->m_catchUpTime -= fixedDt * float(numOwed);
+		numSteps += numOwed;
+	}
+
+	for (NvFlowUint stepIdx = 0u; stepIdx < numSteps; stepIdx++)
+	{
+		if (emitFunc)
+		{
+			emitFunc(userdata, stepper->m_grid, fixedDt);
+		}
+		CpuGridUpdate(stepper->m_grid, fixedDt);
+
+		// only the last two states are ever blended
+		if (stepIdx + 2u >= numSteps)
+		{
+			stepper->capture();
+		}
+	}
+	return numSteps;
+}
+
+float GridStepperGetAlpha(GridStepper* stepper)
+{
+	return stepper->m_timeError / stepper->m_desc.fixedDt;
+}
+
+float GridStepperGetCatchUpTime(GridStepper* stepper)
+{
+	return stepper->m_catchUpTime;
+}
+
+bool GridStepperGetRenderExport(GridStepper* stepper, CpuGridExport* gridExport)
+{
+	if (stepper->m_numStates == 0u)
+	{
+		return false;
+	}
+
+	// a single state blends with itself
+	const StepperState& newest = stepper->m_states[stepper->m_newest];
+	const StepperState& older = stepper->m_numStates > 1u ? stepper->m_states[stepper->m_newest ^ 1] : newest;
+	const float alpha = GridStepperGetAlpha(stepper);
+	const float t = stepper->m_desc.mode == eGridStepperModeExtrapolate ? 1.f + alpha : alpha;
+
+	NvFlowShaderLinearParams& params = stepper->m_shaderParams;
+	const NvFlowUint numCellsPerBlock = params.blockDim.x * params.blockDim.y * params.blockDim.z;
+	const NvFlowUint numVirtualBlocks = params.gridDim.x * params.gridDim.y * params.gridDim.z;
+
+	// union of both states, in virtual order, pool block 0 stays the null block
+	stepper->m_blockTable.assign(numVirtualBlocks, ~0u);
+	stepper->m_blockList.clear();
+	stepper->m_layeredBlockList.clear();
+	for (NvFlowUint idx = 0u; idx < numVirtualBlocks; idx++)
+	{
+		if (newest.blockIdx[idx] != ~0u || (older.blockIdx.size() == numVirtualBlocks && older.blockIdx[idx] != ~0u))
+		{
+			NvFlowUint bx = idx % params.gridDim.x;
+			NvFlowUint by = (idx / params.gridDim.x) % params.gridDim.y;
+			NvFlowUint bz = idx / (params.gridDim.x * params.gridDim.y);
+			NvFlowUint val = NvFlowCPU_coord_to_tableVal(bx, by, bz);
+			stepper->m_blockList.push_back(val);
+			stepper->m_layeredBlockList.push_back({ val, 0u });
+		}
+	}
+	const NvFlowUint numBlocks = NvFlowUint(stepper->m_blockList.size());
+
+	const NvFlowUint numPoolBlocks = numBlocks + 1u;
+	params.poolGridDim.x = params.gridDim.x;
+	params.poolGridDim.y = params.gridDim.y;
+	params.poolGridDim.z = (numPoolBlocks + params.gridDim.x * params.gridDim.y - 1u) / (params.gridDim.x * params.gridDim.y);
+	const NvFlowDim poolDim = {
+		params.poolGridDim.x << params.blockDimBits.x,
+		params.poolGridDim.y << params.blockDimBits.y,
+		params.poolGridDim.z << params.blockDimBits.z
+	};
+	params.dimInv = { 1.f / float(poolDim.x), 1.f / float(poolDim.y), 1.f / float(poolDim.z), 0.f };
+
+	const size_t numPoolCells = size_t(poolDim.x) * poolDim.y * poolDim.z;
+	stepper->m_velocity.assign(numPoolCells, NvFlowFloat4{ 0.f, 0.f, 0.f, 0.f });
+	stepper->m_density.assign(numPoolCells, NvFlowFloat4{ 0.f, 0.f, 0.f, 0.f });
+
+	for (NvFlowUint blockIdx = 0u; blockIdx < numBlocks; blockIdx++)
+	{
+		const NvFlowInt3 vBlockIdx = NvFlowCPU_tableVal_to_coord(stepper->m_blockList[blockIdx]);
+		const NvFlowUint tableIdx = (vBlockIdx.z * params.gridDim.y + vBlockIdx.y) * params.gridDim.x + vBlockIdx.x;
+
+		const NvFlowUint poolBlockIdx = blockIdx + 1u;
+		const NvFlowUint px = poolBlockIdx % params.poolGridDim.x;
+		const NvFlowUint py = (poolBlockIdx / params.poolGridDim.x) % params.poolGridDim.y;
+		const NvFlowUint pz = poolBlockIdx / (params.poolGridDim.x * params.poolGridDim.y);
+		stepper->m_blockTable[tableIdx] = NvFlowCPU_coord_to_tableVal(px, py, pz);
+
+		const NvFlowUint newIdx = newest.blockIdx[tableIdx];
+		const NvFlowUint oldIdx = older.blockIdx.size() == numVirtualBlocks ? older.blockIdx[tableIdx] : ~0u;
+		const NvFlowFloat4* newVelocity = newIdx != ~0u ? &newest.velocity[size_t(newIdx) * numCellsPerBlock] : nullptr;
+		const NvFlowFloat4* newDensity = newIdx != ~0u ? &newest.density[size_t(newIdx) * numCellsPerBlock] : nullptr;
+		const NvFlowFloat4* oldVelocity = oldIdx != ~0u ? &older.velocity[size_t(oldIdx) * numCellsPerBlock] : nullptr;
+		const NvFlowFloat4* oldDensity = oldIdx != ~0u ? &older.density[size_t(oldIdx) * numCellsPerBlock] : nullptr;
+
+		NvFlowUint cellIdx = 0u;
+		for (NvFlowUint k = 0u; k < params.blockDim.z; k++)
+		{
+			for (NvFlowUint j = 0u; j < params.blockDim.y; j++)
+			{
+				size_t rowIdx = (size_t((pz << params.blockDimBits.z) + k) * poolDim.y + (py << params.blockDimBits.y) + j) * poolDim.x + (px << params.blockDimBits.x);
+				for (NvFlowUint i = 0u; i < params.blockDim.x; i++, cellIdx++)
+				{
+					blendCell(stepper->m_velocity[rowIdx + i], oldVelocity ? oldVelocity + cellIdx : nullptr, newVelocity ? newVelocity + cellIdx : nullptr, t);
+					blendCell(stepper->m_density[rowIdx + i], oldDensity ? oldDensity + cellIdx : nullptr, newDensity ? newDensity + cellIdx : nullptr, t);
+				}
+			}
+		}
+	}
+
+	NvFlowGridExportImportLayeredMapping& mapping = gridExport->mapping;
+	mapping.shaderParams = params;
+	mapping.maxBlocks = stepper->m_maxBlocks > numBlocks ? stepper->m_maxBlocks : numBlocks;
+	mapping.layeredBlockListCPU = stepper->m_layeredBlockList.data();
+	mapping.layeredNumBlocks = numBlocks;
+	mapping.modelMatrix = stepper->m_modelMatrix;
+
+	// blended blocks are all stored at level 0
+	gridExport->tableParams.format = { NV_FLOW_TABLE_FORMAT_32, NV_FLOW_TABLE_LEVELS_OFF, 0u, 0u };
+	gridExport->blockTable = stepper->m_blockTable.data();
+	gridExport->blockList = stepper->m_blockList.data();
+	gridExport->numBlocks = numBlocks;
+	gridExport->velocity = stepper->m_velocity.data();
+	gridExport->density = stepper->m_density.data();
+	gridExport->poolDim = poolDim;
+	memset(gridExport->numBlocksPerLevel, 0, sizeof(gridExport->numBlocksPerLevel));
+	gridExport->numBlocksPerLevel[0] = numBlocks;
+	return true;
+}
@@ -0,0 +1,94 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "NvFlow.h"
+
+#include "cpuGrid.h"
+
+/// ****************** Grid Stepper Public *******************************
+
+// Fixed step scheduler for a CPU grid, with an interpolated render export.
+//
+// The stepper owns the time accumulator. Each advance runs as many fixed steps as the frame
+// time covers, keeps the remainder, and records the grid state after the last two steps.
+// Steps past maxSteps are owed and run on later advances with spare steps, up to maxCatchUpTime.
+// The render export blends those states by the remainder, so a 30 Hz simulation renders
+// smoothly at any frame rate. Interpolation shows the simulation one step late,
+// extrapolation shows it on time at the cost of overshoot on sudden changes.
+
+struct GridStepper;
+
+enum GridStepperMode
+{
+	eGridStepperModeInterpolate = 0,	//!< Blend the last two states, one step of latency
+	eGridStepperModeExtrapolate = 1,	//!< Continue the last change past the newest state
+};
+
+struct GridStepperDesc
+{
+	float fixedDt;
+	NvFlowUint maxSteps;				//!< Steps per advance, whole steps past this are owed
+	float maxCatchUpTime;				//!< Owed time past this is dropped
+	GridStepperMode mode;
+};
+
+//! Called before each fixed step, emit into grid here
+typedef void(*GridStepperEmitFunc)(void* userdata, CpuGrid* grid, float dt);
+
+void GridStepperDescDefaults(GridStepperDesc* desc);
+
+GridStepper* GridStepperCreate(CpuGrid* grid, const GridStepperDesc* desc);
+
+void GridStepperRelease(GridStepper* stepper);
+
+//! Forgets the accumulator and recorded states, call after resetting or restoring the grid
+void GridStepperReset(GridStepper* stepper);
+
+//! Accumulates frameDt and runs the fixed steps it covers, returns the number of steps
+NvFlowUint GridStepperAdvance(GridStepper* stepper, float frameDt, GridStepperEmitFunc emitFunc, void* userdata);
+
+//! Accumulated time past the last step, in steps, 0 to 1
+float GridStepperGetAlpha(GridStepper* stepper);
+
+//! Time owed by advances that hit maxSteps, not yet stepped
+float GridStepperGetCatchUpTime(GridStepper* stepper);
+
+/**
+ * Blended export for rendering at the current accumulator position.
+ *
+ * Blocks are at full resolution. A block present in only one state blends against the newest
+ * state's value, so new blocks show their newest values and released blocks fade to zero.
+ * The export stays valid until the next advance or export.
+ *
+ * @param[in] stepper The grid stepper.
+ * @param[out] gridExport The blended export.
+ *
+ * @return Returns false until a step has run.
+ */
+bool GridStepperGetRenderExport(GridStepper* stepper, CpuGridExport* gridExport);
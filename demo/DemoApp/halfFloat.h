@@ -0,0 +1,113 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include <string.h>
+
+#include "NvFlow.h"
+
+/// ****************** Half Float Public *******************************
+
+// IEEE fp16 conversion for CPU copies of eNvFlowFormat_r16_float and r16g16b16a16_float data.
+// Rounds to nearest even, keeps infinities, NaNs and subnormals. Inline, the callers convert per cell.
+
+inline unsigned short HalfFloatFromFloat(float v)
+{
+	NvFlowUint f;
+	memcpy(&f, &v, sizeof(f));
+	NvFlowUint sign = (f >> 16u) & 0x8000;
+	NvFlowUint exponent = (f >> 23u) & 0xFF;
+	NvFlowUint mantissa = f & 0x007FFFFF;
+	if (exponent == 0xFF)
+	{
+		return (unsigned short)(sign | 0x7C00 | (mantissa ? 0x0200 : 0u));
+	}
+	int e = int(exponent) - 127 + 15;
+	if (e >= 0x1F)
+	{
+		return (unsigned short)(sign | 0x7C00);
+	}
+	if (e <= 0)
+	{
+		if (e < -10)
+		{
+			return (unsigned short)sign;
+		}
+		mantissa |= 0x00800000;
+		NvFlowUint shift = NvFlowUint(14 - e);
+		NvFlowUint half = mantissa >> shift;
+		NvFlowUint rem = mantissa & ((1u << shift) - 1u);
+		NvFlowUint halfway = 1u << (shift - 1u);
+		if (rem > halfway || (rem == halfway && (half & 1u)))
+		{
+			half++;
+		}
+		return (unsigned short)(sign | half);
+	}
+	NvFlowUint half = sign | (NvFlowUint(e) << 10u) | (mantissa >> 13u);
+	NvFlowUint rem = mantissa & 0x1FFF;
+	if (rem > 0x1000 || (rem == 0x1000 && (half & 1u)))
+	{
+		half++;
+	}
+	return (unsigned short)half;
+}
+
+inline float HalfFloatToFloat(unsigned short h)
+{
+	NvFlowUint sign = NvFlowUint(h & 0x8000) << 16u;
+	NvFlowUint exponent = (h >> 10u) & 0x1F;
+	NvFlowUint mantissa = h & 0x03FF;
+	NvFlowUint f;
+	if (exponent == 0x1F)
+	{
+		f = sign | 0x7F800000 | (mantissa << 13u);
+	}
+	else if (exponent != 0u)
+	{
+		f = sign | ((exponent + 112u) << 23u) | (mantissa << 13u);
+	}
+	else if (mantissa != 0u)
+	{
+		// subnormal, renormalize
+		exponent = 113u;
+		while ((mantissa & 0x0400) == 0u)
+		{
+			mantissa <<= 1u;
+			exponent--;
+		}
+		f = sign | (exponent << 23u) | ((mantissa & 0x03FF) << 13u);
+	}
+	else
+	{
+		f = sign;
+	}
+	float v;
+	memcpy(&v, &f, sizeof(v));
+	return v;
+}
@@ -48,7 +48,7 @@ namespace Scenes
 	Scene2DTextureEmitter scene2DTextureEmitter2(true);
 	SceneSimpleFlameMesh sceneSimpleFlameMesh;
 	SceneSimpleFlameCollision sceneSimpleFlameCollision;
-	//SceneSimpleFlameCulling sceneSimpleFlameCulling;
+	SceneSimpleFlameCulling sceneSimpleFlameCulling;
 	SceneSimpleFlameConvex sceneSimpleFlameConvex;
 	SceneSimpleFlameCapsule sceneSimpleFlameCapsule;
 	SceneSDFTest sceneSDFTest;
@@ -62,7 +62,7 @@ namespace Scenes
 	SceneSimpleFlameBall sceneSimpleFlameBall;
 	SceneEmitSubStep sceneEmitSubStep;
 
-	const int count = 19;
+	const int count = 20;
 	Scene* list[count] = {
 		&scene2DTextureEmitter1,
 		&scene2DTextureEmitter2,
@@ -72,7 +72,7 @@ namespace Scenes
 		&sceneSimpleFlameMesh,
 		&sceneSDFTest,
 		&sceneSimpleFlameCollision,
-		//&sceneSimpleFlameCulling,
+		&sceneSimpleFlameCulling,
 		&sceneSimpleFlameConvex,
 		&sceneSimpleFlameCapsule,
 		&sceneSimpleSmoke,
@@ -139,6 +139,7 @@ void Scene::update(float dt)
 	doFrameUpdate(m_deltaTime);
 
 	int numSteps = m_timeStepper.getNumSteps(dt);
+	numSteps += getCatchUpSteps(m_timeStepper.m_fixedDt);
 
 	for (int i = 0; i < numSteps; i++)
 	{
@@ -238,11 +239,28 @@ void SceneFluid::imguiDesc()
 		}
 	}
 
-	float oldMemoryLimit = m_flowGridActor.m_memoryLimit;
-	imguiserSlider("Memory Limit", &m_flowGridActor.m_memoryLimit, 1.f, 6.f, 1.f, true);
-	if (oldMemoryLimit != m_flowGridActor.m_memoryLimit)
+	if (imguiCheck("Proxy Ring", m_flowGridActor.m_enableProxyRing, true))
 	{
-		m_flowGridActor.m_gridDesc.residentScale = m_flowGridActor.m_memoryLimit * m_flowGridActor.m_memoryScale;
+		m_flowGridActor.m_enableProxyRing = !m_flowGridActor.m_enableProxyRing;
+		m_shouldReset = true;
+	}
+	if (m_flowGridActor.m_enableProxyRing)
+	{
+		float ringDepth = float(m_flowGridActor.m_proxyRingDepth);
+		if (imguiSlider("Proxy Ring Depth", &ringDepth, 2.f, 6.f, 1.f, true))
+		{
+			m_flowGridActor.m_proxyRingDepth = NvFlowUint(ringDepth);
+			m_shouldReset = true;
+		}
+	}
+
+	// pool size is fixed at grid creation, a new budget takes a reset
+	// defaults are a few tens of MB, the old memory limit tiers
+	float budgetMB = float(m_flowGridActor.m_gridBudget.m_budgetBytes / (1024u * 1024u));
+	if (imguiserSlider("Memory Budget MB", &budgetMB, 4.f, 2048.f, 4.f, true))
+	{
+		m_flowGridActor.m_gridBudget.m_budgetBytes = size_t(budgetMB) * 1024u * 1024u;
+		m_flowGridActor.m_gridDesc.residentScale = m_flowGridActor.m_gridBudget.residentScale(m_flowGridActor.m_gridDesc);
 		m_shouldReset = true;
 	}
 
@@ -564,6 +582,43 @@ void SceneFluid::imguiFluidRender()
 	}
 	imguiserEndGroup();
 
+	imguiLabel("Grid Stats");
+	imguiserBeginGroup("Grid Stats", nullptr);
+	if (imguiserCheck("Component Stats", m_flowGridActor.m_enableComponentStats, true))
+	{
+		m_flowGridActor.m_enableComponentStats = !m_flowGridActor.m_enableComponentStats;
+	}
+	imguiserEndGroup();
+
+	imguiLabel("Grid Cache");
+	imguiserBeginGroup("Grid Cache", nullptr);
+	// the cache is read once the recording is closed, so the two are exclusive
+	if (imguiserCheck("Record", m_flowGridActor.m_enableCacheRecord, true))
+	{
+		m_flowGridActor.m_enableCacheRecord = !m_flowGridActor.m_enableCacheRecord;
+		m_flowGridActor.m_enableCachePlay = false;
+	}
+	if (m_flowGridActor.m_enableCacheRecord)
+	{
+		char buf[80];
+		snprintf(buf, sizeof(buf), "%d written, %d dropped", m_flowGridActor.m_statCacheCapture.numWritten,
+			m_flowGridActor.m_statCacheCapture.numDropped);
+		imguiValue(buf);
+	}
+	if (imguiserCheck("Play", m_flowGridActor.m_enableCachePlay, true))
+	{
+		m_flowGridActor.m_enableCachePlay = !m_flowGridActor.m_enableCachePlay;
+		m_flowGridActor.m_enableCacheRecord = false;
+	}
+	if (m_flowGridActor.m_enableCachePlay && m_flowGridActor.m_cachePlayer)
+	{
+		char buf[80];
+		snprintf(buf, sizeof(buf), "Frame %d of %d, %d stalls", GridCachePlayerGetFrame(m_flowGridActor.m_cachePlayer),
+			GridCachePlayerGetNumFrames(m_flowGridActor.m_cachePlayer), m_flowGridActor.m_statCachePlayer.numStalls);
+		imguiValue(buf);
+	}
+	imguiserEndGroup();
+
 	imguiFluidRenderExtra();
 	imguiserEndGroup();
 }
@@ -607,6 +662,17 @@ void SceneFluid::imguiFluidAlloc()
 	}
 	imguiserSlider("Predict Time", &m_flowGridActor.m_gridParams.bigEffectPredictTime, 0.f, 1.f, 0.01f, true);
 
+	if (imguiserCheck("Predictive Alloc", m_flowGridActor.m_blockPredictor.m_enabled, true))
+	{
+		m_flowGridActor.m_blockPredictor.m_enabled = !m_flowGridActor.m_blockPredictor.m_enabled;
+	}
+	imguiserSlider("Alloc Predict Time", &m_flowGridActor.m_blockPredictor.m_predictTime, 0.f, 1.f, 0.01f, true);
+	float holdFramesf = float(m_flowGridActor.m_blockPredictor.m_holdFrames);
+	if (imguiserSlider("Alloc Hold Frames", &holdFramesf, 1.f, 60.f, 1.f, true))
+	{
+		m_flowGridActor.m_blockPredictor.m_holdFrames = NvFlowUint(holdFramesf);
+	}
+
 	imguiserSlider("Velocity Weight", &m_flowGridActor.m_materialParams.velocity.allocWeight, 0.f, 1.f, 0.01f, true);
 	imguiserSlider("Smoke Weight", &m_flowGridActor.m_materialParams.smoke.allocWeight, 0.f, 1.f, 0.01f, true);
 	imguiserSlider("Temp Weight", &m_flowGridActor.m_materialParams.temperature.allocWeight, 0.f, 1.f, 0.01f, true);
@@ -622,6 +688,19 @@ void SceneFluid::imguiFluidAlloc()
 	}
 	imguiSlider("Test Time Scale", &m_flowGridActor.m_translationTimeScale, 0.25f, 8.f, 0.1f, true);
 
+	if (imguiserCheck("Budget Residency", m_flowGridActor.m_gridBudget.m_enabled, true))
+	{
+		m_flowGridActor.m_gridBudget.m_enabled = !m_flowGridActor.m_gridBudget.m_enabled;
+	}
+	imguiserSlider("Budget High Water", &m_flowGridActor.m_gridBudget.m_policy.highWater, 0.5f, 1.f, 0.01f, true);
+	imguiserSlider("Budget Low Water", &m_flowGridActor.m_gridBudget.m_policy.lowWater, 0.f, 1.f, 0.01f, true);
+	{
+		const GridBudget& budget = m_flowGridActor.m_gridBudget;
+		char buf[80];
+		snprintf(buf, sizeof(buf), "Budget pressure: %.2f%s", budget.m_pressure, budget.m_statSaturated ? " (saturated)" : "");
+		imguiValue(buf);
+	}
+
 	imguiFluidAllocExtra();
 	imguiserEndGroup();
 }
@@ -641,6 +720,44 @@ void SceneFluid::imguiFluidTime()
 			imguiValue(buf);
 		}
 	}
+	float pipelineDepthf = float(m_flowContext.m_maxFramesInFlight);
+	if (imguiSlider("Pipeline Depth", &pipelineDepthf, 1.f, 4.f, 1.f, true))
+	{
+		m_flowContext.m_maxFramesInFlight = int(pipelineDepthf);
+	}
+	imguiLabel("Catch Up Policy");
+	{
+		const char* policyNames[eFlowCatchUpPolicyCount] = { "Drop", "Merge dt", "Sub-step" };
+		for (int policy = 0; policy < eFlowCatchUpPolicyCount; policy++)
+		{
+			if (imguiserCheck(policyNames[policy], m_flowContext.m_catchUpPolicy == policy, true))
+			{
+				m_flowContext.m_catchUpPolicy = FlowCatchUpPolicy(policy);
+			}
+		}
+		char buf[80];
+		snprintf(buf, sizeof(buf), "%s: %.3f s owed, %.3f s dropped", policyNames[m_flowContext.m_catchUpPolicy],
+			m_flowContext.m_catchUpTime, m_flowContext.m_statDroppedTime);
+		imguiValue(buf);
+	}
+	if (imguiCheck("Deterministic", m_flowGridActor.m_deterministic, true))
+	{
+		m_flowGridActor.m_deterministic = !m_flowGridActor.m_deterministic;
+		m_flowContext.m_deterministic = m_flowGridActor.m_deterministic;
+	}
+	if (imguiCheck("Temporal LOD", m_flowGridActor.m_temporalLod.m_enabled, true))
+	{
+		m_flowGridActor.m_temporalLod.m_enabled = !m_flowGridActor.m_temporalLod.m_enabled;
+	}
+	if (m_flowGridActor.m_temporalLod.m_enabled)
+	{
+		imguiSlider("Quiescent Speed", &m_flowGridActor.m_temporalLod.m_speedThreshold, 0.f, 4.f, 0.05f, true);
+
+		char buf[80];
+		snprintf(buf, sizeof(buf), "Rate: 1/%d, %.0f%% quiescent", m_flowGridActor.m_temporalLod.m_divisor,
+			100.f * m_flowGridActor.m_temporalLod.m_statQuiescentFraction);
+		imguiValue(buf);
+	}
 	imguiFluidTimeExtra();
 }
 
@@ -741,6 +858,15 @@ NvFlowUint64 SceneFluid::getGridGPUMemUsage()
 
 bool SceneFluid::getStats(int lineIdx, int statIdx, char* buf)
 {
+	// component stats only take lines once a download has arrived
+	if (statIdx >= 7 && !m_flowGridActor.m_statComponentsValid)
+	{
+		statIdx += 4;
+	}
+	if (statIdx >= 11 && !m_flowGridActor.m_proxyRing)
+	{
+		statIdx += 1;
+	}
 	switch (statIdx)
 	{
 		case 0:
@@ -790,6 +916,37 @@ bool SceneFluid::getStats(int lineIdx, int statIdx, char* buf)
 			return true;
 		}
 		case 7:
+		{
+			NvFlowFloat4 v = m_flowGridActor.m_statDensityMean;
+			snprintf(buf, 79, "Density mean: %.3f %.3f %.3f %.3f", v.x, v.y, v.z, v.w);
+			return true;
+		}
+		case 8:
+		{
+			NvFlowFloat4 v = m_flowGridActor.m_statDensityMax;
+			snprintf(buf, 79, "Density max: %.3f %.3f %.3f %.3f", v.x, v.y, v.z, v.w);
+			return true;
+		}
+		case 9:
+		{
+			NvFlowFloat4 v = m_flowGridActor.m_statVelocityMax;
+			snprintf(buf, 79, "Velocity max: %.3f %.3f %.3f", v.x, v.y, v.z);
+			return true;
+		}
+		case 10:
+		{
+			snprintf(buf, 79, "Checksum: %016llx %016llx", m_flowGridActor.m_statVelocityChecksum, m_flowGridActor.m_statDensityChecksum);
+			return true;
+		}
+		case 11:
+		{
+			GridProxyRingStats stats = {};
+			GridProxyRingGetStats(m_flowGridActor.m_proxyRing, &stats);
+			snprintf(buf, 79, "ProxyRing: v%llu of %llu, %d pending, %llu superseded",
+				m_flowGridActor.m_statProxyRingVersion, stats.numPushed, stats.numPending, stats.numSuperseded);
+			return true;
+		}
+		case 12:
 		{
 			if (m_flowGridActor.m_statVolumeShadowBlocks > 0u)
 			{
@@ -799,7 +956,7 @@ bool SceneFluid::getStats(int lineIdx, int statIdx, char* buf)
 			}
 			return false;
 		}
-		case 8:
+		case 13:
 		{
 			if (m_flowGridActor.m_statVolumeShadowCells > 0u)
 			{
@@ -919,24 +1076,37 @@ void Projectile::update(NvFlowContext* context, NvFlowGrid* grid, float dt)
 		{
 			maxActive = i;
 			const int numSubSteps = 4;
-			const float convert = 3.14159f / 180.f;
 			float stepdt = dt / float(numSubSteps);
+
+			// sweep from the first to the last substep position as one emitter
+			SweptEmitDesc sweptDesc;
+			sweptDesc.shape.sphere.radius = 0.8f;
 			for (int i = 0; i < numSubSteps; i++)
 			{
 				updatePosition(path, stepdt);
 
-				NvFlowShapeDesc shapeDesc;
-				shapeDesc.sphere.radius = 0.8f;
-
 				m_emitParams.localToWorld = m_emitParams.bounds;
 				m_emitParams.shapeType = eNvFlowShapeTypeSphere;
 				m_emitParams.deltaTime = stepdt;
 
-				NvFlowGridEmit(grid, &shapeDesc, 1u, &m_emitParams, 1u);
+				if (i == 0)
+				{
+					sweptDesc.params = m_emitParams;
+				}
 			}
+			sweptDesc.boundsEnd = m_emitParams.bounds;
+			sweptDesc.localToWorldEnd = m_emitParams.localToWorld;
+			sweptDesc.numSubSteps = numSubSteps;
+			sweptDesc.deltaTime = dt;
+			sweptDesc.mode = m_sweptMode;
+
+			SweptEmit(&m_emitterSet, &sweptDesc);
 		}
 	}
 	m_pathsSize = maxActive + 1;
+
+	// all paths and substeps in one emit call
+	m_emitterSet.submit(grid, dt);
 }
 
 void Projectile::draw(DirectX::CXMMATRIX projection, DirectX::CXMMATRIX view)
@@ -1085,6 +1255,10 @@ void Projectile::imgui()
 		m_emitParams.bounds.z.z = m_radius;
 	}
 	imguiSlider("Speed", &m_speed, 0.f, 32.f, 0.1f, true);
+	if (imguiCheck("Swept Capsule", m_sweptMode == eSweptEmitModeCapsule))
+	{
+		m_sweptMode = (m_sweptMode == eSweptEmitModeCapsule) ? eSweptEmitModeSubSteps : eSweptEmitModeCapsule;
+	}
 	imguiSlider("Temperature", &m_temperature, 0.f, 10.f, 0.1f, true);
 	if (m_fireBallMode)
 	{	
@@ -1110,6 +1284,8 @@ void Projectile::release()
 		path.m_active = false;
 	}
 
+	m_emitterSet.release();
+
 	NvFlowReleaseShapeSDF(m_shape);
 
 	MeshRelease(m_mesh);
@@ -36,6 +36,19 @@
 #include "meshInterop.h"
 #include "bitmap.h"
 #include "curveEditor.h"
+#include "emitterSet.h"
+#include "emitterCuller.h"
+#include "sweptEmitter.h"
+#include "gridStats.h"
+#include "blockPredictor.h"
+#include "gridBudget.h"
+#include "temporalLod.h"
+#include "gridProxyRing.h"
+#include "gridCacheCapture.h"
+#include "gridCachePlayer.h"
+#include "taskDispatch.h"
+#include "sdfBake.h"
+#include "sdfCompress.h"
 
 #include "NvFlow.h"
 #include "NvFlowInterop.h"
@@ -106,6 +119,8 @@ struct Scene
 protected:
 	virtual void doFrameUpdate(float dt) {}
 	virtual void doUpdate(float dt) = 0;
+	//! Extra fixed steps owed from updates the simulation could not take
+	virtual int getCatchUpSteps(float fixedDt) { return 0; }
 
 	AppGraphCtx* m_context = nullptr;
 	TimeStepper m_timeStepper;
@@ -140,6 +155,16 @@ struct FlowColorMap
 	bool colorMapActive(int mx, int my, unsigned char mbut);
 };
 
+//! What happens to simulation time that could not be stepped because the grid queue was full
+enum FlowCatchUpPolicy
+{
+	eFlowCatchUpDrop = 0,		//!< Time is lost, the simulation falls behind wall time
+	eFlowCatchUpMergeDt = 1,	//!< Owed time is folded into the dt of the next update
+	eFlowCatchUpSubStep = 2,	//!< Owed time runs as extra fixed steps once the queue drains
+
+	eFlowCatchUpPolicyCount
+};
+
 struct FlowContext
 {
 	AppGraphCtx* m_appctx = nullptr;
@@ -164,9 +189,27 @@ struct FlowContext
 	bool m_multiGPUActive = false;
 	bool m_commandQueueActive = false;
 
+	// the grid runs up to m_maxFramesInFlight frames ahead of rendering
 	int m_maxFramesInFlight = 3u;
 	int m_framesInFlight = 0;
 
+	// CPU side work is split into tasks here, an engine may set m_taskDispatch before init()
+	TaskDispatchInterface m_taskDispatch = {};
+	TaskPool* m_taskPool = nullptr;
+
+	// grid queue fences, refreshed by updateBegin() and preDrawBegin()
+	NvFlowDeviceQueueStatus m_gridQueueStatus = {};
+
+	// replay runs, every update steps by its own dt, waiting on the grid queue instead of skipping
+	bool m_deterministic = false;
+
+	// owed time runs at the fixed dt, a merged dt could grow to m_maxCatchUpTime in one step
+	FlowCatchUpPolicy m_catchUpPolicy = eFlowCatchUpSubStep;
+	float m_maxCatchUpTime = 0.25f;		// owed time past this is dropped
+	int m_maxCatchUpSteps = 4;
+	float m_catchUpTime = 0.f;
+	float m_statDroppedTime = 0.f;
+
 	double m_statUpdateAttemptCount = 0.0;
 	double m_statUpdateSuccessCount = 0.0;
 	float m_statUpdateDt = 0.f;
@@ -177,8 +220,10 @@ struct FlowContext
 	void init(AppGraphCtx* appctx);
 	void release();
 
-	bool updateBegin(float dt);
+	//! False if the grid queue is full, dt may grow to deliver owed time with eFlowCatchUpMergeDt, always true when deterministic
+	bool updateBegin(float* dt);
 	void updateEnd();
+	int takeCatchUpSteps(float fixedDt);
 	void preDrawBegin();
 	void preDrawEnd();
 	void drawBegin();
@@ -202,6 +247,9 @@ struct FlowGridActor
 	NvFlowCrossSection* m_crossSection = nullptr;
 	NvFlowGridSummary* m_gridSummary = nullptr;
 	NvFlowGridSummaryStateCPU* m_gridSummaryStateCPU = nullptr;
+	GridStatsQuery* m_statsQuery = nullptr;
+	GridProxyRing* m_proxyRing = nullptr;
+	GridCacheCapture* m_cacheCapture = nullptr;
 
 	NvFlowGridDesc m_gridDesc;
 	NvFlowGridParams m_gridParams;
@@ -216,11 +264,16 @@ struct FlowGridActor
 
 	NvFlowGridExport* m_gridExportDebugVis = nullptr;
 	NvFlowGridExport* m_gridExportOverride = nullptr;
+	EmitterCuller m_emitterCuller;
+	BlockPredictor m_blockPredictor;
+	std::vector<NvFlowGridMaterialHandle> m_emitMaterials;		//!< Emit material table, empty emits to the default material
+	std::vector<NvFlowGridMaterialHandle> m_layerMaterials;
 	NvFlowVolumeRenderParams m_renderParamsOverride;
 	bool m_separateLighting = false;
 
-	float m_memoryLimit = 3.f;
-	float m_memoryScale = 0.125f * 0.075f;
+	GridBudget m_gridBudget;
+	float m_memoryScale = 0.125f * 0.075f;		//!< Resident scale per memory limit tier, default budgets are whole tiers
+	TemporalLod m_temporalLod;
 	int m_cellSizeLogScale = 0;
 	float m_cellSizeScale = 1.f;
 
@@ -247,6 +300,29 @@ struct FlowGridActor
 	bool m_enableGridSummary = false;
 	bool m_enableGridSummaryDebugVis = false;
 
+	bool m_enableComponentStats = false;
+
+	// versioned exports for rendering, render picks the newest completed version without waiting on the grid queue
+	bool m_enableProxyRing = false;
+	NvFlowUint m_proxyRingDepth = 3u;
+	NvFlowUint64 m_statProxyRingVersion = 0u;
+
+	// records the simulation to a grid cache, frames are written as their downloads retire
+	bool m_enableCacheRecord = false;
+	const char* m_cacheRecordPath = "../../data/capture.nfgc";
+	float m_cacheRecordTime = 0.f;
+	GridCacheCaptureStats m_statCacheCapture = {};
+
+	// replays the recorded cache in place of the simulation, one cache frame per draw
+	bool m_enableCachePlay = false;
+	GridCachePlayer* m_cachePlayer = nullptr;
+	NvFlowGridImport* m_cacheImport = nullptr;
+	NvFlowGridImportStateCPU* m_cacheImportState = nullptr;
+	GridCachePlayerStats m_statCachePlayer = {};
+
+	// replay mode, features steered by late GPU readbacks are bypassed and checksums are reported
+	bool m_deterministic = false;
+
 	bool m_enableTranslationTest = false;
 	float m_translationTimeScale = 1.f;
 	bool m_enableTranslationTestOld = false;
@@ -265,6 +341,13 @@ struct FlowGridActor
 	NvFlowUint m_statVolumeShadowBlocks = 0u;
 	NvFlowUint m_statVolumeShadowCells = 0u;
 
+	bool m_statComponentsValid = false;
+	NvFlowFloat4 m_statDensityMean = { 0.f, 0.f, 0.f, 0.f };
+	NvFlowFloat4 m_statDensityMax = { 0.f, 0.f, 0.f, 0.f };
+	NvFlowFloat4 m_statVelocityMax = { 0.f, 0.f, 0.f, 0.f };
+	NvFlowUint64 m_statVelocityChecksum = 0u;
+	NvFlowUint64 m_statDensityChecksum = 0u;
+
 	FlowGridActor() {}
 	~FlowGridActor() {}
 
@@ -272,10 +355,15 @@ struct FlowGridActor
 	void init(FlowContext* flowContext, AppGraphCtx* appctx);
 	void release();
 
+	//! Sets the emit material table emitMaterialIndex refers to, the predictor may append to it
+	void setEmitMaterials(const NvFlowGridMaterialHandle* materials, NvFlowUint numMaterials);
+
 	void updatePreEmit(FlowContext* flowContext, float dt);
 	void updatePostEmit(FlowContext* flowContext, float dt, bool shouldUpdate, bool shouldReset);
 	void preDraw(FlowContext* flowContext);
 	void draw(FlowContext* flowContext, DirectX::CXMMATRIX projection, DirectX::CXMMATRIX view);
+
+	void releaseCachePlayer();
 };
 
 struct Projectile
@@ -298,6 +386,8 @@ struct Projectile
 
 	NvFlowShapeSDF* m_shape = nullptr;
 	NvFlowGridEmitParams m_emitParams;
+	EmitterSet m_emitterSet;
+	SweptEmitMode m_sweptMode = eSweptEmitModeCapsule;
 
 	float m_radius = 0.15f;
 	float m_speed = 8.f;
@@ -385,6 +475,9 @@ struct SceneFluid : public Scene
 
 	virtual bool shouldReset() { return m_shouldReset; }
 	virtual void reset();
+
+protected:
+	virtual int getCatchUpSteps(float fixedDt) { return m_flowContext.takeCatchUpSteps(fixedDt); }
 };
 
 struct SceneSimpleFlame : public SceneFluid
@@ -708,7 +801,16 @@ struct SceneSimpleFlameCulling : public SceneSimpleFlame
 
 	virtual void imguiFluidEmitterExtra();
 
+	virtual bool getStats(int lineIdx, int statIdx, char* buf);
+
+	void updateEmitters();
+
 	NvFlowUint m_emitGridR = 8u;
+
+	EmitterSet m_emitterSet;
+	EmitterHandle m_mainEmitter;
+	std::vector<EmitterHandle> m_gridEmitters;
+	NvFlowUint m_emitGridRBuilt = ~0u;
 };
 
 struct SceneSimpleFlameConvex : public SceneSimpleFlame
@@ -774,11 +876,25 @@ struct SceneSDFTest : public SceneFluid
 	virtual void draw(DirectX::CXMMATRIX projection, DirectX::CXMMATRIX view);
 	virtual void release();
 	virtual void imgui(int x, int y, int w, int h);
+	virtual void imguiFluidEmitterExtra();
 
 	virtual void initParams();
 
 	NvFlowSDFGen* m_sdfGen = nullptr;
 
+	// bake the SDF on the CPU instead of voxelizing on the GPU, see sdfBake.h
+	bool m_cpuBake = false;
+
+	// bend the mesh every frame, rebaking incrementally with an SdfDeformer, requires m_cpuBake
+	bool m_animateSdf = false;
+	SdfDeformer* m_sdfDeformer = nullptr;
+	float m_deformTime = 0.f;
+	float m_deformPivotY = 0.f;
+
+	// keep the baked SDF as narrow band bricks on an fp16 texture, requires m_cpuBake, see sdfCompress.h
+	bool m_compressSdf = false;
+	SdfHalfShape* m_sdfHalfShape = nullptr;
+
 	MeshContext* m_meshContext = nullptr;
 	Mesh* m_mesh = nullptr;
 };
@@ -914,6 +1030,10 @@ struct SceneEmitSubStep : public SceneFluid
 	float anim_x_old = 0.f;
 
 	TimeStepper m_emitterTimeStepper;
+
+	EmitterSet m_emitterSet;
+	bool m_coalesceSubSteps = true;
+	SweptEmitMode m_sweptMode = eSweptEmitModeCapsule;
 };
 
 Scene* getScene(int index);
@@ -54,6 +54,7 @@ void Scene2DTextureEmitter::initParams()
 	m_emitParams.velocityLinear.y = 0.f;
 	m_emitParams.fuel = 1.4f;
 	m_emitParams.smoke = 0.5f;
+	m_emitParams.maxEdgeDist = 0.02f;		// soft logo edges
 
 	FILE* file = nullptr;
 	fopen_s(&file, "../../data/GeforceClaw.bmp", "rb");
@@ -93,32 +94,23 @@ void Scene2DTextureEmitter::init(AppGraphCtx* appctx, int winw, int winh)
 	shapeDesc.resolution.z = 1u;
 	m_shape = NvFlowCreateShapeSDF(m_flowContext.m_gridContext, &shapeDesc);
 
-	// generate SDF from bitmap
+	// generate SDF from bitmap, true distances so edge falloff works
 	auto mappedData = NvFlowShapeSDFMap(m_shape, m_flowContext.m_gridContext);
 	if (mappedData.data)
 	{
-		NvFlowUint bmRowPitch = ((m_bitmap.bitsPerPixel * m_bitmap.width + 31) / 32) * 4;
+		SdfBakeMask mask = {};
+		mask.data = m_bitmap.data;
+		mask.bitsPerValue = 1u;
+		mask.rowPitch = ((m_bitmap.bitsPerPixel * m_bitmap.width + 31) / 32) * 4;
+		mask.depthPitch = mask.rowPitch * m_bitmap.height;
+		mask.dim = mappedData.dim;
 
-		for (NvFlowUint k = 0; k < mappedData.dim.z; k++)
-			for (NvFlowUint j = 0; j < mappedData.dim.y; j++)
-				for (NvFlowUint i = 0; i < mappedData.dim.x; i++)
-				{
-					float& val = mappedData.data[k * mappedData.depthPitch + j * mappedData.rowPitch + i];
-
-					float v = 0.5f;
+		SdfBakeParams bakeParams;
+		SdfBakeParamsDefaults(&bakeParams);
+		bakeParams.taskDispatch = &m_flowContext.m_taskDispatch;
 
-					NvFlowUint byteIdx = j * bmRowPitch + (i >> 3);
-					NvFlowUint mask = 128 >> (i & 7);
+		SdfBakeFromMask(&mask, &bakeParams, &mappedData);
 
-					NvFlowUint inval = mask & m_bitmap.data[byteIdx];
-					
-					if (inval)
-					{
-						v = -0.5f;
-					}
-
-					val = v;
-				}
 		NvFlowShapeSDFUnmap(m_shape, m_flowContext.m_gridContext);
 	}
 
@@ -147,7 +139,7 @@ void Scene2DTextureEmitter::init(AppGraphCtx* appctx, int winw, int winh)
 
 void Scene2DTextureEmitter::doUpdate(float dt)
 {
-	bool shouldUpdate = m_flowContext.updateBegin(dt);
+	bool shouldUpdate = m_flowContext.updateBegin(&dt);
 	if (shouldUpdate)
 	{
 		AppGraphCtxProfileBegin(m_appctx, "Simulate");
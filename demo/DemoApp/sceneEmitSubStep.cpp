@@ -113,17 +113,50 @@ void SceneEmitSubStep::emitSubSteps(float t_old, float x_old, float t_new, float
 
 	int numSteps = m_emitterTimeStepper.getNumSteps(frame_dt);
 
-	for (int i = 0; i < numSteps; i++)
+	auto substepX = [&](int i)
 	{
 		int substep_i = numSteps - 1 - i;
 
 		float substep_t = emitImpulse_dt * substep_i + m_emitterTimeStepper.m_timeError;
 
 		float s = (substep_t - t_new) / (t_old - t_new);
-		float x = (1.f - s) * x_new + s * x_old;
+		return (1.f - s) * x_new + s * x_old;
+	};
 
-		emitImpulse(x, emitImpulse_dt);
+	if (!m_coalesceSubSteps)
+	{
+		for (int i = 0; i < numSteps; i++)
+		{
+			emitImpulse(substepX(i), emitImpulse_dt);
+		}
+		return;
 	}
+
+	if (numSteps == 0)
+	{
+		return;
+	}
+
+	// sub steps are evenly spaced on a line, so one swept emitter covers them all
+	SweptEmitDesc sweptDesc;
+	sweptDesc.shape.sphere.radius = 0.8f;
+
+	sweptDesc.params = m_emitParams;
+	sweptDesc.params.bounds.w.x = substepX(0);
+	sweptDesc.params.localToWorld = sweptDesc.params.bounds;
+	sweptDesc.params.shapeType = eNvFlowShapeTypeSphere;
+
+	sweptDesc.boundsEnd = sweptDesc.params.bounds;
+	sweptDesc.boundsEnd.w.x = substepX(numSteps - 1);
+	sweptDesc.localToWorldEnd = sweptDesc.boundsEnd;
+
+	sweptDesc.numSubSteps = numSteps;
+	sweptDesc.deltaTime = emitImpulse_dt * float(numSteps);
+	sweptDesc.mode = m_sweptMode;
+
+	SweptEmit(&m_emitterSet, &sweptDesc);
+
+	m_emitterSet.submit(m_flowGridActor.m_grid, frame_dt);
 }
 
 void SceneEmitSubStep::doFrameUpdate(float frame_dt)
@@ -154,7 +187,7 @@ void SceneEmitSubStep::doFrameUpdate(float frame_dt)
 
 void SceneEmitSubStep::doUpdate(float dt)
 {
-	bool shouldUpdate = m_flowContext.updateBegin(dt);
+	bool shouldUpdate = m_flowContext.updateBegin(&dt);
 	if (shouldUpdate)
 	{
 		AppGraphCtxProfileBegin(m_appctx, "Simulate");
@@ -197,6 +230,8 @@ void SceneEmitSubStep::draw(DirectX::CXMMATRIX projection, DirectX::CXMMATRIX vi
 
 void SceneEmitSubStep::release()
 {
+	m_emitterSet.release();
+
 	m_projectile.release();
 
 	m_flowGridActor.release();
@@ -217,5 +252,18 @@ void SceneEmitSubStep::imgui(int xIn, int yIn, int wIn, int hIn)
 
 void SceneEmitSubStep::imguiFluidEmitterExtra()
 {
+	imguiSeparatorLine();
+	imguiLabel("Sub Steps");
+	imguiserBeginGroup("Sub Steps", nullptr);
+
+	if (imguiserCheck("Coalesce", m_coalesceSubSteps, true))
+	{
+		m_coalesceSubSteps = !m_coalesceSubSteps;
+	}
+	if (imguiserCheck("Swept Capsule", m_sweptMode == eSweptEmitModeCapsule, m_coalesceSubSteps))
+	{
+		m_sweptMode = (m_sweptMode == eSweptEmitModeCapsule) ? eSweptEmitModeSubSteps : eSweptEmitModeCapsule;
+	}
 
+	imguiserEndGroup();
 }
\ No newline at end of file
@@ -36,6 +36,12 @@ void FlowContext::init(AppGraphCtx* appctx)
 {
 	m_appctx = appctx;
 
+	if (m_taskDispatch.dispatch == nullptr)
+	{
+		m_taskPool = TaskPoolCreate(0u);
+		TaskPoolGetInterface(m_taskPool, &m_taskDispatch);
+	}
+
 	m_renderContext = NvFlowInteropCreateContext(appctx);
 	m_dsv = NvFlowInteropCreateDepthStencilView(appctx, m_renderContext);
 	m_rtv = NvFlowInteropCreateRenderTargetView(appctx, m_renderContext);
@@ -117,6 +123,13 @@ void FlowContext::release()
 	NvFlowReleaseContext(m_renderContext);
 
 	releaseComputeContext();
+
+	if (m_taskPool)
+	{
+		TaskPoolRelease(m_taskPool);
+		m_taskPool = nullptr;
+		m_taskDispatch = TaskDispatchInterface{};
+	}
 }
 
 void FlowContext::releaseComputeContext()
@@ -181,8 +194,8 @@ int FlowContext::computeContextBegin()
 	if (m_gridDevice != m_renderDevice)
 	{
 		NvFlowDeviceQueueStatus status = {};
-		NvFlowDeviceQueueUpdateContext(m_gridQueue, m_gridContext, &status);
-		framesInFlight = status.framesInFlight;
+		NvFlowDeviceQueueUpdateContext(m_gridQueue, m_gridContext, &m_gridQueueStatus);
+		framesInFlight = m_gridQueueStatus.framesInFlight;
 
 		NvFlowDeviceQueueUpdateContext(m_gridCopyQueue, m_gridCopyContext, &status);
 		NvFlowDeviceQueueUpdateContext(m_renderCopyQueue, m_renderCopyContext, &status);
@@ -190,8 +203,8 @@ int FlowContext::computeContextBegin()
 	else if (m_gridContext != m_renderContext)
 	{
 		NvFlowDeviceQueueStatus status = {};
-		NvFlowDeviceQueueUpdateContext(m_gridQueue, m_gridContext, &status);
-		framesInFlight = status.framesInFlight;
+		NvFlowDeviceQueueUpdateContext(m_gridQueue, m_gridContext, &m_gridQueueStatus);
+		framesInFlight = m_gridQueueStatus.framesInFlight;
 
 		NvFlowDeviceQueueUpdateContext(m_gridCopyQueue, m_gridCopyContext, &status);
 	}
@@ -222,10 +235,18 @@ void FlowContext::computeContextEnd()
 	}
 }
 
-bool FlowContext::updateBegin(float dt)
+bool FlowContext::updateBegin(float* dt)
 {
 	m_framesInFlight = computeContextBegin();
-	bool shouldFlush = (m_framesInFlight < m_maxFramesInFlight);
+	if (m_deterministic && m_framesInFlight >= m_maxFramesInFlight)
+	{
+		// block until the oldest frames retire, a skipped update would change the step sequence
+		NvFlowUint64 fenceValue = m_gridQueueStatus.nextFenceValue - NvFlowUint64(m_maxFramesInFlight);
+		NvFlowDeviceQueueWaitOnFence(m_gridQueue, m_gridContext, fenceValue);
+		NvFlowDeviceQueueUpdateContext(m_gridQueue, m_gridContext, &m_gridQueueStatus);
+		m_framesInFlight = m_gridQueueStatus.framesInFlight;
+	}
+	bool shouldFlush = m_deterministic || (m_framesInFlight < m_maxFramesInFlight);
 
 	if (shouldFlush)
 	{
@@ -238,11 +259,44 @@ bool FlowContext::updateBegin(float dt)
 	if (shouldFlush) m_statUpdateSuccessCount += 1.0;
 	m_statUpdateAttemptCount *= 0.99;
 	m_statUpdateSuccessCount *= 0.99;
-	m_statUpdateDt = dt;
+	m_statUpdateDt = *dt;
+
+	if (m_deterministic || m_catchUpPolicy == eFlowCatchUpDrop)
+	{
+		m_catchUpTime = 0.f;
+		if (!shouldFlush) m_statDroppedTime += *dt;
+	}
+	else if (!shouldFlush)
+	{
+		// the step is owed, not lost, up to the catch up limit
+		m_catchUpTime += *dt;
+		if (m_catchUpTime > m_maxCatchUpTime)
+		{
+			m_statDroppedTime += m_catchUpTime - m_maxCatchUpTime;
+			m_catchUpTime = m_maxCatchUpTime;
+		}
+	}
+	else if (m_catchUpPolicy == eFlowCatchUpMergeDt)
+	{
+		*dt += m_catchUpTime;
+		m_catchUpTime = 0.f;
+	}
 
 	return shouldFlush;
 }
 
+int FlowContext::takeCatchUpSteps(float fixedDt)
+{
+	if (m_deterministic || m_catchUpPolicy != eFlowCatchUpSubStep)
+	{
+		return 0;
+	}
+	int numSteps = int(floorf(m_catchUpTime / fixedDt));
+	if (numSteps > m_maxCatchUpSteps) numSteps = m_maxCatchUpSteps;
+	m_catchUpTime -= fixedDt * float(numSteps);
+	return numSteps;
+}
+
 void FlowContext::updateEnd()
 {
 	computeContextEnd();
@@ -254,7 +308,7 @@ void FlowContext::preDrawBegin()
 	{
 		// update fence status on grid queue, no need to flush
 		NvFlowDeviceQueueStatus status = {};
-		NvFlowDeviceQueueUpdateContext(m_gridQueue, m_gridContext, &status);
+		NvFlowDeviceQueueUpdateContext(m_gridQueue, m_gridContext, &m_gridQueueStatus);
 		NvFlowDeviceQueueUpdateContext(m_gridCopyQueue, m_gridCopyContext, &status);
 		NvFlowDeviceQueueUpdateContext(m_renderCopyQueue, m_renderCopyContext, &status);
 	}
@@ -262,7 +316,7 @@ void FlowContext::preDrawBegin()
 	{
 		// update fence status on grid queue, no need to flush
 		NvFlowDeviceQueueStatus status = {};
-		NvFlowDeviceQueueUpdateContext(m_gridQueue, m_gridContext, &status);
+		NvFlowDeviceQueueUpdateContext(m_gridQueue, m_gridContext, &m_gridQueueStatus);
 		NvFlowDeviceQueueUpdateContext(m_gridCopyQueue, m_gridCopyContext, &status);
 	}
 
@@ -322,19 +376,21 @@ void FlowGridActor::initParams(size_t vramAmount)
 	m_gridDesc.enableVTR = false;
 	#endif
 
-	// attempt to pick good memory limits based on vramAmount
+	// attempt to pick a good memory budget based on vramAmount
 	{
+		float memoryLimit = 3.f;
 		if (vramAmount <= 2ull * 1024ull * 1024ull * 1024ull)
 		{
-			m_memoryLimit = 1.f;
+			memoryLimit = 1.f;
 		}
 		else if (vramAmount <= 3ull * 1024ull * 1024ull * 1024ull)
 		{
-			m_memoryLimit = 2.f;
+			memoryLimit = 2.f;
 		}
+		m_gridBudget.m_budgetBytes = m_gridBudget.poolBytes(m_gridDesc, memoryLimit * m_memoryScale);
 	}
 
-	m_gridDesc.residentScale = m_memoryLimit * m_memoryScale;
+	m_gridDesc.residentScale = m_gridBudget.residentScale(m_gridDesc);
 
 	// configure gravity
 	m_gridParams.gravity = NvFlowFloat3{ 0.f, -1.f, 0.f };
@@ -386,6 +442,25 @@ void FlowGridActor::init(FlowContext* flowContext, AppGraphCtx* appctx)
 	m_gridSummary = NvFlowCreateGridSummary(flowContext->m_gridContext, &gridSummaryDesc);
 	m_gridSummaryStateCPU = NvFlowCreateGridSummaryStateCPU(m_gridSummary);
 
+	GridStatsQueryDesc statsQueryDesc = {};
+	GridStatsQueryDescDefaults(&statsQueryDesc);
+	statsQueryDesc.enableComponents = m_enableComponentStats;
+
+	m_statsQuery = GridStatsQueryCreate(&statsQueryDesc);
+
+	m_emitterCuller.m_taskDispatch = &flowContext->m_taskDispatch;
+
+	// ring slots live on the grid device, so multiGPU keeps the native proxy
+	if (m_enableProxyRing && !flowContext->m_multiGPUActive)
+	{
+		GridProxyRingDesc proxyRingDesc = {};
+		GridProxyRingDescDefaults(&proxyRingDesc);
+		proxyRingDesc.ringDepth = m_proxyRingDepth;
+		proxyRingDesc.gridExport = proxyGridExport;
+
+		m_proxyRing = GridProxyRingCreate(flowContext->m_gridContext, flowContext->m_renderContext, &proxyRingDesc);
+	}
+
 	NvFlowRenderMaterialPoolDesc materialPoolDesc = {};
 	materialPoolDesc.colorMapResolution = 64u;
 	m_colorMap.m_materialPool = NvFlowCreateRenderMaterialPool(flowContext->m_renderContext, &materialPoolDesc);
@@ -418,25 +493,61 @@ void FlowGridActor::init(FlowContext* flowContext, AppGraphCtx* appctx)
 
 void FlowGridActor::release()
 {
+	m_emitMaterials.clear();
 	NvFlowReleaseGrid(m_grid);
 	NvFlowReleaseGridProxy(m_gridProxy);
 	NvFlowReleaseVolumeRender(m_volumeRender);
 	NvFlowReleaseCrossSection(m_crossSection);
 	NvFlowReleaseGridSummary(m_gridSummary);
 	NvFlowReleaseGridSummaryStateCPU(m_gridSummaryStateCPU);
+	GridStatsQueryRelease(m_statsQuery);
+	m_statsQuery = nullptr;
+	GridProxyRingRelease(m_proxyRing);
+	m_proxyRing = nullptr;
+	GridCacheCaptureRelease(m_cacheCapture);
+	m_cacheCapture = nullptr;
+	releaseCachePlayer();
 	NvFlowReleaseRenderMaterialPool(m_colorMap.m_materialPool);
 	if (m_volumeShadow) NvFlowReleaseVolumeShadow(m_volumeShadow);
 	m_volumeShadow = nullptr;
 }
 
+void FlowGridActor::setEmitMaterials(const NvFlowGridMaterialHandle* materials, NvFlowUint numMaterials)
+{
+	m_emitMaterials.assign(materials, materials + numMaterials);
+	NvFlowGridUpdateEmitMaterials(m_grid, m_emitMaterials.data(), numMaterials);
+}
+
 void FlowGridActor::updatePreEmit(FlowContext* flowContext, float dt)
 {
 	NvFlowGridSetParams(m_grid, &m_gridParams);
-	NvFlowGridSetMaterialParams(m_grid, NvFlowGridGetDefaultMaterial(m_grid), &m_materialParams);
+	// budget pressure is applied on top of the user params
+	NvFlowGridMaterialParams materialParams = m_materialParams;
+	if (!m_deterministic)
+	{
+		m_gridBudget.update(dt);
+		m_gridBudget.apply(&materialParams);
+	}
+
+	NvFlowGridSetMaterialParams(m_grid, NvFlowGridGetDefaultMaterial(m_grid), &materialParams);
 	NvFlowRenderMaterialUpdate(m_colorMap.m_materialDefault, &m_renderMaterialDefaultParams);
 	NvFlowRenderMaterialUpdate(m_colorMap.m_material0, &m_renderMaterialMat0Params);
 	NvFlowRenderMaterialUpdate(m_colorMap.m_material1, &m_renderMaterialMat1Params);
 
+	if (!m_deterministic)
+	{
+		// without a table, index 0 is the default material
+		NvFlowGridMaterialHandle defaultMaterial = NvFlowGridGetDefaultMaterial(m_grid);
+		if (m_emitMaterials.empty())
+		{
+			m_blockPredictor.emit(m_grid, dt, &defaultMaterial, 1u);
+		}
+		else
+		{
+			m_blockPredictor.emit(m_grid, dt, m_emitMaterials.data(), NvFlowUint(m_emitMaterials.size()));
+		}
+	}
+
 	if (m_enableTranslationTest)
 	{
 		m_enableTranslationTestOld = true;
@@ -473,11 +584,23 @@ void FlowGridActor::updatePostEmit(FlowContext* flowContext, float dt, bool shou
 		resetDesc.halfSize.z *= scale;
 
 		NvFlowGridReset(m_grid, &resetDesc);
+
+		m_temporalLod.reset();
 	}
 
 	if (shouldUpdate)
 	{
-		NvFlowGridUpdate(m_grid, flowContext->m_gridContext, dt);
+		// replay steps every frame at the given dt, temporal LOD follows the summary readback
+		float stepDt = dt;
+		bool stepGrid = true;
+		if (!m_deterministic)
+		{
+			stepGrid = m_temporalLod.step(dt, &stepDt);
+		}
+		if (stepGrid)
+		{
+			NvFlowGridUpdate(m_grid, flowContext->m_gridContext, stepDt);
+		}
 
 		// collect stats
 		if (m_grid)
@@ -496,34 +619,91 @@ void FlowGridActor::updatePostEmit(FlowContext* flowContext, float dt, bool shou
 
 			if (gridExport)
 			{
-				NvFlowUint* numBlockss[2] = { &m_statNumVelocityBlocks , &m_statNumDensityBlocks };
-				NvFlowUint* numCellss[2] = { &m_statNumVelocityCells , &m_statNumDensityCells };
-				NvFlowUint* maxBlockss[2] = { &m_statMaxVelocityBlocks , &m_statMaxDensityBlocks };
-				NvFlowGridTextureChannel channels[2] = { eNvFlowGridTextureChannelVelocity, eNvFlowGridTextureChannelDensity };
-				for (NvFlowUint passID = 0u; passID < 2; passID++)
-				{
-					NvFlowUint& numBlocks = *numBlockss[passID];
-					NvFlowUint& numCells = *numCellss[passID];
-					NvFlowUint& maxBlocks = *maxBlockss[passID];
+				// emitters are culled against the velocity blocks of this update
+				auto handle = NvFlowGridExportGetHandle(gridExport, flowContext->m_gridContext, eNvFlowGridTextureChannelVelocity);
 
-					auto handle = NvFlowGridExportGetHandle(gridExport, flowContext->m_gridContext, channels[passID]);
-
-					NvFlowGridExportLayeredView layeredView = {};
-					NvFlowGridExportGetLayeredView(handle, &layeredView);
-
-					m_statNumLayers = handle.numLayerViews;
-					numBlocks = 0u;
-					maxBlocks = layeredView.mapping.maxBlocks;
+				NvFlowGridExportLayeredView layeredView = {};
+				NvFlowGridExportGetLayeredView(handle, &layeredView);
 
+				if (layeredView.mapping.layeredBlockListCPU)
+				{
+					m_layerMaterials.resize(handle.numLayerViews);
 					for (NvFlowUint layerIdx = 0u; layerIdx < handle.numLayerViews; layerIdx++)
 					{
 						NvFlowGridExportLayerView layerView = {};
 						NvFlowGridExportGetLayerView(handle, layerIdx, &layerView);
+						m_layerMaterials[layerIdx] = layerView.mapping.material;
+					}
+					m_emitterCuller.updateGrid(layeredView.mapping);
+					m_blockPredictor.updateGrid(layeredView.mapping, m_layerMaterials.data(), handle.numLayerViews);
+				}
+				else
+				{
+					m_emitterCuller.invalidateGrid();
+					m_blockPredictor.invalidateGrid();
+				}
+
+				// downloads ride the next grid queue flush, a shared context has no fence to wait on
+				bool sharedContext = (flowContext->m_gridContext == flowContext->m_renderContext);
+				NvFlowUint64 fenceValue = sharedContext ? 0u : flowContext->m_gridQueueStatus.nextFenceValue;
+
+				// stats arrive once the grid queue passes their fence, the query never waits on the GPU
+				GridStatsQuerySetComponentsEnabled(m_statsQuery, m_enableComponentStats || m_deterministic);
+				GridStatsQueryPush(m_statsQuery, flowContext->m_gridContext, gridExport, m_emitterCuller.m_statSubmitted, fenceValue);
+
+				GridStatsResult result;
+				if (GridStatsQueryPoll(m_statsQuery, flowContext->m_gridContext, flowContext->m_gridQueueStatus.lastFenceCompleted, &result))
+				{
+					const GridStatsChannel& velocity = result.channels[0];
+					const GridStatsChannel& density = result.channels[1];
+
+					m_statNumLayers = velocity.numLayers;
+					m_statNumVelocityBlocks = velocity.numBlocks;
+					m_statNumVelocityCells = velocity.numCells;
+					m_statMaxVelocityBlocks = velocity.maxBlocks;
+					m_statNumDensityBlocks = density.numBlocks;
+					m_statNumDensityCells = density.numCells;
+					m_statMaxDensityBlocks = density.maxBlocks;
 
-						numBlocks += layerView.mapping.numBlocks;
+					m_gridBudget.updateOccupancy(velocity.numBlocks, velocity.maxBlocks);
+					m_gridBudget.updateOccupancy(density.numBlocks, density.maxBlocks);
+
+					if (density.hasComponents && velocity.hasComponents)
+					{
+						m_statDensityMean = density.componentMean;
+						m_statDensityMax = density.componentMax;
+						m_statVelocityMax = velocity.componentMax;
+						m_statVelocityChecksum = velocity.checksum;
+						m_statDensityChecksum = density.checksum;
+						m_statComponentsValid = true;
 					}
+				}
+				if (!m_enableComponentStats && !m_deterministic)
+				{
+					m_statComponentsValid = false;
+				}
 
-					numCells = layeredView.mapping.shaderParams.blockDim.w * numBlocks;
+				if (m_enableCacheRecord && m_cacheCapture == nullptr)
+				{
+					GridCacheCaptureDesc captureDesc = {};
+					GridCacheCaptureDescDefaults(&captureDesc);
+					m_cacheCapture = GridCacheCaptureCreate(m_cacheRecordPath, &captureDesc);
+					m_cacheRecordTime = 0.f;
+				}
+				else if (!m_enableCacheRecord && m_cacheCapture)
+				{
+					GridCacheCaptureRelease(m_cacheCapture);
+					m_cacheCapture = nullptr;
+				}
+				if (m_cacheCapture)
+				{
+					if (stepGrid)
+					{
+						GridCacheCapturePush(m_cacheCapture, flowContext->m_gridContext, gridExport, m_cacheRecordTime, fenceValue);
+						m_cacheRecordTime += stepDt;
+					}
+					GridCacheCapturePoll(m_cacheCapture, flowContext->m_gridContext, flowContext->m_gridQueueStatus.lastFenceCompleted);
+					GridCacheCaptureGetStats(m_cacheCapture, &m_statCacheCapture);
 				}
 			}
 		}
@@ -543,7 +723,8 @@ void FlowGridActor::updatePostEmit(FlowContext* flowContext, float dt, bool shou
 
 		auto gridExport = NvFlowGridGetGridExport(flowContext->m_gridContext, m_grid);
 
-		if (m_enableGridSummary)
+		// the predictor and temporal LOD also rely on the summary
+		if (m_enableGridSummary || m_blockPredictor.m_enabled || m_temporalLod.m_enabled)
 		{
 			NvFlowGridSummaryUpdateParams updateParams = {};
 			updateParams.gridExport = gridExport;
@@ -561,13 +742,32 @@ void FlowGridActor::updatePostEmit(FlowContext* flowContext, float dt, bool shou
 
 				//printf("GridSummary layer(%d) numResults(%d)", layerIdx, numResults);
 			}
+
+			if (m_blockPredictor.m_enabled)
+			{
+				m_blockPredictor.updateVelocity(m_gridSummaryStateCPU);
+			}
+			if (m_temporalLod.m_enabled && stepGrid)
+			{
+				m_temporalLod.updateActivity(m_gridSummaryStateCPU);
+			}
 		}
 
-		NvFlowGridProxyFlushParams flushParams = {};
-		flushParams.gridContext = flowContext->m_gridContext;
-		flushParams.gridCopyContext = flowContext->m_gridCopyContext;
-		flushParams.renderCopyContext = flowContext->m_renderCopyContext;
-		NvFlowGridProxyPush(m_gridProxy, gridExport, &flushParams);
+		if (m_proxyRing)
+		{
+			// the copies ride the next grid queue flush, the native proxy is left idle
+			bool sharedContext = (flowContext->m_gridContext == flowContext->m_renderContext);
+			NvFlowUint64 fenceValue = sharedContext ? 0u : flowContext->m_gridQueueStatus.nextFenceValue;
+			GridProxyRingPush(m_proxyRing, flowContext->m_gridContext, gridExport, fenceValue);
+		}
+		else
+		{
+			NvFlowGridProxyFlushParams flushParams = {};
+			flushParams.gridContext = flowContext->m_gridContext;
+			flushParams.gridCopyContext = flowContext->m_gridCopyContext;
+			flushParams.renderCopyContext = flowContext->m_renderCopyContext;
+			NvFlowGridProxyPush(m_gridProxy, gridExport, &flushParams);
+		}
 	}
 }
 
@@ -583,7 +783,52 @@ void FlowGridActor::preDraw(FlowContext* flowContext)
 	flushParams.renderCopyContext = flowContext->m_renderCopyContext;
 	NvFlowGridProxyFlush(m_gridProxy, &flushParams);
 
-	auto gridExport = NvFlowGridProxyGetGridExport(m_gridProxy, flowContext->m_renderContext);
+	NvFlowGridExport* gridExport = nullptr;
+	if (m_proxyRing)
+	{
+		GridProxyRingUpdate(m_proxyRing, flowContext->m_gridQueueStatus.lastFenceCompleted);
+		gridExport = GridProxyRingAcquireLatest(m_proxyRing, flowContext->m_renderContext, &m_statProxyRingVersion);
+	}
+	// with the ring, the idle native proxy stands in as an empty grid until a version completes
+	if (gridExport == nullptr)
+	{
+		gridExport = NvFlowGridProxyGetGridExport(m_gridProxy, flowContext->m_renderContext);
+	}
+
+	// the import is allocated from the simulation export, so a cache recorded from this grid fits its pool
+	if (m_enableCachePlay && m_cachePlayer == nullptr)
+	{
+		GridCachePlayerDesc playerDesc = {};
+		GridCachePlayerDescDefaults(&playerDesc);
+		m_cachePlayer = GridCachePlayerCreate(m_cacheRecordPath, &playerDesc);
+		if (m_cachePlayer)
+		{
+			NvFlowGridImportDesc importDesc = {};
+			importDesc.gridExport = gridExport;
+			m_cacheImport = NvFlowCreateGridImport(flowContext->m_renderContext, &importDesc);
+			m_cacheImportState = NvFlowCreateGridImportStateCPU(m_cacheImport);
+			NvFlowGridImportUpdateStateCPU(m_cacheImportState, flowContext->m_renderContext, gridExport);
+		}
+		else
+		{
+			// nothing recorded yet
+			m_enableCachePlay = false;
+		}
+	}
+	else if (!m_enableCachePlay && m_cachePlayer)
+	{
+		releaseCachePlayer();
+	}
+	if (m_cachePlayer)
+	{
+		NvFlowGridExport* cacheExport = GridCachePlayerUpload(m_cachePlayer, flowContext->m_renderContext, m_cacheImport, m_cacheImportState);
+		GridCachePlayerGetStats(m_cachePlayer, &m_statCachePlayer);
+		GridCachePlayerSeek(m_cachePlayer, GridCachePlayerGetFrame(m_cachePlayer) + 1u);
+		if (cacheExport)
+		{
+			gridExport = cacheExport;
+		}
+	}
 
 	AppGraphCtxProfileEnd(m_appctx, "UpdateGridView");
 
@@ -672,6 +917,16 @@ void FlowGridActor::preDraw(FlowContext* flowContext)
 	m_gridExportOverride = gridExport;
 }
 
+void FlowGridActor::releaseCachePlayer()
+{
+	GridCachePlayerRelease(m_cachePlayer);
+	m_cachePlayer = nullptr;
+	if (m_cacheImportState) NvFlowReleaseGridImportStateCPU(m_cacheImportState);
+	m_cacheImportState = nullptr;
+	if (m_cacheImport) NvFlowReleaseGridImport(m_cacheImport);
+	m_cacheImport = nullptr;
+}
+
 void FlowGridActor::draw(FlowContext* flowContext, DirectX::CXMMATRIX projection, DirectX::CXMMATRIX view)
 {
 	memcpy(&m_renderParamsOverride.projectionMatrix, &projection, sizeof(m_renderParamsOverride.projectionMatrix));
@@ -771,6 +1026,12 @@ void FlowGridActor::draw(FlowContext* flowContext, DirectX::CXMMATRIX projection
 
 		NvFlowGridSummaryDebugRender(m_gridSummary, flowContext->m_renderContext, &params);
 	}
+
+	// hand the acquired version back to the grid queue
+	if (m_proxyRing)
+	{
+		GridProxyRingRenderEnd(m_proxyRing, flowContext->m_renderContext);
+	}
 }
 
 // *********************** Flow Color Map *****************************************
@@ -27,6 +27,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 
 #include "loader.h"
 #include "imgui.h"
@@ -91,10 +92,7 @@ void SceneSDFTest::init(AppGraphCtx* appctx, int winw, int winh)
 
 	m_flowGridActor.init(&m_flowContext, appctx);
 
-	NvFlowSDFGenDesc sdfDesc;
-	sdfDesc.resolution = { 128u, 128u, 128u };
-
-	m_sdfGen = NvFlowCreateSDFGen(m_flowContext.m_gridContext, &sdfDesc);
+	const NvFlowDim sdfResolution = { 128u, 128u, 128u };
 
 	m_meshContext = MeshInteropContextCreate(appctx);
 	m_mesh = MeshCreate(m_meshContext);
@@ -104,8 +102,6 @@ void SceneSDFTest::init(AppGraphCtx* appctx, int winw, int winh)
 	MeshData meshData;
 	MeshGetData(m_mesh, &meshData);
 
-	NvFlowSDFGenReset(m_sdfGen, m_flowContext.m_gridContext);
-
 	XMMATRIX modelMatrix = XMMatrixMultiply(
 		XMMatrixScaling(8.f, 8.f, 8.f),
 		XMMatrixTranslation(0.f, -0.75f, 0.f)
@@ -123,15 +119,99 @@ void SceneSDFTest::init(AppGraphCtx* appctx, int winw, int winh)
 	meshParams.renderTargetView = m_flowContext.m_multiGPUActive ? nullptr : m_flowContext.m_rtv;
 	meshParams.depthStencilView = m_flowContext.m_multiGPUActive ? nullptr : m_flowContext.m_dsv;
 
-	NvFlowSDFGenVoxelize(m_sdfGen, m_flowContext.m_gridContext, &meshParams);
+	if (m_cpuBake && m_compressSdf && !m_animateSdf)
+	{
+		// bake on the CPU, keep the narrow band bricks and decode them into an fp16 texture
+		SdfBakeParams bakeParams;
+		SdfBakeParamsDefaults(&bakeParams);
+		bakeParams.taskDispatch = &m_flowContext.m_taskDispatch;
+
+		std::vector<float> bakeData(sdfResolution.x * sdfResolution.y * sdfResolution.z);
+		NvFlowShapeSDFData bakeSdf = { bakeData.data(), sdfResolution.x, sdfResolution.x * sdfResolution.y, sdfResolution };
+		SdfBakeMesh(&meshParams, &bakeParams, &bakeSdf);
+
+		SdfCompressDesc compressDesc;
+		SdfCompressDescDefaults(&compressDesc);
+		compressDesc.taskDispatch = &m_flowContext.m_taskDispatch;
+		SdfCompressed* compressed = SdfCompressedCreate(&compressDesc, &bakeSdf);
+
+		m_sdfHalfShape = SdfHalfShapeCreate(m_flowContext.m_gridContext, sdfResolution);
+		SdfHalfShapeUpload(m_sdfHalfShape, m_flowContext.m_gridContext, compressed);
+		m_shape = SdfHalfShapeGetShape(m_sdfHalfShape);
+
+		SdfCompressedRelease(compressed);
+	}
+	else if (m_cpuBake)
+	{
+		NvFlowShapeSDFDesc shapeDesc;
+		NvFlowShapeSDFDescDefaults(&shapeDesc);
+		shapeDesc.resolution = sdfResolution;
+		m_shape = NvFlowCreateShapeSDF(m_flowContext.m_gridContext, &shapeDesc);
+
+		SdfBakeParams bakeParams;
+		SdfBakeParamsDefaults(&bakeParams);
+		bakeParams.taskDispatch = &m_flowContext.m_taskDispatch;
+
+		if (m_animateSdf)
+		{
+			// two bone rig, the upper half of the mesh bends about its middle
+			m_deformPivotY = 0.5f * (meshData.boundsMin[1] + meshData.boundsMax[1]);
+			const float blend = 0.25f * (meshData.boundsMax[1] - meshData.boundsMin[1]);
+
+			std::vector<NvFlowUint> boneIndices(4u * meshData.numVertices, 0u);
+			std::vector<float> boneWeights(4u * meshData.numVertices, 0.f);
+			for (NvFlowUint vertexIdx = 0u; vertexIdx < meshData.numVertices; vertexIdx++)
+			{
+				float y = meshData.positions[vertexIdx * meshData.positionStride / sizeof(float) + 1u];
+				float weight = fminf(fmaxf((y - m_deformPivotY) / blend + 0.5f, 0.f), 1.f);
+				boneIndices[4u * vertexIdx + 1u] = 1u;
+				boneWeights[4u * vertexIdx + 0u] = 1.f - weight;
+				boneWeights[4u * vertexIdx + 1u] = weight;
+			}
+			SdfDeformerSkin skin = { boneIndices.data(), boneWeights.data() };
+
+			SdfDeformerDesc deformerDesc;
+			SdfDeformerDescDefaults(&deformerDesc);
+			deformerDesc.dim = sdfResolution;
+			deformerDesc.bakeParams = bakeParams;
+			m_sdfDeformer = SdfDeformerCreate(&deformerDesc, &meshParams, &skin);
+			m_deformTime = 0.f;
+		}
+
+		auto mappedData = NvFlowShapeSDFMap(m_shape, m_flowContext.m_gridContext);
+		if (mappedData.data)
+		{
+			if (m_sdfDeformer)
+			{
+				SdfDeformerUpdate(m_sdfDeformer);
+				SdfDeformerCopy(m_sdfDeformer, &mappedData);
+			}
+			else
+			{
+				SdfBakeMesh(&meshParams, &bakeParams, &mappedData);
+			}
+			NvFlowShapeSDFUnmap(m_shape, m_flowContext.m_gridContext);
+		}
+	}
+	else
+	{
+		NvFlowSDFGenDesc sdfDesc;
+		sdfDesc.resolution = sdfResolution;
+
+		m_sdfGen = NvFlowCreateSDFGen(m_flowContext.m_gridContext, &sdfDesc);
+
+		NvFlowSDFGenReset(m_sdfGen, m_flowContext.m_gridContext);
 
-	NvFlowSDFGenUpdate(m_sdfGen, m_flowContext.m_gridContext);
+		NvFlowSDFGenVoxelize(m_sdfGen, m_flowContext.m_gridContext, &meshParams);
 
-	// create shape from SDF
-	m_shape = NvFlowCreateShapeSDFFromTexture3D(
-		m_flowContext.m_gridContext, 
-		NvFlowSDFGenShape(m_sdfGen, m_flowContext.m_gridContext)
-	);
+		NvFlowSDFGenUpdate(m_sdfGen, m_flowContext.m_gridContext);
+
+		// create shape from SDF
+		m_shape = NvFlowCreateShapeSDFFromTexture3D(
+			m_flowContext.m_gridContext,
+			NvFlowSDFGenShape(m_sdfGen, m_flowContext.m_gridContext)
+		);
+	}
 
 	// create default color map
 	{
@@ -155,11 +235,39 @@ void SceneSDFTest::init(AppGraphCtx* appctx, int winw, int winh)
 
 void SceneSDFTest::doUpdate(float dt)
 {
-	bool shouldUpdate = m_flowContext.updateBegin(dt);
+	bool shouldUpdate = m_flowContext.updateBegin(&dt);
 	if (shouldUpdate)
 	{
 		AppGraphCtxProfileBegin(m_appctx, "Simulate");
 
+		if (m_sdfDeformer)
+		{
+			using namespace DirectX;
+
+			m_deformTime += dt;
+
+			// bend the upper bone about the pivot, only bricks the motion reaches are rebaked
+			float angle = 0.4f * sinf(2.f * m_deformTime);
+			XMMATRIX bend = XMMatrixMultiply(
+				XMMatrixTranslation(0.f, -m_deformPivotY, 0.f),
+				XMMatrixMultiply(XMMatrixRotationZ(angle), XMMatrixTranslation(0.f, m_deformPivotY, 0.f))
+				);
+			NvFlowFloat4x4 bones[2];
+			XMStoreFloat4x4((XMFLOAT4X4*)&bones[0], XMMatrixIdentity());
+			XMStoreFloat4x4((XMFLOAT4X4*)&bones[1], bend);
+			SdfDeformerSetBones(m_sdfDeformer, bones, 2u);
+
+			if (SdfDeformerUpdate(m_sdfDeformer) > 0u)
+			{
+				auto mappedData = NvFlowShapeSDFMap(m_shape, m_flowContext.m_gridContext);
+				if (mappedData.data)
+				{
+					SdfDeformerCopy(m_sdfDeformer, &mappedData);
+					NvFlowShapeSDFUnmap(m_shape, m_flowContext.m_gridContext);
+				}
+			}
+		}
+
 		{
 			m_flowGridActor.updatePreEmit(&m_flowContext, dt);
 
@@ -244,9 +352,16 @@ void SceneSDFTest::release()
 
 	m_flowGridActor.release();
 
-	NvFlowReleaseShapeSDF(m_shape);
+	if (m_sdfHalfShape) SdfHalfShapeRelease(m_sdfHalfShape);
+	else NvFlowReleaseShapeSDF(m_shape);
+	m_sdfHalfShape = nullptr;
+	m_shape = nullptr;
 
-	NvFlowReleaseSDFGen(m_sdfGen);
+	if (m_sdfGen) NvFlowReleaseSDFGen(m_sdfGen);
+	m_sdfGen = nullptr;
+
+	if (m_sdfDeformer) SdfDeformerRelease(m_sdfDeformer);
+	m_sdfDeformer = nullptr;
 
 	m_flowContext.release();
 
@@ -265,6 +380,25 @@ void SceneSDFTest::imgui(int xIn, int yIn, int wIn, int hIn)
 	}
 }
 
+void SceneSDFTest::imguiFluidEmitterExtra()
+{
+	if (imguiCheck("CPU SDF Bake", m_cpuBake, true))
+	{
+		m_cpuBake = !m_cpuBake;
+		m_shouldReset = true;
+	}
+	if (m_cpuBake && imguiCheck("Animate SDF", m_animateSdf, true))
+	{
+		m_animateSdf = !m_animateSdf;
+		m_shouldReset = true;
+	}
+	if (m_cpuBake && !m_animateSdf && imguiCheck("Compressed SDF", m_compressSdf, true))
+	{
+		m_compressSdf = !m_compressSdf;
+		m_shouldReset = true;
+	}
+}
+
 // ************************** Scene Custom Lighting ******************************
 
 #include "computeContext.h"
@@ -302,7 +436,7 @@ void SceneCustomLighting::init(AppGraphCtx* context, int winw, int winh)
 
 void SceneCustomLighting::doUpdate(float dt)
 {
-	bool shouldUpdate = m_flowContext.updateBegin(dt);
+	bool shouldUpdate = m_flowContext.updateBegin(&dt);
 	if (shouldUpdate)
 	{
 		ComputeContextNvFlowContextUpdate(m_computeContext, m_flowContext.m_renderContext);
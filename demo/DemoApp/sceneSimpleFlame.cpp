@@ -123,7 +123,7 @@ void SceneSimpleFlame::init(AppGraphCtx* appctx, int winw, int winh)
 
 void SceneSimpleFlame::doUpdate(float dt)
 {
-	bool shouldUpdate = m_flowContext.updateBegin(dt);
+	bool shouldUpdate = m_flowContext.updateBegin(&dt);
 	if (shouldUpdate)
 	{
 		AppGraphCtxProfileBegin(m_appctx, "Simulate");
@@ -217,21 +217,20 @@ void SceneSimpleFlameDouble::init(AppGraphCtx* context, int winw, int winh)
 
 	m_flowGridActor.m_renderMaterialMat0Params.material = m_materialA;
 	m_flowGridActor.m_renderMaterialMat1Params.material = m_materialB;
+
+	NvFlowGridMaterialHandle emitMaterials[2u] = { m_materialA, m_materialB };
+	m_flowGridActor.setEmitMaterials(emitMaterials, 2u);
 }
 
 void SceneSimpleFlameDouble::doUpdate(float dt)
 {
-	bool shouldUpdate = m_flowContext.updateBegin(dt);
+	bool shouldUpdate = m_flowContext.updateBegin(&dt);
 	if (shouldUpdate)
 	{
 		AppGraphCtxProfileBegin(m_appctx, "Simulate");
 
 		m_flowGridActor.updatePreEmit(&m_flowContext, dt);
 
-		NvFlowGridMaterialHandle emitMaterials[2u] = { m_materialA, m_materialB };
-
-		NvFlowGridUpdateEmitMaterials(m_flowGridActor.m_grid, emitMaterials, 2u);
-
 		// emit
 		{
 			NvFlowShapeDesc shapeDesc;
@@ -322,7 +321,7 @@ void SceneSimpleFlameFuelMap::init(AppGraphCtx* context, int winw, int winh)
 
 void SceneSimpleFlameFuelMap::doUpdate(float dt)
 {
-	bool shouldUpdate = m_flowContext.updateBegin(dt);
+	bool shouldUpdate = m_flowContext.updateBegin(&dt);
 	if (shouldUpdate)
 	{
 		AppGraphCtxProfileBegin(m_appctx, "Simulate");
@@ -474,7 +473,7 @@ void SceneSimpleFlameParticleSurface::doEmitCustomEmitDensityFunc(NvFlowUint* da
 
 void SceneSimpleFlameParticleSurface::doUpdate(float dt)
 {
-	bool shouldUpdate = m_flowContext.updateBegin(dt);
+	bool shouldUpdate = m_flowContext.updateBegin(&dt);
 	if (shouldUpdate)
 	{
 		// update emit params
@@ -912,80 +911,98 @@ void SceneSimpleFlameCulling::initParams()
 	m_emitParams.allocationPredict = 0.4f;
 }
 
-void SceneSimpleFlameCulling::doUpdate(float dt)
+void SceneSimpleFlameCulling::updateEmitters()
 {
-	bool shouldUpdate = m_flowContext.updateBegin(dt);
-	if (shouldUpdate)
+	// main emitter
 	{
-		AppGraphCtxProfileBegin(m_appctx, "Simulate");
+		NvFlowShapeDesc shapeDesc;
+		shapeDesc.box.halfSize = { 0.8f, 0.8f, 0.8f };
 
-		{
-			m_flowGridActor.updatePreEmit(&m_flowContext, dt);
+		m_emitParams.localToWorld = m_emitParams.bounds;
+		m_emitParams.shapeType = eNvFlowShapeTypeBox;
 
-			// main emitter
-			{
-				NvFlowShapeDesc shapeDesc;
-				shapeDesc.box.halfSize = { 0.8f, 0.8f, 0.8f };
+		if (!m_emitterSet.update(m_mainEmitter, &shapeDesc, &m_emitParams))
+		{
+			m_mainEmitter = m_emitterSet.add(shapeDesc, m_emitParams);
+		}
+	}
 
-				m_emitParams.localToWorld = m_emitParams.bounds;
-				m_emitParams.shapeType = eNvFlowShapeTypeBox;
-				m_emitParams.deltaTime = dt;
+	// grid of emitters, only rebuilt when the grid size changes
+	if (m_emitGridRBuilt != m_emitGridR)
+	{
+		for (EmitterHandle handle : m_gridEmitters)
+		{
+			m_emitterSet.remove(handle);
+		}
+		m_gridEmitters.clear();
 
-				NvFlowGridEmit(m_flowGridActor.m_grid, &shapeDesc, 1u, &m_emitParams, 1u);
-			}
+		const int r = m_emitGridR;
+		const float scale = 0.125f;
 
-			// grid of emitters
-			{
-				const int r = m_emitGridR;
-				const float scale = 0.125f;
+		NvFlowShapeDesc shapeDesc;
+		shapeDesc.sphere.radius = 0.8f;
 
-				NvFlowShapeDesc shapeDesc;
-				shapeDesc.sphere.radius = 0.8f;
+		NvFlowGridEmitParams emitParams;
 
-				NvFlowGridEmitParams emitParams;
+		NvFlowGridEmitParamsDefaults(&emitParams);
 
-				NvFlowGridEmitParamsDefaults(&emitParams);
+		emitParams.bounds.x.x = 0.25f;
+		emitParams.bounds.y.y = 0.25f;
+		emitParams.bounds.z.z = 0.25f;
 
-				emitParams.bounds.x.x = 0.25f;
-				emitParams.bounds.y.y = 0.25f;
-				emitParams.bounds.z.z = 0.25f;
+		emitParams.maxActiveDist = -0.08f;
+		emitParams.slipThickness = 0.25f;
+		emitParams.slipFactor = 0.9f;
 
-				emitParams.maxActiveDist = -0.08f;
-				emitParams.slipThickness = 0.25f;
-				emitParams.slipFactor = 0.9f;
+		emitParams.velocityCoupleRate = { 1000.f, 1000.f, 1000.f };
 
-				emitParams.velocityCoupleRate = { 1000.f, 1000.f, 1000.f };
+		emitParams.temperature = 0.f;
+		emitParams.temperatureCoupleRate = 10.f;
 
-				emitParams.temperature = 0.f;
-				emitParams.temperatureCoupleRate = 10.f;
+		emitParams.fuel = 0.f;
+		emitParams.fuelCoupleRate = 10.f;
 
-				emitParams.fuel = 0.f;
-				emitParams.fuelCoupleRate = 10.f;
+		emitParams.smoke = 0.f;
+		emitParams.smokeCoupleRate = 10.f;
 
-				emitParams.smoke = 0.f;
-				emitParams.smokeCoupleRate = 10.f;
+		emitParams.allocationScale = { 1.f, 1.f, 1.f };
+		emitParams.allocationPredict = 0.f;
 
-				emitParams.allocationScale = { 1.f, 1.f, 1.f };
-				emitParams.allocationPredict = 0.f;
+		emitParams.shapeType = eNvFlowShapeTypeSphere;
 
-				for (int j = -r; j <= r; j++)
-				{
-					for (int i = -r; i <= r; i++)
-					{
-						if (i == 0 && j == 0) continue;
+		for (int j = -r; j <= r; j++)
+		{
+			for (int i = -r; i <= r; i++)
+			{
+				if (i == 0 && j == 0) continue;
 
-						emitParams.bounds.w.x = scale * float(i);
-						emitParams.bounds.w.y = 0.f;
-						emitParams.bounds.w.z = scale * float(j);
+				emitParams.bounds.w.x = scale * float(i);
+				emitParams.bounds.w.y = 0.f;
+				emitParams.bounds.w.z = scale * float(j);
 
-						emitParams.localToWorld = emitParams.bounds;
-						emitParams.shapeType = eNvFlowShapeTypeSphere;
-						emitParams.deltaTime = dt;
+				emitParams.localToWorld = emitParams.bounds;
 
-						NvFlowGridEmit(m_flowGridActor.m_grid, &shapeDesc, 1u, &emitParams, 1u);
-					}
-				}
+				m_gridEmitters.push_back(m_emitterSet.add(shapeDesc, emitParams));
 			}
+		}
+
+		m_emitGridRBuilt = m_emitGridR;
+	}
+}
+
+void SceneSimpleFlameCulling::doUpdate(float dt)
+{
+	bool shouldUpdate = m_flowContext.updateBegin(&dt);
+	if (shouldUpdate)
+	{
+		AppGraphCtxProfileBegin(m_appctx, "Simulate");
+
+		{
+			m_flowGridActor.updatePreEmit(&m_flowContext, dt);
+
+			updateEmitters();
+
+			m_emitterSet.submit(m_flowGridActor.m_grid, dt, &m_flowGridActor.m_emitterCuller);
 
 			m_projectile.update(m_flowContext.m_gridContext, m_flowGridActor.m_grid, dt);
 
@@ -1009,9 +1026,26 @@ void SceneSimpleFlameCulling::imguiFluidEmitterExtra()
 	imguiserSlider("Emit Grid R", &r, 0.f, 16.f, 1.f, true);
 	m_emitGridR = NvFlowUint(r);
 
+	EmitterCuller& culler = m_flowGridActor.m_emitterCuller;
+	if (imguiserCheck("Enable Culling", culler.m_enabled, true))
+	{
+		culler.m_enabled = !culler.m_enabled;
+	}
+
 	imguiserEndGroup();
 }
 
+bool SceneSimpleFlameCulling::getStats(int lineIdx, int statIdx, char* buf)
+{
+	if (statIdx == 0)
+	{
+		const EmitterCuller& culler = m_flowGridActor.m_emitterCuller;
+		snprintf(buf, 79, "Emitters: %d submitted, %d culled", culler.m_statSubmitted, culler.m_statCulled);
+		return true;
+	}
+	return SceneSimpleFlame::getStats(lineIdx, statIdx - 1, buf);
+}
+
 // *************************** SceneSimpleFlameConvex ************************
 
 void SceneSimpleFlameConvex::initParams()
@@ -1027,7 +1061,7 @@ void SceneSimpleFlameConvex::initParams()
 
 void SceneSimpleFlameConvex::doUpdate(float dt)
 {
-	bool shouldUpdate = m_flowContext.updateBegin(dt);
+	bool shouldUpdate = m_flowContext.updateBegin(&dt);
 	if (shouldUpdate)
 	{
 		AppGraphCtxProfileBegin(m_appctx, "Simulate");
@@ -1105,7 +1139,7 @@ void SceneSimpleFlameCapsule::initParams()
 
 void SceneSimpleFlameCapsule::doUpdate(float dt)
 {
-	bool shouldUpdate = m_flowContext.updateBegin(dt);
+	bool shouldUpdate = m_flowContext.updateBegin(&dt);
 	if (shouldUpdate)
 	{
 		AppGraphCtxProfileBegin(m_appctx, "Simulate");
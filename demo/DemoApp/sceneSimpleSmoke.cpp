@@ -137,7 +137,7 @@ NvFlowFloat3 SceneSimpleSmoke::velocityFunc(float theta, float rate)
 
 void SceneSimpleSmoke::doUpdate(float dt)
 {
-	bool shouldUpdate = m_flowContext.updateBegin(dt);
+	bool shouldUpdate = m_flowContext.updateBegin(&dt);
 	if (shouldUpdate)
 	{
 		AppGraphCtxProfileBegin(m_appctx, "Simulate");
@@ -285,7 +285,8 @@ void SceneSimpleFlameBall::initParams()
 	SceneSimpleFlame::initParams();
 
 	m_flowGridActor.m_gridDesc.lowLatencyMapping = true;
-	m_flowGridActor.m_memoryLimit = 4.f;
+	m_flowGridActor.m_gridBudget.m_budgetBytes = m_flowGridActor.m_gridBudget.poolBytes(m_flowGridActor.m_gridDesc, 4.f * m_flowGridActor.m_memoryScale);
+	m_flowGridActor.m_gridDesc.residentScale = m_flowGridActor.m_gridBudget.residentScale(m_flowGridActor.m_gridDesc);
 
 	m_flowGridActor.m_materialParams.smoke.allocWeight = 1.f;
 	m_flowGridActor.m_materialParams.smoke.allocThreshold = 0.02f;
@@ -0,0 +1,370 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <string.h>
+
+#include <vector>
+#include <algorithm>
+
+#include "sdfAtlas.h"
+
+namespace
+{
+	// free cells read as far outside, beyond any NDC distance
+	const float atlasEmptyDist = 4.f;
+
+	struct SdfAtlasEntry
+	{
+		NvFlowUint slotMin[3];
+		NvFlowUint slotCount[3];
+		NvFlowUint offset[3];			// first interior cell, past the apron
+		NvFlowDim dim;
+		bool used = false;
+	};
+
+	NvFlowFloat4 mulRow(const NvFlowFloat4& r, const NvFlowFloat4x4& m)
+	{
+		return {
+			r.x * m.x.x + r.y * m.y.x + r.z * m.z.x + r.w * m.w.x,
+			r.x * m.x.y + r.y * m.y.y + r.z * m.z.y + r.w * m.w.y,
+			r.x * m.x.z + r.y * m.y.z + r.z * m.z.z + r.w * m.w.z,
+			r.x * m.x.w + r.y * m.y.w + r.z * m.z.w + r.w * m.w.w
+		};
+	}
+
+	// row vector convention, a then b
+	NvFlowFloat4x4 matrixMultiply(const NvFlowFloat4x4& a, const NvFlowFloat4x4& b)
+	{
+		return { mulRow(a.x, b), mulRow(a.y, b), mulRow(a.z, b), mulRow(a.w, b) };
+	}
+}
+
+struct SdfAtlas
+{
+	SdfAtlasDesc m_desc;
+	NvFlowDim m_dim = { 0u, 0u, 0u };
+	NvFlowShapeSDF* m_shape = nullptr;
+
+	// CPU copy of the whole atlas, uploaded by flush
+	std::vector<float> m_data;
+	bool m_dirty = true;
+
+	std::vector<unsigned char> m_slotUsed;
+	NvFlowUint m_numSlotsUsed = 0u;
+
+	std::vector<SdfAtlasEntry> m_entries;
+	std::vector<NvFlowUint> m_entryGeneration;
+	std::vector<NvFlowUint> m_freeEntries;
+	NvFlowUint m_numShapes = 0u;
+
+	NvFlowUint slotIdx(NvFlowUint x, NvFlowUint y, NvFlowUint z) const
+	{
+		return (z * m_desc.numSlots.y + y) * m_desc.numSlots.x + x;
+	}
+
+	NvFlowUint cellIdx(NvFlowUint i, NvFlowUint j, NvFlowUint k) const
+	{
+		return (k * m_dim.y + j) * m_dim.x + i;
+	}
+
+	bool isFree(const NvFlowUint* slotMin, const NvFlowUint* slotCount) const;
+	bool findFree(const NvFlowUint* slotCount, NvFlowUint* slotMin) const;
+	void markSlots(const SdfAtlasEntry& entry, unsigned char used);
+	void clearEntry(const SdfAtlasEntry& entry);
+};
+
+bool SdfAtlas::isFree(const NvFlowUint* slotMin, const NvFlowUint* slotCount) const
+{
+	for (NvFlowUint z = slotMin[2]; z < slotMin[2] + slotCount[2]; z++)
+	{
+		for (NvFlowUint y = slotMin[1]; y < slotMin[1] + slotCount[1]; y++)
+		{
+			for (NvFlowUint x = slotMin[0]; x < slotMin[0] + slotCount[0]; x++)
+			{
+				if (m_slotUsed[slotIdx(x, y, z)])
+				{
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool SdfAtlas::findFree(const NvFlowUint* slotCount, NvFlowUint* slotMin) const
+{
+	const NvFlowUint numSlots[3] = { m_desc.numSlots.x, m_desc.numSlots.y, m_desc.numSlots.z };
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (slotCount[axis] > numSlots[axis])
+		{
+			return false;
+		}
+	}
+	// first fit, z major so small shapes fill the low slices first
+	for (slotMin[2] = 0u; slotMin[2] + slotCount[2] <= numSlots[2]; slotMin[2]++)
+	{
+		for (slotMin[1] = 0u; slotMin[1] + slotCount[1] <= numSlots[1]; slotMin[1]++)
+		{
+			for (slotMin[0] = 0u; slotMin[0] + slotCount[0] <= numSlots[0]; slotMin[0]++)
+			{
+				if (isFree(slotMin, slotCount))
+				{
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+void SdfAtlas::markSlots(const SdfAtlasEntry& entry, unsigned char used)
+{
+	for (NvFlowUint z = entry.slotMin[2]; z < entry.slotMin[2] + entry.slotCount[2]; z++)
+	{
+		for (NvFlowUint y = entry.slotMin[1]; y < entry.slotMin[1] + entry.slotCount[1]; y++)
+		{
+			for (NvFlowUint x = entry.slotMin[0]; x < entry.slotMin[0] + entry.slotCount[0]; x++)
+			{
+				m_slotUsed[slotIdx(x, y, z)] = used;
+			}
+		}
+	}
+	NvFlowUint numSlots = entry.slotCount[0] * entry.slotCount[1] * entry.slotCount[2];
+	m_numSlotsUsed = used ? m_numSlotsUsed + numSlots : m_numSlotsUsed - numSlots;
+}
+
+void SdfAtlas::clearEntry(const SdfAtlasEntry& entry)
+{
+	for (NvFlowUint k = 0u; k < entry.dim.z + 2u; k++)
+	{
+		for (NvFlowUint j = 0u; j < entry.dim.y + 2u; j++)
+		{
+			float* dst = &m_data[cellIdx(entry.offset[0] - 1u, entry.offset[1] + j - 1u, entry.offset[2] + k - 1u)];
+			std::fill(dst, dst + entry.dim.x + 2u, atlasEmptyDist);
+		}
+	}
+}
+
+void SdfAtlasDescDefaults(SdfAtlasDesc* desc)
+{
+	desc->slotDim = { 16u, 16u, 16u };
+	desc->numSlots = { 8u, 8u, 8u };
+}
+
+SdfAtlas* SdfAtlasCreate(NvFlowContext* context, const SdfAtlasDesc* desc)
+{
+	SdfAtlas* atlas = new SdfAtlas;
+	atlas->m_desc = *desc;
+	atlas->m_dim = {
+		desc->slotDim.x * desc->numSlots.x,
+		desc->slotDim.y * desc->numSlots.y,
+		desc->slotDim.z * desc->numSlots.z
+	};
+	atlas->m_data.assign(size_t(atlas->m_dim.x) * atlas->m_dim.y * atlas->m_dim.z, atlasEmptyDist);
+	atlas->m_slotUsed.assign(desc->numSlots.x * desc->numSlots.y * desc->numSlots.z, 0u);
+
+	if (context)
+	{
+		NvFlowShapeSDFDesc shapeDesc;
+		NvFlowShapeSDFDescDefaults(&shapeDesc);
+		shapeDesc.resolution = atlas->m_dim;
+		atlas->m_shape = NvFlowCreateShapeSDF(context, &shapeDesc);
+
+		SdfAtlasFlush(atlas, context);
+	}
+
+	return atlas;
+}
+
+void SdfAtlasRelease(SdfAtlas* atlas)
+{
+	if (atlas == nullptr) return;
+
+	if (atlas->m_shape) NvFlowReleaseShapeSDF(atlas->m_shape);
+
+	delete atlas;
+}
+
+SdfAtlasHandle SdfAtlasInsert(SdfAtlas* atlas, const NvFlowShapeSDFData* sdf)
+{
+	SdfAtlasHandle handle;
+	if (sdf->data == nullptr || sdf->dim.x == 0u || sdf->dim.y == 0u || sdf->dim.z == 0u)
+	{
+		return handle;
+	}
+
+	SdfAtlasEntry entry;
+	entry.dim = sdf->dim;
+	const NvFlowUint dim[3] = { sdf->dim.x, sdf->dim.y, sdf->dim.z };
+	const NvFlowUint slotDim[3] = { atlas->m_desc.slotDim.x, atlas->m_desc.slotDim.y, atlas->m_desc.slotDim.z };
+	for (int axis = 0; axis < 3; axis++)
+	{
+		entry.slotCount[axis] = (dim[axis] + 2u + slotDim[axis] - 1u) / slotDim[axis];
+	}
+	if (!atlas->findFree(entry.slotCount, entry.slotMin))
+	{
+		return handle;
+	}
+	for (int axis = 0; axis < 3; axis++)
+	{
+		entry.offset[axis] = entry.slotMin[axis] * slotDim[axis] + 1u;
+	}
+	entry.used = true;
+
+	// interior plus apron, the apron repeats the nearest edge value
+	for (NvFlowUint k = 0u; k < dim[2] + 2u; k++)
+	{
+		NvFlowUint srcK = std::min(std::max(k, 1u), dim[2]) - 1u;
+		for (NvFlowUint j = 0u; j < dim[1] + 2u; j++)
+		{
+			NvFlowUint srcJ = std::min(std::max(j, 1u), dim[1]) - 1u;
+			const float* src = sdf->data + srcK * sdf->depthPitch + srcJ * sdf->rowPitch;
+			float* dst = &atlas->m_data[atlas->cellIdx(entry.offset[0] - 1u, entry.offset[1] + j - 1u, entry.offset[2] + k - 1u)];
+			dst[0] = src[0];
+			memcpy(dst + 1u, src, dim[0] * sizeof(float));
+			dst[dim[0] + 1u] = src[dim[0] - 1u];
+		}
+	}
+
+	NvFlowUint entryIdx;
+	if (atlas->m_freeEntries.size() > 0u)
+	{
+		entryIdx = atlas->m_freeEntries.back();
+		atlas->m_freeEntries.pop_back();
+	}
+	else
+	{
+		entryIdx = NvFlowUint(atlas->m_entries.size());
+		atlas->m_entries.push_back(SdfAtlasEntry());
+		atlas->m_entryGeneration.push_back(0u);
+	}
+	atlas->m_entries[entryIdx] = entry;
+	atlas->markSlots(entry, 1u);
+	atlas->m_numShapes++;
+	atlas->m_dirty = true;
+
+	handle.slot = entryIdx;
+	handle.generation = atlas->m_entryGeneration[entryIdx];
+	return handle;
+}
+
+bool SdfAtlasIsValid(SdfAtlas* atlas, SdfAtlasHandle handle)
+{
+	return handle.slot < atlas->m_entries.size() &&
+		atlas->m_entryGeneration[handle.slot] == handle.generation &&
+		atlas->m_entries[handle.slot].used;
+}
+
+bool SdfAtlasEvict(SdfAtlas* atlas, SdfAtlasHandle handle)
+{
+	if (!SdfAtlasIsValid(atlas, handle))
+	{
+		return false;
+	}
+	SdfAtlasEntry& entry = atlas->m_entries[handle.slot];
+	atlas->markSlots(entry, 0u);
+	atlas->clearEntry(entry);
+	entry.used = false;
+	atlas->m_entryGeneration[handle.slot]++;
+	atlas->m_freeEntries.push_back(handle.slot);
+	atlas->m_numShapes--;
+	atlas->m_dirty = true;
+	return true;
+}
+
+bool SdfAtlasGetEmitParams(SdfAtlas* atlas, SdfAtlasHandle handle, NvFlowGridEmitParams* params)
+{
+	if (!SdfAtlasIsValid(atlas, handle))
+	{
+		return false;
+	}
+	const SdfAtlasEntry& entry = atlas->m_entries[handle.slot];
+	const NvFlowUint dim[3] = { entry.dim.x, entry.dim.y, entry.dim.z };
+	const NvFlowUint atlasDim[3] = { atlas->m_dim.x, atlas->m_dim.y, atlas->m_dim.z };
+
+	// brick center and half size in atlas NDC, shape cell centers land on atlas cell centers
+	float center[3];
+	float halfSize[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		center[axis] = (2.f * float(entry.offset[axis]) + float(dim[axis])) / float(atlasDim[axis]) - 1.f;
+		halfSize[axis] = float(dim[axis]) / float(atlasDim[axis]);
+	}
+
+	// atlas NDC to shape NDC, then on to world as before
+	NvFlowFloat4x4 atlasToShape = {
+		1.f / halfSize[0], 0.f, 0.f, 0.f,
+		0.f, 1.f / halfSize[1], 0.f, 0.f,
+		0.f, 0.f, 1.f / halfSize[2], 0.f,
+		-center[0] / halfSize[0], -center[1] / halfSize[1], -center[2] / halfSize[2], 1.f
+	};
+	params->localToWorld = matrixMultiply(atlasToShape, params->localToWorld);
+	return true;
+}
+
+void SdfAtlasFlush(SdfAtlas* atlas, NvFlowContext* context)
+{
+	if (!atlas->m_dirty || atlas->m_shape == nullptr)
+	{
+		return;
+	}
+	auto mappedData = NvFlowShapeSDFMap(atlas->m_shape, context);
+	if (mappedData.data)
+	{
+		for (NvFlowUint k = 0u; k < atlas->m_dim.z; k++)
+		{
+			for (NvFlowUint j = 0u; j < atlas->m_dim.y; j++)
+			{
+				memcpy(mappedData.data + k * mappedData.depthPitch + j * mappedData.rowPitch,
+					&atlas->m_data[atlas->cellIdx(0u, j, k)], atlas->m_dim.x * sizeof(float));
+			}
+		}
+		NvFlowShapeSDFUnmap(atlas->m_shape, context);
+		atlas->m_dirty = false;
+	}
+}
+
+NvFlowShapeSDF* SdfAtlasGetShape(SdfAtlas* atlas)
+{
+	return atlas->m_shape;
+}
+
+void SdfAtlasGetData(SdfAtlas* atlas, NvFlowShapeSDFData* data)
+{
+	data->data = atlas->m_data.data();
+	data->rowPitch = atlas->m_dim.x;
+	data->depthPitch = atlas->m_dim.x * atlas->m_dim.y;
+	data->dim = atlas->m_dim;
+}
+
+void SdfAtlasGetStats(SdfAtlas* atlas, SdfAtlasStats* stats)
+{
+	stats->numShapes = atlas->m_numShapes;
+	stats->numSlotsUsed = atlas->m_numSlotsUsed;
+	stats->numSlotsTotal = NvFlowUint(atlas->m_slotUsed.size());
+}
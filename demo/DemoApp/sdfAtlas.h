@@ -0,0 +1,108 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "NvFlow.h"
+
+/// ****************** SDF Atlas Public *******************************
+
+// Many SDF shapes packed into one NvFlowShapeSDF, so any number of SDF emitters bind a single texture.
+//
+// The atlas is divided into slots of slotDim cells. Each inserted SDF takes a box of slots,
+// found first fit over a slot occupancy grid, with a one cell apron of clamped edge values so
+// linear filtering never reads a neighbor. Insert and evict only touch the CPU copy, flush
+// uploads it once per batch of changes.
+// An emitter addresses its SDF through its transform: SdfAtlasGetEmitParams() rewrites
+// localToWorld so the shape's [-1, 1] box lands on its brick, bounds keep the emission to it.
+// All atlas emitters then use sdfOffset 0 with SdfAtlasGetShape() as the only emit SDF.
+// Distances keep the units of each inserted SDF, so emitter thresholds work as for a lone shape.
+
+struct SdfAtlas;
+
+struct SdfAtlasHandle
+{
+	NvFlowUint slot = ~0u;
+	NvFlowUint generation = 0u;
+};
+
+struct SdfAtlasDesc
+{
+	NvFlowDim slotDim;					//!< Cells per slot, apron included
+	NvFlowDim numSlots;					//!< Slots per axis, atlas resolution is slotDim * numSlots
+};
+
+struct SdfAtlasStats
+{
+	NvFlowUint numShapes;
+	NvFlowUint numSlotsUsed;
+	NvFlowUint numSlotsTotal;
+};
+
+void SdfAtlasDescDefaults(SdfAtlasDesc* desc);
+
+//! A nullptr context keeps the atlas on the CPU, read it with SdfAtlasGetData()
+SdfAtlas* SdfAtlasCreate(NvFlowContext* context, const SdfAtlasDesc* desc);
+
+void SdfAtlasRelease(SdfAtlas* atlas);
+
+/**
+ * Pack an SDF into the atlas.
+ *
+ * @param[in] atlas The SDF atlas.
+ * @param[in] sdf Source SDF, for example baked with sdfBake.h into a CPU buffer.
+ *
+ * @return Returns the handle, invalid if no free box of slots fits the SDF and its apron.
+ */
+SdfAtlasHandle SdfAtlasInsert(SdfAtlas* atlas, const NvFlowShapeSDFData* sdf);
+
+//! Frees the slots of an SDF, emitters using it must be gone by the next flush
+bool SdfAtlasEvict(SdfAtlas* atlas, SdfAtlasHandle handle);
+
+bool SdfAtlasIsValid(SdfAtlas* atlas, SdfAtlasHandle handle);
+
+/**
+ * Address an SDF from an emitter set up as for its own NvFlowShapeSDF.
+ *
+ * @param[in] atlas The SDF atlas.
+ * @param[in] handle The SDF to address.
+ * @param[in,out] params Emitter with shapeType SDF, localToWorld is rewritten to the atlas frame.
+ *
+ * @return Returns false for an invalid handle, params are left as they were.
+ */
+bool SdfAtlasGetEmitParams(SdfAtlas* atlas, SdfAtlasHandle handle, NvFlowGridEmitParams* params);
+
+//! Uploads pending inserts and evicts, call before the grid update using them
+void SdfAtlasFlush(SdfAtlas* atlas, NvFlowContext* context);
+
+//! The atlas shape, nullptr for a CPU atlas
+NvFlowShapeSDF* SdfAtlasGetShape(SdfAtlas* atlas);
+
+//! CPU copy of the whole atlas, pending changes included, owned by the atlas
+void SdfAtlasGetData(SdfAtlas* atlas, NvFlowShapeSDFData* data);
+
+void SdfAtlasGetStats(SdfAtlas* atlas, SdfAtlasStats* stats);
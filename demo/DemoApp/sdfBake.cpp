@@ -0,0 +1,1376 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <math.h>
+#include <float.h>
+
+#include <vector>
+#include <algorithm>
+
+#include "sdfBake.h"
+#include "taskDispatch.h"
+
+namespace
+{
+	// ****************** Math ************************
+
+	NvFlowFloat3 operator+(const NvFlowFloat3& a, const NvFlowFloat3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+	NvFlowFloat3 operator-(const NvFlowFloat3& a, const NvFlowFloat3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	NvFlowFloat3 operator*(const NvFlowFloat3& a, float b) { return { a.x * b, a.y * b, a.z * b }; }
+
+	float dot(const NvFlowFloat3& a, const NvFlowFloat3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	float length(const NvFlowFloat3& a) { return sqrtf(dot(a, a)); }
+
+	NvFlowFloat3 cross(const NvFlowFloat3& a, const NvFlowFloat3& b)
+	{
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	NvFlowFloat3 min3(const NvFlowFloat3& a, const NvFlowFloat3& b) { return { fminf(a.x, b.x), fminf(a.y, b.y), fminf(a.z, b.z) }; }
+	NvFlowFloat3 max3(const NvFlowFloat3& a, const NvFlowFloat3& b) { return { fmaxf(a.x, b.x), fmaxf(a.y, b.y), fmaxf(a.z, b.z) }; }
+
+	// row vector convention, matching DirectXMath usage in the scenes
+	NvFlowFloat3 transformPoint(const NvFlowFloat4x4& m, const NvFlowFloat3& p)
+	{
+		return {
+			p.x * m.x.x + p.y * m.y.x + p.z * m.z.x + m.w.x,
+			p.x * m.x.y + p.y * m.y.y + p.z * m.z.y + m.w.y,
+			p.x * m.x.z + p.y * m.y.z + p.z * m.z.z + m.w.z
+		};
+	}
+
+	//! Closest point on triangle abc to p, from Ericson, Real-Time Collision Detection 5.1.5
+	NvFlowFloat3 closestPointTriangle(const NvFlowFloat3& p, const NvFlowFloat3& a, const NvFlowFloat3& b, const NvFlowFloat3& c)
+	{
+		NvFlowFloat3 ab = b - a;
+		NvFlowFloat3 ac = c - a;
+		NvFlowFloat3 ap = p - a;
+		float d1 = dot(ab, ap);
+		float d2 = dot(ac, ap);
+		if (d1 <= 0.f && d2 <= 0.f) return a;
+
+		NvFlowFloat3 bp = p - b;
+		float d3 = dot(ab, bp);
+		float d4 = dot(ac, bp);
+		if (d3 >= 0.f && d4 <= d3) return b;
+
+		float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) return a + ab * (d1 / (d1 - d3));
+
+		NvFlowFloat3 cp = p - c;
+		float d5 = dot(ab, cp);
+		float d6 = dot(ac, cp);
+		if (d6 >= 0.f && d5 <= d6) return c;
+
+		float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) return a + ac * (d2 / (d2 - d6));
+
+		float va = d3 * d6 - d5 * d4;
+		if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+		float denom = 1.f / (va + vb + vc);
+		return a + ab * (vb * denom) + ac * (vc * denom);
+	}
+
+	//! Signed solid angle of triangle abc seen from p, Van Oosterom and Strackee
+	float solidAngle(const NvFlowFloat3& p, const NvFlowFloat3& a, const NvFlowFloat3& b, const NvFlowFloat3& c)
+	{
+		NvFlowFloat3 pa = a - p;
+		NvFlowFloat3 pb = b - p;
+		NvFlowFloat3 pc = c - p;
+		float la = length(pa);
+		float lb = length(pb);
+		float lc = length(pc);
+		float num = dot(pa, cross(pb, pc));
+		if (num == 0.f)
+		{
+			// coplanar with p, atan2 would return pi for a negative den
+			return 0.f;
+		}
+		float den = la * lb * lc + dot(pa, pb) * lc + dot(pb, pc) * la + dot(pc, pa) * lb;
+		return 2.f * atan2f(num, den);
+	}
+
+	// ****************** BVH ************************
+
+	static const NvFlowUint bvhLeafSize = 4u;
+	static const float windingFarScale = 2.f;	// node dipoles are used beyond this many node radii
+
+	struct BvhNode
+	{
+		NvFlowFloat3 boundsMin;
+		NvFlowFloat3 boundsMax;
+		NvFlowUint first;				// first child, or first triangle of a leaf
+		NvFlowUint count;				// triangles of a leaf, 0 for inner nodes
+
+		// winding number dipole, area weighted normal about the area weighted center
+		NvFlowFloat3 center;
+		float radius;
+		NvFlowFloat3 areaNormal;
+	};
+
+	struct Bvh
+	{
+		std::vector<NvFlowFloat3> m_positions;
+		std::vector<NvFlowUint> m_triIndices;	// three per triangle, leaf order
+		std::vector<BvhNode> m_nodes;
+
+		void build(const NvFlowSDFGenMeshParams* mesh);
+		void build(const NvFlowUint* indices, NvFlowUint numIndices);
+		float distance(const NvFlowFloat3& p, NvFlowFloat3* closest = nullptr) const;
+		float winding(const NvFlowFloat3& p) const;
+		float orientation() const;
+
+		NvFlowUint numTriangles() const { return NvFlowUint(m_triIndices.size() / 3u); }
+
+		void triangle(NvFlowUint triIdx, NvFlowFloat3* a, NvFlowFloat3* b, NvFlowFloat3* c) const
+		{
+			*a = m_positions[m_triIndices[3u * triIdx + 0u]];
+			*b = m_positions[m_triIndices[3u * triIdx + 1u]];
+			*c = m_positions[m_triIndices[3u * triIdx + 2u]];
+		}
+
+		//! Recompute bounds and dipoles after m_positions moved, the topology is kept
+		void refit() { buildDipoles(); }
+
+	protected:
+		void buildNode(NvFlowUint nodeIdx, NvFlowUint first, NvFlowUint count, std::vector<NvFlowUint>& order, const std::vector<NvFlowFloat3>& centroids);
+		void buildDipoles();
+	};
+
+	float boxDistance2(const NvFlowFloat3& p, const NvFlowFloat3& boundsMin, const NvFlowFloat3& boundsMax)
+	{
+		float dx = fmaxf(fmaxf(boundsMin.x - p.x, p.x - boundsMax.x), 0.f);
+		float dy = fmaxf(fmaxf(boundsMin.y - p.y, p.y - boundsMax.y), 0.f);
+		float dz = fmaxf(fmaxf(boundsMin.z - p.z, p.z - boundsMax.z), 0.f);
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	void Bvh::build(const NvFlowSDFGenMeshParams* mesh)
+	{
+		m_positions.resize(mesh->numVertices);
+		const char* positionData = reinterpret_cast<const char*>(mesh->positions);
+		for (NvFlowUint vertexIdx = 0u; vertexIdx < mesh->numVertices; vertexIdx++)
+		{
+			const float* pos = reinterpret_cast<const float*>(positionData + size_t(vertexIdx) * mesh->positionStride);
+			m_positions[vertexIdx] = transformPoint(mesh->modelMatrix, { pos[0], pos[1], pos[2] });
+		}
+
+		build(mesh->indices, mesh->numIndices);
+	}
+
+	void Bvh::build(const NvFlowUint* indices, NvFlowUint numIndices)
+	{
+		const NvFlowUint numVertices = NvFlowUint(m_positions.size());
+
+		// degenerate triangles add nothing to either query
+		std::vector<NvFlowUint> tris;
+		std::vector<NvFlowFloat3> centroids;
+		for (NvFlowUint idx = 0u; idx + 2u < numIndices; idx += 3u)
+		{
+			NvFlowUint i0 = indices[idx + 0u];
+			NvFlowUint i1 = indices[idx + 1u];
+			NvFlowUint i2 = indices[idx + 2u];
+			if (i0 >= numVertices || i1 >= numVertices || i2 >= numVertices)
+			{
+				continue;
+			}
+			NvFlowFloat3 a = m_positions[i0], b = m_positions[i1], c = m_positions[i2];
+			NvFlowFloat3 n = cross(b - a, c - a);
+			if (dot(n, n) <= FLT_MIN)
+			{
+				continue;
+			}
+			tris.push_back(i0);
+			tris.push_back(i1);
+			tris.push_back(i2);
+			centroids.push_back((a + b + c) * (1.f / 3.f));
+		}
+
+		NvFlowUint numTris = NvFlowUint(centroids.size());
+		std::vector<NvFlowUint> order(numTris);
+		for (NvFlowUint triIdx = 0u; triIdx < numTris; triIdx++)
+		{
+			order[triIdx] = triIdx;
+		}
+
+		m_nodes.clear();
+		m_nodes.reserve(numTris > 0u ? 2u * numTris : 1u);
+		m_nodes.push_back(BvhNode{});
+		if (numTris > 0u)
+		{
+			buildNode(0u, 0u, numTris, order, centroids);
+		}
+
+		m_triIndices.resize(3u * numTris);
+		for (NvFlowUint triIdx = 0u; triIdx < numTris; triIdx++)
+		{
+			m_triIndices[3u * triIdx + 0u] = tris[3u * order[triIdx] + 0u];
+			m_triIndices[3u * triIdx + 1u] = tris[3u * order[triIdx] + 1u];
+			m_triIndices[3u * triIdx + 2u] = tris[3u * order[triIdx] + 2u];
+		}
+
+		buildDipoles();
+	}
+
+	void Bvh::buildNode(NvFlowUint nodeIdx, NvFlowUint first, NvFlowUint count, std::vector<NvFlowUint>& order, const std::vector<NvFlowFloat3>& centroids)
+	{
+		NvFlowFloat3 centroidMin = centroids[order[first]];
+		NvFlowFloat3 centroidMax = centroidMin;
+		for (NvFlowUint idx = first + 1u; idx < first + count; idx++)
+		{
+			centroidMin = min3(centroidMin, centroids[order[idx]]);
+			centroidMax = max3(centroidMax, centroids[order[idx]]);
+		}
+
+		m_nodes[nodeIdx].first = first;
+		m_nodes[nodeIdx].count = count;
+		if (count <= bvhLeafSize)
+		{
+			return;
+		}
+
+		// median split on the longest centroid axis
+		NvFlowFloat3 extent = centroidMax - centroidMin;
+		int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+		NvFlowUint half = count / 2u;
+		std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+			[&](NvFlowUint a, NvFlowUint b) { return (&centroids[a].x)[axis] < (&centroids[b].x)[axis]; });
+
+		NvFlowUint childIdx = NvFlowUint(m_nodes.size());
+		m_nodes.push_back(BvhNode{});
+		m_nodes.push_back(BvhNode{});
+		m_nodes[nodeIdx].first = childIdx;
+		m_nodes[nodeIdx].count = 0u;
+
+		buildNode(childIdx + 0u, first, half, order, centroids);
+		buildNode(childIdx + 1u, first + half, count - half, order, centroids);
+	}
+
+	void Bvh::buildDipoles()
+	{
+		// children always follow their parent, so a reverse pass sees children first
+		for (NvFlowUint nodeIdx = NvFlowUint(m_nodes.size()); nodeIdx-- > 0u; )
+		{
+			BvhNode& node = m_nodes[nodeIdx];
+			if (node.count > 0u)
+			{
+				node.boundsMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+				node.boundsMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+				node.areaNormal = { 0.f, 0.f, 0.f };
+				NvFlowFloat3 centerSum = { 0.f, 0.f, 0.f };
+				float areaSum = 0.f;
+				for (NvFlowUint triIdx = node.first; triIdx < node.first + node.count; triIdx++)
+				{
+					NvFlowFloat3 a, b, c;
+					triangle(triIdx, &a, &b, &c);
+					node.boundsMin = min3(node.boundsMin, min3(a, min3(b, c)));
+					node.boundsMax = max3(node.boundsMax, max3(a, max3(b, c)));
+					NvFlowFloat3 n = cross(b - a, c - a) * 0.5f;
+					float area = length(n);
+					node.areaNormal = node.areaNormal + n;
+					centerSum = centerSum + (a + b + c) * (area / 3.f);
+					areaSum += area;
+				}
+				// a refit can collapse every triangle of a leaf
+				node.center = (areaSum > 0.f) ? centerSum * (1.f / areaSum) : (node.boundsMin + node.boundsMax) * 0.5f;
+				node.radius = 0.f;
+				for (NvFlowUint triIdx = node.first; triIdx < node.first + node.count; triIdx++)
+				{
+					NvFlowFloat3 a, b, c;
+					triangle(triIdx, &a, &b, &c);
+					node.radius = fmaxf(node.radius, fmaxf(length(a - node.center), fmaxf(length(b - node.center), length(c - node.center))));
+				}
+				continue;
+			}
+			if (node.first == 0u)
+			{
+				// empty mesh root
+				node.boundsMin = { 0.f, 0.f, 0.f };
+				node.boundsMax = { 0.f, 0.f, 0.f };
+				node.center = { 0.f, 0.f, 0.f };
+				node.radius = 0.f;
+				node.areaNormal = { 0.f, 0.f, 0.f };
+				continue;
+			}
+			const BvhNode& left = m_nodes[node.first + 0u];
+			const BvhNode& right = m_nodes[node.first + 1u];
+			node.boundsMin = min3(left.boundsMin, right.boundsMin);
+			node.boundsMax = max3(left.boundsMax, right.boundsMax);
+			node.areaNormal = left.areaNormal + right.areaNormal;
+			// bounding sphere of the child spheres about the box center
+			node.center = (node.boundsMin + node.boundsMax) * 0.5f;
+			node.radius = fmaxf(length(left.center - node.center) + left.radius, length(right.center - node.center) + right.radius);
+		}
+	}
+
+	float Bvh::distance(const NvFlowFloat3& p, NvFlowFloat3* closest) const
+	{
+		float best2 = FLT_MAX;
+		NvFlowUint stack[64u];
+		NvFlowUint stackSize = 0u;
+		stack[stackSize++] = 0u;
+		while (stackSize > 0u)
+		{
+			const BvhNode& node = m_nodes[stack[--stackSize]];
+			if (boxDistance2(p, node.boundsMin, node.boundsMax) >= best2)
+			{
+				continue;
+			}
+			if (node.count > 0u)
+			{
+				for (NvFlowUint triIdx = node.first; triIdx < node.first + node.count; triIdx++)
+				{
+					NvFlowFloat3 a, b, c;
+					triangle(triIdx, &a, &b, &c);
+					NvFlowFloat3 q = closestPointTriangle(p, a, b, c);
+					NvFlowFloat3 d = q - p;
+					float dist2 = dot(d, d);
+					if (dist2 < best2)
+					{
+						best2 = dist2;
+						if (closest) *closest = q;
+					}
+				}
+				continue;
+			}
+			// visit the nearer child first
+			NvFlowUint near = node.first + 0u;
+			NvFlowUint far = node.first + 1u;
+			if (boxDistance2(p, m_nodes[far].boundsMin, m_nodes[far].boundsMax) < boxDistance2(p, m_nodes[near].boundsMin, m_nodes[near].boundsMax))
+			{
+				std::swap(near, far);
+			}
+			stack[stackSize++] = far;
+			stack[stackSize++] = near;
+		}
+		return sqrtf(best2);
+	}
+
+	float Bvh::winding(const NvFlowFloat3& p) const
+	{
+		const float inv4Pi = 0.25f / 3.14159265358979f;
+		float sum = 0.f;
+		NvFlowUint stack[64u];
+		NvFlowUint stackSize = 0u;
+		stack[stackSize++] = 0u;
+		while (stackSize > 0u)
+		{
+			const BvhNode& node = m_nodes[stack[--stackSize]];
+			if (node.count > 0u)
+			{
+				for (NvFlowUint triIdx = node.first; triIdx < node.first + node.count; triIdx++)
+				{
+					NvFlowFloat3 a, b, c;
+					triangle(triIdx, &a, &b, &c);
+					sum += solidAngle(p, a, b, c);
+				}
+				continue;
+			}
+			NvFlowFloat3 r = node.center - p;
+			float dist = length(r);
+			if (dist > windingFarScale * node.radius)
+			{
+				// far field, the node acts as a dipole
+				sum += dot(node.areaNormal, r) / (dist * dist * dist);
+				continue;
+			}
+			if (node.first != 0u)
+			{
+				stack[stackSize++] = node.first + 0u;
+				stack[stackSize++] = node.first + 1u;
+			}
+		}
+		return sum * inv4Pi;
+	}
+
+	//! 1 for counter clockwise triangles seen from outside, -1 if the mesh encloses negative volume
+	float Bvh::orientation() const
+	{
+		float volume = 0.f;
+		for (NvFlowUint triIdx = 0u; triIdx < numTriangles(); triIdx++)
+		{
+			NvFlowFloat3 a, b, c;
+			triangle(triIdx, &a, &b, &c);
+			volume += dot(a, cross(b, c));
+		}
+		return volume < 0.f ? -1.f : 1.f;
+	}
+
+	// ****************** Fast Sweeping ************************
+
+	static const NvFlowUint sweepGrainSize = 4u;	// fewest slices of a sweep plane per task
+
+	struct SdfBakeGrid
+	{
+		NvFlowDim m_dim;
+		float m_h[3];
+		std::vector<float> m_dist;
+		std::vector<signed char> m_sign;		// 0 until the cell is reached
+		std::vector<unsigned char> m_fixed;
+
+		NvFlowUint idx(NvFlowUint i, NvFlowUint j, NvFlowUint k) const
+		{
+			return (k * m_dim.y + j) * m_dim.x + i;
+		}
+
+		NvFlowFloat3 cellCenter(NvFlowUint i, NvFlowUint j, NvFlowUint k) const
+		{
+			return {
+				2.f * (float(i) + 0.5f) / float(m_dim.x) - 1.f,
+				2.f * (float(j) + 0.5f) / float(m_dim.y) - 1.f,
+				2.f * (float(k) + 0.5f) / float(m_dim.z) - 1.f
+			};
+		}
+
+		void update(NvFlowUint i, NvFlowUint j, NvFlowUint k);
+		void sweep(const TaskDispatchInterface* taskDispatch, int sx, int sy, int sz);
+	};
+
+	void SdfBakeGrid::update(NvFlowUint i, NvFlowUint j, NvFlowUint k)
+	{
+		NvFlowUint cellIdx = idx(i, j, k);
+		if (m_fixed[cellIdx])
+		{
+			return;
+		}
+
+		// smallest neighbor per axis
+		const NvFlowUint coord[3] = { i, j, k };
+		const NvFlowUint dim[3] = { m_dim.x, m_dim.y, m_dim.z };
+		const NvFlowUint stride[3] = { 1u, m_dim.x, m_dim.x * m_dim.y };
+		float a[3];
+		float h[3];
+		NvFlowUint numAxes = 0u;
+		float bestNeighbor = FLT_MAX;
+		signed char sign = 0;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float v = FLT_MAX;
+			NvFlowUint vIdx = ~0u;
+			if (coord[axis] > 0u && m_dist[cellIdx - stride[axis]] < v)
+			{
+				vIdx = cellIdx - stride[axis];
+				v = m_dist[vIdx];
+			}
+			if (coord[axis] + 1u < dim[axis] && m_dist[cellIdx + stride[axis]] < v)
+			{
+				vIdx = cellIdx + stride[axis];
+				v = m_dist[vIdx];
+			}
+			if (v < FLT_MAX)
+			{
+				a[numAxes] = v;
+				h[numAxes] = m_h[axis];
+				numAxes++;
+				if (v < bestNeighbor)
+				{
+					bestNeighbor = v;
+					sign = m_sign[vIdx];
+				}
+			}
+		}
+		if (numAxes == 0u)
+		{
+			return;
+		}
+
+		// sort axes by neighbor value
+		for (NvFlowUint x = 1u; x < numAxes; x++)
+		{
+			for (NvFlowUint y = x; y > 0u && a[y] < a[y - 1u]; y--)
+			{
+				std::swap(a[y], a[y - 1u]);
+				std::swap(h[y], h[y - 1u]);
+			}
+		}
+
+		// solve sum((u - a_n) / h_n)^2 = 1, adding axes while they are upwind of u
+		float u = a[0] + h[0];
+		float sumW = 0.f, sumWA = 0.f, sumWA2 = 0.f;
+		for (NvFlowUint n = 0u; n < numAxes && u > a[n]; n++)
+		{
+			float w = 1.f / (h[n] * h[n]);
+			sumW += w;
+			sumWA += w * a[n];
+			sumWA2 += w * a[n] * a[n];
+			float disc = sumWA * sumWA - sumW * (sumWA2 - 1.f);
+			if (disc < 0.f)
+			{
+				break;
+			}
+			u = (sumWA + sqrtf(disc)) / sumW;
+		}
+
+		if (u < m_dist[cellIdx])
+		{
+			m_dist[cellIdx] = u;
+			m_sign[cellIdx] = sign;
+		}
+	}
+
+	void SdfBakeGrid::sweep(const TaskDispatchInterface* taskDispatch, int sx, int sy, int sz)
+	{
+		// cells on a plane i + j + k = level only read the planes before and after, so each plane runs in parallel
+		const int nx = int(m_dim.x), ny = int(m_dim.y), nz = int(m_dim.z);
+		const int numLevels = nx + ny + nz - 2;
+		for (int level = 0; level < numLevels; level++)
+		{
+			int kBegin = std::max(0, level - (nx - 1) - (ny - 1));
+			int kEnd = std::min(nz - 1, level) + 1;
+			TaskDispatchRange(taskDispatch, NvFlowUint(kEnd - kBegin), sweepGrainSize, [&](NvFlowUint begin, NvFlowUint end)
+			{
+				for (int kk = kBegin + int(begin); kk < kBegin + int(end); kk++)
+				{
+					int jBegin = std::max(0, level - kk - (nx - 1));
+					int jEnd = std::min(ny - 1, level - kk);
+					for (int jj = jBegin; jj <= jEnd; jj++)
+					{
+						int ii = level - kk - jj;
+						NvFlowUint i = NvFlowUint(sx > 0 ? ii : nx - 1 - ii);
+						NvFlowUint j = NvFlowUint(sy > 0 ? jj : ny - 1 - jj);
+						NvFlowUint k = NvFlowUint(sz > 0 ? kk : nz - 1 - kk);
+						update(i, j, k);
+					}
+				}
+			});
+		}
+	}
+
+	// ****************** Distance Transform ************************
+
+	static const NvFlowUint edtGrainSize = 16u;	// fewest lines per task
+
+	//! Squared distance transform of one line, Felzenszwalb and Huttenlocher, cells h apart, FLT_MAX for no feature
+	//! nearest receives the line position each distance came from, ~0u for no feature
+	void edtLine(const float* f, float* d, NvFlowUint* nearest, NvFlowUint n, float h, std::vector<NvFlowUint>& v, std::vector<float>& z)
+	{
+		v.resize(n);
+		z.resize(n + 1u);
+
+		// lower envelope of the parabolas of cells holding a finite value
+		int k = -1;
+		for (NvFlowUint q = 0u; q < n; q++)
+		{
+			if (f[q] == FLT_MAX)
+			{
+				continue;
+			}
+			const float fq = f[q] + (float(q) * h) * (float(q) * h);
+			float s = -FLT_MAX;
+			while (k >= 0)
+			{
+				const float p = float(v[k]) * h;
+				s = (fq - (f[v[k]] + p * p)) / (2.f * (float(q) * h - p));
+				if (s > z[k])
+				{
+					break;
+				}
+				k--;
+			}
+			k++;
+			v[k] = q;
+			z[k] = (k == 0) ? -FLT_MAX : s;
+			z[k + 1] = FLT_MAX;
+		}
+
+		if (k < 0)
+		{
+			for (NvFlowUint q = 0u; q < n; q++)
+			{
+				d[q] = FLT_MAX;
+				nearest[q] = ~0u;
+			}
+			return;
+		}
+		int j = 0;
+		for (NvFlowUint q = 0u; q < n; q++)
+		{
+			const float x = float(q) * h;
+			while (z[j + 1] < x)
+			{
+				j++;
+			}
+			const float dx = x - float(v[j]) * h;
+			d[q] = dx * dx + f[v[j]];
+			nearest[q] = v[j];
+		}
+	}
+
+	//! Squared distance to the nearest cell with feature set, in place, each axis pass over lines as tasks
+	//! feature holds the index of that cell, starts as the cell itself on features, ~0u elsewhere
+	void edt(const TaskDispatchInterface* taskDispatch, std::vector<float>& dist2, std::vector<NvFlowUint>& feature, const NvFlowDim& dim, const float* h)
+	{
+		const NvFlowUint dims[3] = { dim.x, dim.y, dim.z };
+		const NvFlowUint strides[3] = { 1u, dim.x, dim.x * dim.y };
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const NvFlowUint n = dims[axis];
+			if (n <= 1u)
+			{
+				continue;
+			}
+			// lines run along axis, indexed by the other two coordinates
+			const int axisA = (axis == 0) ? 1 : 0;
+			const int axisB = (axis == 2) ? 1 : 2;
+			const NvFlowUint numLines = dims[axisA] * dims[axisB];
+			TaskDispatchRange(taskDispatch, numLines, edtGrainSize, [&](NvFlowUint begin, NvFlowUint end)
+			{
+				std::vector<float> f(n);
+				std::vector<float> d(n);
+				std::vector<NvFlowUint> lineFeature(n);
+				std::vector<NvFlowUint> nearest(n);
+				std::vector<NvFlowUint> v;
+				std::vector<float> z;
+				for (NvFlowUint lineIdx = begin; lineIdx < end; lineIdx++)
+				{
+					const NvFlowUint a = lineIdx % dims[axisA];
+					const NvFlowUint b = lineIdx / dims[axisA];
+					const NvFlowUint base = a * strides[axisA] + b * strides[axisB];
+					for (NvFlowUint q = 0u; q < n; q++)
+					{
+						f[q] = dist2[base + q * strides[axis]];
+						lineFeature[q] = feature[base + q * strides[axis]];
+					}
+					edtLine(f.data(), d.data(), nearest.data(), n, h[axis], v, z);
+					for (NvFlowUint q = 0u; q < n; q++)
+					{
+						dist2[base + q * strides[axis]] = d[q];
+						feature[base + q * strides[axis]] = (nearest[q] != ~0u) ? lineFeature[nearest[q]] : ~0u;
+					}
+				}
+			});
+		}
+	}
+}
+
+void SdfBakeParamsDefaults(SdfBakeParams* params)
+{
+	params->narrowBandCells = 2.f;
+	params->windingThreshold = 0.5f;
+	params->taskDispatch = nullptr;
+}
+
+bool SdfBakeMesh(const NvFlowSDFGenMeshParams* mesh, const SdfBakeParams* params, const NvFlowShapeSDFData* sdf)
+{
+	if (sdf->data == nullptr || sdf->dim.x == 0u || sdf->dim.y == 0u || sdf->dim.z == 0u ||
+		mesh->positions == nullptr || mesh->indices == nullptr)
+	{
+		return false;
+	}
+
+	Bvh bvh;
+	bvh.build(mesh);
+	if (bvh.numTriangles() == 0u)
+	{
+		return false;
+	}
+
+	SdfBakeGrid grid;
+	grid.m_dim = sdf->dim;
+	grid.m_h[0] = 2.f / float(sdf->dim.x);
+	grid.m_h[1] = 2.f / float(sdf->dim.y);
+	grid.m_h[2] = 2.f / float(sdf->dim.z);
+	const NvFlowUint numCells = sdf->dim.x * sdf->dim.y * sdf->dim.z;
+	grid.m_dist.assign(numCells, FLT_MAX);
+	grid.m_sign.assign(numCells, 0);
+	grid.m_fixed.assign(numCells, 0u);
+
+	// mark the band around each triangle
+	const float band = params->narrowBandCells * std::max(grid.m_h[0], std::max(grid.m_h[1], grid.m_h[2]));
+	const NvFlowUint dim[3] = { sdf->dim.x, sdf->dim.y, sdf->dim.z };
+	for (NvFlowUint triIdx = 0u; triIdx < bvh.numTriangles(); triIdx++)
+	{
+		NvFlowFloat3 a, b, c;
+		bvh.triangle(triIdx, &a, &b, &c);
+		NvFlowFloat3 triMin = min3(a, min3(b, c));
+		NvFlowFloat3 triMax = max3(a, max3(b, c));
+		int cmin[3], cmax[3];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			// cell centers sit at 2 * (i + 0.5) / dim - 1
+			float scale = 0.5f * float(dim[axis]);
+			cmin[axis] = std::max(int(ceilf(((&triMin.x)[axis] - band + 1.f) * scale - 0.5f)), 0);
+			cmax[axis] = std::min(int(floorf(((&triMax.x)[axis] + band + 1.f) * scale - 0.5f)), int(dim[axis]) - 1);
+		}
+		for (int k = cmin[2]; k <= cmax[2]; k++)
+		{
+			for (int j = cmin[1]; j <= cmax[1]; j++)
+			{
+				for (int i = cmin[0]; i <= cmax[0]; i++)
+				{
+					grid.m_fixed[grid.idx(i, j, k)] = 1u;
+				}
+			}
+		}
+	}
+
+	std::vector<NvFlowUint> bandCells;
+	for (NvFlowUint cellIdx = 0u; cellIdx < numCells; cellIdx++)
+	{
+		if (grid.m_fixed[cellIdx])
+		{
+			bandCells.push_back(cellIdx);
+		}
+	}
+	// a mesh outside the volume leaves no band, every cell is computed exactly then
+	if (bandCells.empty())
+	{
+		grid.m_fixed.assign(numCells, 1u);
+		bandCells.resize(numCells);
+		for (NvFlowUint cellIdx = 0u; cellIdx < numCells; cellIdx++)
+		{
+			bandCells[cellIdx] = cellIdx;
+		}
+	}
+
+	// exact distance and winding number sign in the band
+	TaskDispatchRange(params->taskDispatch, NvFlowUint(bandCells.size()), 64u, [&](NvFlowUint begin, NvFlowUint end)
+	{
+		for (NvFlowUint bandIdx = begin; bandIdx < end; bandIdx++)
+		{
+			NvFlowUint cellIdx = bandCells[bandIdx];
+			NvFlowUint i = cellIdx % sdf->dim.x;
+			NvFlowUint j = (cellIdx / sdf->dim.x) % sdf->dim.y;
+			NvFlowUint k = cellIdx / (sdf->dim.x * sdf->dim.y);
+			NvFlowFloat3 p = grid.cellCenter(i, j, k);
+			grid.m_dist[cellIdx] = bvh.distance(p);
+			grid.m_sign[cellIdx] = (fabsf(bvh.winding(p)) > params->windingThreshold) ? -1 : 1;
+		}
+	});
+
+	// far field, one sweep per octant direction
+	if (bandCells.size() < numCells)
+	{
+		for (int octant = 0; octant < 8; octant++)
+		{
+			grid.sweep(params->taskDispatch, (octant & 1) ? -1 : 1, (octant & 2) ? -1 : 1, (octant & 4) ? -1 : 1);
+		}
+	}
+
+	// the winding number magnitude finds the enclosed cells, the orientation says which side is inside
+	const float orientation = bvh.orientation();
+
+	TaskDispatchRange(params->taskDispatch, sdf->dim.z, 1u, [&](NvFlowUint begin, NvFlowUint end)
+	{
+		for (NvFlowUint k = begin; k < end; k++)
+		{
+			for (NvFlowUint j = 0u; j < sdf->dim.y; j++)
+			{
+				float* dst = sdf->data + k * sdf->depthPitch + j * sdf->rowPitch;
+				for (NvFlowUint i = 0u; i < sdf->dim.x; i++)
+				{
+					NvFlowUint cellIdx = grid.idx(i, j, k);
+					dst[i] = orientation * ((grid.m_sign[cellIdx] < 0) ? -grid.m_dist[cellIdx] : grid.m_dist[cellIdx]);
+				}
+			}
+		}
+	});
+
+	return true;
+}
+
+bool SdfBakeFromMask(const SdfBakeMask* mask, const SdfBakeParams* params, const NvFlowShapeSDFData* sdf)
+{
+	if (sdf->data == nullptr || mask->data == nullptr ||
+		mask->dim.x != sdf->dim.x || mask->dim.y != sdf->dim.y || mask->dim.z != sdf->dim.z ||
+		(mask->bitsPerValue != 1u && mask->bitsPerValue != 8u))
+	{
+		return false;
+	}
+
+	const NvFlowDim dim = sdf->dim;
+	const NvFlowUint numCells = dim.x * dim.y * dim.z;
+	const float h[3] = { 2.f / float(dim.x), 2.f / float(dim.y), 2.f / float(dim.z) };
+
+	// distances to inside cells and to outside cells, and which cell is nearest
+	std::vector<float> toInside(numCells);
+	std::vector<float> toOutside(numCells);
+	std::vector<NvFlowUint> nearestInside(numCells);
+	std::vector<NvFlowUint> nearestOutside(numCells);
+	for (NvFlowUint k = 0u; k < dim.z; k++)
+	{
+		for (NvFlowUint j = 0u; j < dim.y; j++)
+		{
+			const unsigned char* row = mask->data + size_t(k) * mask->depthPitch + size_t(j) * mask->rowPitch;
+			for (NvFlowUint i = 0u; i < dim.x; i++)
+			{
+				bool inside = (mask->bitsPerValue == 1u) ? (row[i >> 3u] & (128u >> (i & 7u))) != 0u : row[i] != 0u;
+				NvFlowUint cellIdx = (k * dim.y + j) * dim.x + i;
+				toInside[cellIdx] = inside ? 0.f : FLT_MAX;
+				toOutside[cellIdx] = inside ? FLT_MAX : 0.f;
+				nearestInside[cellIdx] = inside ? cellIdx : ~0u;
+				nearestOutside[cellIdx] = inside ? ~0u : cellIdx;
+			}
+		}
+	}
+
+	edt(params->taskDispatch, toInside, nearestInside, dim, h);
+	edt(params->taskDispatch, toOutside, nearestOutside, dim, h);
+
+	// the surface is half a cell short of the nearest opposite cell, along the axis it mostly lies on,
+	// so anisotropic cells offset by their own spacing
+	auto halfCell = [&](NvFlowUint i, NvFlowUint j, NvFlowUint k, NvFlowUint nearestIdx)
+	{
+		const float dx = fabsf(float(int(nearestIdx % dim.x) - int(i))) * h[0];
+		const float dy = fabsf(float(int((nearestIdx / dim.x) % dim.y) - int(j))) * h[1];
+		const float dz = fabsf(float(int(nearestIdx / (dim.x * dim.y)) - int(k))) * h[2];
+		const int axis = (dx >= dy && dx >= dz) ? 0 : (dy >= dz ? 1 : 2);
+		return 0.5f * h[axis];
+	};
+
+	// an all inside or all outside mask has no surface, clamp to the NDC diagonal
+	const float maxDist = 2.f * sqrtf(3.f);
+	TaskDispatchRange(params->taskDispatch, dim.z * dim.y, edtGrainSize, [&](NvFlowUint begin, NvFlowUint end)
+	{
+		for (NvFlowUint lineIdx = begin; lineIdx < end; lineIdx++)
+		{
+			const NvFlowUint j = lineIdx % dim.y;
+			const NvFlowUint k = lineIdx / dim.y;
+			float* dst = sdf->data + k * sdf->depthPitch + j * sdf->rowPitch;
+			for (NvFlowUint i = 0u; i < dim.x; i++)
+			{
+				NvFlowUint cellIdx = (k * dim.y + j) * dim.x + i;
+				float value;
+				if (toInside[cellIdx] > 0.f)
+				{
+					value = (toInside[cellIdx] == FLT_MAX) ? maxDist : sqrtf(toInside[cellIdx]) - halfCell(i, j, k, nearestInside[cellIdx]);
+				}
+				else
+				{
+					value = (toOutside[cellIdx] == FLT_MAX) ? -maxDist : halfCell(i, j, k, nearestOutside[cellIdx]) - sqrtf(toOutside[cellIdx]);
+				}
+				dst[i] = value;
+			}
+		}
+	});
+
+	return true;
+}
+
+/// ****************** SDF Deformer *******************************
+
+namespace
+{
+	enum SdfBrickClass
+	{
+		eSdfBrickFine = 0,
+		eSdfBrickCoarse = 1,
+		eSdfBrickConstant = 2
+	};
+}
+
+struct SdfDeformer
+{
+	SdfDeformerDesc m_desc = {};
+	float m_h[3] = {};
+	float m_tolerance = 0.f;
+	float m_maxDist = 0.f;
+	float m_band = 0.f;
+
+	NvFlowFloat4x4 m_modelMatrix = {};
+	std::vector<NvFlowFloat3> m_restPositions;
+	std::vector<NvFlowUint> m_indices;
+	std::vector<NvFlowUint> m_boneIndices;
+	std::vector<float> m_boneWeights;
+	std::vector<NvFlowFloat3> m_deltas;
+	std::vector<NvFlowFloat4x4> m_bones;
+
+	Bvh m_bvh;									// holds the current pose
+	std::vector<NvFlowFloat3> m_bakedPositions;	// pose of each vertex when its bricks were last refreshed
+	std::vector<unsigned char> m_moved;
+
+	NvFlowDim m_brickGridDim = {};
+	std::vector<unsigned char> m_brickDirty;
+	std::vector<NvFlowUint> m_dirtyBricks;
+	std::vector<unsigned char> m_brickClass;
+	std::vector<float> m_field;					// signed as for counter clockwise triangles
+	float m_orientation = 1.f;					// of the rest pose, applied on copy
+	bool m_needsFullBake = true;
+
+	SdfDeformerStats m_stats = {};
+
+	void pose(std::vector<NvFlowFloat3>& positions) const;
+	void markBricks(NvFlowFloat3 boundsMin, NvFlowFloat3 boundsMax);
+	void refreshBrick(NvFlowUint brickIdx);
+	int refreshBlock(const NvFlowUint c0[3], const NvFlowUint c1[3], float sign);
+	void splitBlock(const NvFlowUint c0[3], const NvFlowUint c1[3], float sign);
+
+	NvFlowUint idx(NvFlowUint i, NvFlowUint j, NvFlowUint k) const
+	{
+		return (k * m_desc.dim.y + j) * m_desc.dim.x + i;
+	}
+
+	NvFlowFloat3 cellCenter(NvFlowUint i, NvFlowUint j, NvFlowUint k) const
+	{
+		return {
+			2.f * (float(i) + 0.5f) / float(m_desc.dim.x) - 1.f,
+			2.f * (float(j) + 0.5f) / float(m_desc.dim.y) - 1.f,
+			2.f * (float(k) + 0.5f) / float(m_desc.dim.z) - 1.f
+		};
+	}
+};
+
+void SdfDeformer::pose(std::vector<NvFlowFloat3>& positions) const
+{
+	const NvFlowUint numVertices = NvFlowUint(m_restPositions.size());
+	const NvFlowUint numBones = NvFlowUint(m_bones.size());
+	const bool skinned = numBones > 0u && !m_boneIndices.empty();
+	positions.resize(numVertices);
+	TaskDispatchRange(m_desc.bakeParams.taskDispatch, numVertices, 256u, [&](NvFlowUint begin, NvFlowUint end)
+	{
+		for (NvFlowUint vertexIdx = begin; vertexIdx < end; vertexIdx++)
+		{
+			NvFlowFloat3 p = m_restPositions[vertexIdx];
+			if (!m_deltas.empty())
+			{
+				p = p + m_deltas[vertexIdx];
+			}
+			if (skinned)
+			{
+				NvFlowFloat3 sum = { 0.f, 0.f, 0.f };
+				float weightSum = 0.f;
+				for (NvFlowUint influenceIdx = 0u; influenceIdx < 4u; influenceIdx++)
+				{
+					NvFlowUint boneIdx = m_boneIndices[4u * vertexIdx + influenceIdx];
+					float weight = m_boneWeights[4u * vertexIdx + influenceIdx];
+					if (boneIdx < numBones && weight != 0.f)
+					{
+						sum = sum + transformPoint(m_bones[boneIdx], p) * weight;
+						weightSum += weight;
+					}
+				}
+				if (weightSum > 0.f)
+				{
+					p = sum * (1.f / weightSum);
+				}
+			}
+			positions[vertexIdx] = transformPoint(m_modelMatrix, p);
+		}
+	});
+}
+
+void SdfDeformer::markBricks(NvFlowFloat3 boundsMin, NvFlowFloat3 boundsMax)
+{
+	const NvFlowUint dim[3] = { m_desc.dim.x, m_desc.dim.y, m_desc.dim.z };
+	const NvFlowUint brickGridDim[3] = { m_brickGridDim.x, m_brickGridDim.y, m_brickGridDim.z };
+	int bmin[3], bmax[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		// cell range of the box, then the bricks holding it
+		float scale = 0.5f * float(dim[axis]);
+		int cmin = std::max(int(ceilf(((&boundsMin.x)[axis] + 1.f) * scale - 0.5f)), 0);
+		int cmax = std::min(int(floorf(((&boundsMax.x)[axis] + 1.f) * scale - 0.5f)), int(dim[axis]) - 1);
+		if (cmin > cmax)
+		{
+			return;
+		}
+		bmin[axis] = cmin / int(m_desc.brickDim);
+		bmax[axis] = std::min(cmax / int(m_desc.brickDim), int(brickGridDim[axis]) - 1);
+	}
+	for (int bk = bmin[2]; bk <= bmax[2]; bk++)
+	{
+		for (int bj = bmin[1]; bj <= bmax[1]; bj++)
+		{
+			for (int bi = bmin[0]; bi <= bmax[0]; bi++)
+			{
+				NvFlowUint brickIdx = (bk * m_brickGridDim.y + bj) * m_brickGridDim.x + bi;
+				if (!m_brickDirty[brickIdx])
+				{
+					m_brickDirty[brickIdx] = 1u;
+					m_dirtyBricks.push_back(brickIdx);
+				}
+			}
+		}
+	}
+}
+
+void SdfDeformer::refreshBrick(NvFlowUint brickIdx)
+{
+	const NvFlowUint bi = brickIdx % m_brickGridDim.x;
+	const NvFlowUint bj = (brickIdx / m_brickGridDim.x) % m_brickGridDim.y;
+	const NvFlowUint bk = brickIdx / (m_brickGridDim.x * m_brickGridDim.y);
+	const NvFlowUint c0[3] = { bi * m_desc.brickDim, bj * m_desc.brickDim, bk * m_desc.brickDim };
+	const NvFlowUint c1[3] = {
+		std::min(c0[0] + m_desc.brickDim, m_desc.dim.x) - 1u,
+		std::min(c0[1] + m_desc.brickDim, m_desc.dim.y) - 1u,
+		std::min(c0[2] + m_desc.brickDim, m_desc.dim.z) - 1u
+	};
+	m_brickClass[brickIdx] = (unsigned char)refreshBlock(c0, c1, 0.f);
+}
+
+//! Refresh the octants of cells c0 to c1 inclusive one by one
+void SdfDeformer::splitBlock(const NvFlowUint c0[3], const NvFlowUint c1[3], float sign)
+{
+	for (NvFlowUint octant = 0u; octant < 8u; octant++)
+	{
+		NvFlowUint s0[3], s1[3];
+		bool empty = false;
+		for (NvFlowUint axis = 0u; axis < 3u; axis++)
+		{
+			NvFlowUint mid = (c0[axis] + c1[axis]) / 2u;
+			bool upper = (octant & (1u << axis)) != 0u;
+			s0[axis] = upper ? mid + 1u : c0[axis];
+			s1[axis] = upper ? c1[axis] : mid;
+			// a single cell axis has no upper half
+			empty = empty || s0[axis] > s1[axis];
+		}
+		if (!empty)
+		{
+			refreshBlock(s0, s1, sign);
+		}
+	}
+}
+
+//! Refresh cells c0 to c1 inclusive, sign is +-1 when known for the whole block, 0 otherwise
+int SdfDeformer::refreshBlock(const NvFlowUint c0[3], const NvFlowUint c1[3], float sign)
+{
+	const float windingThreshold = m_desc.bakeParams.windingThreshold;
+
+	if (c0[0] == c1[0] && c0[1] == c1[1] && c0[2] == c1[2])
+	{
+		NvFlowFloat3 p = cellCenter(c0[0], c0[1], c0[2]);
+		if (sign == 0.f)
+		{
+			sign = (fabsf(m_bvh.winding(p)) > windingThreshold) ? -1.f : 1.f;
+		}
+		m_field[idx(c0[0], c0[1], c0[2])] = sign * fminf(m_bvh.distance(p), m_maxDist);
+		return eSdfBrickFine;
+	}
+
+	// the block center decides if the block is coarse or splits toward the surface
+	NvFlowFloat3 lo = cellCenter(c0[0], c0[1], c0[2]);
+	NvFlowFloat3 hi = cellCenter(c1[0], c1[1], c1[2]);
+	NvFlowFloat3 center = (lo + hi) * 0.5f;
+	float halfDiag = 0.5f * length(hi - lo);
+	float centerDist = m_bvh.distance(center);
+
+	// no surface in the block, one sign for every cell
+	if (sign == 0.f && centerDist > halfDiag)
+	{
+		sign = (fabsf(m_bvh.winding(center)) > windingThreshold) ? -1.f : 1.f;
+	}
+
+	if (centerDist - halfDiag <= m_band)
+	{
+		splitBlock(c0, c1, sign);
+		return eSdfBrickFine;
+	}
+
+	if (centerDist - halfDiag >= m_maxDist)
+	{
+		for (NvFlowUint k = c0[2]; k <= c1[2]; k++)
+		{
+			for (NvFlowUint j = c0[1]; j <= c1[1]; j++)
+			{
+				for (NvFlowUint i = c0[0]; i <= c1[0]; i++)
+				{
+					m_field[idx(i, j, k)] = sign * m_maxDist;
+				}
+			}
+		}
+		return eSdfBrickConstant;
+	}
+
+	// trilinear fill from the corners, if its error bound is within the tolerance.
+	// The distance has curvature at most 1/dMin past dMin from the surface, which bounds the
+	// overestimate, and the spread of the corner gradients bounds how far a ridge of the distance
+	// between the corners rises above the fill. Blocks that miss the bound split toward cells.
+	const float dMin = centerDist - halfDiag;
+	const float curvatureBound = 0.5f * halfDiag * halfDiag / dMin;
+	if (curvatureBound > m_tolerance)
+	{
+		splitBlock(c0, c1, sign);
+		return eSdfBrickFine;
+	}
+
+	float corner[8];
+	NvFlowFloat3 gradient[8];
+	NvFlowFloat3 gradientMean = { 0.f, 0.f, 0.f };
+	for (NvFlowUint cornerIdx = 0u; cornerIdx < 8u; cornerIdx++)
+	{
+		NvFlowFloat3 p = cellCenter(
+			(cornerIdx & 1u) ? c1[0] : c0[0],
+			(cornerIdx & 2u) ? c1[1] : c0[1],
+			(cornerIdx & 4u) ? c1[2] : c0[2]);
+		NvFlowFloat3 closest = p;
+		corner[cornerIdx] = m_bvh.distance(p, &closest);
+		gradient[cornerIdx] = (p - closest) * (1.f / corner[cornerIdx]);
+		gradientMean = gradientMean + gradient[cornerIdx] * 0.125f;
+	}
+	float gradientSpread = 0.f;
+	for (NvFlowUint cornerIdx = 0u; cornerIdx < 8u; cornerIdx++)
+	{
+		gradientSpread = fmaxf(gradientSpread, length(gradient[cornerIdx] - gradientMean));
+	}
+	if (curvatureBound + halfDiag * gradientSpread > m_tolerance)
+	{
+		splitBlock(c0, c1, sign);
+		return eSdfBrickFine;
+	}
+
+	const float invSpan[3] = {
+		(c1[0] > c0[0]) ? 1.f / float(c1[0] - c0[0]) : 0.f,
+		(c1[1] > c0[1]) ? 1.f / float(c1[1] - c0[1]) : 0.f,
+		(c1[2] > c0[2]) ? 1.f / float(c1[2] - c0[2]) : 0.f
+	};
+	for (NvFlowUint k = c0[2]; k <= c1[2]; k++)
+	{
+		float tz = float(k - c0[2]) * invSpan[2];
+		for (NvFlowUint j = c0[1]; j <= c1[1]; j++)
+		{
+			float ty = float(j - c0[1]) * invSpan[1];
+			for (NvFlowUint i = c0[0]; i <= c1[0]; i++)
+			{
+				float tx = float(i - c0[0]) * invSpan[0];
+				float d00 = corner[0] + (corner[1] - corner[0]) * tx;
+				float d10 = corner[2] + (corner[3] - corner[2]) * tx;
+				float d01 = corner[4] + (corner[5] - corner[4]) * tx;
+				float d11 = corner[6] + (corner[7] - corner[6]) * tx;
+				float d0 = d00 + (d10 - d00) * ty;
+				float d1 = d01 + (d11 - d01) * ty;
+				m_field[idx(i, j, k)] = sign * fminf(d0 + (d1 - d0) * tz, m_maxDist);
+			}
+		}
+	}
+	return eSdfBrickCoarse;
+}
+
+void SdfDeformerDescDefaults(SdfDeformerDesc* desc)
+{
+	desc->dim = { 128u, 128u, 128u };
+	desc->brickDim = 8u;
+	desc->toleranceCells = 0.25f;
+	desc->maxDistanceCells = 8.f;
+	SdfBakeParamsDefaults(&desc->bakeParams);
+}
+
+SdfDeformer* SdfDeformerCreate(const SdfDeformerDesc* desc, const NvFlowSDFGenMeshParams* mesh, const SdfDeformerSkin* skin)
+{
+	if (mesh->positions == nullptr || mesh->indices == nullptr ||
+		desc->dim.x == 0u || desc->dim.y == 0u || desc->dim.z == 0u || desc->brickDim == 0u)
+	{
+		return nullptr;
+	}
+
+	auto ptr = new SdfDeformer();
+
+	ptr->m_desc = *desc;
+	ptr->m_h[0] = 2.f / float(desc->dim.x);
+	ptr->m_h[1] = 2.f / float(desc->dim.y);
+	ptr->m_h[2] = 2.f / float(desc->dim.z);
+	const float h = std::max(ptr->m_h[0], std::max(ptr->m_h[1], ptr->m_h[2]));
+	ptr->m_tolerance = desc->toleranceCells * h;
+	ptr->m_maxDist = std::max(desc->maxDistanceCells, desc->bakeParams.narrowBandCells) * h;
+	ptr->m_band = desc->bakeParams.narrowBandCells * h;
+
+	ptr->m_modelMatrix = mesh->modelMatrix;
+	ptr->m_restPositions.resize(mesh->numVertices);
+	const char* positionData = reinterpret_cast<const char*>(mesh->positions);
+	for (NvFlowUint vertexIdx = 0u; vertexIdx < mesh->numVertices; vertexIdx++)
+	{
+		const float* pos = reinterpret_cast<const float*>(positionData + size_t(vertexIdx) * mesh->positionStride);
+		ptr->m_restPositions[vertexIdx] = { pos[0], pos[1], pos[2] };
+	}
+	ptr->m_indices.assign(mesh->indices, mesh->indices + mesh->numIndices);
+	if (skin && skin->boneIndices && skin->boneWeights)
+	{
+		ptr->m_boneIndices.assign(skin->boneIndices, skin->boneIndices + 4u * mesh->numVertices);
+		ptr->m_boneWeights.assign(skin->boneWeights, skin->boneWeights + 4u * mesh->numVertices);
+	}
+
+	// the rest pose fixes the BVH topology, later poses only refit it
+	ptr->pose(ptr->m_bvh.m_positions);
+	ptr->m_bvh.build(ptr->m_indices.data(), NvFlowUint(ptr->m_indices.size()));
+	if (ptr->m_bvh.numTriangles() == 0u)
+	{
+		delete ptr;
+		return nullptr;
+	}
+	ptr->m_orientation = ptr->m_bvh.orientation();
+
+	ptr->m_brickGridDim = {
+		(desc->dim.x + desc->brickDim - 1u) / desc->brickDim,
+		(desc->dim.y + desc->brickDim - 1u) / desc->brickDim,
+		(desc->dim.z + desc->brickDim - 1u) / desc->brickDim
+	};
+	const NvFlowUint numBricks = ptr->m_brickGridDim.x * ptr->m_brickGridDim.y * ptr->m_brickGridDim.z;
+	ptr->m_brickDirty.assign(numBricks, 0u);
+	ptr->m_brickClass.assign(numBricks, eSdfBrickConstant);
+	ptr->m_field.assign(desc->dim.x * desc->dim.y * desc->dim.z, ptr->m_maxDist);
+	ptr->m_stats.numBricks = numBricks;
+
+	return ptr;
+}
+
+void SdfDeformerRelease(SdfDeformer* deformer)
+{
+	delete deformer;
+}
+
+void SdfDeformerSetDeltas(SdfDeformer* deformer, const NvFlowFloat3* deltas, NvFlowUint numDeltas)
+{
+	deformer->m_deltas.clear();
+	if (deltas && numDeltas > 0u)
+	{
+		deformer->m_deltas.resize(deformer->m_restPositions.size(), NvFlowFloat3{ 0.f, 0.f, 0.f });
+		std::copy(deltas, deltas + std::min(numDeltas, NvFlowUint(deformer->m_deltas.size())), deformer->m_deltas.begin());
+	}
+}
+
+void SdfDeformerSetBones(SdfDeformer* deformer, const NvFlowFloat4x4* bones, NvFlowUint numBones)
+{
+	deformer->m_bones.clear();
+	if (bones)
+	{
+		deformer->m_bones.assign(bones, bones + numBones);
+	}
+}
+
+NvFlowUint SdfDeformerUpdate(SdfDeformer* deformer)
+{
+	auto& d = *deformer;
+
+	std::vector<NvFlowFloat3>& positions = d.m_bvh.m_positions;
+	d.pose(positions);
+	const NvFlowUint numVertices = NvFlowUint(positions.size());
+
+	d.m_dirtyBricks.clear();
+	d.m_stats.numMovedVertices = 0u;
+	if (d.m_needsFullBake)
+	{
+		d.m_needsFullBake = false;
+		d.m_bakedPositions = positions;
+		d.m_brickDirty.assign(d.m_brickDirty.size(), 1u);
+		for (NvFlowUint brickIdx = 0u; brickIdx < NvFlowUint(d.m_brickDirty.size()); brickIdx++)
+		{
+			d.m_dirtyBricks.push_back(brickIdx);
+		}
+		d.m_stats.numMovedVertices = numVertices;
+	}
+	else
+	{
+		d.m_moved.assign(numVertices, 0u);
+		const float tolerance2 = d.m_tolerance * d.m_tolerance;
+		for (NvFlowUint vertexIdx = 0u; vertexIdx < numVertices; vertexIdx++)
+		{
+			NvFlowFloat3 delta = positions[vertexIdx] - d.m_bakedPositions[vertexIdx];
+			if (dot(delta, delta) > tolerance2)
+			{
+				d.m_moved[vertexIdx] = 1u;
+				d.m_stats.numMovedVertices++;
+			}
+		}
+
+		// a moved triangle changes the field within max distance of where it was and where it is,
+		// plus the tolerance its other vertices may have drifted since
+		const float reach = d.m_maxDist + d.m_tolerance;
+		const NvFlowFloat3 pad = { reach, reach, reach };
+		for (NvFlowUint idx = 0u; idx + 2u < NvFlowUint(d.m_indices.size()); idx += 3u)
+		{
+			NvFlowUint i0 = d.m_indices[idx + 0u];
+			NvFlowUint i1 = d.m_indices[idx + 1u];
+			NvFlowUint i2 = d.m_indices[idx + 2u];
+			if (i0 >= numVertices || i1 >= numVertices || i2 >= numVertices ||
+				!(d.m_moved[i0] || d.m_moved[i1] || d.m_moved[i2]))
+			{
+				continue;
+			}
+			NvFlowFloat3 boundsMin = min3(min3(d.m_bakedPositions[i0], min3(d.m_bakedPositions[i1], d.m_bakedPositions[i2])),
+				min3(positions[i0], min3(positions[i1], positions[i2])));
+			NvFlowFloat3 boundsMax = max3(max3(d.m_bakedPositions[i0], max3(d.m_bakedPositions[i1], d.m_bakedPositions[i2])),
+				max3(positions[i0], max3(positions[i1], positions[i2])));
+			d.markBricks(boundsMin - pad, boundsMax + pad);
+		}
+		for (NvFlowUint vertexIdx = 0u; vertexIdx < numVertices; vertexIdx++)
+		{
+			if (d.m_moved[vertexIdx])
+			{
+				d.m_bakedPositions[vertexIdx] = positions[vertexIdx];
+			}
+		}
+	}
+
+	d.m_stats.numRefreshed = NvFlowUint(d.m_dirtyBricks.size());
+	d.m_stats.numFine = 0u;
+	d.m_stats.numCoarse = 0u;
+	d.m_stats.numConstant = 0u;
+	if (d.m_dirtyBricks.empty())
+	{
+		return 0u;
+	}
+
+	d.m_bvh.refit();
+
+	TaskDispatchRange(d.m_desc.bakeParams.taskDispatch, NvFlowUint(d.m_dirtyBricks.size()), 1u, [&](NvFlowUint begin, NvFlowUint end)
+	{
+		for (NvFlowUint dirtyIdx = begin; dirtyIdx < end; dirtyIdx++)
+		{
+			d.refreshBrick(d.m_dirtyBricks[dirtyIdx]);
+		}
+	});
+
+	for (NvFlowUint brickIdx : d.m_dirtyBricks)
+	{
+		d.m_brickDirty[brickIdx] = 0u;
+		switch (d.m_brickClass[brickIdx])
+		{
+		case eSdfBrickFine: d.m_stats.numFine++; break;
+		case eSdfBrickCoarse: d.m_stats.numCoarse++; break;
+		default: d.m_stats.numConstant++; break;
+		}
+	}
+
+	return d.m_stats.numRefreshed;
+}
+
+bool SdfDeformerCopy(SdfDeformer* deformer, const NvFlowShapeSDFData* sdf)
+{
+	const NvFlowDim dim = deformer->m_desc.dim;
+	if (sdf->data == nullptr || sdf->dim.x != dim.x || sdf->dim.y != dim.y || sdf->dim.z != dim.z)
+	{
+		return false;
+	}
+	for (NvFlowUint k = 0u; k < dim.z; k++)
+	{
+		for (NvFlowUint j = 0u; j < dim.y; j++)
+		{
+			const float* src = deformer->m_field.data() + deformer->idx(0u, j, k);
+			float* dst = sdf->data + k * sdf->depthPitch + j * sdf->rowPitch;
+			for (NvFlowUint i = 0u; i < dim.x; i++)
+			{
+				dst[i] = deformer->m_orientation * src[i];
+			}
+		}
+	}
+	return true;
+}
+
+void SdfDeformerGetStats(SdfDeformer* deformer, SdfDeformerStats* stats)
+{
+	*stats = deformer->m_stats;
+}
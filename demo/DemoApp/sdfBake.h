@@ -0,0 +1,176 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "NvFlow.h"
+
+struct TaskDispatchInterface;
+
+/// ****************** SDF Bake Public *******************************
+
+// CPU mesh to signed distance field baker, an offline alternative to NvFlowSDFGen.
+//
+// Takes the same NvFlowSDFGenMeshParams, the view fields are ignored, and writes distances
+// in SDF NDC units, the convention of the procedural SDFs in the scenes. Cells within the
+// narrow band get exact distances from a triangle BVH and their sign from the generalized
+// winding number, so meshes with holes still bake. The signed volume of the mesh decides which
+// side is inside, reversed triangle winding turns the field inside out. Remaining cells are
+// filled by fast sweeping, plane by plane so each plane runs as tasks, and take their sign
+// from the band they were swept from.
+// Masks, images or voxels, bake with an exact Euclidean distance transform instead, see SdfBakeFromMask().
+// The destination is any NvFlowShapeSDFData, a mapped NvFlowShapeSDF or a CPU buffer with the
+// same layout, so bakes can be cached and uploaded later.
+
+struct SdfBakeParams
+{
+	float narrowBandCells;						//!< Cells around the surface with exact distances
+	float windingThreshold;						//!< Cells with an absolute winding number above this are enclosed
+	const TaskDispatchInterface* taskDispatch;	//!< Job system to bake on, nullptr bakes on the calling thread
+};
+
+//! Inside/outside mask, one value per SDF cell
+struct SdfBakeMask
+{
+	const unsigned char* data;
+	NvFlowUint bitsPerValue;			//!< 8 for byte masks, 1 for packed bits, most significant bit first as in 1 bpp bitmaps
+	NvFlowUint rowPitch;				//!< Bytes between rows
+	NvFlowUint depthPitch;				//!< Bytes between slices
+	NvFlowDim dim;						//!< Must match the SDF dim, 1 deep for images
+};
+
+void SdfBakeParamsDefaults(SdfBakeParams* params);
+
+/**
+ * Bake the signed distance field of a triangle mesh.
+ *
+ * @param[in] mesh Triangle mesh, modelMatrix transforms to SDF NDC space.
+ * @param[in] params Bake parameters.
+ * @param[in] sdf Destination, every cell of dim is written.
+ *
+ * @return Returns false if the mesh has no triangles or the destination no data.
+ */
+bool SdfBakeMesh(const NvFlowSDFGenMeshParams* mesh, const SdfBakeParams* params, const NvFlowShapeSDFData* sdf);
+
+/**
+ * Bake the signed distance field of a mask, nonzero values are inside.
+ *
+ * Uses the separable linear time Euclidean distance transform of Felzenszwalb and Huttenlocher,
+ * once to the inside cells and once to the outside cells, each axis pass split into tasks over rows.
+ * The surface sits halfway between inside and outside cell centers.
+ *
+ * @param[in] mask The mask.
+ * @param[in] params Bake parameters, only taskDispatch applies.
+ * @param[in] sdf Destination, every cell of dim is written.
+ *
+ * @return Returns false if the mask and SDF dims differ or either has no data.
+ */
+bool SdfBakeFromMask(const SdfBakeMask* mask, const SdfBakeParams* params, const NvFlowShapeSDFData* sdf);
+
+/// ****************** SDF Deformer Public *******************************
+
+// Incremental rebake for deforming meshes, where a full SdfBakeMesh() or NvFlowSDFGen pass
+// every frame costs the whole volume.
+//
+// The field is kept on the CPU in bricks of brickDim cells. Each update poses the rest mesh with
+// per-vertex deltas and/or a bone palette, refits the BVH and refreshes only the bricks within reach
+// of triangles whose vertices moved more than the tolerance since they were last baked. Distances
+// are clamped to maxDistanceCells, which bounds that reach, so cost follows the moving surface.
+// Refreshed bricks are coarse to fine: a brick further than its half diagonal from the surface takes
+// one sign for all cells and either the clamp value or an interpolation of its corner distances.
+// Interpolation is only used where its error bound, from the surface distance and the corner
+// gradients, is within the tolerance. Other bricks split toward cells computed as in SdfBakeMesh().
+
+struct SdfDeformer;
+
+struct SdfDeformerDesc
+{
+	NvFlowDim dim;						//!< Field resolution, must match the SDFs copied to
+	NvFlowUint brickDim;				//!< Cells per brick side, the unit of refresh
+	float toleranceCells;				//!< Vertex motion below this leaves its bricks as they are, also bounds interpolation error
+	float maxDistanceCells;				//!< Distances are clamped here, bounds how far motion reaches
+	SdfBakeParams bakeParams;			//!< Band, sign and tasks, as for SdfBakeMesh()
+};
+
+//! Linear blend skinning weights, four influences per vertex
+struct SdfDeformerSkin
+{
+	const NvFlowUint* boneIndices;
+	const float* boneWeights;
+};
+
+struct SdfDeformerStats
+{
+	NvFlowUint numBricks;
+	NvFlowUint numMovedVertices;		//!< Vertices past the tolerance in the last update
+	NvFlowUint numRefreshed;			//!< Bricks refreshed by the last update
+	NvFlowUint numFine;					//!< Of those, computed cell by cell
+	NvFlowUint numCoarse;				//!< Of those, interpolated from their corners
+	NvFlowUint numConstant;				//!< Of those, beyond the max distance
+};
+
+void SdfDeformerDescDefaults(SdfDeformerDesc* desc);
+
+/**
+ * Create a deformer for a triangle mesh, the mesh data is copied as the rest pose.
+ *
+ * @param[in] desc Deformer description.
+ * @param[in] mesh Rest mesh, modelMatrix transforms posed model space to SDF NDC space.
+ * @param[in] skin Optional skin weights for SdfDeformerSetBones(), nullptr for deltas only.
+ *
+ * @return The deformer, nullptr if the mesh has no triangles.
+ */
+SdfDeformer* SdfDeformerCreate(const SdfDeformerDesc* desc, const NvFlowSDFGenMeshParams* mesh, const SdfDeformerSkin* skin);
+
+void SdfDeformerRelease(SdfDeformer* deformer);
+
+//! Model space offsets added to the rest positions before skinning, nullptr clears them
+void SdfDeformerSetDeltas(SdfDeformer* deformer, const NvFlowFloat3* deltas, NvFlowUint numDeltas);
+
+//! Model space bone transforms, applied through the skin given at create, nullptr clears them
+void SdfDeformerSetBones(SdfDeformer* deformer, const NvFlowFloat4x4* bones, NvFlowUint numBones);
+
+/**
+ * Pose the mesh and refresh the bricks it moved through, the first update bakes every brick.
+ *
+ * @param[in] deformer The deformer.
+ *
+ * @return Returns the number of bricks refreshed, 0 means the field is unchanged.
+ */
+NvFlowUint SdfDeformerUpdate(SdfDeformer* deformer);
+
+/**
+ * Copy the field to an SDF, typically a mapped NvFlowShapeSDF after an update refreshed bricks.
+ *
+ * @param[in] deformer The deformer.
+ * @param[in] sdf Destination, every cell of dim is written.
+ *
+ * @return Returns false if the dims differ or the destination has no data.
+ */
+bool SdfDeformerCopy(SdfDeformer* deformer, const NvFlowShapeSDFData* sdf);
+
+void SdfDeformerGetStats(SdfDeformer* deformer, SdfDeformerStats* stats);
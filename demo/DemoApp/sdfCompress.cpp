@@ -0,0 +1,355 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <string.h>
+#include <math.h>
+
+#include <vector>
+#include <algorithm>
+
+#include "sdfCompress.h"
+#include "taskDispatch.h"
+#include "halfFloat.h"
+
+namespace
+{
+	// brick table entries for bricks beyond the band, others index the brick pool
+	const NvFlowUint brickOutside = ~0u;
+	const NvFlowUint brickInside = ~0u - 1u;
+
+	const NvFlowUint rowGrainSize = 16u;
+}
+
+struct SdfCompressed
+{
+	SdfCompressDesc m_desc = {};
+	NvFlowDim m_dim = {};
+	float m_band = 0.f;
+	unsigned short m_outsideHalf = 0u;
+	unsigned short m_insideHalf = 0u;
+
+	NvFlowDim m_brickGridDim = {};
+	std::vector<NvFlowUint> m_brickTable;
+	std::vector<unsigned short> m_values;		// dense volume, or brickDim^3 per stored brick
+
+	//! Write one row of fp16 values, the source of both decode paths
+	void decodeRow(NvFlowUint j, NvFlowUint k, unsigned short* dst) const;
+};
+
+void SdfCompressed::decodeRow(NvFlowUint j, NvFlowUint k, unsigned short* dst) const
+{
+	if (m_desc.format == eSdfCompressHalf)
+	{
+		memcpy(dst, m_values.data() + (size_t(k) * m_dim.y + j) * m_dim.x, m_dim.x * sizeof(unsigned short));
+		return;
+	}
+	const NvFlowUint brickDim = m_desc.brickDim;
+	const NvFlowUint bj = j / brickDim;
+	const NvFlowUint bk = k / brickDim;
+	const size_t brickOffset = (size_t(k % brickDim) * brickDim + (j % brickDim)) * brickDim;
+	for (NvFlowUint bi = 0u; bi < m_brickGridDim.x; bi++)
+	{
+		const NvFlowUint i0 = bi * brickDim;
+		const NvFlowUint count = std::min(brickDim, m_dim.x - i0);
+		const NvFlowUint entry = m_brickTable[(bk * m_brickGridDim.y + bj) * m_brickGridDim.x + bi];
+		if (entry == brickOutside || entry == brickInside)
+		{
+			std::fill(dst + i0, dst + i0 + count, (entry == brickInside) ? m_insideHalf : m_outsideHalf);
+		}
+		else
+		{
+			memcpy(dst + i0, m_values.data() + size_t(entry) * brickDim * brickDim * brickDim + brickOffset, count * sizeof(unsigned short));
+		}
+	}
+}
+
+void SdfCompressDescDefaults(SdfCompressDesc* desc)
+{
+	desc->format = eSdfCompressBricks;
+	desc->brickDim = 8u;
+	desc->narrowBandCells = 4.f;
+	desc->taskDispatch = nullptr;
+}
+
+SdfCompressed* SdfCompressedCreate(const SdfCompressDesc* desc, const NvFlowShapeSDFData* sdf)
+{
+	if (sdf->data == nullptr || sdf->dim.x == 0u || sdf->dim.y == 0u || sdf->dim.z == 0u ||
+		(desc->format == eSdfCompressBricks && desc->brickDim == 0u))
+	{
+		return nullptr;
+	}
+
+	auto ptr = new SdfCompressed();
+
+	ptr->m_desc = *desc;
+	ptr->m_dim = sdf->dim;
+	const NvFlowDim dim = sdf->dim;
+
+	if (desc->format == eSdfCompressHalf)
+	{
+		ptr->m_values.resize(size_t(dim.x) * dim.y * dim.z);
+		TaskDispatchRange(desc->taskDispatch, dim.y * dim.z, rowGrainSize, [&](NvFlowUint begin, NvFlowUint end)
+		{
+			for (NvFlowUint rowIdx = begin; rowIdx < end; rowIdx++)
+			{
+				const float* src = sdf->data + (rowIdx / dim.y) * sdf->depthPitch + (rowIdx % dim.y) * sdf->rowPitch;
+				unsigned short* dst = ptr->m_values.data() + size_t(rowIdx) * dim.x;
+				for (NvFlowUint i = 0u; i < dim.x; i++)
+				{
+					dst[i] = HalfFloatFromFloat(src[i]);
+				}
+			}
+		});
+		return ptr;
+	}
+
+	// the band is in the units of the field, cells of the finest axis
+	const NvFlowUint brickDim = desc->brickDim;
+	const NvFlowUint brickCells = brickDim * brickDim * brickDim;
+	const float h = 2.f / float(std::max(dim.x, std::max(dim.y, dim.z)));
+	ptr->m_band = desc->narrowBandCells * h;
+	ptr->m_outsideHalf = HalfFloatFromFloat(ptr->m_band);
+	ptr->m_insideHalf = HalfFloatFromFloat(-ptr->m_band);
+	ptr->m_brickGridDim = {
+		(dim.x + brickDim - 1u) / brickDim,
+		(dim.y + brickDim - 1u) / brickDim,
+		(dim.z + brickDim - 1u) / brickDim
+	};
+	const NvFlowUint numBricks = ptr->m_brickGridDim.x * ptr->m_brickGridDim.y * ptr->m_brickGridDim.z;
+	ptr->m_brickTable.resize(numBricks);
+
+	// classify in parallel, bricks with a cell inside the band or of both signs are stored
+	TaskDispatchRange(desc->taskDispatch, numBricks, 1u, [&](NvFlowUint begin, NvFlowUint end)
+	{
+		for (NvFlowUint brickIdx = begin; brickIdx < end; brickIdx++)
+		{
+			const NvFlowUint bi = brickIdx % ptr->m_brickGridDim.x;
+			const NvFlowUint bj = (brickIdx / ptr->m_brickGridDim.x) % ptr->m_brickGridDim.y;
+			const NvFlowUint bk = brickIdx / (ptr->m_brickGridDim.x * ptr->m_brickGridDim.y);
+			bool anyOutside = false;
+			bool anyInside = false;
+			bool anyBand = false;
+			for (NvFlowUint k = bk * brickDim; k < std::min((bk + 1u) * brickDim, dim.z) && !anyBand; k++)
+			{
+				for (NvFlowUint j = bj * brickDim; j < std::min((bj + 1u) * brickDim, dim.y) && !anyBand; j++)
+				{
+					const float* src = sdf->data + k * sdf->depthPitch + j * sdf->rowPitch;
+					for (NvFlowUint i = bi * brickDim; i < std::min((bi + 1u) * brickDim, dim.x); i++)
+					{
+						anyOutside = anyOutside || src[i] >= ptr->m_band;
+						anyInside = anyInside || src[i] <= -ptr->m_band;
+						anyBand = anyBand || fabsf(src[i]) < ptr->m_band;
+					}
+				}
+			}
+			if (anyBand || (anyOutside && anyInside))
+			{
+				ptr->m_brickTable[brickIdx] = 0u;
+			}
+			else
+			{
+				ptr->m_brickTable[brickIdx] = anyInside ? brickInside : brickOutside;
+			}
+		}
+	});
+
+	// pool slots in brick order, then fill the stored bricks in parallel
+	std::vector<NvFlowUint> storedBricks;
+	for (NvFlowUint brickIdx = 0u; brickIdx < numBricks; brickIdx++)
+	{
+		if (ptr->m_brickTable[brickIdx] == 0u)
+		{
+			ptr->m_brickTable[brickIdx] = NvFlowUint(storedBricks.size());
+			storedBricks.push_back(brickIdx);
+		}
+	}
+	ptr->m_values.resize(size_t(storedBricks.size()) * brickCells);
+	TaskDispatchRange(desc->taskDispatch, NvFlowUint(storedBricks.size()), 1u, [&](NvFlowUint begin, NvFlowUint end)
+	{
+		for (NvFlowUint poolIdx = begin; poolIdx < end; poolIdx++)
+		{
+			const NvFlowUint brickIdx = storedBricks[poolIdx];
+			const NvFlowUint bi = brickIdx % ptr->m_brickGridDim.x;
+			const NvFlowUint bj = (brickIdx / ptr->m_brickGridDim.x) % ptr->m_brickGridDim.y;
+			const NvFlowUint bk = brickIdx / (ptr->m_brickGridDim.x * ptr->m_brickGridDim.y);
+			unsigned short* dst = ptr->m_values.data() + size_t(poolIdx) * brickCells;
+			for (NvFlowUint k = 0u; k < brickDim; k++)
+			{
+				for (NvFlowUint j = 0u; j < brickDim; j++)
+				{
+					// cells past the volume edge repeat the last cell
+					const NvFlowUint sk = std::min(bk * brickDim + k, dim.z - 1u);
+					const NvFlowUint sj = std::min(bj * brickDim + j, dim.y - 1u);
+					const float* src = sdf->data + sk * sdf->depthPitch + sj * sdf->rowPitch;
+					for (NvFlowUint i = 0u; i < brickDim; i++)
+					{
+						float value = src[std::min(bi * brickDim + i, dim.x - 1u)];
+						*dst++ = HalfFloatFromFloat(std::max(-ptr->m_band, std::min(value, ptr->m_band)));
+					}
+				}
+			}
+		}
+	});
+
+	return ptr;
+}
+
+void SdfCompressedRelease(SdfCompressed* compressed)
+{
+	delete compressed;
+}
+
+void SdfCompressedGetStats(SdfCompressed* compressed, SdfCompressedStats* stats)
+{
+	const NvFlowDim dim = compressed->m_dim;
+	const NvFlowUint brickDim = compressed->m_desc.brickDim;
+	stats->dim = dim;
+	stats->numBricks = NvFlowUint(compressed->m_brickTable.size());
+	stats->numStoredBricks = (compressed->m_desc.format == eSdfCompressBricks) ?
+		NvFlowUint(compressed->m_values.size() / (size_t(brickDim) * brickDim * brickDim)) : 0u;
+	stats->denseBytes = size_t(dim.x) * dim.y * dim.z * sizeof(float);
+	stats->compressedBytes = compressed->m_values.size() * sizeof(unsigned short) +
+		compressed->m_brickTable.size() * sizeof(NvFlowUint);
+}
+
+SdfCompressBrickClass SdfCompressedGetBrickClass(SdfCompressed* compressed, NvFlowUint bi, NvFlowUint bj, NvFlowUint bk)
+{
+	if (compressed->m_desc.format == eSdfCompressHalf)
+	{
+		return eSdfCompressBrickStored;
+	}
+	const NvFlowDim brickGridDim = compressed->m_brickGridDim;
+	const NvFlowUint entry = compressed->m_brickTable[(bk * brickGridDim.y + bj) * brickGridDim.x + bi];
+	if (entry == brickOutside)
+	{
+		return eSdfCompressBrickOutside;
+	}
+	return (entry == brickInside) ? eSdfCompressBrickInside : eSdfCompressBrickStored;
+}
+
+void SdfCompressedDecodeRow(SdfCompressed* compressed, NvFlowUint j, NvFlowUint k, unsigned short* dst)
+{
+	compressed->decodeRow(j, k, dst);
+}
+
+bool SdfCompressedDecode(SdfCompressed* compressed, const NvFlowShapeSDFData* sdf)
+{
+	const NvFlowDim dim = compressed->m_dim;
+	if (sdf->data == nullptr || sdf->dim.x != dim.x || sdf->dim.y != dim.y || sdf->dim.z != dim.z)
+	{
+		return false;
+	}
+	TaskDispatchRange(compressed->m_desc.taskDispatch, dim.y * dim.z, rowGrainSize, [&](NvFlowUint begin, NvFlowUint end)
+	{
+		std::vector<unsigned short> row(dim.x);
+		for (NvFlowUint rowIdx = begin; rowIdx < end; rowIdx++)
+		{
+			const NvFlowUint j = rowIdx % dim.y;
+			const NvFlowUint k = rowIdx / dim.y;
+			compressed->decodeRow(j, k, row.data());
+			float* dst = sdf->data + k * sdf->depthPitch + j * sdf->rowPitch;
+			for (NvFlowUint i = 0u; i < dim.x; i++)
+			{
+				dst[i] = HalfFloatToFloat(row[i]);
+			}
+		}
+	});
+	return true;
+}
+
+bool SdfCompressedDecodeHalf(SdfCompressed* compressed, const NvFlowMappedData* mapped)
+{
+	const NvFlowDim dim = compressed->m_dim;
+	if (mapped->data == nullptr)
+	{
+		return false;
+	}
+	TaskDispatchRange(compressed->m_desc.taskDispatch, dim.y * dim.z, rowGrainSize, [&](NvFlowUint begin, NvFlowUint end)
+	{
+		for (NvFlowUint rowIdx = begin; rowIdx < end; rowIdx++)
+		{
+			const NvFlowUint j = rowIdx % dim.y;
+			const NvFlowUint k = rowIdx / dim.y;
+			compressed->decodeRow(j, k, (unsigned short*)((unsigned char*)mapped->data + size_t(k) * mapped->depthPitch + size_t(j) * mapped->rowPitch));
+		}
+	});
+	return true;
+}
+
+/// ****************** SDF Half Shape *******************************
+
+struct SdfHalfShape
+{
+	NvFlowDim m_dim = {};
+	NvFlowTexture3D* m_texture = nullptr;
+	NvFlowShapeSDF* m_shape = nullptr;
+};
+
+SdfHalfShape* SdfHalfShapeCreate(NvFlowContext* context, NvFlowDim dim)
+{
+	auto ptr = new SdfHalfShape();
+
+	ptr->m_dim = dim;
+
+	NvFlowTexture3DDesc texDesc = {};
+	texDesc.format = eNvFlowFormat_r16_float;
+	texDesc.dim = dim;
+	texDesc.uploadAccess = true;
+	texDesc.downloadAccess = false;
+	ptr->m_texture = NvFlowCreateTexture3D(context, &texDesc);
+
+	// the emitter samples the texture through its view, so the format is transparent to it
+	ptr->m_shape = NvFlowCreateShapeSDFFromTexture3D(context, ptr->m_texture);
+
+	return ptr;
+}
+
+void SdfHalfShapeRelease(SdfHalfShape* shape)
+{
+	// the shape references the texture, release it first
+	if (shape->m_shape) NvFlowReleaseShapeSDF(shape->m_shape);
+	if (shape->m_texture) NvFlowReleaseTexture3D(shape->m_texture);
+
+	delete shape;
+}
+
+bool SdfHalfShapeUpload(SdfHalfShape* shape, NvFlowContext* context, SdfCompressed* compressed)
+{
+	if (memcmp(&shape->m_dim, &compressed->m_dim, sizeof(NvFlowDim)) != 0)
+	{
+		return false;
+	}
+	NvFlowMappedData mapped = NvFlowTexture3DMap(context, shape->m_texture);
+	bool result = SdfCompressedDecodeHalf(compressed, &mapped);
+	NvFlowTexture3DUnmap(context, shape->m_texture);
+	return result;
+}
+
+NvFlowShapeSDF* SdfHalfShapeGetShape(SdfHalfShape* shape)
+{
+	return shape->m_shape;
+}
@@ -0,0 +1,132 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "NvFlow.h"
+#include "NvFlowContextExt.h"
+
+struct TaskDispatchInterface;
+
+/// ****************** SDF Compress Public *******************************
+
+// Compressed storage for SDF shapes, so many more collision shapes stay resident than as dense floats.
+//
+// Two formats, both fp16, which keeps distances to a fraction of a cell even at 256^3:
+// eSdfCompressHalf is the dense volume at half the size.
+// eSdfCompressBricks clamps distances to a narrow band and splits the volume into bricks, bricks fully
+// beyond the band in one sign take no storage, the rest are kept as fp16 bricks. Only surface bricks
+// cost memory, typically an order of magnitude below the dense float volume.
+// A compressed SDF decodes into a mapped NvFlowShapeSDF, or straight into the fp16 texture of an
+// SdfHalfShape, which also halves the GPU copy. Neither path goes through a dense float volume.
+
+enum SdfCompressFormat
+{
+	eSdfCompressHalf = 0,				//!< Dense fp16
+	eSdfCompressBricks = 1,				//!< Narrow band fp16 bricks
+};
+
+enum SdfCompressBrickClass
+{
+	eSdfCompressBrickStored = 0,		//!< Holds the surface, kept as fp16 cells
+	eSdfCompressBrickOutside = 1,		//!< Every cell at or past the band, decodes to the band
+	eSdfCompressBrickInside = 2,		//!< Every cell at or past the negative band, decodes to it
+};
+
+struct SdfCompressDesc
+{
+	SdfCompressFormat format;
+	NvFlowUint brickDim;				//!< Cells per brick side, bricks format only
+	float narrowBandCells;				//!< Distances are clamped to this many cells, bricks format only
+	const TaskDispatchInterface* taskDispatch;	//!< Job system to encode and decode on, nullptr for the calling thread
+};
+
+struct SdfCompressed;
+
+struct SdfCompressedStats
+{
+	NvFlowDim dim;
+	NvFlowUint numBricks;				//!< Bricks format, total bricks
+	NvFlowUint numStoredBricks;			//!< Bricks format, bricks holding the surface
+	size_t denseBytes;					//!< Size as a dense float volume
+	size_t compressedBytes;				//!< Size as stored
+};
+
+void SdfCompressDescDefaults(SdfCompressDesc* desc);
+
+/**
+ * Encode an SDF, a mapped NvFlowShapeSDF or a CPU buffer with the same layout.
+ *
+ * @param[in] desc Format to encode to.
+ * @param[in] sdf Source field.
+ *
+ * @return The compressed SDF, nullptr if the source has no data.
+ */
+SdfCompressed* SdfCompressedCreate(const SdfCompressDesc* desc, const NvFlowShapeSDFData* sdf);
+
+void SdfCompressedRelease(SdfCompressed* compressed);
+
+void SdfCompressedGetStats(SdfCompressed* compressed, SdfCompressedStats* stats);
+
+//! Class of brick (bi, bj, bk), every brick of the dense format is stored
+SdfCompressBrickClass SdfCompressedGetBrickClass(SdfCompressed* compressed, NvFlowUint bi, NvFlowUint bj, NvFlowUint bk);
+
+//! Decode row (j, k) to dim.x fp16 values, the source of both decode paths
+void SdfCompressedDecodeRow(SdfCompressed* compressed, NvFlowUint j, NvFlowUint k, unsigned short* dst);
+
+/**
+ * Decode to floats, typically into a mapped NvFlowShapeSDF.
+ *
+ * @param[in] compressed The compressed SDF.
+ * @param[in] sdf Destination, every cell of dim is written.
+ *
+ * @return Returns false if the dims differ or the destination has no data.
+ */
+bool SdfCompressedDecode(SdfCompressed* compressed, const NvFlowShapeSDFData* sdf);
+
+/**
+ * Decode to fp16 texels, typically a mapped eNvFlowFormat_r16_float texture.
+ *
+ * @param[in] compressed The compressed SDF.
+ * @param[in] mapped Destination, pitches in bytes, covering dim.
+ *
+ * @return Returns false if the destination has no data.
+ */
+bool SdfCompressedDecodeHalf(SdfCompressed* compressed, const NvFlowMappedData* mapped);
+
+//! An NvFlowShapeSDF backed by an fp16 texture
+struct SdfHalfShape;
+
+SdfHalfShape* SdfHalfShapeCreate(NvFlowContext* context, NvFlowDim dim);
+
+void SdfHalfShapeRelease(SdfHalfShape* shape);
+
+//! Decode a compressed SDF of the same dim into the texture, uploaded on unmap
+bool SdfHalfShapeUpload(SdfHalfShape* shape, NvFlowContext* context, SdfCompressed* compressed);
+
+//! The shape to pass to NvFlowGridUpdateEmitSDFs(), owned by the SdfHalfShape
+NvFlowShapeSDF* SdfHalfShapeGetShape(SdfHalfShape* shape);
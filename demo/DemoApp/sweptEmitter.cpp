@@ -0,0 +1,184 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <math.h>
+
+#include "sweptEmitter.h"
+#include "emitterSet.h"
+
+namespace
+{
+	float rowLength(const NvFlowFloat4& row)
+	{
+		return sqrtf(row.x * row.x + row.y * row.y + row.z * row.z);
+	}
+
+	NvFlowFloat4 lerpRow(const NvFlowFloat4& a, const NvFlowFloat4& b, float t)
+	{
+		return { a.x + t * (b.x - a.x), a.y + t * (b.y - a.y), a.z + t * (b.z - a.z), a.w + t * (b.w - a.w) };
+	}
+
+	// per step rotations are small, so row lerp is close enough
+	NvFlowFloat4x4 lerpMatrix(const NvFlowFloat4x4& a, const NvFlowFloat4x4& b, float t)
+	{
+		return { lerpRow(a.x, b.x, t), lerpRow(a.y, b.y, t), lerpRow(a.z, b.z, t), lerpRow(a.w, b.w, t) };
+	}
+
+	bool sameRow(const NvFlowFloat4& a, const NvFlowFloat4& b, float tolerance)
+	{
+		return fabsf(a.x - b.x) <= tolerance && fabsf(a.y - b.y) <= tolerance && fabsf(a.z - b.z) <= tolerance;
+	}
+
+	//! Uniform scale of the upper 3x3, or 0 if the scale is not uniform
+	float uniformScale(const NvFlowFloat4x4& m)
+	{
+		float sx = rowLength(m.x);
+		float sy = rowLength(m.y);
+		float sz = rowLength(m.z);
+		float tolerance = 1e-4f * sx;
+		if (fabsf(sx - sy) > tolerance || fabsf(sx - sz) > tolerance)
+		{
+			return 0.f;
+		}
+		return sx;
+	}
+
+	void scaleCoupleRates(NvFlowGridEmitParams& params, float scale)
+	{
+		params.velocityCoupleRate.x *= scale;
+		params.velocityCoupleRate.y *= scale;
+		params.velocityCoupleRate.z *= scale;
+		params.smokeCoupleRate *= scale;
+		params.temperatureCoupleRate *= scale;
+		params.fuelCoupleRate *= scale;
+		params.fuelRelease *= scale;
+	}
+
+	NvFlowUint emitSubSteps(EmitterSet* emitterSet, const SweptEmitDesc* desc)
+	{
+		const NvFlowUint numSubSteps = desc->numSubSteps > 0u ? desc->numSubSteps : 1u;
+		NvFlowGridEmitParams params = desc->params;
+		params.deltaTime = desc->deltaTime / float(numSubSteps);
+		for (NvFlowUint stepIdx = 0u; stepIdx < numSubSteps; stepIdx++)
+		{
+			float t = (numSubSteps > 1u) ? float(stepIdx) / float(numSubSteps - 1u) : 1.f;
+			params.bounds = lerpMatrix(desc->params.bounds, desc->boundsEnd, t);
+			params.localToWorld = lerpMatrix(desc->params.localToWorld, desc->localToWorldEnd, t);
+			emitterSet->emitTransient(desc->shape, params);
+		}
+		return numSubSteps;
+	}
+
+	bool emitCapsule(EmitterSet* emitterSet, const SweptEmitDesc* desc)
+	{
+		const NvFlowGridEmitParams& begin = desc->params;
+		if (begin.shapeType != eNvFlowShapeTypeSphere || begin.shapeRangeSize != 1u)
+		{
+			return false;
+		}
+
+		// only translation may change over the sweep
+		const float scale = uniformScale(begin.localToWorld);
+		const float boundsScale = uniformScale(begin.bounds);
+		const float tolerance = 1e-4f * scale;
+		if (scale <= 0.f || boundsScale <= 0.f ||
+			!sameRow(begin.localToWorld.x, desc->localToWorldEnd.x, tolerance) ||
+			!sameRow(begin.localToWorld.y, desc->localToWorldEnd.y, tolerance) ||
+			!sameRow(begin.localToWorld.z, desc->localToWorldEnd.z, tolerance))
+		{
+			return false;
+		}
+
+		NvFlowFloat3 delta = {
+			desc->localToWorldEnd.w.x - begin.localToWorld.w.x,
+			desc->localToWorldEnd.w.y - begin.localToWorld.w.y,
+			desc->localToWorldEnd.w.z - begin.localToWorld.w.z
+		};
+		const float dist = sqrtf(delta.x * delta.x + delta.y * delta.y + delta.z * delta.z);
+
+		NvFlowGridEmitParams params = begin;
+		params.deltaTime = desc->deltaTime;
+		if (dist <= tolerance)
+		{
+			emitterSet->emitTransient(desc->shape, params);
+			return true;
+		}
+
+		// orthonormal frame with x along the motion
+		NvFlowFloat3 axisX = { delta.x / dist, delta.y / dist, delta.z / dist };
+		NvFlowFloat3 ref = fabsf(axisX.y) < 0.9f ? NvFlowFloat3{ 0.f, 1.f, 0.f } : NvFlowFloat3{ 1.f, 0.f, 0.f };
+		NvFlowFloat3 axisZ = {
+			axisX.y * ref.z - axisX.z * ref.y,
+			axisX.z * ref.x - axisX.x * ref.z,
+			axisX.x * ref.y - axisX.y * ref.x
+		};
+		float lenZ = sqrtf(axisZ.x * axisZ.x + axisZ.y * axisZ.y + axisZ.z * axisZ.z);
+		axisZ = { axisZ.x / lenZ, axisZ.y / lenZ, axisZ.z / lenZ };
+		NvFlowFloat3 axisY = {
+			axisZ.y * axisX.z - axisZ.z * axisX.y,
+			axisZ.z * axisX.x - axisZ.x * axisX.z,
+			axisZ.x * axisX.y - axisZ.y * axisX.x
+		};
+
+		NvFlowFloat4 center = lerpRow(begin.localToWorld.w, desc->localToWorldEnd.w, 0.5f);
+		params.localToWorld.x = { scale * axisX.x, scale * axisX.y, scale * axisX.z, 0.f };
+		params.localToWorld.y = { scale * axisY.x, scale * axisY.y, scale * axisY.z, 0.f };
+		params.localToWorld.z = { scale * axisZ.x, scale * axisZ.y, scale * axisZ.z, 0.f };
+		params.localToWorld.w = center;
+
+		NvFlowFloat4 boundsCenter = lerpRow(begin.bounds.w, desc->boundsEnd.w, 0.5f);
+		const float boundsHalfLength = boundsScale + 0.5f * dist;
+		params.bounds.x = { boundsHalfLength * axisX.x, boundsHalfLength * axisX.y, boundsHalfLength * axisX.z, 0.f };
+		params.bounds.y = { boundsScale * axisY.x, boundsScale * axisY.y, boundsScale * axisY.z, 0.f };
+		params.bounds.z = { boundsScale * axisZ.x, boundsScale * axisZ.y, boundsScale * axisZ.z, 0.f };
+		params.bounds.w = boundsCenter;
+
+		params.shapeType = eNvFlowShapeTypeCapsule;
+
+		NvFlowShapeDesc shape;
+		shape.capsule.radius = desc->shape.sphere.radius;
+		shape.capsule.length = dist / scale;
+
+		// a cell on the path is only inside the moving sphere for part of the sweep,
+		// the capsule covers it for all of it, so couple proportionally slower,
+		// using the mean chord of a sphere, 4/3 radius, as the covered length
+		const float chord = (4.f / 3.f) * desc->shape.sphere.radius * scale;
+		scaleCoupleRates(params, chord / (dist + chord));
+
+		emitterSet->emitTransient(shape, params);
+		return true;
+	}
+}
+
+NvFlowUint SweptEmit(EmitterSet* emitterSet, const SweptEmitDesc* desc)
+{
+	if (desc->mode == eSweptEmitModeCapsule && emitCapsule(emitterSet, desc))
+	{
+		return 1u;
+	}
+	return emitSubSteps(emitterSet, desc);
+}
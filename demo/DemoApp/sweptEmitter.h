@@ -0,0 +1,53 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "NvFlow.h"
+
+struct EmitterSet;
+
+enum SweptEmitMode
+{
+	eSweptEmitModeSubSteps = 0,		//!< One emitter per sub step, interpolated between begin and end
+	eSweptEmitModeCapsule = 1,		//!< Translating spheres become one capsule over the path, otherwise sub steps
+};
+
+//! Description of an emitter moving from a begin to an end transform over deltaTime
+struct SweptEmitDesc
+{
+	NvFlowShapeDesc shape;
+	NvFlowGridEmitParams params;		//!< Emitter params, bounds and localToWorld are the begin transforms
+	NvFlowFloat4x4 boundsEnd;			//!< Bounds at the end of the sweep
+	NvFlowFloat4x4 localToWorldEnd;		//!< Shape transform at the end of the sweep
+	NvFlowUint numSubSteps;				//!< Sub steps the sweep represents, begin and end inclusive
+	float deltaTime;					//!< Time covered by the whole sweep
+	SweptEmitMode mode;
+};
+
+//! Adds the swept emitter to the set as transient emitters, returns the number added
+NvFlowUint SweptEmit(EmitterSet* emitterSet, const SweptEmitDesc* desc);
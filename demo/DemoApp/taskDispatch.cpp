@@ -0,0 +1,231 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "taskDispatch.h"
+
+namespace
+{
+	struct RangeTasks
+	{
+		const std::function<void(NvFlowUint, NvFlowUint)>* func;
+		NvFlowUint numItems;
+		NvFlowUint itemsPerTask;
+	};
+
+	void rangeTask(void* taskUserdata, NvFlowUint taskIdx)
+	{
+		const RangeTasks* tasks = static_cast<const RangeTasks*>(taskUserdata);
+		NvFlowUint begin = taskIdx * tasks->itemsPerTask;
+		NvFlowUint end = begin + tasks->itemsPerTask;
+		(*tasks->func)(begin, end < tasks->numItems ? end : tasks->numItems);
+	}
+}
+
+void TaskDispatchRange(const TaskDispatchInterface* dispatch, NvFlowUint numItems, NvFlowUint grainSize, const std::function<void(NvFlowUint, NvFlowUint)>& func)
+{
+	if (numItems == 0u)
+	{
+		return;
+	}
+	if (dispatch == nullptr || dispatch->numThreads <= 1u || numItems <= grainSize)
+	{
+		func(0u, numItems);
+		return;
+	}
+
+	// a few tasks per thread lets a work stealing scheduler balance uneven items
+	NvFlowUint numTasks = 4u * dispatch->numThreads;
+	NvFlowUint itemsPerTask = (numItems + numTasks - 1u) / numTasks;
+	if (itemsPerTask < grainSize)
+	{
+		itemsPerTask = grainSize;
+	}
+	numTasks = (numItems + itemsPerTask - 1u) / itemsPerTask;
+
+	RangeTasks tasks = { &func, numItems, itemsPerTask };
+	dispatch->dispatch(dispatch->userdata, numTasks, rangeTask, &tasks);
+}
+
+// ****************** Task Pool ************************
+
+struct TaskPool
+{
+	std::vector<std::thread> m_threads;
+	std::mutex m_mutex;
+	std::condition_variable m_workCond;
+	std::condition_variable m_doneCond;
+
+	// one dispatch runs at a time, other callers queue here
+	std::mutex m_dispatchMutex;
+
+	TaskDispatchFunc m_func = nullptr;
+	void* m_taskUserdata = nullptr;
+	NvFlowUint m_numTasks = 0u;
+	std::atomic<NvFlowUint> m_nextTask;
+	NvFlowUint m_numBusy = 0u;
+	NvFlowUint64 m_generation = 0u;
+	bool m_shutdown = false;
+
+	void init(NvFlowUint numWorkers);
+	void release();
+	void runTasks();
+	void threadMain();
+	void dispatch(NvFlowUint numTasks, TaskDispatchFunc func, void* taskUserdata);
+};
+
+namespace
+{
+	// pool whose task the current thread is running, nested dispatches to it run inline
+	thread_local TaskPool* tlsRunningPool = nullptr;
+
+	void poolDispatch(void* userdata, NvFlowUint numTasks, TaskDispatchFunc func, void* taskUserdata)
+	{
+		static_cast<TaskPool*>(userdata)->dispatch(numTasks, func, taskUserdata);
+	}
+}
+
+void TaskPool::init(NvFlowUint numWorkers)
+{
+	m_nextTask = 0u;
+	if (numWorkers == 0u)
+	{
+		numWorkers = std::thread::hardware_concurrency();
+	}
+	// the dispatching thread works too
+	for (NvFlowUint i = 1u; i < numWorkers; i++)
+	{
+		m_threads.push_back(std::thread([this]() { threadMain(); }));
+	}
+}
+
+void TaskPool::release()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_shutdown = true;
+	}
+	m_workCond.notify_all();
+	for (auto& thread : m_threads)
+	{
+		thread.join();
+	}
+	m_threads.clear();
+}
+
+void TaskPool::runTasks()
+{
+	TaskPool* prevPool = tlsRunningPool;
+	tlsRunningPool = this;
+	NvFlowUint taskIdx;
+	while ((taskIdx = m_nextTask++) < m_numTasks)
+	{
+		m_func(m_taskUserdata, taskIdx);
+	}
+	tlsRunningPool = prevPool;
+}
+
+void TaskPool::threadMain()
+{
+	NvFlowUint64 generation = 0u;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_workCond.wait(lock, [&]() { return m_shutdown || m_generation != generation; });
+			if (m_shutdown)
+			{
+				return;
+			}
+			generation = m_generation;
+		}
+		runTasks();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_numBusy--;
+		}
+		m_doneCond.notify_one();
+	}
+}
+
+void TaskPool::dispatch(NvFlowUint numTasks, TaskDispatchFunc func, void* taskUserdata)
+{
+	if (m_threads.size() == 0u || numTasks <= 1u || tlsRunningPool == this)
+	{
+		for (NvFlowUint taskIdx = 0u; taskIdx < numTasks; taskIdx++)
+		{
+			func(taskUserdata, taskIdx);
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex> dispatchLock(m_dispatchMutex);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_func = func;
+		m_taskUserdata = taskUserdata;
+		m_numTasks = numTasks;
+		m_nextTask = 0u;
+		m_numBusy = NvFlowUint(m_threads.size());
+		m_generation++;
+	}
+	m_workCond.notify_all();
+
+	runTasks();
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_doneCond.wait(lock, [&]() { return m_numBusy == 0u; });
+	m_func = nullptr;
+	m_taskUserdata = nullptr;
+}
+
+TaskPool* TaskPoolCreate(NvFlowUint numWorkers)
+{
+	TaskPool* pool = new TaskPool;
+	pool->init(numWorkers);
+	return pool;
+}
+
+void TaskPoolRelease(TaskPool* pool)
+{
+	if (pool == nullptr) return;
+
+	pool->release();
+	delete pool;
+}
+
+void TaskPoolGetInterface(TaskPool* pool, TaskDispatchInterface* dispatch)
+{
+	dispatch->userdata = pool;
+	dispatch->dispatch = poolDispatch;
+	dispatch->numThreads = NvFlowUint(pool->m_threads.size()) + 1u;
+}
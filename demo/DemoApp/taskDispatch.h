@@ -0,0 +1,74 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include <functional>
+
+#include "NvFlow.h"
+
+/// ****************** Task Dispatch Public *******************************
+
+// Hook for running the demo's CPU side work on an engine job system.
+//
+// An engine fills TaskDispatchInterface with its scheduler, typically pushing numTasks jobs
+// to a work stealing queue and helping until they finish. Without one, TaskPool provides
+// a plain worker pool with the same interface. Tasks may dispatch again, the built in pool
+// runs nested dispatches inline.
+
+typedef void(*TaskDispatchFunc)(void* taskUserdata, NvFlowUint taskIdx);
+
+struct TaskDispatchInterface
+{
+	void* userdata;
+
+	//! Runs func for every taskIdx in [0, numTasks) on any threads, returns once all finished
+	void(*dispatch)(void* userdata, NvFlowUint numTasks, TaskDispatchFunc func, void* taskUserdata);
+
+	//! Threads dispatch may use, the caller included, used to size tasks
+	NvFlowUint numThreads;
+};
+
+/**
+ * Run a range of items as tasks of at least grainSize items.
+ *
+ * @param[in] dispatch The dispatch interface, nullptr runs all items on the calling thread.
+ * @param[in] numItems Items to run.
+ * @param[in] grainSize Fewest items per task.
+ * @param[in] func Called with [begin, end) item ranges, ranges never overlap.
+ */
+void TaskDispatchRange(const TaskDispatchInterface* dispatch, NvFlowUint numItems, NvFlowUint grainSize, const std::function<void(NvFlowUint, NvFlowUint)>& func);
+
+struct TaskPool;
+
+//! numWorkers of 0 selects the hardware concurrency, the dispatching thread counts as a worker
+TaskPool* TaskPoolCreate(NvFlowUint numWorkers);
+
+void TaskPoolRelease(TaskPool* pool);
+
+//! Interface valid until TaskPoolRelease(), dispatch may be called from several threads
+void TaskPoolGetInterface(TaskPool* pool, TaskDispatchInterface* dispatch);
@@ -0,0 +1,139 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <vector>
+
+#include "temporalLod.h"
+
+TemporalLod::TemporalLod()
+{
+	for (NvFlowUint layerIdx = 0u; layerIdx < maxLayers; layerIdx++)
+	{
+		m_layerMaxDivisor[layerIdx] = 4u;
+	}
+}
+
+void TemporalLod::updateActivity(NvFlowGridSummaryStateCPU* stateCPU)
+{
+	NvFlowUint numLayers = NvFlowGridSummaryGetNumLayers(stateCPU);
+	std::vector<const NvFlowGridSummaryResult*> layerResults(numLayers, nullptr);
+	std::vector<NvFlowUint> layerNumResults(numLayers, 0u);
+	for (NvFlowUint layerIdx = 0u; layerIdx < numLayers; layerIdx++)
+	{
+		NvFlowGridSummaryResult* results = nullptr;
+		NvFlowUint numResults = 0u;
+
+		NvFlowGridSummaryGetSummaries(stateCPU, &results, &numResults, layerIdx);
+
+		layerResults[layerIdx] = results;
+		layerNumResults[layerIdx] = numResults;
+	}
+
+	updateActivity(layerResults.data(), layerNumResults.data(), numLayers);
+}
+
+void TemporalLod::updateActivity(const NvFlowGridSummaryResult* const* layerResults, const NvFlowUint* layerNumResults, NvFlowUint numLayers)
+{
+	NvFlowUint numRegions = 0u;
+	NvFlowUint numQuiescent = 0u;
+	NvFlowUint maxDivisor = 4u;
+
+	for (NvFlowUint layerIdx = 0u; layerIdx < numLayers; layerIdx++)
+	{
+		const NvFlowGridSummaryResult* results = layerResults[layerIdx];
+		const NvFlowUint numResults = layerNumResults[layerIdx];
+
+		for (NvFlowUint idx = 0u; idx < numResults; idx++)
+		{
+			if (results[idx].averageSpeed < m_speedThreshold)
+			{
+				numQuiescent++;
+			}
+		}
+		numRegions += numResults;
+
+		// one layer that must stay at full rate holds the whole grid
+		if (numResults > 0u)
+		{
+			NvFlowUint layerMax = m_layerMaxDivisor[layerIdx < maxLayers ? layerIdx : maxLayers - 1u];
+			if (layerMax < maxDivisor) maxDivisor = layerMax;
+		}
+	}
+
+	m_statQuiescentFraction = numRegions > 0u ? float(numQuiescent) / float(numRegions) : 1.f;
+
+	NvFlowUint divisor = 1u;
+	if (m_statQuiescentFraction >= m_quarterRateFraction)
+	{
+		divisor = 4u;
+	}
+	else if (m_statQuiescentFraction >= m_halfRateFraction)
+	{
+		divisor = 2u;
+	}
+	if (divisor > maxDivisor) divisor = maxDivisor;
+	if (divisor < 1u) divisor = 1u;
+
+	m_nextDivisor = divisor;
+}
+
+bool TemporalLod::step(float dt, float* stepDt)
+{
+	if (!m_enabled)
+	{
+		reset();
+		*stepDt = dt;
+		return true;
+	}
+
+	m_accumDt += dt;
+	m_frame++;
+
+	// never let a skipped run grow past the longest stable step
+	if (m_frame < m_divisor && m_accumDt + dt <= m_maxStepDt)
+	{
+		m_statStepsSkipped++;
+		return false;
+	}
+
+	*stepDt = m_accumDt;
+	m_accumDt = 0.f;
+	m_frame = 0u;
+
+	// divisor only changes on a step, so time is never dropped
+	m_divisor = m_nextDivisor;
+	return true;
+}
+
+void TemporalLod::reset()
+{
+	m_divisor = 1u;
+	m_nextDivisor = 1u;
+	m_frame = 0u;
+	m_accumDt = 0.f;
+	m_statStepsSkipped = 0u;
+}
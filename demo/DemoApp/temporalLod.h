@@ -0,0 +1,71 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#pragma once
+
+#include "NvFlow.h"
+
+// Temporal level of detail for a grid.
+//
+// Flow steps every block of a grid at the same rate, so the rate is picked for the whole grid
+// from the grid summary. When enough summary regions are quiescent, averageSpeed below
+// m_speedThreshold, the grid steps at half or quarter rate with the skipped frame time folded
+// into the next step. Emits made on skipped frames stay queued on the grid until that step.
+struct TemporalLod
+{
+	static const NvFlowUint maxLayers = 16u;
+
+	bool m_enabled = false;
+	float m_speedThreshold = 0.5f;			//!< Regions slower than this are quiescent, world units per second
+	float m_halfRateFraction = 0.5f;		//!< Quiescent fraction to step at half rate
+	float m_quarterRateFraction = 0.85f;	//!< Quiescent fraction to step at quarter rate
+	float m_maxStepDt = 1.f / 15.f;			//!< Longest step handed to NvFlowGridUpdate
+	NvFlowUint m_layerMaxDivisor[maxLayers];	//!< Per layer limit on the rate divisor, 1 keeps a layer at full rate
+
+	NvFlowUint m_divisor = 1u;
+	NvFlowUint m_frame = 0u;
+	float m_accumDt = 0.f;
+
+	float m_statQuiescentFraction = 0.f;
+	NvFlowUint m_statStepsSkipped = 0u;
+
+	TemporalLod();
+
+	//! Picks the rate divisor from the summary of the last update
+	void updateActivity(NvFlowGridSummaryStateCPU* stateCPU);
+
+	//! Picks the rate divisor from per layer summary results, layerResults[layerIdx] holds layerNumResults[layerIdx] results
+	void updateActivity(const NvFlowGridSummaryResult* const* layerResults, const NvFlowUint* layerNumResults, NvFlowUint numLayers);
+
+	//! Accumulates dt, returns true with the time to step when the grid should update this frame
+	bool step(float dt, float* stepDt);
+
+	void reset();
+
+protected:
+	NvFlowUint m_nextDivisor = 1u;
+};
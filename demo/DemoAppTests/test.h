@@ -0,0 +1,59 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+
+/// ****************** Test Public *******************************
+
+// Minimal self registering test cases for the headless DemoApp modules, run by DemoAppTests
+// after every build. A failed check reports and lets the case continue, so one run lists them all.
+
+typedef void(*TestFunc)();
+
+struct TestRegistration
+{
+	TestRegistration(const char* name, TestFunc func);
+};
+
+//! Records a failure of the running case, returns ok
+bool TestCheck(bool ok, const char* expr, const char* file, int line);
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static TestRegistration name##Registration(#name, name); \
+	static void name()
+
+#define TEST_CHECK(expr) TestCheck(!!(expr), #expr, __FILE__, __LINE__)
+
+//! Checks |a - b| <= tol, and prints both values when it fails
+#define TEST_CHECK_NEAR(a, b, tol) \
+	if (!TestCheck(fabs(double(a) - double(b)) <= double(tol), #a " ~ " #b, __FILE__, __LINE__)) \
+		printf("    %g vs %g, tolerance %g\n", double(a), double(b), double(tol))
@@ -0,0 +1,199 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <math.h>
+
+#include <set>
+#include <vector>
+
+#include "NvFlowShaderCPU.h"
+
+#include "test.h"
+#include "testGrid.h"
+#include "blockPredictor.h"
+
+namespace
+{
+	const NvFlowGridMaterialHandle testMaterialA = { nullptr, 1u };
+	const NvFlowGridMaterialHandle testMaterialB = { nullptr, 2u };
+
+	//! Held block of one material, as (uid, x, y, z)
+	typedef NvFlowUint64 TestHeldBlock;
+
+	TestHeldBlock testHeld(NvFlowUint64 uid, NvFlowUint x, NvFlowUint y, NvFlowUint z)
+	{
+		return (uid << 48u) | (NvFlowUint64(z) << 32u) | (NvFlowUint64(y) << 16u) | NvFlowUint64(x);
+	}
+
+	//! Predictor over the default test grid, 8 blocks a side of 0.5, rising 2 blocks per prediction
+	struct TestPredictor
+	{
+		BlockPredictor predictor;
+		NvFlowGridExportImportLayeredMapping mapping;
+		std::vector<NvFlowUint2> blockList;
+
+		TestPredictor()
+		{
+			CpuGridDesc desc;
+			TestGridDescDefaults(&desc);
+			CpuGrid* grid = CpuGridCreate(&desc);
+			CpuGridExport gridExport;
+			CpuGridGetExport(grid, &gridExport);
+			mapping = gridExport.mapping;
+			CpuGridRelease(grid);
+
+			predictor.m_enabled = true;
+			predictor.m_predictTime = 0.25f;
+			predictor.m_holdFrames = 4u;
+
+			// one summary cell over the whole grid
+			NvFlowGridSummaryResult result = {};
+			result.worldLocation = { 0.f, 0.f, 0.f, 1.f };
+			result.worldHalfSize = { 2.f, 2.f, 2.f, 0.f };
+			result.averageVelocity = { 0.f, 4.f, 0.f };
+			predictor.addCoarseVelocity(result);
+		}
+
+		void update(const NvFlowGridMaterialHandle* layerMaterials, NvFlowUint numLayers)
+		{
+			mapping.layeredBlockListCPU = blockList.data();
+			mapping.layeredNumBlocks = NvFlowUint(blockList.size());
+			predictor.updateGrid(mapping, layerMaterials, numLayers);
+			blockList.clear();
+		}
+
+		void addBlock(NvFlowUint x, NvFlowUint y, NvFlowUint z, NvFlowUint layerIdx)
+		{
+			blockList.push_back({ NvFlowCPU_coord_to_tableVal(x, y, z), layerIdx });
+		}
+
+		//! Blocks the emitters request, by material, from the box bounds
+		std::set<TestHeldBlock> gather(const NvFlowGridMaterialHandle* emitMaterials, NvFlowUint numEmitMaterials)
+		{
+			std::set<TestHeldBlock> held;
+			NvFlowUint numEmitters = predictor.gather(1.f / 60.f, emitMaterials, numEmitMaterials);
+			const NvFlowFloat3& blockSize = predictor.m_blockSize;
+			for (NvFlowUint idx = 0u; idx < numEmitters; idx++)
+			{
+				const NvFlowGridEmitParams& params = predictor.m_params[idx];
+				const NvFlowGridMaterialHandle& material = predictor.m_emitMaterials[params.emitMaterialIndex];
+				const float minX = params.bounds.w.x - params.bounds.x.x + 2.f;
+				const float maxX = params.bounds.w.x + params.bounds.x.x + 2.f;
+				const NvFlowUint y = NvFlowUint(floorf((params.bounds.w.y + 2.f) / blockSize.y));
+				const NvFlowUint z = NvFlowUint(floorf((params.bounds.w.z + 2.f) / blockSize.z));
+				for (NvFlowUint x = NvFlowUint(floorf(minX / blockSize.x)); x <= NvFlowUint(floorf(maxX / blockSize.x)); x++)
+				{
+					held.insert(testHeld(material.uid, x, y, z));
+				}
+			}
+			return held;
+		}
+	};
+}
+
+TEST_CASE(BlockPredictorHoldsPerMaterial)
+{
+	TestPredictor test;
+	const NvFlowGridMaterialHandle layerMaterials[2u] = { testMaterialA, testMaterialB };
+	test.addBlock(2u, 2u, 2u, 0u);
+	test.addBlock(5u, 2u, 5u, 1u);
+	test.update(layerMaterials, 2u);
+
+	// a scene emitting only B, A is appended to the table
+	std::set<TestHeldBlock> held = test.gather(&testMaterialB, 1u);
+	const std::set<TestHeldBlock> expected = {
+		testHeld(1u, 2u, 3u, 2u), testHeld(1u, 2u, 4u, 2u),
+		testHeld(2u, 5u, 3u, 5u), testHeld(2u, 5u, 4u, 5u)
+	};
+	TEST_CHECK(held == expected);
+	TEST_CHECK(test.predictor.m_statHeldBlocks == 4u);
+	TEST_CHECK(test.predictor.m_emitMaterials.size() == 2u);
+	TEST_CHECK(test.predictor.m_emitMaterials[0u].uid == testMaterialB.uid);
+	TEST_CHECK(test.predictor.m_emitMaterials[1u].uid == testMaterialA.uid);
+
+	// emitters only request allocation
+	for (const NvFlowGridEmitParams& params : test.predictor.m_params)
+	{
+		TEST_CHECK(params.emitMode == (eNvFlowGridEmitModeDisableVelocity | eNvFlowGridEmitModeDisableDensity));
+	}
+
+	// layers swap places, holds stay with their material
+	const NvFlowGridMaterialHandle swapped[2u] = { testMaterialB, testMaterialA };
+	test.update(swapped, 2u);
+	TEST_CHECK(test.gather(swapped, 2u) == expected);
+	TEST_CHECK(test.predictor.m_emitMaterials.size() == 2u);
+
+	// a removed material drops its holds
+	test.update(&testMaterialA, 1u);
+	const std::set<TestHeldBlock> expectedA = { testHeld(1u, 2u, 3u, 2u), testHeld(1u, 2u, 4u, 2u) };
+	TEST_CHECK(test.gather(&testMaterialA, 1u) == expectedA);
+}
+
+TEST_CASE(BlockPredictorReleasesHolds)
+{
+	TestPredictor test;
+	test.addBlock(2u, 2u, 2u, 0u);
+	test.update(&testMaterialA, 1u);
+	TEST_CHECK(test.gather(&testMaterialA, 1u).size() == 2u);
+
+	// holds fade over m_holdFrames exports without the source block
+	for (NvFlowUint frame = 1u; frame < test.predictor.m_holdFrames; frame++)
+	{
+		test.update(&testMaterialA, 1u);
+		TEST_CHECK(test.gather(&testMaterialA, 1u).size() == 2u);
+	}
+	test.update(&testMaterialA, 1u);
+	TEST_CHECK(test.gather(&testMaterialA, 1u).empty());
+	TEST_CHECK(test.predictor.m_params.empty());
+
+	test.predictor.m_enabled = false;
+	test.addBlock(2u, 2u, 2u, 0u);
+	test.update(&testMaterialA, 1u);
+	TEST_CHECK(test.gather(&testMaterialA, 1u).empty());
+}
+
+TEST_CASE(BlockPredictorPredictedBlocksDoNotSeedTheirLayer)
+{
+	TestPredictor test;
+	const NvFlowGridMaterialHandle layerMaterials[2u] = { testMaterialA, testMaterialB };
+	test.addBlock(2u, 2u, 2u, 0u);
+	test.update(layerMaterials, 2u);
+
+	// the blocks prediction allocated for A show up, and B fills one of them on its own
+	test.addBlock(2u, 2u, 2u, 0u);
+	test.addBlock(2u, 3u, 2u, 0u);
+	test.addBlock(2u, 4u, 2u, 0u);
+	test.addBlock(2u, 3u, 2u, 1u);
+	test.update(layerMaterials, 2u);
+
+	// A still reaches only from its source block, B sweeps from its block as it was never held for B
+	const std::set<TestHeldBlock> expected = {
+		testHeld(1u, 2u, 3u, 2u), testHeld(1u, 2u, 4u, 2u),
+		testHeld(2u, 2u, 4u, 2u), testHeld(2u, 2u, 5u, 2u)
+	};
+	TEST_CHECK(test.gather(layerMaterials, 2u) == expected);
+}
@@ -0,0 +1,302 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+
+#include <vector>
+
+#include "NvFlowShaderCPU.h"
+
+#include "test.h"
+#include "testGrid.h"
+
+TEST_CASE(CpuGridSameChecksumForAnyWorkerCount)
+{
+	const NvFlowUint workerCounts[] = { 1u, 2u, 3u, 8u };
+	const float dt = 1.f / 60.f;
+
+	NvFlowUint64 velocity[4] = {}, density[4] = {};
+	NvFlowUint numBlocks[4] = {};
+	for (int run = 0; run < 4; run++)
+	{
+		CpuGridDesc desc;
+		TestGridDescDefaults(&desc);
+		desc.numWorkers = workerCounts[run];
+		CpuGrid* grid = CpuGridCreate(&desc);
+		for (int frame = 0; frame < 30; frame++)
+		{
+			TestGridStep(grid, float(frame) * dt, dt);
+		}
+		TestGridChecksum(grid, &velocity[run], &density[run]);
+		numBlocks[run] = TestGridNumBlocks(grid);
+		CpuGridRelease(grid);
+	}
+
+	TEST_CHECK(numBlocks[0] > 0u);
+	for (int run = 1; run < 4; run++)
+	{
+		TEST_CHECK(numBlocks[run] == numBlocks[0]);
+		TEST_CHECK(velocity[run] == velocity[0]);
+		TEST_CHECK(density[run] == density[0]);
+	}
+}
+
+TEST_CASE(CpuGridEmitterPastMaxFaceAllocatesNothing)
+{
+	// 36 cells leave a partial last block on each axis
+	CpuGridDesc desc;
+	TestGridDescDefaults(&desc);
+	desc.gridDesc.virtualDim = { 36u, 36u, 36u };
+	desc.numWorkers = 1u;
+	CpuGrid* grid = CpuGridCreate(&desc);
+
+	NvFlowShapeDesc shape;
+	NvFlowGridEmitParams params;
+	TestGridFireBall(0.f, &shape, &params);
+	const NvFlowFloat4 outside = { 3.f, 0.f, 0.f, 1.f };
+	params.localToWorld.w = outside;
+	params.bounds.w = outside;
+	CpuGridEmit(grid, &shape, 1u, &params, 1u);
+	CpuGridUpdate(grid, 1.f / 60.f);
+
+	TEST_CHECK(TestGridNumBlocks(grid) == 0u);
+
+	CpuGridRelease(grid);
+}
+
+TEST_CASE(CpuGridLodLevelsFollowDistanceAndShareThePool)
+{
+	const float dt = 1.f / 60.f;
+	CpuGridDesc desc;
+	TestGridDescDefaults(&desc);
+	desc.numWorkers = 1u;
+	desc.maxLevel = CpuGridMaxLevel;
+	CpuGrid* grid = CpuGridCreate(&desc);
+
+	// the fire ball circles the camera 0.75 away, its plume rises through both distance bands
+	CpuGridLodParams lodParams;
+	CpuGridLodParamsDefaults(&lodParams);
+	lodParams.cameraPosition = { 0.f, -1.f, 0.f };
+	lodParams.levelDistance = 0.5f;
+	CpuGridSetLodParams(grid, &lodParams);
+
+	for (int frame = 0; frame < 30; frame++)
+	{
+		TestGridStep(grid, float(frame) * dt, dt);
+	}
+
+	CpuGridExport gridExport;
+	CpuGridGetExport(grid, &gridExport);
+	const NvFlowShaderLinearParams& params = gridExport.mapping.shaderParams;
+	TEST_CHECK(NvFlowCPU_hasTableLevels(gridExport.tableParams));
+
+	NvFlowUint numPerLevel[CpuGridMaxLevel + 1u] = {};
+	const NvFlowFloat3 cellSize = {
+		2.f * desc.gridDesc.halfSize.x / float(desc.gridDesc.virtualDim.x),
+		2.f * desc.gridDesc.halfSize.y / float(desc.gridDesc.virtualDim.y),
+		2.f * desc.gridDesc.halfSize.z / float(desc.gridDesc.virtualDim.z)
+	};
+	const float half = 0.5f * float(CpuGridBlockDim);
+	std::vector<unsigned char> realCellUsed(size_t(gridExport.poolDim.x) * gridExport.poolDim.y * gridExport.poolDim.z, 0u);
+	NvFlowUint numWrongLevel = 0u;
+	NvFlowUint numOutsidePool = 0u;
+	NvFlowUint numShared = 0u;
+	for (NvFlowUint idx = 0u; idx < gridExport.numBlocks; idx++)
+	{
+		const NvFlowInt3 vBlockIdx = NvFlowCPU_tableVal_to_coord(gridExport.blockList[idx]);
+		const NvFlowUint tableVal = NvFlowCPU_blockTableLoad(gridExport.blockTable, params, vBlockIdx.x, vBlockIdx.y, vBlockIdx.z);
+		const NvFlowUint level = NvFlowCPU_tableVal_to_level(tableVal);
+		if (level > CpuGridMaxLevel)
+		{
+			numWrongLevel++;
+			continue;
+		}
+		numPerLevel[level]++;
+
+		// distance only, the level doubles its distance band each step
+		const float dx = -desc.gridDesc.halfSize.x + (float(vBlockIdx.x) * float(CpuGridBlockDim) + half) * cellSize.x - lodParams.cameraPosition.x;
+		const float dy = -desc.gridDesc.halfSize.y + (float(vBlockIdx.y) * float(CpuGridBlockDim) + half) * cellSize.y - lodParams.cameraPosition.y;
+		const float dz = -desc.gridDesc.halfSize.z + (float(vBlockIdx.z) * float(CpuGridBlockDim) + half) * cellSize.z - lodParams.cameraPosition.z;
+		const float dist = sqrtf(dx * dx + dy * dy + dz * dz);
+		const bool nearBand = fabsf(dist - lodParams.levelDistance) < 1e-3f || fabsf(dist - 2.f * lodParams.levelDistance) < 1e-3f;
+		const NvFlowUint expected = dist < lodParams.levelDistance ? 0u : (dist < 2.f * lodParams.levelDistance ? 1u : 2u);
+		if (!nearBand && level != expected)
+		{
+			numWrongLevel++;
+		}
+
+		// a level l block covers (blockDim >> l)^3 real cells, no two blocks may share one
+		const int levelBlockDim = int(CpuGridBlockDim >> level);
+		for (int k = 0; k < levelBlockDim; k++)
+		{
+			for (int j = 0; j < levelBlockDim; j++)
+			{
+				for (int i = 0; i < levelBlockDim; i++)
+				{
+					const NvFlowInt3 vidx = {
+						(vBlockIdx.x << CpuGridBlockDimBits) + (i << level),
+						(vBlockIdx.y << CpuGridBlockDimBits) + (j << level),
+						(vBlockIdx.z << CpuGridBlockDimBits) + (k << level)
+					};
+					const NvFlowInt3 ridx = NvFlowCPU_virtualToRealLod(gridExport.blockTable, params, vidx);
+					if (NvFlowUint(ridx.x) >= gridExport.poolDim.x || NvFlowUint(ridx.y) >= gridExport.poolDim.y || NvFlowUint(ridx.z) >= gridExport.poolDim.z)
+					{
+						numOutsidePool++;
+						continue;
+					}
+					unsigned char& used = realCellUsed[(size_t(ridx.z) * gridExport.poolDim.y + ridx.y) * gridExport.poolDim.x + ridx.x];
+					if (used) numShared++;
+					used = 1u;
+				}
+			}
+		}
+	}
+
+	TEST_CHECK(gridExport.numBlocks > 0u);
+	TEST_CHECK(numWrongLevel == 0u);
+	TEST_CHECK(numOutsidePool == 0u);
+	TEST_CHECK(numShared == 0u);
+	for (NvFlowUint level = 0u; level <= CpuGridMaxLevel; level++)
+	{
+		TEST_CHECK(numPerLevel[level] == gridExport.numBlocksPerLevel[level]);
+	}
+	TEST_CHECK(numPerLevel[1] > 0u);
+	TEST_CHECK(numPerLevel[2] > 0u);
+
+	CpuGridRelease(grid);
+}
+
+TEST_CASE(CpuGridLodMatchesAcrossWorkersAndLevelZeroMatchesNoLod)
+{
+	const float dt = 1.f / 60.f;
+	const struct { NvFlowUint maxLevel; float levelDistance; NvFlowUint numWorkers; } runs[] = {
+		{ CpuGridMaxLevel, 0.5f, 1u },
+		{ CpuGridMaxLevel, 0.5f, 4u },
+		{ 0u, 0.f, 1u },
+		{ CpuGridMaxLevel, 0.f, 3u }
+	};
+	NvFlowUint64 velocity[4] = {}, density[4] = {};
+	NvFlowUint numBlocks[4] = {};
+	for (int run = 0; run < 4; run++)
+	{
+		CpuGridDesc desc;
+		TestGridDescDefaults(&desc);
+		desc.numWorkers = runs[run].numWorkers;
+		desc.maxLevel = runs[run].maxLevel;
+		CpuGrid* grid = CpuGridCreate(&desc);
+
+		CpuGridLodParams lodParams;
+		CpuGridLodParamsDefaults(&lodParams);
+		lodParams.cameraPosition = { 0.f, -1.f, 0.f };
+		lodParams.levelDistance = runs[run].levelDistance;
+		CpuGridSetLodParams(grid, &lodParams);
+
+		for (int frame = 0; frame < 30; frame++)
+		{
+			TestGridStep(grid, float(frame) * dt, dt);
+		}
+		TestGridChecksum(grid, &velocity[run], &density[run]);
+		numBlocks[run] = TestGridNumBlocks(grid);
+		CpuGridRelease(grid);
+	}
+
+	// levelled runs are deterministic too
+	TEST_CHECK(numBlocks[0] > 0u);
+	TEST_CHECK(numBlocks[1] == numBlocks[0]);
+	TEST_CHECK(velocity[1] == velocity[0]);
+	TEST_CHECK(density[1] == density[0]);
+
+	// with every block at level 0, a levelled grid simulates exactly as one without levels
+	TEST_CHECK(numBlocks[3] == numBlocks[2]);
+	TEST_CHECK(velocity[3] == velocity[2]);
+	TEST_CHECK(density[3] == density[2]);
+}
+
+TEST_CASE(CpuGridRestoreThenUpdateMatchesUninterruptedRun)
+{
+	const float dt = 1.f / 60.f;
+	for (NvFlowUint maxLevel = 0u; maxLevel <= CpuGridMaxLevel; maxLevel += CpuGridMaxLevel)
+	{
+		CpuGridDesc desc;
+		TestGridDescDefaults(&desc);
+		desc.numWorkers = 2u;
+		desc.maxLevel = maxLevel;
+
+		CpuGridLodParams lodParams;
+		CpuGridLodParamsDefaults(&lodParams);
+		lodParams.cameraPosition = { 0.f, -1.f, 0.f };
+		lodParams.levelDistance = maxLevel > 0u ? 0.5f : 0.f;
+
+		CpuGrid* grid = CpuGridCreate(&desc);
+		CpuGridSetLodParams(grid, &lodParams);
+		for (int frame = 0; frame < 20; frame++)
+		{
+			TestGridStep(grid, float(frame) * dt, dt);
+		}
+		std::vector<unsigned char> snapshot(CpuGridGetSnapshotSize(grid));
+		TEST_CHECK(!CpuGridSnapshot(grid, snapshot.data(), snapshot.size() - 1u));
+		TEST_CHECK(CpuGridSnapshot(grid, snapshot.data(), snapshot.size()));
+
+		NvFlowUint64 snapshotVelocity = 0u, snapshotDensity = 0u;
+		TestGridChecksum(grid, &snapshotVelocity, &snapshotDensity);
+		for (int frame = 20; frame < 35; frame++)
+		{
+			TestGridStep(grid, float(frame) * dt, dt);
+		}
+		NvFlowUint64 velocity = 0u, density = 0u;
+		TestGridChecksum(grid, &velocity, &density);
+		const NvFlowUint numBlocks = TestGridNumBlocks(grid);
+
+		// restore into a fresh grid with another worker count, and into the grid that ran ahead
+		desc.numWorkers = 3u;
+		CpuGrid* restored = CpuGridCreate(&desc);
+		CpuGrid* grids[2] = { restored, grid };
+		for (CpuGrid* target : grids)
+		{
+			TEST_CHECK(CpuGridRestore(target, snapshot.data(), snapshot.size()));
+
+			NvFlowUint64 restoredVelocity = 0u, restoredDensity = 0u;
+			TestGridChecksum(target, &restoredVelocity, &restoredDensity);
+			TEST_CHECK(restoredVelocity == snapshotVelocity);
+			TEST_CHECK(restoredDensity == snapshotDensity);
+
+			for (int frame = 20; frame < 35; frame++)
+			{
+				TestGridStep(target, float(frame) * dt, dt);
+			}
+			TestGridChecksum(target, &restoredVelocity, &restoredDensity);
+			TEST_CHECK(TestGridNumBlocks(target) == numBlocks);
+			TEST_CHECK(restoredVelocity == velocity);
+			TEST_CHECK(restoredDensity == density);
+		}
+
+		// a truncated snapshot is rejected
+		TEST_CHECK(!CpuGridRestore(restored, snapshot.data(), snapshot.size() / 2u));
+
+		CpuGridRelease(restored);
+		CpuGridRelease(grid);
+	}
+}
@@ -0,0 +1,142 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <vector>
+
+#include "test.h"
+#include "testGrid.h"
+#include "emitterCuller.h"
+
+namespace
+{
+	enum TestCullerEmitter
+	{
+		eTestCullerFireBall = 0,		//!< Allocates, inside the grid
+		eTestCullerFollower,			//!< Disabled allocation, over the fire ball blocks
+		eTestCullerIdle,				//!< Zero allocation scale, far from active blocks
+		eTestCullerFlat,				//!< Allocation scale zero on one axis only, far from active blocks
+		eTestCullerOutside,				//!< Allocates, outside the grid
+
+		eTestCullerCount
+	};
+
+	void TestCullerEmitters(float t, float dt, NvFlowShapeDesc* shapes, NvFlowGridEmitParams* params)
+	{
+		for (NvFlowUint idx = 0u; idx < eTestCullerCount; idx++)
+		{
+			TestGridFireBall(t, &shapes[idx], &params[idx]);
+			params[idx].deltaTime = dt;
+			params[idx].shapeRangeOffset = idx;
+		}
+
+		params[eTestCullerFollower].emitMode = eNvFlowGridEmitModeDisableAlloc;
+		params[eTestCullerFollower].smoke = 4.f;
+
+		const NvFlowFloat4 corner = { -1.6f, -1.6f, 1.6f, 1.f };
+		params[eTestCullerIdle].allocationScale = { 0.f, 0.f, 0.f };
+		params[eTestCullerIdle].localToWorld.w = corner;
+		params[eTestCullerIdle].bounds.w = corner;
+		params[eTestCullerFlat].allocationScale = { 1.f, 0.f, 1.f };
+		params[eTestCullerFlat].localToWorld.w = corner;
+		params[eTestCullerFlat].bounds.w = corner;
+
+		const NvFlowFloat4 outside = { 8.f, 0.f, 0.f, 1.f };
+		params[eTestCullerOutside].localToWorld.w = outside;
+		params[eTestCullerOutside].bounds.w = outside;
+	}
+}
+
+TEST_CASE(EmitterCullerMatchesUnculledEmit)
+{
+	const float dt = 1.f / 60.f;
+	CpuGridDesc desc;
+	TestGridDescDefaults(&desc);
+	desc.numWorkers = 1u;
+	CpuGrid* unculled = CpuGridCreate(&desc);
+	CpuGrid* culled = CpuGridCreate(&desc);
+
+	// the culler sees the blocks of the previous export, let the fire ball allocate first
+	const int warmUpFrames = 4;
+	for (int frame = 0; frame < warmUpFrames; frame++)
+	{
+		TestGridStep(unculled, float(frame) * dt, dt);
+		TestGridStep(culled, float(frame) * dt, dt);
+	}
+
+	EmitterCuller culler;
+	std::vector<unsigned char> visible;
+	NvFlowUint numMismatched = 0u;
+	NvFlowUint numVisible[eTestCullerCount] = {};
+	const int numFrames = 24;
+	for (int frame = warmUpFrames; frame < numFrames; frame++)
+	{
+		const float t = float(frame) * dt;
+		NvFlowShapeDesc shapes[eTestCullerCount];
+		NvFlowGridEmitParams params[eTestCullerCount];
+		TestCullerEmitters(t, dt, shapes, params);
+
+		CpuGridExport gridExport;
+		CpuGridGetExport(culled, &gridExport);
+		culler.updateGrid(gridExport.mapping);
+		culler.cull(params, eTestCullerCount, visible);
+
+		std::vector<NvFlowGridEmitParams> visibleParams;
+		for (NvFlowUint idx = 0u; idx < eTestCullerCount; idx++)
+		{
+			if (visible[idx])
+			{
+				visibleParams.push_back(params[idx]);
+				numVisible[idx]++;
+			}
+		}
+
+		CpuGridEmit(unculled, shapes, eTestCullerCount, params, eTestCullerCount);
+		CpuGridUpdate(unculled, dt);
+		CpuGridEmit(culled, shapes, eTestCullerCount, visibleParams.data(), NvFlowUint(visibleParams.size()));
+		CpuGridUpdate(culled, dt);
+
+		NvFlowUint64 velocity[2], density[2];
+		TestGridChecksum(unculled, &velocity[0], &density[0]);
+		TestGridChecksum(culled, &velocity[1], &density[1]);
+		if (velocity[0] != velocity[1] || density[0] != density[1])
+		{
+			numMismatched++;
+		}
+	}
+	TEST_CHECK(numMismatched == 0u);
+
+	// only emitters that can change the grid are submitted
+	const NvFlowUint numCompared = NvFlowUint(numFrames - warmUpFrames);
+	TEST_CHECK(numVisible[eTestCullerFireBall] == numCompared);
+	TEST_CHECK(numVisible[eTestCullerFollower] == numCompared);
+	TEST_CHECK(numVisible[eTestCullerIdle] == 0u);
+	TEST_CHECK(numVisible[eTestCullerFlat] == 0u);
+	TEST_CHECK(numVisible[eTestCullerOutside] == 0u);
+
+	CpuGridRelease(culled);
+	CpuGridRelease(unculled);
+}
@@ -0,0 +1,176 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <vector>
+
+#include "test.h"
+#include "testGrid.h"
+#include "emitterSet.h"
+
+namespace
+{
+	//! What the test expects an emitter to submit, smoke doubles as the emitter id
+	struct TestSetEmitter
+	{
+		EmitterHandle handle;
+		float smoke;
+		float radius;
+		bool transient;
+	};
+
+	void TestSetEmitterDesc(const TestSetEmitter& emitter, NvFlowShapeDesc* shape, NvFlowGridEmitParams* params)
+	{
+		TestGridFireBall(emitter.smoke, shape, params);
+		shape->sphere.radius = emitter.radius;
+		params->smoke = emitter.smoke;
+		params->deltaTime = emitter.transient ? 0.5f : 0.f;
+	}
+
+	TestSetEmitter TestSetAdd(EmitterSet& emitterSet, float smoke, float radius)
+	{
+		TestSetEmitter emitter = { EmitterHandle(), smoke, radius, false };
+		NvFlowShapeDesc shape;
+		NvFlowGridEmitParams params;
+		TestSetEmitterDesc(emitter, &shape, &params);
+		emitter.handle = emitterSet.add(shape, params);
+		return emitter;
+	}
+
+	//! Gathers and checks every expected emitter is submitted exactly once, with its own shape
+	bool TestSetSubmitMatches(EmitterSet& emitterSet, float dt, const std::vector<TestSetEmitter>& expected)
+	{
+		const NvFlowShapeDesc* shapes = nullptr;
+		const NvFlowGridEmitParams* params = nullptr;
+		NvFlowUint numEmitters = emitterSet.gather(dt, nullptr, &shapes, &params);
+		if (numEmitters != expected.size())
+		{
+			return false;
+		}
+		std::vector<unsigned char> found(expected.size(), 0u);
+		for (NvFlowUint idx = 0u; idx < numEmitters; idx++)
+		{
+			if (params[idx].shapeRangeOffset != idx || params[idx].shapeRangeSize != 1u)
+			{
+				return false;
+			}
+			NvFlowUint match = 0u;
+			while (match < expected.size() && expected[match].smoke != params[idx].smoke)
+			{
+				match++;
+			}
+			if (match == expected.size() || found[match] ||
+				shapes[idx].sphere.radius != expected[match].radius ||
+				params[idx].deltaTime != (expected[match].transient ? 0.5f : dt))
+			{
+				return false;
+			}
+			found[match] = 1u;
+		}
+		return true;
+	}
+}
+
+TEST_CASE(EmitterSetHandlesGoStale)
+{
+	EmitterSet emitterSet;
+	TestSetEmitter a = TestSetAdd(emitterSet, 1.f, 0.1f);
+	TestSetEmitter b = TestSetAdd(emitterSet, 2.f, 0.2f);
+	TEST_CHECK(emitterSet.isValid(a.handle) && emitterSet.isValid(b.handle));
+	TEST_CHECK(emitterSet.getParams(b.handle)->smoke == 2.f);
+
+	// a removed slot is reused under a new generation
+	TEST_CHECK(emitterSet.remove(a.handle));
+	TEST_CHECK(!emitterSet.remove(a.handle));
+	TestSetEmitter c = TestSetAdd(emitterSet, 3.f, 0.3f);
+	TEST_CHECK(c.handle.slot == a.handle.slot);
+	TEST_CHECK(!emitterSet.isValid(a.handle));
+	TEST_CHECK(emitterSet.getParams(a.handle) == nullptr);
+	TEST_CHECK(!emitterSet.update(a.handle, nullptr, nullptr));
+
+	// removing moved b's dense index, its handle still finds it
+	TEST_CHECK(emitterSet.getParams(b.handle)->smoke == 2.f);
+	TEST_CHECK(emitterSet.getParams(c.handle)->smoke == 3.f);
+
+	emitterSet.clear();
+	TEST_CHECK(emitterSet.size() == 0u);
+	TEST_CHECK(!emitterSet.isValid(b.handle) && !emitterSet.isValid(c.handle));
+
+	emitterSet.release();
+}
+
+TEST_CASE(EmitterSetSubmitTracksEdits)
+{
+	EmitterSet emitterSet;
+	std::vector<TestSetEmitter> expected;
+	for (NvFlowUint idx = 0u; idx < 4u; idx++)
+	{
+		expected.push_back(TestSetAdd(emitterSet, float(idx + 1u), 0.1f * float(idx + 1u)));
+	}
+	float dt = 1.f / 60.f;
+	TEST_CHECK(TestSetSubmitMatches(emitterSet, dt, expected));
+
+	// dirty entries only, shape and params separately
+	expected[1].radius = 0.15f;
+	NvFlowShapeDesc shape;
+	NvFlowGridEmitParams params;
+	TestSetEmitterDesc(expected[1], &shape, &params);
+	TEST_CHECK(emitterSet.update(expected[1].handle, &shape, nullptr));
+	expected[3].smoke = 7.f;
+	TestSetEmitterDesc(expected[3], &shape, &params);
+	TEST_CHECK(emitterSet.update(expected[3].handle, nullptr, &params));
+	TEST_CHECK(TestSetSubmitMatches(emitterSet, dt, expected));
+
+	// removal from the middle reorders the dense arrays
+	TEST_CHECK(emitterSet.remove(expected[0].handle));
+	expected.erase(expected.begin());
+	TEST_CHECK(TestSetSubmitMatches(emitterSet, dt, expected));
+
+	// a new dt reaches clean entries too
+	dt = 1.f / 30.f;
+	TEST_CHECK(TestSetSubmitMatches(emitterSet, dt, expected));
+
+	// transients keep their own deltaTime and last one submit
+	TestSetEmitter transient = { EmitterHandle(), 9.f, 0.4f, true };
+	TestSetEmitterDesc(transient, &shape, &params);
+	emitterSet.emitTransient(shape, params);
+	expected[0].smoke = 8.f;
+	TestSetEmitterDesc(expected[0], &shape, &params);
+	TEST_CHECK(emitterSet.update(expected[0].handle, nullptr, &params));
+	expected.push_back(transient);
+	TEST_CHECK(TestSetSubmitMatches(emitterSet, dt, expected));
+	expected.pop_back();
+	TEST_CHECK(TestSetSubmitMatches(emitterSet, dt, expected));
+
+	expected.push_back(TestSetAdd(emitterSet, 10.f, 0.5f));
+	TEST_CHECK(TestSetSubmitMatches(emitterSet, dt, expected));
+
+	emitterSet.clear();
+	expected.clear();
+	TEST_CHECK(TestSetSubmitMatches(emitterSet, dt, expected));
+
+	emitterSet.release();
+}
@@ -0,0 +1,88 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+
+#pragma once
+
+#include <math.h>
+
+#include "cpuGrid.h"
+#include "gridChecksum.h"
+
+// Shared setup for the tests that step a CpuGrid: a small grid and a moving fire ball emitter.
+
+inline void TestGridDescDefaults(CpuGridDesc* desc)
+{
+	CpuGridDescDefaults(desc);
+	desc->gridDesc.virtualDim = { 64u, 64u, 64u };
+	desc->gridDesc.residentScale = 0.5f;
+	desc->pressureIterations = 8u;
+}
+
+//! Fire ball emit params and shape at time t, the emitter circles so blocks come and go
+inline void TestGridFireBall(float t, NvFlowShapeDesc* shape, NvFlowGridEmitParams* params)
+{
+	const float radius = 0.25f;
+	const NvFlowFloat3 center = { 0.75f * cosf(2.f * t), -1.f, 0.75f * sinf(2.f * t) };
+
+	shape->sphere.radius = radius;
+
+	CpuGridEmitParamsDefaults(params);
+	params->localToWorld.w = { center.x, center.y, center.z, 1.f };
+	params->bounds.x.x = 2.f * radius;
+	params->bounds.y.y = 2.f * radius;
+	params->bounds.z.z = 2.f * radius;
+	params->bounds.w = { center.x, center.y, center.z, 1.f };
+	params->velocityLinear = { 0.f, 2.f, 0.f };
+	params->temperature = 2.f;
+	params->fuel = 1.5f;
+	params->smoke = 1.f;
+}
+
+inline void TestGridStep(CpuGrid* grid, float t, float dt)
+{
+	NvFlowShapeDesc shape;
+	NvFlowGridEmitParams params;
+	TestGridFireBall(t, &shape, &params);
+	params.deltaTime = dt;
+	CpuGridEmit(grid, &shape, 1u, &params, 1u);
+	CpuGridUpdate(grid, dt);
+}
+
+inline void TestGridChecksum(CpuGrid* grid, NvFlowUint64* velocity, NvFlowUint64* density)
+{
+	CpuGridExport gridExport;
+	CpuGridGetExport(grid, &gridExport);
+	GridChecksumCpuGrid(&gridExport, velocity, density);
+}
+
+inline NvFlowUint TestGridNumBlocks(CpuGrid* grid)
+{
+	CpuGridExport gridExport;
+	CpuGridGetExport(grid, &gridExport);
+	return gridExport.numBlocks;
+}
@@ -0,0 +1,183 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include "test.h"
+#include "testGrid.h"
+#include "gridBudget.h"
+
+namespace
+{
+	//! Material params with distinct thresholds, one of them zero
+	void TestBudgetMaterial(NvFlowGridMaterialParams* params)
+	{
+		CpuGridMaterialParamsDefaults(params);
+		params->velocity.allocThreshold = 0.1f;
+		params->smoke.allocThreshold = 0.2f;
+		params->temperature.allocThreshold = 0.f;
+		params->fuel.allocThreshold = 0.4f;
+		params->velocity.allocWeight = 1.f;
+		params->smoke.allocWeight = 1.f;
+		params->temperature.allocWeight = 1.f;
+		params->fuel.allocWeight = 1.f;
+	}
+
+	//! Fraction of full pressure each component received, from its allocWeight
+	void TestBudgetShares(const GridBudget& budget, float shares[eGridBudgetComponentCount])
+	{
+		NvFlowGridMaterialParams params;
+		TestBudgetMaterial(&params);
+		budget.apply(&params);
+		const NvFlowGridMaterialPerComponent* components[eGridBudgetComponentCount] = {
+			&params.velocity, &params.smoke, &params.temperature, &params.fuel
+		};
+		for (int idx = 0; idx < eGridBudgetComponentCount; idx++)
+		{
+			shares[idx] = (1.f - components[idx]->allocWeight) / (1.f - budget.m_policy.minWeightScale);
+		}
+	}
+}
+
+TEST_CASE(GridBudgetPressureRaisesThresholdsByPriority)
+{
+	GridBudget budget;
+	const float tol = 1e-6f;
+
+	// no pressure leaves the user params alone
+	NvFlowGridMaterialParams params;
+	TestBudgetMaterial(&params);
+	budget.apply(&params);
+	TEST_CHECK(params.temperature.allocThreshold == 0.f);
+	TEST_CHECK(params.fuel.allocThreshold == 0.4f);
+
+	// default priorities give way fuel, temperature, velocity, smoke, a quarter of the pressure each
+	float shares[eGridBudgetComponentCount];
+	budget.m_pressure = 0.25f;
+	TestBudgetShares(budget, shares);
+	TEST_CHECK_NEAR(shares[eGridBudgetFuel], 1.f, tol);
+	TEST_CHECK_NEAR(shares[eGridBudgetTemperature], 0.f, tol);
+	TEST_CHECK_NEAR(shares[eGridBudgetVelocity], 0.f, tol);
+	TEST_CHECK_NEAR(shares[eGridBudgetSmoke], 0.f, tol);
+
+	budget.m_pressure = 0.625f;
+	TestBudgetShares(budget, shares);
+	TEST_CHECK_NEAR(shares[eGridBudgetFuel], 1.f, tol);
+	TEST_CHECK_NEAR(shares[eGridBudgetTemperature], 1.f, tol);
+	TEST_CHECK_NEAR(shares[eGridBudgetVelocity], 0.5f, tol);
+	TEST_CHECK_NEAR(shares[eGridBudgetSmoke], 0.f, tol);
+
+	// full pressure scales every threshold, a zero threshold starts from the minimum
+	budget.m_pressure = 1.f;
+	TestBudgetMaterial(&params);
+	budget.apply(&params);
+	const float maxScale = budget.m_policy.maxThresholdScale;
+	TEST_CHECK_NEAR(params.velocity.allocThreshold, 0.1f * maxScale, tol);
+	TEST_CHECK_NEAR(params.smoke.allocThreshold, 0.2f * maxScale, tol);
+	TEST_CHECK_NEAR(params.temperature.allocThreshold, 0.01f * maxScale, tol);
+	TEST_CHECK_NEAR(params.fuel.allocThreshold, 0.4f * maxScale, tol);
+	TEST_CHECK_NEAR(params.smoke.allocWeight, budget.m_policy.minWeightScale, tol);
+
+	// a custom policy reorders, equal priorities go in component order
+	budget.m_policy.priority[eGridBudgetVelocity] = 0.f;
+	budget.m_policy.priority[eGridBudgetSmoke] = 0.f;
+	budget.m_policy.priority[eGridBudgetTemperature] = 5.f;
+	budget.m_policy.priority[eGridBudgetFuel] = 5.f;
+	budget.m_pressure = 0.375f;
+	TestBudgetShares(budget, shares);
+	TEST_CHECK_NEAR(shares[eGridBudgetVelocity], 1.f, tol);
+	TEST_CHECK_NEAR(shares[eGridBudgetSmoke], 0.5f, tol);
+	TEST_CHECK_NEAR(shares[eGridBudgetTemperature], 0.f, tol);
+	TEST_CHECK_NEAR(shares[eGridBudgetFuel], 0.f, tol);
+
+	// disabled, nothing is applied
+	budget.m_enabled = false;
+	TestBudgetMaterial(&params);
+	budget.apply(&params);
+	TEST_CHECK(params.velocity.allocThreshold == 0.1f);
+}
+
+TEST_CASE(GridBudgetPressureFollowsOccupancy)
+{
+	GridBudget budget;
+	const float dt = 1.f / 60.f;
+
+	// above high water pressure builds until saturated, the fuller channel counts
+	NvFlowUint frame = 0u;
+	for (; frame < 600u && !budget.m_statSaturated; frame++)
+	{
+		budget.updateOccupancy(500u, 1000u);
+		budget.updateOccupancy(1000u, 1000u);
+		float pressure = budget.m_pressure;
+		budget.update(dt);
+		TEST_CHECK(budget.m_pressure > pressure || budget.m_pressure == 1.f);
+	}
+	TEST_CHECK(budget.m_statSaturated);
+	TEST_CHECK(budget.m_pressure == 1.f);
+	TEST_CHECK(frame < 600u);
+
+	// between the water marks pressure holds
+	budget.updateOccupancy(800u, 1000u);
+	budget.update(dt);
+	TEST_CHECK(budget.m_pressure == 1.f);
+	TEST_CHECK(!budget.m_statSaturated && budget.m_statSaturatedFrames == 0u);
+
+	// below low water it releases at the response rate
+	budget.updateOccupancy(100u, 1000u);
+	budget.update(dt);
+	TEST_CHECK_NEAR(budget.m_pressure, 1.f - budget.m_policy.response * dt, 1e-6f);
+
+	// occupancy is consumed by each update, no feed counts as empty
+	for (frame = 0u; frame < 600u && budget.m_pressure > 0.f; frame++)
+	{
+		budget.update(dt);
+	}
+	TEST_CHECK(budget.m_pressure == 0.f);
+
+	budget.m_pressure = 0.5f;
+	budget.m_enabled = false;
+	budget.update(dt);
+	TEST_CHECK(budget.m_pressure == 0.f);
+}
+
+TEST_CASE(GridBudgetResidentScaleFitsTheBudget)
+{
+	GridBudget budget;
+	NvFlowGridDesc gridDesc = {};
+	gridDesc.virtualDim = { 256u, 256u, 256u };
+	gridDesc.densityMultiRes = eNvFlowMultiRes1x1x1;
+
+	float scale = budget.residentScale(gridDesc);
+	TEST_CHECK(scale > 0.f && scale < 1.f);
+	TEST_CHECK_NEAR(double(budget.poolBytes(gridDesc, scale)), double(budget.m_budgetBytes), 0.001 * double(budget.m_budgetBytes));
+
+	// finer density costs more per cell
+	gridDesc.densityMultiRes = eNvFlowMultiRes2x2x2;
+	TEST_CHECK(budget.residentScale(gridDesc) < scale);
+
+	// a budget larger than the grid clamps to fully resident
+	budget.m_budgetBytes = size_t(1) << 40u;
+	TEST_CHECK(budget.residentScale(gridDesc) == 1.f);
+}
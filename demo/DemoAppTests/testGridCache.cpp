@@ -0,0 +1,453 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+
+#include <string.h>
+
+#include <vector>
+
+#include "NvFlowShaderCPU.h"
+
+#include "test.h"
+#include "testGrid.h"
+#include "gridCache.h"
+
+namespace
+{
+	const char* testCacheFile = "testGridCache.nfgc";
+	const char* testCorruptFile = "testGridCacheCorrupt.nfgc";
+
+	FILE* openFile(const char* filename, const char* mode)
+	{
+#if defined(_WIN32)
+		FILE* file = nullptr;
+		fopen_s(&file, filename, mode);
+		return file;
+#else
+		return fopen(filename, mode);
+#endif
+	}
+
+	std::vector<unsigned char> readFile(const char* filename)
+	{
+		std::vector<unsigned char> data;
+		FILE* file = openFile(filename, "rb");
+		if (file)
+		{
+			fseek(file, 0, SEEK_END);
+			data.resize(size_t(ftell(file)));
+			fseek(file, 0, SEEK_SET);
+			size_t numRead = fread(data.data(), 1u, data.size(), file);
+			data.resize(numRead);
+			fclose(file);
+		}
+		return data;
+	}
+
+	void writeFile(const char* filename, const std::vector<unsigned char>& data)
+	{
+		FILE* file = openFile(filename, "wb");
+		if (file)
+		{
+			fwrite(data.data(), 1u, data.size(), file);
+			fclose(file);
+		}
+	}
+
+	//! Cells of each active block in block list order, looked up through NvFlowCPU_virtualToRealLod()
+	void exportBlockCells(const CpuGridExport& gridExport, const NvFlowFloat4* pool, std::vector<NvFlowFloat4>* cells)
+	{
+		const NvFlowShaderLinearParams& params = gridExport.mapping.shaderParams;
+		cells->clear();
+		for (NvFlowUint blockIdx = 0u; blockIdx < gridExport.mapping.layeredNumBlocks; blockIdx++)
+		{
+			NvFlowInt3 vBlockIdx = NvFlowCPU_tableVal_to_coord(gridExport.mapping.layeredBlockListCPU[blockIdx].x);
+			for (NvFlowUint k = 0u; k < params.blockDim.z; k++)
+			{
+				for (NvFlowUint j = 0u; j < params.blockDim.y; j++)
+				{
+					for (NvFlowUint i = 0u; i < params.blockDim.x; i++)
+					{
+						NvFlowInt3 vidx = {
+							int(vBlockIdx.x * params.blockDim.x + i),
+							int(vBlockIdx.y * params.blockDim.y + j),
+							int(vBlockIdx.z * params.blockDim.z + k)
+						};
+						NvFlowInt3 ridx = NvFlowCPU_virtualToRealLod(gridExport.blockTable, params, vidx);
+						cells->push_back(pool[(size_t(ridx.z) * gridExport.poolDim.y + ridx.y) * gridExport.poolDim.x + ridx.x]);
+					}
+				}
+			}
+		}
+	}
+
+	//! Three 4x4x4 blocks in a row, one per codec: constant, two runs, noise
+	void writeCodecCache(const char* filename)
+	{
+		const NvFlowUint numBlocks = 3u;
+		const NvFlowUint numCells = 64u;
+		std::vector<NvFlowFloat4> pool(numBlocks * numCells);
+		std::vector<NvFlowUint> blockTable(numBlocks);
+		std::vector<NvFlowUint2> blockList(numBlocks);
+		for (NvFlowUint blockIdx = 0u; blockIdx < numBlocks; blockIdx++)
+		{
+			blockTable[blockIdx] = NvFlowCPU_coord_to_tableVal(blockIdx, 0u, 0u);
+			blockList[blockIdx] = { NvFlowCPU_coord_to_tableVal(blockIdx, 0u, 0u), 0u };
+		}
+		for (NvFlowUint k = 0u; k < 4u; k++)
+		{
+			for (NvFlowUint j = 0u; j < 4u; j++)
+			{
+				for (NvFlowUint i = 0u; i < 4u * numBlocks; i++)
+				{
+					NvFlowUint blockIdx = i / 4u;
+					float v = blockIdx == 0u ? 1.f : blockIdx == 1u ? float(k >= 2u) : float((i * 7u + j * 13u + k * 29u) % 17u);
+					pool[(k * 4u + j) * 4u * numBlocks + i] = { v, -v, 0.5f * v, 1.f };
+				}
+			}
+		}
+
+		GridCacheDesc desc = {};
+		desc.numChannels = 1u;
+		desc.blockDim[0] = desc.blockDim[1] = desc.blockDim[2] = 4u;
+		desc.gridDim[0] = numBlocks;
+		desc.gridDim[1] = desc.gridDim[2] = 1u;
+
+		GridCacheLayerSource layer = {};
+		layer.blockTable = blockTable.data();
+		layer.channelData[0] = pool.data();
+
+		GridCacheFrameSource frame = {};
+		frame.poolDim = { 4u * numBlocks, 4u, 4u };
+		frame.blockList = blockList.data();
+		frame.numBlocks = numBlocks;
+		frame.layers = &layer;
+		frame.numLayers = 1u;
+
+		GridCacheWriter* writer = GridCacheWriterCreate(filename, &desc);
+		GridCacheWriterAddFrame(writer, &frame);
+		GridCacheWriterRelease(writer);
+	}
+
+	struct CodecBlockOffsets
+	{
+		size_t blockOffsets;				//!< File offset of the block offset table
+		size_t payload[3];					//!< File offset of each payload header
+	};
+
+	bool findCodecBlocks(const char* filename, CodecBlockOffsets* offsets)
+	{
+		GridCacheReader* reader = GridCacheReaderOpen(filename);
+		if (reader == nullptr)
+		{
+			return false;
+		}
+		GridCacheFrameView view;
+		bool ok = GridCacheReaderGetFrame(reader, 0u, &view);
+		if (ok)
+		{
+			const size_t frameOffset = size_t(GridCacheReaderGetFrameIndex(reader, 0u)->offset);
+			offsets->blockOffsets = frameOffset + size_t((const unsigned char*)view.blockOffsets - view.base);
+			for (NvFlowUint blockIdx = 0u; blockIdx < 3u; blockIdx++)
+			{
+				offsets->payload[blockIdx] = frameOffset + view.blockOffsets[blockIdx];
+			}
+		}
+		GridCacheReaderRelease(reader);
+		return ok;
+	}
+
+	//! Decodes every block of frame 0 of the given file, false if any block is rejected
+	NvFlowUint countDecodedBlocks(const char* filename)
+	{
+		GridCacheReader* reader = GridCacheReaderOpen(filename);
+		if (reader == nullptr)
+		{
+			return 0u;
+		}
+		NvFlowUint numDecoded = 0u;
+		GridCacheFrameView view;
+		if (GridCacheReaderGetFrame(reader, 0u, &view))
+		{
+			std::vector<NvFlowFloat4> cells(GridCacheReaderGetHeader(reader)->blockDim.w);
+			for (NvFlowUint blockIdx = 0u; blockIdx < view.header->numBlocks; blockIdx++)
+			{
+				if (GridCacheReaderDecodeBlock(reader, &view, 0u, blockIdx, cells.data()))
+				{
+					numDecoded++;
+				}
+			}
+		}
+		GridCacheReaderRelease(reader);
+		return numDecoded;
+	}
+}
+
+TEST_CASE(GridCacheRoundTripMatchesCpuGrid)
+{
+	const float dt = 1.f / 60.f;
+	const NvFlowUint numFrames = 6u;
+
+	CpuGridDesc desc;
+	TestGridDescDefaults(&desc);
+	desc.numWorkers = 1u;
+	CpuGrid* grid = CpuGridCreate(&desc);
+
+	CpuGridExport gridExport;
+	CpuGridGetExport(grid, &gridExport);
+	const NvFlowShaderLinearParams& params = gridExport.mapping.shaderParams;
+
+	GridCacheDesc cacheDesc = {};
+	cacheDesc.numChannels = 2u;
+	cacheDesc.blockDim[0] = params.blockDim.x;
+	cacheDesc.blockDim[1] = params.blockDim.y;
+	cacheDesc.blockDim[2] = params.blockDim.z;
+	cacheDesc.gridDim[0] = params.gridDim.x;
+	cacheDesc.gridDim[1] = params.gridDim.y;
+	cacheDesc.gridDim[2] = params.gridDim.z;
+	GridCacheWriter* writer = GridCacheWriterCreate(testCacheFile, &cacheDesc);
+	TEST_CHECK(writer != nullptr);
+	if (writer == nullptr)
+	{
+		CpuGridRelease(grid);
+		return;
+	}
+
+	std::vector<NvFlowUint2> expectedBlockList[numFrames];
+	std::vector<NvFlowFloat4> expectedCells[numFrames][2];
+	for (NvFlowUint frameIdx = 0u; frameIdx < numFrames; frameIdx++)
+	{
+		for (int step = 0; step < 5; step++)
+		{
+			TestGridStep(grid, float(frameIdx * 5u + step) * dt, dt);
+		}
+		CpuGridGetExport(grid, &gridExport);
+		TEST_CHECK(GridCacheWriterAddCpuGridFrame(writer, &gridExport, float(frameIdx)));
+
+		expectedBlockList[frameIdx].assign(gridExport.mapping.layeredBlockListCPU, gridExport.mapping.layeredBlockListCPU + gridExport.mapping.layeredNumBlocks);
+		exportBlockCells(gridExport, gridExport.velocity, &expectedCells[frameIdx][0]);
+		exportBlockCells(gridExport, gridExport.density, &expectedCells[frameIdx][1]);
+	}
+	TEST_CHECK(GridCacheWriterRelease(writer));
+	CpuGridRelease(grid);
+
+	GridCacheReader* reader = GridCacheReaderOpen(testCacheFile);
+	TEST_CHECK(reader != nullptr);
+	if (reader == nullptr)
+	{
+		return;
+	}
+	TEST_CHECK(GridCacheReaderGetNumFrames(reader) == numFrames);
+	const NvFlowUint numCells = GridCacheReaderGetHeader(reader)->blockDim.w;
+
+	std::vector<NvFlowFloat4> cells(numCells);
+	for (NvFlowUint frameIdx = 0u; frameIdx < numFrames; frameIdx++)
+	{
+		GridCacheFrameView view;
+		TEST_CHECK(GridCacheReaderGetFrame(reader, frameIdx, &view));
+		TEST_CHECK(view.header->time == float(frameIdx));
+		TEST_CHECK(view.header->numBlocks == expectedBlockList[frameIdx].size());
+		if (view.header->numBlocks != expectedBlockList[frameIdx].size())
+		{
+			continue;
+		}
+		TEST_CHECK(view.header->numBlocks > 0u);
+
+		NvFlowUint numMismatched = 0u;
+		for (NvFlowUint channelIdx = 0u; channelIdx < 2u; channelIdx++)
+		{
+			for (NvFlowUint blockIdx = 0u; blockIdx < view.header->numBlocks; blockIdx++)
+			{
+				TEST_CHECK(view.blockList[blockIdx].x == expectedBlockList[frameIdx][blockIdx].x);
+				TEST_CHECK(GridCacheReaderDecodeBlock(reader, &view, channelIdx, blockIdx, cells.data()));
+				if (memcmp(cells.data(), &expectedCells[frameIdx][channelIdx][blockIdx * numCells], numCells * sizeof(NvFlowFloat4)) != 0)
+				{
+					numMismatched++;
+				}
+			}
+		}
+		TEST_CHECK(numMismatched == 0u);
+	}
+	GridCacheReaderRelease(reader);
+	remove(testCacheFile);
+}
+
+TEST_CASE(GridCacheWriterReportsFailedWrites)
+{
+#if !defined(_WIN32)
+	// every write to /dev/full fails once it reaches the device, at the latest when release flushes
+	const float dt = 1.f / 60.f;
+	CpuGridDesc desc;
+	TestGridDescDefaults(&desc);
+	desc.numWorkers = 1u;
+	CpuGrid* grid = CpuGridCreate(&desc);
+	TestGridStep(grid, 0.f, dt);
+
+	CpuGridExport gridExport;
+	CpuGridGetExport(grid, &gridExport);
+	const NvFlowShaderLinearParams& params = gridExport.mapping.shaderParams;
+
+	GridCacheDesc cacheDesc = {};
+	cacheDesc.numChannels = 2u;
+	cacheDesc.blockDim[0] = params.blockDim.x;
+	cacheDesc.blockDim[1] = params.blockDim.y;
+	cacheDesc.blockDim[2] = params.blockDim.z;
+	cacheDesc.gridDim[0] = params.gridDim.x;
+	cacheDesc.gridDim[1] = params.gridDim.y;
+	cacheDesc.gridDim[2] = params.gridDim.z;
+	GridCacheWriter* writer = GridCacheWriterCreate("/dev/full", &cacheDesc);
+	TEST_CHECK(writer != nullptr);
+	if (writer != nullptr)
+	{
+		// frames past the stdio buffer fail in the add, and every add after that fails too
+		bool added[3];
+		for (NvFlowUint frameIdx = 0u; frameIdx < 3u; frameIdx++)
+		{
+			added[frameIdx] = GridCacheWriterAddCpuGridFrame(writer, &gridExport, float(frameIdx));
+		}
+		TEST_CHECK(!added[2]);
+		TEST_CHECK(!GridCacheWriterRelease(writer));
+	}
+	CpuGridRelease(grid);
+#endif
+}
+
+TEST_CASE(GridCacheDecodesEachCodec)
+{
+	writeCodecCache(testCacheFile);
+
+	GridCacheReader* reader = GridCacheReaderOpen(testCacheFile);
+	TEST_CHECK(reader != nullptr);
+	if (reader == nullptr)
+	{
+		return;
+	}
+	GridCacheFrameView view;
+	TEST_CHECK(GridCacheReaderGetFrame(reader, 0u, &view));
+
+	const GridCacheBlockHeader* headers[3];
+	for (NvFlowUint blockIdx = 0u; blockIdx < 3u; blockIdx++)
+	{
+		headers[blockIdx] = (const GridCacheBlockHeader*)(view.base + view.blockOffsets[blockIdx]);
+	}
+	TEST_CHECK(headers[0]->codec == eGridCacheCodecConstant);
+	TEST_CHECK(headers[1]->codec == eGridCacheCodecRLE);
+	TEST_CHECK(headers[2]->codec == eGridCacheCodecRaw);
+	TEST_CHECK(GridCacheReaderGetBlockRaw(reader, &view, 0u, 0u) == nullptr);
+	TEST_CHECK(GridCacheReaderGetBlockRaw(reader, &view, 0u, 2u) != nullptr);
+
+	NvFlowFloat4 cells[64];
+	TEST_CHECK(GridCacheReaderDecodeBlock(reader, &view, 0u, 0u, cells));
+	TEST_CHECK(cells[0].x == 1.f && cells[63].x == 1.f);
+	TEST_CHECK(GridCacheReaderDecodeBlock(reader, &view, 0u, 1u, cells));
+	TEST_CHECK(cells[31].x == 0.f && cells[32].x == 1.f && cells[63].y == -1.f);
+	TEST_CHECK(GridCacheReaderDecodeBlock(reader, &view, 0u, 2u, cells));
+	TEST_CHECK(cells[5].x == float((9u * 7u + 1u * 13u + 0u * 29u) % 17u));
+
+	GridCacheReaderRelease(reader);
+	remove(testCacheFile);
+}
+
+TEST_CASE(GridCacheRejectsCorruptPayloads)
+{
+	writeCodecCache(testCacheFile);
+	const std::vector<unsigned char> original = readFile(testCacheFile);
+	CodecBlockOffsets offsets = {};
+	if (!TEST_CHECK(findCodecBlocks(testCacheFile, &offsets)))
+	{
+		return;
+	}
+	TEST_CHECK(countDecodedBlocks(testCacheFile) == 3u);
+
+	// block offset past the end of the frame
+	std::vector<unsigned char> data = original;
+	NvFlowUint badOffset = 0x7FFFFFF0;
+	memcpy(&data[offsets.blockOffsets + 2u * sizeof(NvFlowUint)], &badOffset, sizeof(badOffset));
+	writeFile(testCorruptFile, data);
+	TEST_CHECK(countDecodedBlocks(testCorruptFile) == 2u);
+	{
+		GridCacheReader* reader = GridCacheReaderOpen(testCorruptFile);
+		GridCacheFrameView view;
+		TEST_CHECK(reader != nullptr && GridCacheReaderGetFrame(reader, 0u, &view));
+		if (reader)
+		{
+			TEST_CHECK(GridCacheReaderGetBlockRaw(reader, &view, 0u, 2u) == nullptr);
+			GridCacheReaderRelease(reader);
+		}
+	}
+
+	// payload size larger than the frame
+	data = original;
+	GridCacheBlockHeader* rleHeader = (GridCacheBlockHeader*)&data[offsets.payload[1]];
+	rleHeader->sizeInBytes += 4096u;
+	writeFile(testCorruptFile, data);
+	TEST_CHECK(countDecodedBlocks(testCorruptFile) == 2u);
+
+	// raw payload too small for a block
+	data = original;
+	GridCacheBlockHeader* rawHeader = (GridCacheBlockHeader*)&data[offsets.payload[2]];
+	rawHeader->sizeInBytes = sizeof(NvFlowFloat4);
+	writeFile(testCorruptFile, data);
+	TEST_CHECK(countDecodedBlocks(testCorruptFile) == 2u);
+
+	// run longer than the block
+	data = original;
+	NvFlowUint badCount = 1000u;
+	memcpy(&data[offsets.payload[1] + sizeof(GridCacheBlockHeader)], &badCount, sizeof(badCount));
+	writeFile(testCorruptFile, data);
+	TEST_CHECK(countDecodedBlocks(testCorruptFile) == 2u);
+
+	// block coordinate past the grid, an upload would write outside the block table
+	data = original;
+	{
+		GridCacheReader* reader = GridCacheReaderOpen(testCacheFile);
+		GridCacheFrameView view;
+		if (TEST_CHECK(reader != nullptr && GridCacheReaderGetFrame(reader, 0u, &view)))
+		{
+			const NvFlowUint64 blockListOffset = GridCacheReaderGetFrameIndex(reader, 0u)->offset + NvFlowUint64((const unsigned char*)view.blockList - view.base);
+			const NvFlowUint outside = NvFlowCPU_coord_to_tableVal(GridCacheReaderGetHeader(reader)->gridDim.x, 0u, 0u);
+			memcpy(&data[size_t(blockListOffset) + sizeof(NvFlowUint2)], &outside, sizeof(outside));
+		}
+		GridCacheReaderRelease(reader);
+	}
+	writeFile(testCorruptFile, data);
+	{
+		GridCacheReader* reader = GridCacheReaderOpen(testCorruptFile);
+		GridCacheFrameView view;
+		TEST_CHECK(reader != nullptr && !GridCacheReaderGetFrame(reader, 0u, &view));
+		GridCacheReaderRelease(reader);
+	}
+
+	// truncated before the frame index
+	data = original;
+	data.resize(data.size() / 2u);
+	writeFile(testCorruptFile, data);
+	TEST_CHECK(GridCacheReaderOpen(testCorruptFile) == nullptr);
+
+	remove(testCorruptFile);
+	remove(testCacheFile);
+}
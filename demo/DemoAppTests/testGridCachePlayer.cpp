@@ -0,0 +1,153 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+
+#include <chrono>
+#include <thread>
+
+#include "test.h"
+#include "testGrid.h"
+#include "gridCache.h"
+#include "gridCachePlayer.h"
+
+namespace
+{
+	const char* testPlayerFile = "testGridCachePlayer.nfgc";
+
+	//! Frames half a second apart, a few steps each
+	void writePlayerCache(NvFlowUint numFrames)
+	{
+		const float dt = 1.f / 60.f;
+
+		CpuGridDesc desc;
+		TestGridDescDefaults(&desc);
+		desc.gridDesc.virtualDim = { 32u, 32u, 32u };
+		desc.numWorkers = 1u;
+		CpuGrid* grid = CpuGridCreate(&desc);
+
+		CpuGridExport gridExport;
+		CpuGridGetExport(grid, &gridExport);
+		const NvFlowShaderLinearParams& params = gridExport.mapping.shaderParams;
+
+		GridCacheDesc cacheDesc = {};
+		cacheDesc.numChannels = 2u;
+		cacheDesc.blockDim[0] = params.blockDim.x;
+		cacheDesc.blockDim[1] = params.blockDim.y;
+		cacheDesc.blockDim[2] = params.blockDim.z;
+		cacheDesc.gridDim[0] = params.gridDim.x;
+		cacheDesc.gridDim[1] = params.gridDim.y;
+		cacheDesc.gridDim[2] = params.gridDim.z;
+		GridCacheWriter* writer = GridCacheWriterCreate(testPlayerFile, &cacheDesc);
+		for (NvFlowUint frameIdx = 0u; frameIdx < numFrames; frameIdx++)
+		{
+			for (int step = 0; step < 3; step++)
+			{
+				TestGridStep(grid, float(frameIdx * 3u + step) * dt, dt);
+			}
+			CpuGridGetExport(grid, &gridExport);
+			GridCacheWriterAddCpuGridFrame(writer, &gridExport, 0.5f * float(frameIdx));
+		}
+		GridCacheWriterRelease(writer);
+		CpuGridRelease(grid);
+	}
+
+	bool waitFrameReady(GridCachePlayer* player)
+	{
+		for (int attempt = 0; attempt < 500; attempt++)
+		{
+			if (GridCachePlayerIsFrameReady(player))
+			{
+				return true;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		return false;
+	}
+}
+
+TEST_CASE(GridCachePlayerFindsFramesByTime)
+{
+	writePlayerCache(8u);
+
+	GridCachePlayerDesc desc;
+	GridCachePlayerDescDefaults(&desc);
+	GridCachePlayer* player = GridCachePlayerCreate(testPlayerFile, &desc);
+	TEST_CHECK(player != nullptr);
+	if (player)
+	{
+		TEST_CHECK(GridCachePlayerGetNumFrames(player) == 8u);
+		TEST_CHECK(GridCachePlayerFindFrame(player, -1.f) == 0u);
+		TEST_CHECK(GridCachePlayerFindFrame(player, 1.2f) == 2u);
+		TEST_CHECK(GridCachePlayerFindFrame(player, 1.5f) == 3u);
+		TEST_CHECK(GridCachePlayerFindFrame(player, 100.f) == 7u);
+		GridCachePlayerRelease(player);
+	}
+	remove(testPlayerFile);
+}
+
+TEST_CASE(GridCachePlayerPrefetchFollowsSeeks)
+{
+	writePlayerCache(8u);
+
+	GridCachePlayerDesc desc;
+	GridCachePlayerDescDefaults(&desc);
+	desc.numPrefetchFrames = 2u;
+	GridCachePlayer* player = GridCachePlayerCreate(testPlayerFile, &desc);
+	TEST_CHECK(player != nullptr);
+	if (player)
+	{
+		TEST_CHECK(waitFrameReady(player));
+
+		// playback order, each frame is decoded ahead of its seek
+		for (NvFlowUint frameIdx = 1u; frameIdx < 12u; frameIdx++)
+		{
+			GridCachePlayerSeek(player, frameIdx);
+			TEST_CHECK(GridCachePlayerGetFrame(player) == frameIdx % 8u);
+			TEST_CHECK(waitFrameReady(player));
+		}
+
+		// a jump past the prefetch window decodes from scratch
+		GridCachePlayerSeek(player, 5u);
+		TEST_CHECK(waitFrameReady(player));
+
+		GridCachePlayerStats stats;
+		GridCachePlayerGetStats(player, &stats);
+		TEST_CHECK(stats.numFramesDecoded >= 8u);
+		GridCachePlayerRelease(player);
+	}
+
+	desc.loop = false;
+	player = GridCachePlayerCreate(testPlayerFile, &desc);
+	if (player)
+	{
+		GridCachePlayerSeek(player, 20u);
+		TEST_CHECK(GridCachePlayerGetFrame(player) == 7u);
+		TEST_CHECK(waitFrameReady(player));
+		GridCachePlayerRelease(player);
+	}
+	remove(testPlayerFile);
+}
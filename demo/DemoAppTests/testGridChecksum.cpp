@@ -0,0 +1,82 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <string.h>
+
+#include "test.h"
+#include "gridChecksum.h"
+
+namespace
+{
+	//! Layered block list in the order GridChecksumSortLayeredBlockList() must produce
+	const NvFlowUint2 testSortedBlocks[] = {
+		{ ~(1u), 0u },									// layer 0, (1, 0, 0)
+		{ ~(2u), 0u },									// layer 0, (2, 0, 0)
+		{ ~((1u << 10u) | (1u << 30u)), 0u },			// layer 0, (0, 1, 0) at level 1
+		{ ~(1u << 20u), 0u },							// layer 0, (0, 0, 1)
+		{ ~(2u << 30u), 1u },							// layer 1, (0, 0, 0) at level 2
+		{ ~(1u), 1u }									// layer 1, (1, 0, 0)
+	};
+	const NvFlowUint testNumBlocks = sizeof(testSortedBlocks) / sizeof(testSortedBlocks[0]);
+
+	//! GridChecksumAppend() of testSortedBlocks, pinned so the hash cannot drift between builds
+	const NvFlowUint64 testSortedBlocksChecksum = 0x56d822f784a21723ull;
+}
+
+TEST_CASE(GridChecksumAppendIsFnv1a)
+{
+	// tails shorter than a word hash bytewise, so these are the published FNV-1a 64 vectors
+	TEST_CHECK(GridChecksumAppend(GridChecksumSeed, "", 0u) == GridChecksumSeed);
+	TEST_CHECK(GridChecksumAppend(GridChecksumSeed, "a", 1u) == 0xaf63dc4c8601ec8cull);
+	TEST_CHECK(GridChecksumAppend(GridChecksumSeed, "foobar", 6u) == 0x85944171f73967e8ull);
+
+	// whole words fold in at once
+	const NvFlowUint64 word = 0x0123456789abcdefull;
+	TEST_CHECK(GridChecksumAppend(GridChecksumSeed, &word, sizeof(word)) == (GridChecksumSeed ^ word) * 0x100000001b3ull);
+}
+
+TEST_CASE(GridChecksumSortLayeredBlockListOrdersByLayerThenVirtualBlock)
+{
+	// every rotation of the list sorts back to the same order, level bits do not change the order
+	for (NvFlowUint rotation = 0u; rotation < testNumBlocks; rotation++)
+	{
+		NvFlowUint2 blockList[testNumBlocks];
+		for (NvFlowUint idx = 0u; idx < testNumBlocks; idx++)
+		{
+			blockList[idx] = testSortedBlocks[(testNumBlocks - 1u - idx + rotation) % testNumBlocks];
+		}
+		GridChecksumSortLayeredBlockList(blockList, testNumBlocks);
+		TEST_CHECK(memcmp(blockList, testSortedBlocks, sizeof(blockList)) == 0);
+		TEST_CHECK(GridChecksumAppend(GridChecksumSeed, blockList, sizeof(blockList)) == testSortedBlocksChecksum);
+	}
+
+	// moving a block to another layer changes the hash
+	NvFlowUint2 moved[testNumBlocks];
+	memcpy(moved, testSortedBlocks, sizeof(moved));
+	moved[testNumBlocks - 1u].y = 2u;
+	TEST_CHECK(GridChecksumAppend(GridChecksumSeed, moved, sizeof(moved)) != testSortedBlocksChecksum);
+}
@@ -0,0 +1,121 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+
+#include <vector>
+
+#include "test.h"
+#include "testGrid.h"
+#include "gridPreroll.h"
+
+namespace
+{
+	const NvFlowUint testPrerollSteps = 20u;
+	const float testPrerollDt = 1.f / 30.f;
+	const NvFlowUint testPrerollPressureIterations = 4u;
+
+	void TestPrerollDescDefaults(GridPrerollDesc* desc, NvFlowShapeDesc* shape, NvFlowGridEmitParams* emitParams)
+	{
+		GridPrerollDescDefaults(desc);
+		TestGridDescDefaults(&desc->gridDesc);
+		desc->gridDesc.numWorkers = 2u;
+		desc->numSteps = testPrerollSteps;
+		desc->stepDt = testPrerollDt;
+		desc->pressureIterations = testPrerollPressureIterations;
+
+		TestGridFireBall(0.f, shape, emitParams);
+		desc->shapes = shape;
+		desc->numShapes = 1u;
+		desc->emitParams = emitParams;
+		desc->numEmitParams = 1u;
+	}
+}
+
+TEST_CASE(GridPrerollRestoresTheSteppedState)
+{
+	GridPrerollDesc desc;
+	NvFlowShapeDesc shape;
+	NvFlowGridEmitParams emitParams;
+	TestPrerollDescDefaults(&desc, &shape, &emitParams);
+	GridPreroll* preroll = GridPrerollStart(&desc);
+
+	// the same steps on the calling thread, emitters follow stepDt
+	CpuGridDesc referenceDesc = desc.gridDesc;
+	referenceDesc.numWorkers = 1u;
+	referenceDesc.pressureIterations = testPrerollPressureIterations;
+	CpuGrid* reference = CpuGridCreate(&referenceDesc);
+	emitParams.deltaTime = 0.f;
+	for (NvFlowUint stepIdx = 0u; stepIdx < testPrerollSteps; stepIdx++)
+	{
+		CpuGridEmit(reference, &shape, 1u, &emitParams, 1u);
+		CpuGridUpdate(reference, testPrerollDt);
+	}
+	NvFlowUint64 velocity = 0u, density = 0u;
+	TestGridChecksum(reference, &velocity, &density);
+	const NvFlowUint numBlocks = TestGridNumBlocks(reference);
+	CpuGridRelease(reference);
+
+	size_t snapshotSize = 0u;
+	const void* snapshot = GridPrerollGetSnapshot(preroll, true, &snapshotSize);
+	TEST_CHECK(GridPrerollIsDone(preroll));
+	TEST_CHECK(GridPrerollGetProgress(preroll) == testPrerollSteps);
+	TEST_CHECK(snapshot != nullptr && snapshotSize > 0u);
+
+	// the runtime grid keeps its own pressure iterations, only the state comes from the preroll
+	CpuGrid* grid = CpuGridCreate(&desc.gridDesc);
+	TEST_CHECK(CpuGridRestore(grid, snapshot, snapshotSize));
+	NvFlowUint64 restoredVelocity = 0u, restoredDensity = 0u;
+	TestGridChecksum(grid, &restoredVelocity, &restoredDensity);
+	TEST_CHECK(numBlocks > 0u);
+	TEST_CHECK(TestGridNumBlocks(grid) == numBlocks);
+	TEST_CHECK(restoredVelocity == velocity);
+	TEST_CHECK(restoredDensity == density);
+	CpuGridRelease(grid);
+
+	GridPrerollRelease(preroll);
+}
+
+TEST_CASE(GridPrerollReleaseCancelsARunningPreroll)
+{
+	GridPrerollDesc desc;
+	NvFlowShapeDesc shape;
+	NvFlowGridEmitParams emitParams;
+	TestPrerollDescDefaults(&desc, &shape, &emitParams);
+	desc.numSteps = 1000000u;
+	GridPreroll* preroll = GridPrerollStart(&desc);
+
+	size_t snapshotSize = 1u;
+	if (!GridPrerollIsDone(preroll))
+	{
+		TEST_CHECK(GridPrerollGetSnapshot(preroll, false, &snapshotSize) == nullptr);
+		TEST_CHECK(snapshotSize == 0u);
+	}
+	TEST_CHECK(GridPrerollGetProgress(preroll) < desc.numSteps);
+
+	// returns once the thread sees the cancel, long before the last step
+	GridPrerollRelease(preroll);
+}
@@ -0,0 +1,140 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include "test.h"
+#include "gridProxyRing.h"
+
+namespace
+{
+	const NvFlowUint noSlot = GridProxyRingVersions::noSlot;
+
+	NvFlowUint64 TestRingVersion(const GridProxyRingVersions& versions, NvFlowUint slotIdx)
+	{
+		return slotIdx != noSlot ? versions.m_slots[slotIdx].version : 0u;
+	}
+
+	GridProxyRingStats TestRingStats(const GridProxyRingVersions& versions)
+	{
+		GridProxyRingStats stats = {};
+		versions.getStats(&stats);
+		return stats;
+	}
+}
+
+TEST_CASE(GridProxyRingPushesTheOldestFreeSlot)
+{
+	GridProxyRingVersions versions;
+	versions.reset(3u);
+	TEST_CHECK(versions.m_slots.size() == 3u);
+
+	// empty slots fill in order
+	NvFlowUint slot0 = versions.beginPush();
+	TEST_CHECK(slot0 == 0u);
+	TEST_CHECK(versions.endPush(slot0, 1u, false) == 1u);
+	NvFlowUint slot1 = versions.beginPush();
+	TEST_CHECK(slot1 == 1u);
+	TEST_CHECK(versions.endPush(slot1, 2u, false) == 2u);
+
+	// the held slot is never written
+	versions.update(1u);
+	TEST_CHECK(versions.acquireLatest() == slot0);
+	NvFlowUint slot2 = versions.beginPush();
+	TEST_CHECK(slot2 == 2u);
+	TEST_CHECK(versions.endPush(slot2, 3u, false) == 3u);
+
+	// version 2 never completed, it is the oldest free slot and is superseded
+	TEST_CHECK(versions.beginPush() == slot1);
+	TEST_CHECK(TestRingStats(versions).numSuperseded == 1u);
+	TEST_CHECK(versions.endPush(slot1, 4u, false) == 4u);
+
+	// the newest completed version is spared, so the renderer always has one to move to
+	versions.update(4u);
+	TEST_CHECK(versions.latestCompleted() == slot1);
+	TEST_CHECK(versions.beginPush() == slot2);
+	versions.endPush(slot2, 5u, false);
+
+	GridProxyRingStats stats = TestRingStats(versions);
+	TEST_CHECK(stats.numPushed == 5u);
+	TEST_CHECK(stats.numSuperseded == 1u);
+
+	// with the held slot and the newest completed one the only candidates, the newest completed is written
+	versions.reset(1u);
+	TEST_CHECK(versions.m_slots.size() == 2u);
+	slot0 = versions.beginPush();
+	versions.endPush(slot0, 0u, true);
+	TEST_CHECK(versions.acquireLatest() == slot0);
+	slot1 = versions.beginPush();
+	TEST_CHECK(slot1 != slot0);
+	versions.endPush(slot1, 0u, true);
+	TEST_CHECK(versions.beginPush() == slot1);
+	TEST_CHECK(versions.latestCompleted() == slot0);
+}
+
+TEST_CASE(GridProxyRingCompletesVersionsByFence)
+{
+	GridProxyRingVersions versions;
+	versions.reset(3u);
+
+	versions.endPush(versions.beginPush(), 5u, false);
+	versions.endPush(versions.beginPush(), 7u, false);
+
+	// nothing to acquire until the grid queue passes a fence
+	TEST_CHECK(versions.acquireLatest() == noSlot);
+	GridProxyRingStats stats = TestRingStats(versions);
+	TEST_CHECK(stats.latestCompleted == 0u);
+	TEST_CHECK(stats.numPending == 2u);
+
+	versions.update(4u);
+	TEST_CHECK(versions.latestCompleted() == noSlot);
+
+	versions.update(5u);
+	TEST_CHECK(TestRingVersion(versions, versions.acquireLatest()) == 1u);
+	stats = TestRingStats(versions);
+	TEST_CHECK(stats.latestCompleted == 1u);
+	TEST_CHECK(stats.numPending == 1u);
+
+	// a skipped fence value completes every version at or below it
+	versions.update(9u);
+	TEST_CHECK(TestRingVersion(versions, versions.acquireLatest()) == 2u);
+	TEST_CHECK(TestRingStats(versions).numPending == 0u);
+
+	// pushes without a fence complete at once
+	const NvFlowUint64 version = versions.endPush(versions.beginPush(), 0u, true);
+	TEST_CHECK(version == 3u);
+	TEST_CHECK(TestRingVersion(versions, versions.latestCompleted()) == 3u);
+
+	// a slot being written is hidden, acquire falls back to the newest other version
+	const NvFlowUint slotIdx = versions.beginPush();
+	TEST_CHECK(versions.m_slots[slotIdx].version == 0u);
+	TEST_CHECK(!versions.m_slots[slotIdx].completed);
+	TEST_CHECK(TestRingVersion(versions, versions.acquireLatest()) == 3u);
+	versions.endPush(slotIdx, 12u, false);
+	versions.update(11u);
+	TEST_CHECK(TestRingVersion(versions, versions.latestCompleted()) == 3u);
+	versions.update(12u);
+	TEST_CHECK(TestRingVersion(versions, versions.latestCompleted()) == 4u);
+}
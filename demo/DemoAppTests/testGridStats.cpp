@@ -0,0 +1,263 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <float.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "NvFlowShaderCPU.h"
+
+#include "test.h"
+#include "testGrid.h"
+#include "gridStats.h"
+#include "halfFloat.h"
+
+namespace
+{
+	//! Copy of a CPU grid export's velocity, laid out as the downloaded textures
+	struct TestStatsLayer
+	{
+		NvFlowShaderLinearParams params;
+		std::vector<NvFlowUint> blockTable;
+		std::vector<NvFlowFloat4> data;
+		std::vector<NvFlowUint2> blockList;
+		NvFlowDim poolDim;
+
+		NvFlowMappedData mappedTable()
+		{
+			const NvFlowUint rowPitch = params.gridDim.x * sizeof(NvFlowUint);
+			return { blockTable.data(), rowPitch, rowPitch * params.gridDim.y };
+		}
+
+		NvFlowMappedData mappedData()
+		{
+			const NvFlowUint rowPitch = poolDim.x * sizeof(NvFlowFloat4);
+			return { data.data(), rowPitch, rowPitch * poolDim.y };
+		}
+	};
+
+	void TestStatsCapture(CpuGrid* grid, TestStatsLayer* layer)
+	{
+		CpuGridExport gridExport;
+		CpuGridGetExport(grid, &gridExport);
+		const NvFlowShaderLinearParams& params = gridExport.mapping.shaderParams;
+		layer->params = params;
+		layer->poolDim = gridExport.poolDim;
+		layer->blockTable.assign(gridExport.blockTable, gridExport.blockTable + params.gridDim.x * params.gridDim.y * params.gridDim.z);
+		layer->data.assign(gridExport.velocity, gridExport.velocity + size_t(gridExport.poolDim.x) * gridExport.poolDim.y * gridExport.poolDim.z);
+		layer->blockList.clear();
+		for (NvFlowUint idx = 0u; idx < gridExport.numBlocks; idx++)
+		{
+			layer->blockList.push_back({ gridExport.blockList[idx], 0u });
+		}
+	}
+
+	//! Reduces the layer's block list, data as the layer's or packed in another format
+	GridStatsChannel TestStatsReduce(TestStatsLayer& layer, const NvFlowMappedData& data, NvFlowFormat format)
+	{
+		std::vector<NvFlowUint2> blockList = layer.blockList;
+		GridChecksumSortLayeredBlockList(blockList.data(), NvFlowUint(blockList.size()));
+
+		GridStatsComponents components;
+		GridStatsComponentsReset(&components);
+		GridStatsComponentsAddLayer(&components, layer.params, blockList.data(), NvFlowUint(blockList.size()), 0u,
+			layer.mappedTable(), data, format);
+
+		GridStatsChannel channel = {};
+		GridStatsComponentsResolve(&components, &channel);
+		return channel;
+	}
+
+	GridStatsChannel TestStatsReduce(TestStatsLayer& layer)
+	{
+		return TestStatsReduce(layer, layer.mappedData(), eNvFlowFormat_r32g32b32a32_float);
+	}
+
+	CpuGrid* TestStatsGrid()
+	{
+		CpuGridDesc desc;
+		TestGridDescDefaults(&desc);
+		desc.numWorkers = 1u;
+		CpuGrid* grid = CpuGridCreate(&desc);
+		const float dt = 1.f / 60.f;
+		for (int frame = 0; frame < 8; frame++)
+		{
+			TestGridStep(grid, float(frame) * dt, dt);
+		}
+		return grid;
+	}
+}
+
+TEST_CASE(GridStatsComponentsMatchTheGridData)
+{
+	CpuGrid* grid = TestStatsGrid();
+	TestStatsLayer layer;
+	TestStatsCapture(grid, &layer);
+	TEST_CHECK(layer.blockList.size() > 1u);
+	GridStatsChannel channel = TestStatsReduce(layer);
+
+	// visit every active cell through the virtual to real lookup instead of linear block addressing
+	float minVal[4] = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
+	float maxVal[4] = { -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	double sum[4] = { 0.0, 0.0, 0.0, 0.0 };
+	NvFlowUint64 count = 0u;
+	const NvFlowShaderLinearParams& params = layer.params;
+	for (const NvFlowUint2& entry : layer.blockList)
+	{
+		const NvFlowInt3 vBlockIdx = NvFlowCPU_tableVal_to_coord(entry.x);
+		for (int k = 0; k < int(params.blockDim.z); k++)
+		{
+			for (int j = 0; j < int(params.blockDim.y); j++)
+			{
+				for (int i = 0; i < int(params.blockDim.x); i++)
+				{
+					const NvFlowInt3 vidx = {
+						(vBlockIdx.x << params.blockDimBits.x) + i,
+						(vBlockIdx.y << params.blockDimBits.y) + j,
+						(vBlockIdx.z << params.blockDimBits.z) + k
+					};
+					const NvFlowInt3 ridx = NvFlowCPU_virtualToReal(layer.blockTable.data(), params, vidx);
+					const float* value = &layer.data[(size_t(ridx.z) * layer.poolDim.y + ridx.y) * layer.poolDim.x + ridx.x].x;
+					for (int c = 0; c < 4; c++)
+					{
+						minVal[c] = fminf(minVal[c], value[c]);
+						maxVal[c] = fmaxf(maxVal[c], value[c]);
+						sum[c] += value[c];
+					}
+					count++;
+				}
+			}
+		}
+	}
+	const float* componentMin = &channel.componentMin.x;
+	const float* componentMax = &channel.componentMax.x;
+	const float* componentMean = &channel.componentMean.x;
+	for (int c = 0; c < 4; c++)
+	{
+		TEST_CHECK(componentMin[c] == minVal[c]);
+		TEST_CHECK(componentMax[c] == maxVal[c]);
+		TEST_CHECK_NEAR(componentMean[c], sum[c] / double(count), 1e-6);
+	}
+	// the fire ball pushes smoke up
+	TEST_CHECK(channel.componentMax.y > 0.f);
+
+	CpuGridRelease(grid);
+}
+
+TEST_CASE(GridStatsComponentsIgnoreBlockPlacement)
+{
+	CpuGrid* grid = TestStatsGrid();
+	TestStatsLayer layer;
+	TestStatsCapture(grid, &layer);
+	TEST_CHECK(layer.blockList.size() > 1u);
+	const GridStatsChannel reference = TestStatsReduce(layer);
+
+	// swap the pool blocks of the first two active blocks, and reverse the block list
+	TestStatsLayer moved = layer;
+	const NvFlowShaderLinearParams& params = layer.params;
+	const NvFlowInt3 vBlockA = NvFlowCPU_tableVal_to_coord(layer.blockList[0u].x);
+	const NvFlowInt3 vBlockB = NvFlowCPU_tableVal_to_coord(layer.blockList[1u].x);
+	NvFlowUint& tableA = moved.blockTable[(vBlockA.z * params.gridDim.y + vBlockA.y) * params.gridDim.x + vBlockA.x];
+	NvFlowUint& tableB = moved.blockTable[(vBlockB.z * params.gridDim.y + vBlockB.y) * params.gridDim.x + vBlockB.x];
+	const NvFlowInt3 rBlockA = NvFlowCPU_tableVal_to_coord(tableA);
+	const NvFlowInt3 rBlockB = NvFlowCPU_tableVal_to_coord(tableB);
+	for (NvFlowUint k = 0u; k < params.linearBlockDim.z; k++)
+	{
+		for (NvFlowUint j = 0u; j < params.linearBlockDim.y; j++)
+		{
+			for (NvFlowUint i = 0u; i < params.linearBlockDim.x; i++)
+			{
+				auto poolIdx = [&](const NvFlowInt3& rBlock)
+				{
+					return (size_t(rBlock.z * params.linearBlockDim.z + k) * layer.poolDim.y + rBlock.y * params.linearBlockDim.y + j) *
+						layer.poolDim.x + rBlock.x * params.linearBlockDim.x + i;
+				};
+				std::swap(moved.data[poolIdx(rBlockA)], moved.data[poolIdx(rBlockB)]);
+			}
+		}
+	}
+	std::swap(tableA, tableB);
+	std::reverse(moved.blockList.begin(), moved.blockList.end());
+
+	GridStatsChannel channel = TestStatsReduce(moved);
+	TEST_CHECK(channel.checksum == reference.checksum);
+	TEST_CHECK(memcmp(&channel.componentMin, &reference.componentMin, sizeof(NvFlowFloat4)) == 0);
+	TEST_CHECK(memcmp(&channel.componentMax, &reference.componentMax, sizeof(NvFlowFloat4)) == 0);
+	TEST_CHECK(memcmp(&channel.componentMean, &reference.componentMean, sizeof(NvFlowFloat4)) == 0);
+
+	// blocks of another layer are skipped, a changed bit in any cell changes the checksum
+	moved.blockList.push_back({ moved.blockList[0u].x, 1u });
+	TEST_CHECK(TestStatsReduce(moved).checksum == reference.checksum);
+	const NvFlowInt3 ridx = NvFlowCPU_virtualToReal(moved.blockTable.data(), params, NvFlowInt3{
+		vBlockA.x << params.blockDimBits.x, vBlockA.y << params.blockDimBits.y, vBlockA.z << params.blockDimBits.z });
+	NvFlowFloat4& cell = moved.data[(size_t(ridx.z) * layer.poolDim.y + ridx.y) * layer.poolDim.x + ridx.x];
+	cell.w = nextafterf(cell.w, FLT_MAX);
+	TEST_CHECK(TestStatsReduce(moved).checksum != reference.checksum);
+
+	// nothing added resolves to zeros
+	GridStatsComponents empty;
+	GridStatsComponentsReset(&empty);
+	GridStatsChannel emptyChannel = {};
+	GridStatsComponentsResolve(&empty, &emptyChannel);
+	TEST_CHECK(emptyChannel.checksum == GridChecksumSeed);
+	TEST_CHECK(emptyChannel.componentMin.x == 0.f && emptyChannel.componentMax.x == 0.f && emptyChannel.componentMean.x == 0.f);
+
+	CpuGridRelease(grid);
+}
+
+TEST_CASE(GridStatsComponentsReadHalfData)
+{
+	CpuGrid* grid = TestStatsGrid();
+	TestStatsLayer layer;
+	TestStatsCapture(grid, &layer);
+	TEST_CHECK(layer.blockList.size() > 1u);
+
+	// the same cells as fp16 texels, and as floats holding the fp16 values
+	std::vector<unsigned short> packed(4u * layer.data.size());
+	for (size_t idx = 0u; idx < layer.data.size(); idx++)
+	{
+		float* value = &layer.data[idx].x;
+		for (int c = 0; c < 4; c++)
+		{
+			packed[4u * idx + c] = HalfFloatFromFloat(value[c]);
+			value[c] = HalfFloatToFloat(packed[4u * idx + c]);
+		}
+	}
+	const NvFlowUint rowPitch = layer.poolDim.x * 4u * sizeof(unsigned short);
+	const NvFlowMappedData mappedHalf = { packed.data(), rowPitch, rowPitch * layer.poolDim.y };
+
+	const GridStatsChannel reference = TestStatsReduce(layer);
+	const GridStatsChannel channel = TestStatsReduce(layer, mappedHalf, eNvFlowFormat_r16g16b16a16_float);
+	TEST_CHECK(memcmp(&channel.componentMin, &reference.componentMin, sizeof(NvFlowFloat4)) == 0);
+	TEST_CHECK(memcmp(&channel.componentMax, &reference.componentMax, sizeof(NvFlowFloat4)) == 0);
+	TEST_CHECK(memcmp(&channel.componentMean, &reference.componentMean, sizeof(NvFlowFloat4)) == 0);
+	TEST_CHECK(channel.componentMax.y > 0.f);
+
+	CpuGridRelease(grid);
+}
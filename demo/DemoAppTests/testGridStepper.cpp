@@ -0,0 +1,283 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+
+#include <vector>
+
+#include "NvFlowShaderCPU.h"
+
+#include "test.h"
+#include "testGrid.h"
+#include "gridStepper.h"
+
+namespace
+{
+	//! Emits the fire ball at the stepper's simulation time, the same emits as TestGridStep()
+	void TestStepperEmit(void* userdata, CpuGrid* grid, float dt)
+	{
+		float* t = (float*)userdata;
+		NvFlowShapeDesc shape;
+		NvFlowGridEmitParams params;
+		TestGridFireBall(*t, &shape, &params);
+		params.deltaTime = dt;
+		CpuGridEmit(grid, &shape, 1u, &params, 1u);
+		*t += dt;
+	}
+
+	//! Dense copy of a grid state, cells of inactive blocks stay zero
+	struct TestStepperField
+	{
+		std::vector<unsigned char> active;	//!< Per virtual block
+		std::vector<NvFlowFloat4> velocity;
+		std::vector<NvFlowFloat4> density;
+	};
+
+	void TestStepperCapture(CpuGrid* grid, TestStepperField* field)
+	{
+		CpuGridExport gridExport;
+		CpuGridGetExport(grid, &gridExport);
+		const NvFlowShaderLinearParams& params = gridExport.mapping.shaderParams;
+		const NvFlowUint numCells = (params.gridDim.x * params.gridDim.y * params.gridDim.z) << (params.blockDimBits.x + params.blockDimBits.y + params.blockDimBits.z);
+		field->active.assign(params.gridDim.x * params.gridDim.y * params.gridDim.z, 0u);
+		field->velocity.assign(numCells, NvFlowFloat4{ 0.f, 0.f, 0.f, 0.f });
+		field->density.assign(numCells, NvFlowFloat4{ 0.f, 0.f, 0.f, 0.f });
+
+		const NvFlowUint cellDimX = params.gridDim.x << params.blockDimBits.x;
+		const NvFlowUint cellDimY = params.gridDim.y << params.blockDimBits.y;
+		for (NvFlowUint blockIdx = 0u; blockIdx < gridExport.numBlocks; blockIdx++)
+		{
+			const NvFlowInt3 vBlockIdx = NvFlowCPU_tableVal_to_coord(gridExport.blockList[blockIdx]);
+			field->active[(vBlockIdx.z * params.gridDim.y + vBlockIdx.y) * params.gridDim.x + vBlockIdx.x] = 1u;
+			for (NvFlowUint k = 0u; k < params.blockDim.z; k++)
+			{
+				for (NvFlowUint j = 0u; j < params.blockDim.y; j++)
+				{
+					for (NvFlowUint i = 0u; i < params.blockDim.x; i++)
+					{
+						const NvFlowInt3 vidx = {
+							int((vBlockIdx.x << params.blockDimBits.x) + i),
+							int((vBlockIdx.y << params.blockDimBits.y) + j),
+							int((vBlockIdx.z << params.blockDimBits.z) + k)
+						};
+						const NvFlowInt3 ridx = NvFlowCPU_virtualToRealLod(gridExport.blockTable, params, vidx);
+						const size_t src = (size_t(ridx.z) * gridExport.poolDim.y + ridx.y) * gridExport.poolDim.x + ridx.x;
+						const size_t dst = (size_t(vidx.z) * cellDimY + vidx.y) * cellDimX + vidx.x;
+						field->velocity[dst] = gridExport.velocity[src];
+						field->density[dst] = gridExport.density[src];
+					}
+				}
+			}
+		}
+	}
+
+	//! Largest component difference between a render export cell and the expected blend
+	float TestStepperBlendError(const NvFlowFloat4& value, const NvFlowFloat4& a, const NvFlowFloat4& b, float t)
+	{
+		const float dx = fabsf(value.x - (a.x + (b.x - a.x) * t));
+		const float dy = fabsf(value.y - (a.y + (b.y - a.y) * t));
+		const float dz = fabsf(value.z - (a.z + (b.z - a.z) * t));
+		const float dw = fabsf(value.w - (a.w + (b.w - a.w) * t));
+		return fmaxf(fmaxf(dx, dy), fmaxf(dz, dw));
+	}
+
+	struct TestStepperResult
+	{
+		float maxError = 0.f;
+		NvFlowUint numAdded = 0u;		//!< Blocks only in the newest state
+		NvFlowUint numReleased = 0u;	//!< Blocks only in the older state
+	};
+
+	//! Compares the render export against the blend of the reference states, block by block
+	void TestStepperCompare(const CpuGridExport& gridExport, const TestStepperField& older, const TestStepperField& newest, float t, TestStepperResult* result)
+	{
+		const NvFlowShaderLinearParams& params = gridExport.mapping.shaderParams;
+		const NvFlowUint cellDimX = params.gridDim.x << params.blockDimBits.x;
+		const NvFlowUint cellDimY = params.gridDim.y << params.blockDimBits.y;
+		const NvFlowFloat4 zero = { 0.f, 0.f, 0.f, 0.f };
+		NvFlowUint numUnion = 0u;
+		for (NvFlowUint bz = 0u; bz < params.gridDim.z; bz++)
+		{
+			for (NvFlowUint by = 0u; by < params.gridDim.y; by++)
+			{
+				for (NvFlowUint bx = 0u; bx < params.gridDim.x; bx++)
+				{
+					const NvFlowUint idx = (bz * params.gridDim.y + by) * params.gridDim.x + bx;
+					const bool inOlder = older.active[idx] != 0u;
+					const bool inNewest = newest.active[idx] != 0u;
+					if (!inOlder && !inNewest)
+					{
+						continue;
+					}
+					numUnion++;
+					if (!inOlder) result->numAdded++;
+					if (!inNewest) result->numReleased++;
+
+					for (NvFlowUint k = 0u; k < params.blockDim.z; k++)
+					{
+						for (NvFlowUint j = 0u; j < params.blockDim.y; j++)
+						{
+							for (NvFlowUint i = 0u; i < params.blockDim.x; i++)
+							{
+								const NvFlowInt3 vidx = {
+									int((bx << params.blockDimBits.x) + i),
+									int((by << params.blockDimBits.y) + j),
+									int((bz << params.blockDimBits.z) + k)
+								};
+								const NvFlowInt3 ridx = NvFlowCPU_virtualToRealLod(gridExport.blockTable, params, vidx);
+								const size_t src = (size_t(ridx.z) * gridExport.poolDim.y + ridx.y) * gridExport.poolDim.x + ridx.x;
+								const size_t cell = (size_t(vidx.z) * cellDimY + vidx.y) * cellDimX + vidx.x;
+
+								// a block new in the newest state blends against itself, a released one against zero
+								const NvFlowFloat4& newVelocity = newest.velocity[cell];
+								const NvFlowFloat4& newDensity = newest.density[cell];
+								const NvFlowFloat4& oldVelocity = inOlder ? older.velocity[cell] : newVelocity;
+								const NvFlowFloat4& oldDensity = inOlder ? older.density[cell] : newDensity;
+								float error = fmaxf(
+									TestStepperBlendError(gridExport.velocity[src], oldVelocity, inNewest ? newVelocity : zero, t),
+									TestStepperBlendError(gridExport.density[src], oldDensity, inNewest ? newDensity : zero, t));
+								result->maxError = fmaxf(result->maxError, error);
+							}
+						}
+					}
+				}
+			}
+		}
+		if (numUnion != gridExport.numBlocks)
+		{
+			result->maxError = INFINITY;
+		}
+	}
+}
+
+TEST_CASE(GridStepperRenderExportBlendsTheLastTwoStates)
+{
+	const GridStepperMode modes[] = { eGridStepperModeInterpolate, eGridStepperModeExtrapolate };
+	for (GridStepperMode mode : modes)
+	{
+		CpuGridDesc gridDesc;
+		TestGridDescDefaults(&gridDesc);
+		CpuGrid* grid = CpuGridCreate(&gridDesc);
+		CpuGrid* reference = CpuGridCreate(&gridDesc);
+
+		GridStepperDesc desc;
+		GridStepperDescDefaults(&desc);
+		desc.mode = mode;
+		GridStepper* stepper = GridStepperCreate(grid, &desc);
+
+		CpuGridExport gridExport;
+		TEST_CHECK(!GridStepperGetRenderExport(stepper, &gridExport));
+
+		// frames of 1.25 steps alternate between one and two steps, with the remainder moving
+		float stepperTime = 0.f;
+		float referenceTime = 0.f;
+		TestStepperField fields[2];
+		int newest = 0;
+		NvFlowUint numSteps = 0u;
+		TestStepperResult result;
+		for (int frame = 0; frame < 40; frame++)
+		{
+			const NvFlowUint frameSteps = GridStepperAdvance(stepper, 1.25f * desc.fixedDt, TestStepperEmit, &stepperTime);
+			for (NvFlowUint stepIdx = 0u; stepIdx < frameSteps; stepIdx++)
+			{
+				TestGridStep(reference, referenceTime, desc.fixedDt);
+				referenceTime += desc.fixedDt;
+				newest ^= 1;
+				TestStepperCapture(reference, &fields[newest]);
+			}
+			numSteps += frameSteps;
+			if (numSteps < 2u)
+			{
+				continue;
+			}
+
+			const float alpha = GridStepperGetAlpha(stepper);
+			const float t = mode == eGridStepperModeExtrapolate ? 1.f + alpha : alpha;
+			TEST_CHECK(alpha >= 0.f && alpha < 1.f);
+			TEST_CHECK(GridStepperGetRenderExport(stepper, &gridExport));
+			TestStepperCompare(gridExport, fields[newest ^ 1], fields[newest], t, &result);
+		}
+
+		TEST_CHECK(numSteps > 40u);
+		TEST_CHECK_NEAR(result.maxError, 0.f, 1e-5f);
+		TEST_CHECK(result.numAdded > 0u);
+		TEST_CHECK(result.numReleased > 0u);
+
+		GridStepperRelease(stepper);
+		CpuGridRelease(reference);
+		CpuGridRelease(grid);
+	}
+}
+
+TEST_CASE(GridStepperCarriesClampedSteps)
+{
+	CpuGridDesc gridDesc;
+	TestGridDescDefaults(&gridDesc);
+	gridDesc.gridDesc.virtualDim = { 32u, 32u, 32u };
+	gridDesc.numWorkers = 1u;
+	CpuGrid* grid = CpuGridCreate(&gridDesc);
+
+	// binary fractions, so the accumulator is exact
+	GridStepperDesc desc;
+	GridStepperDescDefaults(&desc);
+	desc.fixedDt = 0.125f;
+	desc.maxSteps = 2u;
+	desc.maxCatchUpTime = 0.5f;
+	GridStepper* stepper = GridStepperCreate(grid, &desc);
+
+	// a long frame runs maxSteps and owes the rest, the remainder still drives the blend
+	TEST_CHECK(GridStepperAdvance(stepper, 5.5f * desc.fixedDt, nullptr, nullptr) == 2u);
+	TEST_CHECK(GridStepperGetCatchUpTime(stepper) == 3.f * desc.fixedDt);
+	TEST_CHECK(GridStepperGetAlpha(stepper) == 0.5f);
+
+	// owed steps fill spare steps only
+	TEST_CHECK(GridStepperAdvance(stepper, 0.f, nullptr, nullptr) == 2u);
+	TEST_CHECK(GridStepperGetCatchUpTime(stepper) == desc.fixedDt);
+	TEST_CHECK(GridStepperAdvance(stepper, 2.f * desc.fixedDt, nullptr, nullptr) == 2u);
+	TEST_CHECK(GridStepperGetCatchUpTime(stepper) == desc.fixedDt);
+	TEST_CHECK(GridStepperAdvance(stepper, 0.5f * desc.fixedDt, nullptr, nullptr) == 2u);
+	TEST_CHECK(GridStepperGetCatchUpTime(stepper) == 0.f);
+	TEST_CHECK(GridStepperGetAlpha(stepper) == 0.f);
+
+	// past maxCatchUpTime the owed time is dropped
+	NvFlowUint numSteps = GridStepperAdvance(stepper, 10.f * desc.fixedDt, nullptr, nullptr);
+	TEST_CHECK(GridStepperGetCatchUpTime(stepper) == desc.maxCatchUpTime);
+	for (int frame = 0; frame < 4; frame++)
+	{
+		numSteps += GridStepperAdvance(stepper, 0.f, nullptr, nullptr);
+	}
+	TEST_CHECK(numSteps == 2u + 4u);
+	TEST_CHECK(GridStepperGetCatchUpTime(stepper) == 0.f);
+
+	// reset forgets the debt
+	GridStepperAdvance(stepper, 4.f * desc.fixedDt, nullptr, nullptr);
+	GridStepperReset(stepper);
+	TEST_CHECK(GridStepperGetCatchUpTime(stepper) == 0.f);
+	TEST_CHECK(GridStepperAdvance(stepper, 0.f, nullptr, nullptr) == 0u);
+
+	GridStepperRelease(stepper);
+	CpuGridRelease(grid);
+}
@@ -0,0 +1,94 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "test.h"
+
+namespace
+{
+	struct TestEntry
+	{
+		const char* name;
+		TestFunc func;
+	};
+
+	std::vector<TestEntry>& testEntries()
+	{
+		static std::vector<TestEntry> entries;
+		return entries;
+	}
+
+	int g_numFailed = 0;
+}
+
+TestRegistration::TestRegistration(const char* name, TestFunc func)
+{
+	testEntries().push_back({ name, func });
+}
+
+bool TestCheck(bool ok, const char* expr, const char* file, int line)
+{
+	if (!ok)
+	{
+		printf("  %s(%d): check failed: %s\n", file, line, expr);
+		g_numFailed++;
+	}
+	return ok;
+}
+
+// DemoAppTests [filter], runs the cases whose name contains filter, returns the number of failed cases
+int main(int argc, char** argv)
+{
+	const char* filter = (argc > 1) ? argv[1] : nullptr;
+
+	int numRun = 0;
+	int numCasesFailed = 0;
+	for (const TestEntry& entry : testEntries())
+	{
+		if (filter && !strstr(entry.name, filter))
+		{
+			continue;
+		}
+		const int failedBefore = g_numFailed;
+		entry.func();
+		const bool passed = (g_numFailed == failedBefore);
+		printf("[%s] %s\n", passed ? "  OK  " : " FAIL ", entry.name);
+		numRun++;
+		if (!passed)
+		{
+			numCasesFailed++;
+		}
+	}
+
+	printf("%d of %d test cases passed\n", numRun - numCasesFailed, numRun);
+	return numCasesFailed;
+}
@@ -0,0 +1,164 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+
+#include <math.h>
+
+#include <vector>
+
+#include "test.h"
+#include "sdfAtlas.h"
+
+namespace
+{
+	//! Distinct value per cell, so a sample names the cell it came from
+	float TestSdfAtlasValue(NvFlowUint i, NvFlowUint j, NvFlowUint k)
+	{
+		return float(i) + 100.f * float(j) + 10000.f * float(k);
+	}
+
+	void TestSdfAtlasField(NvFlowDim dim, std::vector<float>* data, NvFlowShapeSDFData* sdf)
+	{
+		data->resize(dim.x * dim.y * dim.z);
+		for (NvFlowUint k = 0u; k < dim.z; k++)
+		{
+			for (NvFlowUint j = 0u; j < dim.y; j++)
+			{
+				for (NvFlowUint i = 0u; i < dim.x; i++)
+				{
+					(*data)[(k * dim.y + j) * dim.x + i] = TestSdfAtlasValue(i, j, k);
+				}
+			}
+		}
+		sdf->data = data->data();
+		sdf->rowPitch = dim.x;
+		sdf->depthPitch = dim.x * dim.y;
+		sdf->dim = dim;
+	}
+}
+
+TEST_CASE(SdfAtlasEmitParamsSampleTheInsertedField)
+{
+	SdfAtlasDesc desc;
+	SdfAtlasDescDefaults(&desc);
+	desc.slotDim = { 8u, 8u, 8u };
+	desc.numSlots = { 4u, 4u, 4u };
+	SdfAtlas* atlas = SdfAtlasCreate(nullptr, &desc);
+	TEST_CHECK(SdfAtlasGetShape(atlas) == nullptr);
+
+	// a filler first, so the shape under test sits away from the atlas origin
+	std::vector<float> fillerData, shapeData;
+	NvFlowShapeSDFData filler, shape;
+	TestSdfAtlasField({ 10u, 10u, 10u }, &fillerData, &filler);
+	TestSdfAtlasField({ 11u, 7u, 5u }, &shapeData, &shape);
+	SdfAtlasHandle fillerHandle = SdfAtlasInsert(atlas, &filler);
+	SdfAtlasHandle handle = SdfAtlasInsert(atlas, &shape);
+	TEST_CHECK(SdfAtlasIsValid(atlas, fillerHandle));
+	TEST_CHECK(SdfAtlasIsValid(atlas, handle));
+
+	// the emitter as set up for its own SDF, scaled and moved
+	const NvFlowFloat3 scale = { 2.f, 3.f, 0.5f };
+	const NvFlowFloat3 translate = { 1.f, -2.f, 4.f };
+	NvFlowGridEmitParams params = {};
+	params.localToWorld = {
+		scale.x, 0.f, 0.f, 0.f,
+		0.f, scale.y, 0.f, 0.f,
+		0.f, 0.f, scale.z, 0.f,
+		translate.x, translate.y, translate.z, 1.f
+	};
+	TEST_CHECK(SdfAtlasGetEmitParams(atlas, handle, &params));
+	const NvFlowFloat4x4& m = params.localToWorld;
+
+	// every atlas cell, through the rewritten transform to world, then back through the original to shape NDC
+	NvFlowShapeSDFData atlasData;
+	SdfAtlasGetData(atlas, &atlasData);
+	const NvFlowDim& dim = shape.dim;
+	NvFlowUint numInterior = 0u;
+	NvFlowUint numApron = 0u;
+	NvFlowUint numOffCenter = 0u;
+	NvFlowUint numWrong = 0u;
+	for (NvFlowUint k = 0u; k < atlasData.dim.z; k++)
+	{
+		for (NvFlowUint j = 0u; j < atlasData.dim.y; j++)
+		{
+			for (NvFlowUint i = 0u; i < atlasData.dim.x; i++)
+			{
+				const float qx = -1.f + 2.f * (float(i) + 0.5f) / float(atlasData.dim.x);
+				const float qy = -1.f + 2.f * (float(j) + 0.5f) / float(atlasData.dim.y);
+				const float qz = -1.f + 2.f * (float(k) + 0.5f) / float(atlasData.dim.z);
+				const float wx = qx * m.x.x + qy * m.y.x + qz * m.z.x + m.w.x;
+				const float wy = qx * m.x.y + qy * m.y.y + qz * m.z.y + m.w.y;
+				const float wz = qx * m.x.z + qy * m.y.z + qz * m.z.z + m.w.z;
+				const float px = (wx - translate.x) / scale.x;
+				const float py = (wy - translate.y) / scale.y;
+				const float pz = (wz - translate.z) / scale.z;
+
+				// shape cell coordinates, cell centers at integers
+				const float cx = 0.5f * (px + 1.f) * float(dim.x) - 0.5f;
+				const float cy = 0.5f * (py + 1.f) * float(dim.y) - 0.5f;
+				const float cz = 0.5f * (pz + 1.f) * float(dim.z) - 0.5f;
+				const float rx = floorf(cx + 0.5f);
+				const float ry = floorf(cy + 0.5f);
+				const float rz = floorf(cz + 0.5f);
+				if (rx < -1.f || ry < -1.f || rz < -1.f || rx > float(dim.x) || ry > float(dim.y) || rz > float(dim.z))
+				{
+					continue;
+				}
+				if (fabsf(cx - rx) > 1e-3f || fabsf(cy - ry) > 1e-3f || fabsf(cz - rz) > 1e-3f)
+				{
+					numOffCenter++;
+				}
+
+				// inside the brick the field itself, on the one cell apron its clamped edge
+				const bool interior = rx >= 0.f && ry >= 0.f && rz >= 0.f && rx < float(dim.x) && ry < float(dim.y) && rz < float(dim.z);
+				if (interior) numInterior++;
+				else numApron++;
+				const float expected = TestSdfAtlasValue(
+					NvFlowUint(fminf(fmaxf(rx, 0.f), float(dim.x - 1u))),
+					NvFlowUint(fminf(fmaxf(ry, 0.f), float(dim.y - 1u))),
+					NvFlowUint(fminf(fmaxf(rz, 0.f), float(dim.z - 1u))));
+				if (atlasData.data[k * atlasData.depthPitch + j * atlasData.rowPitch + i] != expected)
+				{
+					numWrong++;
+				}
+			}
+		}
+	}
+	TEST_CHECK(numInterior == dim.x * dim.y * dim.z);
+	TEST_CHECK(numApron == (dim.x + 2u) * (dim.y + 2u) * (dim.z + 2u) - dim.x * dim.y * dim.z);
+	TEST_CHECK(numOffCenter == 0u);
+	TEST_CHECK(numWrong == 0u);
+
+	// the freed slots take the next shape, the old handle is gone
+	TEST_CHECK(SdfAtlasEvict(atlas, handle));
+	TEST_CHECK(!SdfAtlasIsValid(atlas, handle));
+	SdfAtlasHandle reinserted = SdfAtlasInsert(atlas, &shape);
+	TEST_CHECK(SdfAtlasIsValid(atlas, reinserted));
+	TEST_CHECK(reinserted.slot == handle.slot && reinserted.generation != handle.generation);
+
+	SdfAtlasRelease(atlas);
+}
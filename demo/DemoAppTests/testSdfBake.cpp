@@ -0,0 +1,324 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+
+#include <math.h>
+
+#include <vector>
+
+#include "test.h"
+#include "sdfBake.h"
+
+namespace
+{
+	//! Box with half extents b, counter clockwise seen from outside, or clockwise if flipped
+	struct TestSdfBox
+	{
+		float b[3];
+		float positions[8u * 3u];
+		NvFlowUint indices[36u];
+
+		TestSdfBox(float bx, float by, float bz, bool flipped)
+		{
+			b[0] = bx;
+			b[1] = by;
+			b[2] = bz;
+			for (NvFlowUint vertexIdx = 0u; vertexIdx < 8u; vertexIdx++)
+			{
+				positions[3u * vertexIdx + 0u] = (vertexIdx & 1u) ? b[0] : -b[0];
+				positions[3u * vertexIdx + 1u] = (vertexIdx & 2u) ? b[1] : -b[1];
+				positions[3u * vertexIdx + 2u] = (vertexIdx & 4u) ? b[2] : -b[2];
+			}
+			const NvFlowUint boxIndices[36u] = {
+				0, 2, 1, 1, 2, 3,	4, 5, 6, 5, 7, 6,
+				0, 1, 4, 1, 5, 4,	2, 6, 3, 3, 6, 7,
+				0, 4, 2, 2, 4, 6,	1, 3, 5, 3, 7, 5
+			};
+			for (NvFlowUint idx = 0u; idx < 36u; idx += 3u)
+			{
+				indices[idx + 0u] = boxIndices[idx + 0u];
+				indices[idx + 1u] = boxIndices[idx + (flipped ? 2u : 1u)];
+				indices[idx + 2u] = boxIndices[idx + (flipped ? 1u : 2u)];
+			}
+		}
+
+		void getMesh(NvFlowSDFGenMeshParams* mesh, const NvFlowFloat3& t)
+		{
+			*mesh = NvFlowSDFGenMeshParams();
+			mesh->numVertices = 8u;
+			mesh->positions = positions;
+			mesh->positionStride = 3u * sizeof(float);
+			mesh->numIndices = 36u;
+			mesh->indices = indices;
+			mesh->modelMatrix = {
+				1.f, 0.f, 0.f, 0.f,
+				0.f, 1.f, 0.f, 0.f,
+				0.f, 0.f, 1.f, 0.f,
+				t.x, t.y, t.z, 1.f
+			};
+		}
+
+		//! Exact signed distance at p in model space
+		float distance(float px, float py, float pz) const
+		{
+			const float q[3] = { fabsf(px) - b[0], fabsf(py) - b[1], fabsf(pz) - b[2] };
+			const float ox = fmaxf(q[0], 0.f), oy = fmaxf(q[1], 0.f), oz = fmaxf(q[2], 0.f);
+			return sqrtf(ox * ox + oy * oy + oz * oz) + fminf(fmaxf(q[0], fmaxf(q[1], q[2])), 0.f);
+		}
+	};
+
+	//! Bakes a 1 deep byte mask inside below the plane, axis 0 splits columns, axis 1 splits rows
+	float TestSdfBakeMaskPlaneError(NvFlowDim dim, int axis, NvFlowUint numInside)
+	{
+		std::vector<unsigned char> maskData(dim.x * dim.y);
+		for (NvFlowUint j = 0u; j < dim.y; j++)
+		{
+			for (NvFlowUint i = 0u; i < dim.x; i++)
+			{
+				maskData[j * dim.x + i] = ((axis == 0 ? i : j) < numInside) ? 1u : 0u;
+			}
+		}
+		SdfBakeMask mask = {};
+		mask.data = maskData.data();
+		mask.bitsPerValue = 8u;
+		mask.rowPitch = dim.x;
+		mask.depthPitch = dim.x * dim.y;
+		mask.dim = dim;
+
+		std::vector<float> sdfData(dim.x * dim.y, 0.f);
+		NvFlowShapeSDFData sdf = {};
+		sdf.data = sdfData.data();
+		sdf.rowPitch = dim.x;
+		sdf.depthPitch = dim.x * dim.y;
+		sdf.dim = dim;
+
+		SdfBakeParams params;
+		SdfBakeParamsDefaults(&params);
+		if (!SdfBakeFromMask(&mask, &params, &sdf))
+		{
+			return INFINITY;
+		}
+
+		// the surface sits on the face between the last inside and first outside cell
+		const float h = 2.f / float(axis == 0 ? dim.x : dim.y);
+		const float plane = -1.f + float(numInside) * h;
+		float maxError = 0.f;
+		for (NvFlowUint j = 0u; j < dim.y; j++)
+		{
+			for (NvFlowUint i = 0u; i < dim.x; i++)
+			{
+				const float center = -1.f + (float(axis == 0 ? i : j) + 0.5f) * h;
+				maxError = fmaxf(maxError, fabsf(sdfData[j * dim.x + i] - (center - plane)));
+			}
+		}
+		return maxError;
+	}
+}
+
+TEST_CASE(SdfBakeFromMaskOffsetsEachAxisByItsOwnSpacing)
+{
+	// 0.054 wide and 0.1 high cells, a row split must not take the column half spacing
+	const NvFlowDim dim = { 37u, 20u, 1u };
+	TEST_CHECK_NEAR(TestSdfBakeMaskPlaneError(dim, 1, 10u), 0.f, 1e-5f);
+	TEST_CHECK_NEAR(TestSdfBakeMaskPlaneError(dim, 0, 18u), 0.f, 1e-5f);
+
+	const NvFlowDim square = { 20u, 20u, 1u };
+	TEST_CHECK_NEAR(TestSdfBakeMaskPlaneError(square, 1, 7u), 0.f, 1e-5f);
+}
+
+TEST_CASE(SdfDeformerCoarseBricksStayWithinTheTolerance)
+{
+	// a turned box, whose exact signed distance is known everywhere
+	const float b[3] = { 0.3f, 0.2f, 0.25f };
+	const float angle = 0.5f;
+	const float c = cosf(angle), s = sinf(angle);
+	const NvFlowFloat3 t = { 0.05f, -0.1f, 0.02f };
+	float positions[8u * 3u];
+	for (NvFlowUint vertexIdx = 0u; vertexIdx < 8u; vertexIdx++)
+	{
+		positions[3u * vertexIdx + 0u] = (vertexIdx & 1u) ? b[0] : -b[0];
+		positions[3u * vertexIdx + 1u] = (vertexIdx & 2u) ? b[1] : -b[1];
+		positions[3u * vertexIdx + 2u] = (vertexIdx & 4u) ? b[2] : -b[2];
+	}
+	NvFlowUint indices[36u] = {
+		0, 2, 1, 1, 2, 3,	4, 5, 6, 5, 7, 6,
+		0, 1, 4, 1, 5, 4,	2, 6, 3, 3, 6, 7,
+		0, 4, 2, 2, 4, 6,	1, 3, 5, 3, 7, 5
+	};
+	NvFlowSDFGenMeshParams mesh = {};
+	mesh.numVertices = 8u;
+	mesh.positions = positions;
+	mesh.positionStride = 3u * sizeof(float);
+	mesh.numIndices = 36u;
+	mesh.indices = indices;
+	mesh.modelMatrix = {
+		c, 0.f, -s, 0.f,
+		0.f, 1.f, 0.f, 0.f,
+		s, 0.f, c, 0.f,
+		t.x, t.y, t.z, 1.f
+	};
+
+	// a looser tolerance lets whole bricks far from the box interpolate, within that tolerance
+	const struct { float maxDistanceCells; float toleranceCells; } runs[] = {
+		{ 8.f, 0.25f },
+		{ 24.f, 2.f }
+	};
+	for (const auto& run : runs)
+	{
+		SdfDeformerDesc desc;
+		SdfDeformerDescDefaults(&desc);
+		desc.dim = { 48u, 48u, 48u };
+		desc.maxDistanceCells = run.maxDistanceCells;
+		desc.toleranceCells = run.toleranceCells;
+		SdfDeformer* deformer = SdfDeformerCreate(&desc, &mesh, nullptr);
+		TEST_CHECK(deformer != nullptr);
+		if (deformer == nullptr)
+		{
+			continue;
+		}
+		TEST_CHECK(SdfDeformerUpdate(deformer) > 0u);
+
+		const NvFlowDim& dim = desc.dim;
+		std::vector<float> sdfData(dim.x * dim.y * dim.z, 0.f);
+		NvFlowShapeSDFData sdf = {};
+		sdf.data = sdfData.data();
+		sdf.rowPitch = dim.x;
+		sdf.depthPitch = dim.x * dim.y;
+		sdf.dim = dim;
+		TEST_CHECK(SdfDeformerCopy(deformer, &sdf));
+
+		// clamped cells only need to stay past the clamp
+		const float h = 2.f / float(dim.x);
+		const float maxDist = desc.maxDistanceCells * h;
+		float maxError = 0.f;
+		for (NvFlowUint k = 0u; k < dim.z; k++)
+		{
+			for (NvFlowUint j = 0u; j < dim.y; j++)
+			{
+				for (NvFlowUint i = 0u; i < dim.x; i++)
+				{
+					const float wx = -1.f + (float(i) + 0.5f) * h - t.x;
+					const float wy = -1.f + (float(j) + 0.5f) * h - t.y;
+					const float wz = -1.f + (float(k) + 0.5f) * h - t.z;
+					const float q[3] = {
+						fabsf(wx * c - wz * s) - b[0],
+						fabsf(wy) - b[1],
+						fabsf(wx * s + wz * c) - b[2]
+					};
+					const float ox = fmaxf(q[0], 0.f), oy = fmaxf(q[1], 0.f), oz = fmaxf(q[2], 0.f);
+					const float exact = sqrtf(ox * ox + oy * oy + oz * oz) + fminf(fmaxf(q[0], fmaxf(q[1], q[2])), 0.f);
+					const float expected = fminf(fmaxf(exact, -maxDist), maxDist);
+					maxError = fmaxf(maxError, fabsf(sdfData[(k * dim.y + j) * dim.x + i] - expected));
+				}
+			}
+		}
+		TEST_CHECK_NEAR(maxError / h, 0.f, desc.toleranceCells + 1e-3f);
+
+		SdfDeformerStats stats;
+		SdfDeformerGetStats(deformer, &stats);
+		TEST_CHECK(stats.numRefreshed == stats.numBricks);
+		TEST_CHECK(stats.numFine < stats.numBricks);
+		TEST_CHECK(run.toleranceCells < 1.f || stats.numCoarse > 0u);
+
+		SdfDeformerRelease(deformer);
+	}
+}
+
+TEST_CASE(SdfBakeMeshMatchesTheBoxDistance)
+{
+	const NvFlowDim dim = { 40u, 40u, 40u };
+	const float h = 2.f / float(dim.x);
+	const NvFlowFloat3 t = { 0.1f, -0.05f, 0.03f };
+
+	SdfBakeParams params;
+	SdfBakeParamsDefaults(&params);
+
+	float maxBandError[2] = {};
+	float maxFarError[2] = {};
+	NvFlowUint numSignErrors[2] = {};
+	std::vector<float> sdfData[2];
+	for (int flipped = 0; flipped < 2; flipped++)
+	{
+		TestSdfBox box(0.45f, 0.3f, 0.35f, flipped != 0);
+		NvFlowSDFGenMeshParams mesh;
+		box.getMesh(&mesh, t);
+
+		sdfData[flipped].assign(dim.x * dim.y * dim.z, 0.f);
+		NvFlowShapeSDFData sdf = {};
+		sdf.data = sdfData[flipped].data();
+		sdf.rowPitch = dim.x;
+		sdf.depthPitch = dim.x * dim.y;
+		sdf.dim = dim;
+		TEST_CHECK(SdfBakeMesh(&mesh, &params, &sdf));
+
+		// flipped triangles turn the field inside out
+		const float sign = flipped ? -1.f : 1.f;
+		for (NvFlowUint k = 0u; k < dim.z; k++)
+		{
+			for (NvFlowUint j = 0u; j < dim.y; j++)
+			{
+				for (NvFlowUint i = 0u; i < dim.x; i++)
+				{
+					const float exact = box.distance(
+						-1.f + (float(i) + 0.5f) * h - t.x,
+						-1.f + (float(j) + 0.5f) * h - t.y,
+						-1.f + (float(k) + 0.5f) * h - t.z
+					);
+					const float baked = sign * sdfData[flipped][(k * dim.y + j) * dim.x + i];
+					if ((baked < 0.f) != (exact < 0.f))
+					{
+						numSignErrors[flipped]++;
+					}
+					const float error = fabsf(baked - exact);
+					if (fabsf(exact) <= params.narrowBandCells * h)
+					{
+						maxBandError[flipped] = fmaxf(maxBandError[flipped], error);
+					}
+					else
+					{
+						maxFarError[flipped] = fmaxf(maxFarError[flipped], error);
+					}
+				}
+			}
+		}
+	}
+
+	for (int flipped = 0; flipped < 2; flipped++)
+	{
+		TEST_CHECK(numSignErrors[flipped] == 0u);
+		// exact in the band, the sweep is first order beyond it and drifts around the box corners
+		TEST_CHECK_NEAR(maxBandError[flipped] / h, 0.f, 1e-3f);
+		TEST_CHECK_NEAR(maxFarError[flipped] / h, 0.f, 1.5f);
+	}
+
+	NvFlowUint numMirrored = 0u;
+	for (size_t cellIdx = 0u; cellIdx < sdfData[0].size(); cellIdx++)
+	{
+		numMirrored += (sdfData[1][cellIdx] == -sdfData[0][cellIdx]) ? 1u : 0u;
+	}
+	TEST_CHECK(numMirrored == sdfData[0].size());
+}
@@ -0,0 +1,349 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <math.h>
+
+#include <vector>
+#include <algorithm>
+
+#include "test.h"
+#include "sdfCompress.h"
+#include "halfFloat.h"
+#include "taskDispatch.h"
+
+namespace
+{
+	//! Sphere field in SDF NDC units, dims not a multiple of the brick size so edge bricks are partial
+	struct TestSdfSphere
+	{
+		NvFlowDim dim = { 40u, 36u, 44u };
+		std::vector<float> data;
+		NvFlowShapeSDFData sdf = {};
+
+		TestSdfSphere()
+		{
+			// row pitch padded past dim.x, as in a mapped texture
+			const NvFlowUint rowPitch = dim.x + 3u;
+			data.assign(rowPitch * dim.y * dim.z, NAN);
+			sdf.data = data.data();
+			sdf.rowPitch = rowPitch;
+			sdf.depthPitch = rowPitch * dim.y;
+			sdf.dim = dim;
+			for (NvFlowUint k = 0u; k < dim.z; k++)
+			{
+				for (NvFlowUint j = 0u; j < dim.y; j++)
+				{
+					for (NvFlowUint i = 0u; i < dim.x; i++)
+					{
+						const float x = -1.f + (float(i) + 0.5f) * 2.f / float(dim.x) - 0.1f;
+						const float y = -1.f + (float(j) + 0.5f) * 2.f / float(dim.y) + 0.05f;
+						const float z = -1.f + (float(k) + 0.5f) * 2.f / float(dim.z);
+						at(i, j, k) = sqrtf(x * x + y * y + z * z) - 0.8f;
+					}
+				}
+			}
+		}
+
+		float& at(NvFlowUint i, NvFlowUint j, NvFlowUint k)
+		{
+			return data[k * sdf.depthPitch + j * sdf.rowPitch + i];
+		}
+	};
+
+	//! Band of the bricks format, cells of the finest axis
+	float TestSdfBand(const SdfCompressDesc& desc, NvFlowDim dim)
+	{
+		return desc.narrowBandCells * 2.f / float(std::max(dim.x, std::max(dim.y, dim.z)));
+	}
+
+	std::vector<float> TestSdfDecode(SdfCompressed* compressed, NvFlowDim dim)
+	{
+		std::vector<float> decoded(dim.x * dim.y * dim.z, NAN);
+		NvFlowShapeSDFData sdf = {};
+		sdf.data = decoded.data();
+		sdf.rowPitch = dim.x;
+		sdf.depthPitch = dim.x * dim.y;
+		sdf.dim = dim;
+		TEST_CHECK(SdfCompressedDecode(compressed, &sdf));
+		return decoded;
+	}
+}
+
+TEST_CASE(HalfFloatRoundTripsEveryHalf)
+{
+	TEST_CHECK(HalfFloatFromFloat(1.f) == 0x3C00);
+	TEST_CHECK(HalfFloatFromFloat(-2.f) == 0xC000);
+	TEST_CHECK(HalfFloatFromFloat(-0.f) == 0x8000);
+	TEST_CHECK(HalfFloatFromFloat(65504.f) == 0x7BFF);
+	TEST_CHECK(HalfFloatFromFloat(1e6f) == 0x7C00);
+	TEST_CHECK(HalfFloatFromFloat(ldexpf(1.f, -24)) == 0x0001);
+	TEST_CHECK(HalfFloatFromFloat(ldexpf(1.f, -26)) == 0x0000);
+	// ties round to even
+	TEST_CHECK(HalfFloatFromFloat(1.f + ldexpf(1.f, -11)) == 0x3C00);
+	TEST_CHECK(HalfFloatFromFloat(1.f + 3.f * ldexpf(1.f, -11)) == 0x3C02);
+	TEST_CHECK(HalfFloatToFloat(0x0001) == ldexpf(1.f, -24));
+	TEST_CHECK(isinf(HalfFloatToFloat(0xFC00)) && HalfFloatToFloat(0xFC00) < 0.f);
+	TEST_CHECK(isnan(HalfFloatToFloat(HalfFloatFromFloat(NAN))));
+
+	// every value, subnormals included, survives a trip through float
+	NvFlowUint numMismatched = 0u;
+	for (NvFlowUint h = 0u; h < 0x10000; h++)
+	{
+		const bool isNan = (h & 0x7C00) == 0x7C00 && (h & 0x03FF) != 0u;
+		if (!isNan && HalfFloatFromFloat(HalfFloatToFloat((unsigned short)h)) != h)
+		{
+			numMismatched++;
+		}
+	}
+	TEST_CHECK(numMismatched == 0u);
+}
+
+TEST_CASE(SdfCompressHalfRoundTripsTheField)
+{
+	TestSdfSphere sphere;
+	const NvFlowDim dim = sphere.dim;
+
+	SdfCompressDesc desc;
+	SdfCompressDescDefaults(&desc);
+	desc.format = eSdfCompressHalf;
+	SdfCompressed* compressed = SdfCompressedCreate(&desc, &sphere.sdf);
+	TEST_CHECK(compressed != nullptr);
+	if (compressed == nullptr)
+	{
+		return;
+	}
+
+	SdfCompressedStats stats;
+	SdfCompressedGetStats(compressed, &stats);
+	TEST_CHECK(stats.compressedBytes * 2u == stats.denseBytes);
+
+	// each cell is the nearest half, within half an fp16 ulp of the source
+	std::vector<float> decoded = TestSdfDecode(compressed, dim);
+	NvFlowUint numMismatched = 0u;
+	float maxRelError = 0.f;
+	for (NvFlowUint k = 0u; k < dim.z; k++)
+	{
+		for (NvFlowUint j = 0u; j < dim.y; j++)
+		{
+			for (NvFlowUint i = 0u; i < dim.x; i++)
+			{
+				const float src = sphere.at(i, j, k);
+				const float value = decoded[(k * dim.y + j) * dim.x + i];
+				numMismatched += (value != HalfFloatToFloat(HalfFloatFromFloat(src))) ? 1u : 0u;
+				maxRelError = std::max(maxRelError, fabsf(value - src) / std::max(fabsf(src), ldexpf(1.f, -14)));
+			}
+		}
+	}
+	TEST_CHECK(numMismatched == 0u);
+	TEST_CHECK_NEAR(maxRelError, 0.f, ldexpf(1.f, -11));
+
+	// the fp16 path writes the same bits, at the texture's pitches
+	const NvFlowUint rowPitch = 2u * dim.x + 6u;
+	std::vector<unsigned char> texels(rowPitch * dim.y * dim.z, 0xFF);
+	NvFlowMappedData mapped = {};
+	mapped.data = texels.data();
+	mapped.rowPitch = rowPitch;
+	mapped.depthPitch = rowPitch * dim.y;
+	TEST_CHECK(SdfCompressedDecodeHalf(compressed, &mapped));
+	numMismatched = 0u;
+	for (NvFlowUint k = 0u; k < dim.z; k++)
+	{
+		for (NvFlowUint j = 0u; j < dim.y; j++)
+		{
+			const unsigned short* row = (const unsigned short*)(texels.data() + k * mapped.depthPitch + j * mapped.rowPitch);
+			for (NvFlowUint i = 0u; i < dim.x; i++)
+			{
+				numMismatched += (row[i] != HalfFloatFromFloat(sphere.at(i, j, k))) ? 1u : 0u;
+			}
+		}
+	}
+	TEST_CHECK(numMismatched == 0u);
+
+	SdfCompressedRelease(compressed);
+}
+
+TEST_CASE(SdfCompressBricksClassifyByTheBand)
+{
+	TestSdfSphere sphere;
+	const NvFlowDim dim = sphere.dim;
+
+	SdfCompressDesc desc;
+	SdfCompressDescDefaults(&desc);
+	const float band = TestSdfBand(desc, dim);
+	SdfCompressed* compressed = SdfCompressedCreate(&desc, &sphere.sdf);
+	TEST_CHECK(compressed != nullptr);
+	if (compressed == nullptr)
+	{
+		return;
+	}
+
+	const NvFlowUint brickDim = desc.brickDim;
+	const NvFlowDim brickGridDim = {
+		(dim.x + brickDim - 1u) / brickDim,
+		(dim.y + brickDim - 1u) / brickDim,
+		(dim.z + brickDim - 1u) / brickDim
+	};
+	NvFlowUint classCounts[3] = {};
+	NvFlowUint numMisclassified = 0u;
+	for (NvFlowUint bk = 0u; bk < brickGridDim.z; bk++)
+	{
+		for (NvFlowUint bj = 0u; bj < brickGridDim.y; bj++)
+		{
+			for (NvFlowUint bi = 0u; bi < brickGridDim.x; bi++)
+			{
+				// a brick is stored if any of its cells is in the band or it holds both signs
+				float minVal = INFINITY, maxVal = -INFINITY;
+				for (NvFlowUint k = bk * brickDim; k < std::min((bk + 1u) * brickDim, dim.z); k++)
+				{
+					for (NvFlowUint j = bj * brickDim; j < std::min((bj + 1u) * brickDim, dim.y); j++)
+					{
+						for (NvFlowUint i = bi * brickDim; i < std::min((bi + 1u) * brickDim, dim.x); i++)
+						{
+							minVal = std::min(minVal, sphere.at(i, j, k));
+							maxVal = std::max(maxVal, sphere.at(i, j, k));
+						}
+					}
+				}
+				SdfCompressBrickClass expected = eSdfCompressBrickStored;
+				if (minVal >= band)
+				{
+					expected = eSdfCompressBrickOutside;
+				}
+				else if (maxVal <= -band)
+				{
+					expected = eSdfCompressBrickInside;
+				}
+				const SdfCompressBrickClass brickClass = SdfCompressedGetBrickClass(compressed, bi, bj, bk);
+				numMisclassified += (brickClass != expected) ? 1u : 0u;
+				classCounts[brickClass]++;
+			}
+		}
+	}
+	TEST_CHECK(numMisclassified == 0u);
+	TEST_CHECK(classCounts[eSdfCompressBrickStored] > 0u);
+	TEST_CHECK(classCounts[eSdfCompressBrickOutside] > 0u);
+	TEST_CHECK(classCounts[eSdfCompressBrickInside] > 0u);
+
+	SdfCompressedStats stats;
+	SdfCompressedGetStats(compressed, &stats);
+	TEST_CHECK(stats.numBricks == brickGridDim.x * brickGridDim.y * brickGridDim.z);
+	TEST_CHECK(stats.numStoredBricks == classCounts[eSdfCompressBrickStored]);
+	TEST_CHECK(stats.compressedBytes < stats.denseBytes / 2u);
+
+	SdfCompressedRelease(compressed);
+}
+
+TEST_CASE(SdfCompressDecodeRowMatchesTheSource)
+{
+	TestSdfSphere sphere;
+	const NvFlowDim dim = sphere.dim;
+
+	const SdfCompressFormat formats[] = { eSdfCompressHalf, eSdfCompressBricks };
+	for (SdfCompressFormat format : formats)
+	{
+		SdfCompressDesc desc;
+		SdfCompressDescDefaults(&desc);
+		desc.format = format;
+		const float band = (format == eSdfCompressBricks) ? TestSdfBand(desc, dim) : INFINITY;
+		SdfCompressed* compressed = SdfCompressedCreate(&desc, &sphere.sdf);
+		TEST_CHECK(compressed != nullptr);
+		if (compressed == nullptr)
+		{
+			continue;
+		}
+
+		// every row is the source clamped to the band, in fp16, whichever bricks it crosses
+		std::vector<unsigned short> row(dim.x + 1u);
+		NvFlowUint numMismatched = 0u;
+		NvFlowUint numOverwritten = 0u;
+		for (NvFlowUint k = 0u; k < dim.z; k++)
+		{
+			for (NvFlowUint j = 0u; j < dim.y; j++)
+			{
+				row[dim.x] = 0xABCD;
+				SdfCompressedDecodeRow(compressed, j, k, row.data());
+				for (NvFlowUint i = 0u; i < dim.x; i++)
+				{
+					const float expected = std::max(-band, std::min(sphere.at(i, j, k), band));
+					numMismatched += (row[i] != HalfFloatFromFloat(expected)) ? 1u : 0u;
+				}
+				numOverwritten += (row[dim.x] != 0xABCD) ? 1u : 0u;
+			}
+		}
+		TEST_CHECK(numMismatched == 0u);
+		TEST_CHECK(numOverwritten == 0u);
+
+		SdfCompressedRelease(compressed);
+	}
+}
+
+TEST_CASE(SdfCompressBricksMatchTheDenseResult)
+{
+	TestSdfSphere sphere;
+	const NvFlowDim dim = sphere.dim;
+
+	SdfCompressDesc desc;
+	SdfCompressDescDefaults(&desc);
+	desc.format = eSdfCompressHalf;
+	SdfCompressed* dense = SdfCompressedCreate(&desc, &sphere.sdf);
+	std::vector<float> denseDecoded = TestSdfDecode(dense, dim);
+	SdfCompressedRelease(dense);
+
+	// encoded and decoded as tasks, which must not change a bit
+	TaskPool* pool = TaskPoolCreate(4u);
+	TaskDispatchInterface dispatch;
+	TaskPoolGetInterface(pool, &dispatch);
+
+	SdfCompressDescDefaults(&desc);
+	const float band = TestSdfBand(desc, dim);
+	for (int run = 0; run < 2; run++)
+	{
+		desc.taskDispatch = (run == 0) ? nullptr : &dispatch;
+		SdfCompressed* bricks = SdfCompressedCreate(&desc, &sphere.sdf);
+		std::vector<float> decoded = TestSdfDecode(bricks, dim);
+		SdfCompressedRelease(bricks);
+
+		// identical within the band, past it the same sign at the band distance
+		NvFlowUint numMismatched = 0u;
+		for (size_t cellIdx = 0u; cellIdx < decoded.size(); cellIdx++)
+		{
+			const float denseValue = denseDecoded[cellIdx];
+			const float value = decoded[cellIdx];
+			if (fabsf(denseValue) < band)
+			{
+				numMismatched += (value != denseValue) ? 1u : 0u;
+			}
+			else
+			{
+				numMismatched += (value != HalfFloatToFloat(HalfFloatFromFloat(denseValue < 0.f ? -band : band))) ? 1u : 0u;
+			}
+		}
+		TEST_CHECK(numMismatched == 0u);
+	}
+
+	TaskPoolRelease(pool);
+}
@@ -0,0 +1,436 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+
+#include "test.h"
+#include "testShaderCPU.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// NvFlowShaderCPU.h against the NvFlowShader.h macros, over random tables and coordinates that
+// reach two blocks past every face of the grid. Results must match exactly.
+
+namespace
+{
+	const NvFlowUint testNumSamples = 4096u;
+
+	struct TestShaderConfig
+	{
+		NvFlowUint3 blockDim;
+		NvFlowUint3 gridDim;
+	};
+
+	const TestShaderConfig testConfigs[] = {
+		{ { 32u, 16u, 8u }, { 7u, 5u, 3u } },
+		{ { 8u, 8u, 8u }, { 4u, 4u, 4u } },
+		{ { 16u, 4u, 2u }, { 5u, 3u, 6u } },
+		{ { 1u, 2u, 4u }, { 6u, 6u, 6u } }
+	};
+
+	//! Levelled tables need at least 3 bits per axis, out of bounds loads decode as the reserved level 3
+	const TestShaderConfig testLodConfigs[] = {
+		{ { 8u, 8u, 8u }, { 4u, 4u, 4u } },
+		{ { 32u, 16u, 8u }, { 7u, 5u, 3u } },
+		{ { 8u, 64u, 16u }, { 3u, 2u, 5u } }
+	};
+
+	const NvFlowUint testNumConfigs = sizeof(testConfigs) / sizeof(testConfigs[0]);
+	const NvFlowUint testNumLodConfigs = sizeof(testLodConfigs) / sizeof(testLodConfigs[0]);
+
+	TestShaderTable testTable;
+
+	bool cpuHasAvx2()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+		{
+			return false;
+		}
+		__cpuid(info, 1);
+		const int osxsaveAvx = (1 << 27) | (1 << 28);
+		if ((info[2] & osxsaveAvx) != osxsaveAvx || (_xgetbv(0) & 6u) != 6u)
+		{
+			return false;
+		}
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+		return __builtin_cpu_supports("avx2") != 0;
+#else
+		return false;
+#endif
+	}
+}
+
+TEST_CASE(ShaderCPUVirtualToRealMatchesShader)
+{
+	for (NvFlowUint configIdx = 0u; configIdx < testNumConfigs; configIdx++)
+	{
+		TestShaderTableInit(&testTable, testConfigs[configIdx].blockDim, testConfigs[configIdx].gridDim, false, configIdx + 1u);
+		for (NvFlowUint isVTR = 0u; isVTR < 2u; isVTR++)
+		{
+			testTable.params.isVTR.x = isVTR;
+			TestShaderTableBind(&testTable);
+
+			NvFlowUint state = 17u * configIdx + isVTR;
+			NvFlowUint numMismatched = 0u;
+			for (NvFlowUint sampleIdx = 0u; sampleIdx < testNumSamples; sampleIdx++)
+			{
+				NvFlowInt3 vidx = TestShaderRandomCell(testTable.params, &state);
+				int3 expected = hlslVirtualToReal(int3(vidx.x, vidx.y, vidx.z));
+				if (!TestShaderSame(NvFlowCPU_virtualToReal(testTable.table, testTable.params, vidx), expected))
+				{
+					numMismatched++;
+				}
+			}
+			TEST_CHECK(numMismatched == 0u);
+		}
+	}
+}
+
+TEST_CASE(ShaderCPUVirtualToRealLinearMatchesShader)
+{
+	for (NvFlowUint configIdx = 0u; configIdx < testNumConfigs; configIdx++)
+	{
+		TestShaderTableInit(&testTable, testConfigs[configIdx].blockDim, testConfigs[configIdx].gridDim, false, configIdx + 5u);
+		for (NvFlowUint isVTR = 0u; isVTR < 2u; isVTR++)
+		{
+			testTable.params.isVTR.x = isVTR;
+			TestShaderTableBind(&testTable);
+
+			NvFlowUint state = 31u * configIdx + isVTR;
+			NvFlowUint numMismatched = 0u;
+			for (NvFlowUint sampleIdx = 0u; sampleIdx < testNumSamples; sampleIdx++)
+			{
+				NvFlowFloat3 vidx = TestShaderRandomPoint(testTable.params, &state);
+				float3 expected = hlslVirtualToRealLinear(float3(vidx.x, vidx.y, vidx.z));
+				if (!TestShaderSame(NvFlowCPU_virtualToRealLinear(testTable.table, testTable.params, vidx), expected))
+				{
+					numMismatched++;
+				}
+			}
+			TEST_CHECK(numMismatched == 0u);
+		}
+	}
+}
+
+TEST_CASE(ShaderCPUDispatchMatchesShader)
+{
+	for (NvFlowUint configIdx = 0u; configIdx < testNumConfigs; configIdx++)
+	{
+		TestShaderTableInit(&testTable, testConfigs[configIdx].blockDim, testConfigs[configIdx].gridDim, false, configIdx + 9u);
+		TestShaderTableBind(&testTable);
+
+		const NvFlowShaderLinearParams& params = testTable.params;
+		// dispatches cover the listed blocks, then run past the list, which loads 0
+		const NvFlowUint dispatchDimX = (testTable.numListBlocks + 3u) * params.blockDim.x;
+		NvFlowUint numMismatched = 0u;
+		for (NvFlowUint x = 0u; x < dispatchDimX; x++)
+		{
+			NvFlowUint3 tidx = { x, x * 7u % (2u * params.blockDim.y), x * 13u % (2u * params.blockDim.z) };
+			int3 expected = Hlsl32::DispatchIDToVirtual(uint3(tidx.x, tidx.y, tidx.z));
+			if (!TestShaderSame(NvFlowCPU_dispatchIDToVirtual(testTable.list, testTable.numListBlocks, params, tidx), expected))
+			{
+				numMismatched++;
+			}
+		}
+		TEST_CHECK(numMismatched == 0u);
+	}
+}
+
+TEST_CASE(ShaderCPUWideMatchesShader)
+{
+	for (NvFlowUint configIdx = 0u; configIdx < testNumConfigs; configIdx++)
+	{
+		TestShaderTableInit(&testTable, testConfigs[configIdx].blockDim, testConfigs[configIdx].gridDim, false, configIdx + 13u);
+		TestShaderTableBind(&testTable);
+
+		const NvFlowShaderLinearParams& params = testTable.params;
+		NvFlowShaderTableParams tableParams = {};
+		TEST_CHECK(!NvFlowCPU_isTableWide(tableParams));
+		tableParams.format.x = NV_FLOW_TABLE_FORMAT_WIDE;
+		TEST_CHECK(NvFlowCPU_isTableWide(tableParams));
+
+		NvFlowUint state = 43u * configIdx;
+		NvFlowUint numMismatched = 0u;
+		for (NvFlowUint sampleIdx = 0u; sampleIdx < testNumSamples; sampleIdx++)
+		{
+			NvFlowInt3 vidx = TestShaderRandomCell(params, &state);
+			if (!TestShaderSame(NvFlowCPU_virtualToRealWide(testTable.tableWide, params, vidx), hlslVirtualToRealWide(int3(vidx.x, vidx.y, vidx.z))))
+			{
+				numMismatched++;
+			}
+			NvFlowFloat3 vidxf = TestShaderRandomPoint(params, &state);
+			if (!TestShaderSame(NvFlowCPU_virtualToRealLinearWide(testTable.tableWide, params, vidxf), hlslVirtualToRealLinearWide(float3(vidxf.x, vidxf.y, vidxf.z))))
+			{
+				numMismatched++;
+			}
+		}
+		const NvFlowUint dispatchDimX = (testTable.numListBlocks + 3u) * params.blockDim.x;
+		for (NvFlowUint x = 0u; x < dispatchDimX; x++)
+		{
+			NvFlowUint3 tidx = { x, x * 7u % (2u * params.blockDim.y), x * 13u % (2u * params.blockDim.z) };
+			int3 expected = HlslWide::DispatchIDToVirtual(uint3(tidx.x, tidx.y, tidx.z));
+			if (!TestShaderSame(NvFlowCPU_dispatchIDToVirtualWide(testTable.listWide, testTable.numListBlocks, params, tidx), expected))
+			{
+				numMismatched++;
+			}
+		}
+		TEST_CHECK(numMismatched == 0u);
+	}
+}
+
+TEST_CASE(ShaderCPUWideAddressesPastTheNarrowLimit)
+{
+	const NvFlowUint4 narrowDim = { 1024u, 1024u, 1024u, 0u };
+	const NvFlowUint4 wideDim = { 4096u, 1024u, 64u, 0u };
+	TEST_CHECK(NvFlowCPU_tableFormatForGrid(narrowDim, narrowDim) == NV_FLOW_TABLE_FORMAT_32);
+	TEST_CHECK(NvFlowCPU_tableFormatForGrid(wideDim, narrowDim) == NV_FLOW_TABLE_FORMAT_WIDE);
+	TEST_CHECK(NvFlowCPU_tableFormatForGrid(narrowDim, wideDim) == NV_FLOW_TABLE_FORMAT_WIDE);
+
+	// coordinates past 10 bits, up to the 21 bit maximum, round trip on both sides
+	const NvFlowUint coords[][3] = { { 1024u, 0u, 1u }, { 4095u, 1500u, 2047u }, { 0x1FFFFFu, 0x1FFFFEu, 0x1FFFFDu }, { 0u, 0x1FFFFFu, 0u } };
+	for (const NvFlowUint* c : coords)
+	{
+		NvFlowUint64 val = NvFlowCPU_coord_to_tableValWide(c[0], c[1], c[2]);
+		TEST_CHECK(val == testTableValWide(c[0], c[1], c[2]));
+		NvFlowInt3 cpu = NvFlowCPU_tableValWide_to_coord(val);
+		int3 hlsl = NvFlow_tableValWide_to_coord(testSplitWide(val));
+		TEST_CHECK(TestShaderSame(cpu, hlsl));
+		TEST_CHECK(NvFlowUint(cpu.x) == c[0] && NvFlowUint(cpu.y) == c[1] && NvFlowUint(cpu.z) == c[2]);
+	}
+}
+
+TEST_CASE(ShaderCPULodMatchesShader)
+{
+	for (NvFlowUint configIdx = 0u; configIdx < testNumLodConfigs; configIdx++)
+	{
+		TestShaderTableInit(&testTable, testLodConfigs[configIdx].blockDim, testLodConfigs[configIdx].gridDim, true, configIdx + 17u);
+		TestShaderTableBind(&testTable);
+
+		const NvFlowShaderLinearParams& params = testTable.params;
+		TEST_CHECK(NvFlowCPU_hasTableLevels(testTable.tableParams));
+
+		NvFlowUint state = 59u * configIdx;
+		NvFlowUint numMismatched = 0u;
+		for (NvFlowUint sampleIdx = 0u; sampleIdx < testNumSamples; sampleIdx++)
+		{
+			NvFlowInt3 vidx = TestShaderRandomCell(params, &state);
+			if (!TestShaderSame(NvFlowCPU_virtualToRealLod(testTable.table, params, vidx), hlslVirtualToRealLod(int3(vidx.x, vidx.y, vidx.z))))
+			{
+				numMismatched++;
+			}
+			NvFlowFloat3 vidxf = TestShaderRandomPoint(params, &state);
+			if (!TestShaderSame(NvFlowCPU_virtualToRealLinearLod(testTable.table, params, vidxf), hlslVirtualToRealLinearLod(float3(vidxf.x, vidxf.y, vidxf.z))))
+			{
+				numMismatched++;
+			}
+		}
+		TEST_CHECK(numMismatched == 0u);
+
+		// level 0 tables read the same through either macro
+		for (NvFlowUint idx = 0u; idx < params.gridDim.w; idx++)
+		{
+			testTable.table[idx] |= 0xC0000000;
+		}
+		numMismatched = 0u;
+		for (NvFlowUint sampleIdx = 0u; sampleIdx < testNumSamples; sampleIdx++)
+		{
+			NvFlowInt3 vidx = TestShaderRandomCell(params, &state);
+			NvFlowFloat3 vidxf = TestShaderRandomPoint(params, &state);
+			if (NvFlowCPU_blockTableLoad(testTable.table, params, vidx.x >> int(params.blockDimBits.x), vidx.y >> int(params.blockDimBits.y), vidx.z >> int(params.blockDimBits.z)) != 0u &&
+				!TestShaderSame(NvFlowCPU_virtualToRealLod(testTable.table, params, vidx), hlslVirtualToReal(int3(vidx.x, vidx.y, vidx.z))))
+			{
+				numMismatched++;
+			}
+			if (NvFlowCPU_blockTableLoad(testTable.table, params, int(floorf(params.blockDimInv.x * vidxf.x)), int(floorf(params.blockDimInv.y * vidxf.y)), int(floorf(params.blockDimInv.z * vidxf.z))) != 0u &&
+				!TestShaderSame(NvFlowCPU_virtualToRealLinearLod(testTable.table, params, vidxf), hlslVirtualToRealLinear(float3(vidxf.x, vidxf.y, vidxf.z))))
+			{
+				numMismatched++;
+			}
+		}
+		TEST_CHECK(numMismatched == 0u);
+	}
+}
+
+TEST_CASE(ShaderCPULinearLodKeepsTheApron)
+{
+	const NvFlowUint3 blockDim = { 8u, 8u, 8u };
+	const NvFlowUint3 gridDim = { 2u, 2u, 2u };
+	TestShaderTableInit(&testTable, blockDim, gridDim, true, 5u);
+	const NvFlowShaderLinearParams& params = testTable.params;
+	TEST_CHECK(params.linearBlockDim.x == 10u && params.linearBlockOffset.x == 1u);
+
+	// level 1 blocks are 4 cells at a pitch of 10 >> 1 = 5, behind the same offset of 1
+	testTable.table[0] = NvFlowCPU_coord_to_tableValLevel(3u, 1u, 2u, 1u);
+	testTable.table[1] = NvFlowCPU_coord_to_tableValLevel(2u, 0u, 1u, 0u);
+	TestShaderTableBind(&testTable);
+
+	const NvFlowFloat3 coarse = { 2.5f, 4.f, 7.f };
+	NvFlowFloat3 cpu = NvFlowCPU_virtualToRealLinearLod(testTable.table, params, coarse);
+	TEST_CHECK(TestShaderSame(cpu, hlslVirtualToRealLinearLod(float3(coarse.x, coarse.y, coarse.z))));
+	TEST_CHECK_NEAR(cpu.x, 5.f * 3.f + 4.f * 0.3125f + 1.f, 0.f);
+	TEST_CHECK_NEAR(cpu.y, 5.f * 1.f + 4.f * 0.5f + 1.f, 0.f);
+	TEST_CHECK_NEAR(cpu.z, 5.f * 2.f + 4.f * 0.875f + 1.f, 0.f);
+
+	// level 0 blocks land where the macro without levels puts them
+	const NvFlowFloat3 fine = { 10.5f, 4.f, 7.f };
+	cpu = NvFlowCPU_virtualToRealLinearLod(testTable.table, params, fine);
+	TEST_CHECK(TestShaderSame(cpu, hlslVirtualToRealLinear(float3(fine.x, fine.y, fine.z))));
+	TEST_CHECK_NEAR(cpu.x, 10.f * 2.f + 2.5f + 1.f, 0.f);
+	TEST_CHECK_NEAR(cpu.y, 0.f + 4.f + 1.f, 0.f);
+	TEST_CHECK_NEAR(cpu.z, 10.f * 1.f + 7.f + 1.f, 0.f);
+}
+
+TEST_CASE(ShaderCPUBatchMatchesShader)
+{
+	const NvFlowUint maxCount = 37u;
+	NvFlowInt vx[maxCount], vy[maxCount], vz[maxCount], rx[maxCount], ry[maxCount], rz[maxCount];
+	float vxf[maxCount], vyf[maxCount], vzf[maxCount], rxf[maxCount], ryf[maxCount], rzf[maxCount];
+
+	for (NvFlowUint configIdx = 0u; configIdx < testNumConfigs; configIdx++)
+	{
+		TestShaderTableInit(&testTable, testConfigs[configIdx].blockDim, testConfigs[configIdx].gridDim, false, configIdx + 21u);
+		TestShaderTableBind(&testTable);
+
+		const NvFlowShaderLinearParams& params = testTable.params;
+		NvFlowUint state = 71u * configIdx;
+		NvFlowUint numMismatched = 0u;
+		// every count up to 37 exercises the full SIMD groups and each scalar tail, 8 and 16 run the fixed size wrappers
+		for (NvFlowUint count = 0u; count <= maxCount + 2u; count++)
+		{
+			const NvFlowUint n = count <= maxCount ? count : (count == maxCount + 1u ? 8u : 16u);
+			for (NvFlowUint idx = 0u; idx < n; idx++)
+			{
+				NvFlowInt3 vidx = TestShaderRandomCell(params, &state);
+				vx[idx] = vidx.x;
+				vy[idx] = vidx.y;
+				vz[idx] = vidx.z;
+				NvFlowFloat3 vidxf = TestShaderRandomPoint(params, &state);
+				vxf[idx] = vidxf.x;
+				vyf[idx] = vidxf.y;
+				vzf[idx] = vidxf.z;
+			}
+			if (count == maxCount + 1u)
+			{
+				NvFlowCPU_virtualToReal8(testTable.table, params, vx, vy, vz, rx, ry, rz);
+				NvFlowCPU_virtualToRealLinear8(testTable.table, params, vxf, vyf, vzf, rxf, ryf, rzf);
+			}
+			else if (count == maxCount + 2u)
+			{
+				NvFlowCPU_virtualToReal16(testTable.table, params, vx, vy, vz, rx, ry, rz);
+				NvFlowCPU_virtualToRealLinear16(testTable.table, params, vxf, vyf, vzf, rxf, ryf, rzf);
+			}
+			else
+			{
+				NvFlowCPU_virtualToRealBatch(testTable.table, params, vx, vy, vz, rx, ry, rz, n);
+				NvFlowCPU_virtualToRealLinearBatch(testTable.table, params, vxf, vyf, vzf, rxf, ryf, rzf, n);
+			}
+			for (NvFlowUint idx = 0u; idx < n; idx++)
+			{
+				if (!TestShaderSame(NvFlowInt3{ rx[idx], ry[idx], rz[idx] }, hlslVirtualToReal(int3(vx[idx], vy[idx], vz[idx]))))
+				{
+					numMismatched++;
+				}
+				if (!TestShaderSame(NvFlowFloat3{ rxf[idx], ryf[idx], rzf[idx] }, hlslVirtualToRealLinear(float3(vxf[idx], vyf[idx], vzf[idx]))))
+				{
+					numMismatched++;
+				}
+			}
+		}
+		TEST_CHECK(numMismatched == 0u);
+	}
+}
+
+TEST_CASE(ShaderCPUSse2MatchesShader)
+{
+#if NV_FLOW_SHADER_CPU_SSE2
+	for (NvFlowUint configIdx = 0u; configIdx < testNumConfigs; configIdx++)
+	{
+		TestShaderTableInit(&testTable, testConfigs[configIdx].blockDim, testConfigs[configIdx].gridDim, false, configIdx + 25u);
+		TestShaderTableBind(&testTable);
+
+		const NvFlowShaderLinearParams& params = testTable.params;
+		NvFlowUint state = 83u * configIdx;
+		NvFlowUint numMismatched = 0u;
+		for (NvFlowUint sampleIdx = 0u; sampleIdx < testNumSamples; sampleIdx += 4u)
+		{
+			NvFlowInt vx[4], vy[4], vz[4], rx[4], ry[4], rz[4];
+			float vxf[4], vyf[4], vzf[4], rxf[4], ryf[4], rzf[4];
+			for (NvFlowUint idx = 0u; idx < 4u; idx++)
+			{
+				NvFlowInt3 vidx = TestShaderRandomCell(params, &state);
+				vx[idx] = vidx.x;
+				vy[idx] = vidx.y;
+				vz[idx] = vidx.z;
+				NvFlowFloat3 vidxf = TestShaderRandomPoint(params, &state);
+				vxf[idx] = vidxf.x;
+				vyf[idx] = vidxf.y;
+				vzf[idx] = vidxf.z;
+			}
+			NvFlowShaderCPUDetail::virtualToReal4(testTable.table, params, vx, vy, vz, rx, ry, rz);
+			NvFlowShaderCPUDetail::virtualToRealLinear4(testTable.table, params, vxf, vyf, vzf, rxf, ryf, rzf);
+			for (NvFlowUint idx = 0u; idx < 4u; idx++)
+			{
+				if (!TestShaderSame(NvFlowInt3{ rx[idx], ry[idx], rz[idx] }, hlslVirtualToReal(int3(vx[idx], vy[idx], vz[idx]))))
+				{
+					numMismatched++;
+				}
+				if (!TestShaderSame(NvFlowFloat3{ rxf[idx], ryf[idx], rzf[idx] }, hlslVirtualToRealLinear(float3(vxf[idx], vyf[idx], vzf[idx]))))
+				{
+					numMismatched++;
+				}
+			}
+		}
+		TEST_CHECK(numMismatched == 0u);
+	}
+#else
+	printf("    skipped, SSE2 kernels not compiled in\n");
+#endif
+}
+
+TEST_CASE(ShaderCPUAvx2MatchesShader)
+{
+	if (!cpuHasAvx2())
+	{
+		printf("    skipped, no AVX2 on this CPU\n");
+		return;
+	}
+	NvFlowUint numCompared = 0u;
+	NvFlowUint numMismatched = TestShaderCPUAvx2Mismatches(&numCompared);
+	if (numMismatched == ~0u)
+	{
+		printf("    skipped, AVX2 kernels not compiled in\n");
+		return;
+	}
+	TEST_CHECK(numCompared > 0u);
+	TEST_CHECK(numMismatched == 0u);
+}
@@ -0,0 +1,361 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+
+#pragma once
+
+#include <math.h>
+#include <string.h>
+
+#include "NvFlowTypes.h"
+
+// Reference for the NvFlowShaderCPU.h tests: the NV_FLOW_SHADER_UTILS macros of NvFlowShader.h,
+// expanded as C++ over a minimal set of HLSL vector types. Operand types convert as in HLSL,
+// int with uint gives uint and shifts keep the left type, and resource loads outside the
+// table or list return 0 as D3D does. Everything here has internal linkage, so the SSE2 and
+// AVX2 test files each get their own copy, and the helpers below avoid std containers and the
+// NvFlowCPU_ scalar functions so no code built for AVX2 is shared with the rest of the tests.
+
+namespace
+{
+	typedef unsigned int uint;
+
+	template <typename T>
+	struct HlslVec2
+	{
+		T x, y;
+	};
+
+	template <typename T>
+	struct HlslVec3
+	{
+		T x, y, z;
+
+		HlslVec3() = default;
+		HlslVec3(T xIn, T yIn, T zIn) : x(xIn), y(yIn), z(zIn) {}
+		template <typename U>
+		HlslVec3(const HlslVec3<U>& v) : x(T(v.x)), y(T(v.y)), z(T(v.z)) {}
+	};
+
+	template <typename T>
+	struct HlslVec4
+	{
+		union
+		{
+			struct
+			{
+				T x, y, z, w;
+			};
+			HlslVec3<T> xyz;
+		};
+	};
+
+	typedef HlslVec2<uint> uint2;
+	typedef HlslVec3<int> int3;
+	typedef HlslVec3<uint> uint3;
+	typedef HlslVec3<float> float3;
+	typedef HlslVec4<uint> uint4;
+	typedef HlslVec4<float> float4;
+
+#define TEST_HLSL_BINARY_OP(op) \
+	template <typename T, typename U> \
+	HlslVec3<decltype(T() op U())> operator op(const HlslVec3<T>& a, const HlslVec3<U>& b) \
+	{ \
+		return HlslVec3<decltype(T() op U())>(a.x op b.x, a.y op b.y, a.z op b.z); \
+	} \
+	template <typename T> \
+	HlslVec3<decltype(T() op uint())> operator op(const HlslVec3<T>& a, uint b) \
+	{ \
+		return HlslVec3<decltype(T() op uint())>(a.x op b, a.y op b, a.z op b); \
+	}
+
+	TEST_HLSL_BINARY_OP(+)
+	TEST_HLSL_BINARY_OP(-)
+	TEST_HLSL_BINARY_OP(*)
+	TEST_HLSL_BINARY_OP(&)
+	TEST_HLSL_BINARY_OP(|)
+	TEST_HLSL_BINARY_OP(<<)
+	TEST_HLSL_BINARY_OP(>>)
+
+#undef TEST_HLSL_BINARY_OP
+
+	uint2 operator~(const uint2& a)
+	{
+		return uint2{ ~a.x, ~a.y };
+	}
+
+	float3 floor(const float3& v)
+	{
+		return float3(floorf(v.x), floorf(v.y), floorf(v.z));
+	}
+
+	//! Texture3D<uint> or Texture3D<uint2>
+	template <typename T>
+	struct HlslTexture3D
+	{
+		const T* data;
+		uint3 dim;
+
+		T operator[](const int3& idx) const
+		{
+			if (uint(idx.x) >= dim.x || uint(idx.y) >= dim.y || uint(idx.z) >= dim.z)
+			{
+				return T();
+			}
+			return data[(uint(idx.z) * dim.y + uint(idx.y)) * dim.x + uint(idx.x)];
+		}
+	};
+
+	//! Buffer<uint> or Buffer<uint2>
+	template <typename T>
+	struct HlslBuffer
+	{
+		const T* data;
+		uint dim;
+
+		T operator[](uint idx) const
+		{
+			return idx < dim ? data[idx] : T();
+		}
+	};
+
+	//! The fields of NvFlowShaderLinearParams the macros read
+	struct HlslParams
+	{
+		uint4 isVTR;
+		uint4 blockDim;
+		uint4 blockDimBits;
+		float4 blockDimInv;
+		uint4 linearBlockDim;
+		uint4 linearBlockOffset;
+	};
+
+	struct HlslResources
+	{
+		HlslParams params;
+		HlslTexture3D<uint> table;
+		HlslTexture3D<uint2> tableWide;
+		HlslBuffer<uint> list;
+		HlslBuffer<uint2> listWide;
+	};
+
+	HlslResources g_hlsl;
+
+#define NV_FLOW_SHADER_UTILS 1
+#include "NvFlowShader.h"
+
+	inline NV_FLOW_VIRTUAL_TO_REAL(hlslVirtualToReal, g_hlsl.table, g_hlsl.params)
+	inline NV_FLOW_VIRTUAL_TO_REAL_LINEAR(hlslVirtualToRealLinear, g_hlsl.table, g_hlsl.params)
+	inline NV_FLOW_VIRTUAL_TO_REAL_WIDE(hlslVirtualToRealWide, g_hlsl.tableWide, g_hlsl.params)
+	inline NV_FLOW_VIRTUAL_TO_REAL_LINEAR_WIDE(hlslVirtualToRealLinearWide, g_hlsl.tableWide, g_hlsl.params)
+	inline NV_FLOW_VIRTUAL_TO_REAL_LOD(hlslVirtualToRealLod, g_hlsl.table, g_hlsl.params)
+	inline NV_FLOW_VIRTUAL_TO_REAL_LINEAR_LOD(hlslVirtualToRealLinearLod, g_hlsl.table, g_hlsl.params)
+
+	namespace Hlsl32
+	{
+		inline NV_FLOW_DISPATCH_ID_TO_VIRTUAL(g_hlsl.list, g_hlsl.params)
+	}
+
+	namespace HlslWide
+	{
+		inline NV_FLOW_DISPATCH_ID_TO_VIRTUAL_WIDE(g_hlsl.listWide, g_hlsl.params)
+	}
+}
+
+#include "NvFlowShaderCPU.h"
+
+namespace
+{
+	enum
+	{
+		eTestShaderMaxBlocks = 256
+	};
+
+	//! Block table, list and params for one test configuration, with the HLSL view of the same data
+	struct TestShaderTable
+	{
+		NvFlowShaderLinearParams params;
+		NvFlowShaderTableParams tableParams;
+		NvFlowUint table[eTestShaderMaxBlocks];
+		NvFlowUint64 tableWide[eTestShaderMaxBlocks];
+		uint2 tableWideHlsl[eTestShaderMaxBlocks];
+		NvFlowUint numListBlocks;
+		NvFlowUint list[eTestShaderMaxBlocks];
+		NvFlowUint64 listWide[eTestShaderMaxBlocks];
+		uint2 listWideHlsl[eTestShaderMaxBlocks];
+	};
+
+	NvFlowUint testRandom(NvFlowUint* state)
+	{
+		*state = *state * 1664525u + 1013904223u;
+		return *state ^ (*state >> 16u);
+	}
+
+	NvFlowUint testTableVal(NvFlowUint x, NvFlowUint y, NvFlowUint z, NvFlowUint level)
+	{
+		return ~(x | (y << 10u) | (z << 20u) | (level << 30u));
+	}
+
+	NvFlowUint64 testTableValWide(NvFlowUint x, NvFlowUint y, NvFlowUint z)
+	{
+		return ~(NvFlowUint64(x) | (NvFlowUint64(y) << 21u) | (NvFlowUint64(z) << 42u));
+	}
+
+	uint2 testSplitWide(NvFlowUint64 val)
+	{
+		return uint2{ NvFlowUint(val), NvFlowUint(val >> 32u) };
+	}
+
+	NvFlowUint testLog2(NvFlowUint dim)
+	{
+		NvFlowUint bits = 0u;
+		while ((1u << bits) < dim) bits++;
+		return bits;
+	}
+
+	/**
+	 * Fill a table and block list with random entries.
+	 *
+	 * @param[in] blockDim Cells per block, powers of two. With levels every axis needs at least 3 bits,
+	 *     out of bounds loads return 0, which decodes as the reserved level 3.
+	 * @param[in] gridDim Virtual blocks per axis, at most eTestShaderMaxBlocks in total.
+	 * @param[in] levels Table values carry random block levels, otherwise half of them are arbitrary bit patterns.
+	 * @param[in] seed Random seed.
+	 */
+	void TestShaderTableInit(TestShaderTable* t, NvFlowUint3 blockDim, NvFlowUint3 gridDim, bool levels, NvFlowUint seed)
+	{
+		NvFlowShaderLinearParams& params = t->params;
+		memset(&params, 0, sizeof(params));
+		t->tableParams.format = { NV_FLOW_TABLE_FORMAT_32, NvFlowUint(levels ? NV_FLOW_TABLE_LEVELS_ON : NV_FLOW_TABLE_LEVELS_OFF), 0u, 0u };
+		params.blockDim = { blockDim.x, blockDim.y, blockDim.z, blockDim.x * blockDim.y * blockDim.z };
+		params.blockDimBits = { testLog2(blockDim.x), testLog2(blockDim.y), testLog2(blockDim.z), 0u };
+		params.poolGridDim = { 6u, 5u, 4u, 6u * 5u * 4u };
+		params.gridDim = { gridDim.x, gridDim.y, gridDim.z, gridDim.x * gridDim.y * gridDim.z };
+		params.blockDimInv = { 1.f / float(blockDim.x), 1.f / float(blockDim.y), 1.f / float(blockDim.z), 0.f };
+		// one cell of apron, as the linear pools carry
+		params.linearBlockDim = { blockDim.x + 2u, blockDim.y + 2u, blockDim.z + 2u, 0u };
+		params.linearBlockOffset = { 1u, 1u, 1u, 0u };
+
+		NvFlowUint state = seed;
+		const NvFlowUint numEntries = params.gridDim.w;
+		for (NvFlowUint idx = 0u; idx < numEntries; idx++)
+		{
+			NvFlowUint r = testRandom(&state);
+			if (levels)
+			{
+				NvFlowUint level = r % (NV_FLOW_TABLE_MAX_LEVEL + 1u);
+				t->table[idx] = testTableVal(
+					testRandom(&state) % (params.poolGridDim.x << level),
+					testRandom(&state) % (params.poolGridDim.y << level),
+					testRandom(&state) % (params.poolGridDim.z << level),
+					level);
+			}
+			else if (r & 1u)
+			{
+				t->table[idx] = testRandom(&state);
+			}
+			else
+			{
+				t->table[idx] = testTableVal(r % params.poolGridDim.x, (r >> 8u) % params.poolGridDim.y, (r >> 16u) % params.poolGridDim.z, 0u);
+			}
+			t->tableWide[idx] = (NvFlowUint64(testRandom(&state)) << 32u) | testRandom(&state);
+			t->tableWideHlsl[idx] = testSplitWide(t->tableWide[idx]);
+		}
+
+		t->numListBlocks = 1u + testRandom(&state) % numEntries;
+		for (NvFlowUint idx = 0u; idx < t->numListBlocks; idx++)
+		{
+			NvFlowUint r = testRandom(&state);
+			NvFlowUint x = r % params.gridDim.x;
+			NvFlowUint y = (r >> 8u) % params.gridDim.y;
+			NvFlowUint z = (r >> 16u) % params.gridDim.z;
+			t->list[idx] = testTableVal(x, y, z, 0u);
+			t->listWide[idx] = testTableValWide(x, y, z);
+			t->listWideHlsl[idx] = testSplitWide(t->listWide[idx]);
+		}
+	}
+
+	//! Points the HLSL resources at the table
+	void TestShaderTableBind(const TestShaderTable* t)
+	{
+		const NvFlowShaderLinearParams& params = t->params;
+		HlslParams& hlslParams = g_hlsl.params;
+		memcpy(&hlslParams.isVTR, &params.isVTR, sizeof(uint4));
+		memcpy(&hlslParams.blockDim, &params.blockDim, sizeof(uint4));
+		memcpy(&hlslParams.blockDimBits, &params.blockDimBits, sizeof(uint4));
+		memcpy(&hlslParams.blockDimInv, &params.blockDimInv, sizeof(float4));
+		memcpy(&hlslParams.linearBlockDim, &params.linearBlockDim, sizeof(uint4));
+		memcpy(&hlslParams.linearBlockOffset, &params.linearBlockOffset, sizeof(uint4));
+
+		const uint3 gridDim(params.gridDim.x, params.gridDim.y, params.gridDim.z);
+		g_hlsl.table = { t->table, gridDim };
+		g_hlsl.tableWide = { t->tableWideHlsl, gridDim };
+		g_hlsl.list = { t->list, t->numListBlocks };
+		g_hlsl.listWide = { t->listWideHlsl, t->numListBlocks };
+	}
+
+	//! Virtual cell coordinates over the grid and up to two blocks past each face
+	NvFlowInt3 TestShaderRandomCell(const NvFlowShaderLinearParams& params, NvFlowUint* state)
+	{
+		const int margin[3] = { 2 * int(params.blockDim.x), 2 * int(params.blockDim.y), 2 * int(params.blockDim.z) };
+		const int extent[3] = { int(params.gridDim.x * params.blockDim.x), int(params.gridDim.y * params.blockDim.y), int(params.gridDim.z * params.blockDim.z) };
+		int v[3];
+		for (int c = 0; c < 3; c++)
+		{
+			v[c] = int(testRandom(state) % NvFlowUint(extent[c] + 2 * margin[c])) - margin[c];
+		}
+		return NvFlowInt3{ v[0], v[1], v[2] };
+	}
+
+	NvFlowFloat3 TestShaderRandomPoint(const NvFlowShaderLinearParams& params, NvFlowUint* state)
+	{
+		NvFlowInt3 cell = TestShaderRandomCell(params, state);
+		const float fx = float(testRandom(state) & 0xFFFF) / 65536.f;
+		const float fy = float(testRandom(state) & 0xFFFF) / 65536.f;
+		const float fz = float(testRandom(state) & 0xFFFF) / 65536.f;
+		return NvFlowFloat3{ float(cell.x) + fx, float(cell.y) + fy, float(cell.z) + fz };
+	}
+
+	bool TestShaderSame(const NvFlowInt3& a, const int3& b)
+	{
+		return a.x == b.x && a.y == b.y && a.z == b.z;
+	}
+
+	bool TestShaderSame(const NvFlowFloat3& a, const float3& b)
+	{
+		return memcmp(&a.x, &b.x, sizeof(float)) == 0 && memcmp(&a.y, &b.y, sizeof(float)) == 0 && memcmp(&a.z, &b.z, sizeof(float)) == 0;
+	}
+}
+
+/**
+ * Compare the AVX2 kernels of NvFlowShaderCPU.h against the HLSL macros, built with AVX2 enabled.
+ *
+ * @param[out] numCompared Coordinates compared.
+ *
+ * @return Returns the number of mismatched coordinates, or ~0u if the AVX2 kernels are not compiled in.
+ */
+NvFlowUint TestShaderCPUAvx2Mismatches(NvFlowUint* numCompared);
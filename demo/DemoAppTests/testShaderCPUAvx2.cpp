@@ -0,0 +1,93 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+
+// Built with AVX2 enabled, so NvFlowShaderCPU.h compiles its 8 wide kernels here.
+// Only TestShaderCPUAvx2Mismatches() is visible outside, callers check the CPU first.
+
+#include "testShaderCPU.h"
+
+namespace
+{
+	const NvFlowUint testNumAvx2Samples = 4096u;
+
+	const NvFlowUint3 testAvx2BlockDims[] = { { 32u, 16u, 8u }, { 8u, 8u, 8u }, { 16u, 4u, 2u }, { 1u, 2u, 4u } };
+	const NvFlowUint3 testAvx2GridDims[] = { { 7u, 5u, 3u }, { 4u, 4u, 4u }, { 5u, 3u, 6u }, { 6u, 6u, 6u } };
+
+#if NV_FLOW_SHADER_CPU_AVX2
+	TestShaderTable testAvx2Table;
+#endif
+}
+
+NvFlowUint TestShaderCPUAvx2Mismatches(NvFlowUint* numCompared)
+{
+	*numCompared = 0u;
+#if NV_FLOW_SHADER_CPU_AVX2
+	NvFlowUint numMismatched = 0u;
+	for (NvFlowUint configIdx = 0u; configIdx < 4u; configIdx++)
+	{
+		TestShaderTableInit(&testAvx2Table, testAvx2BlockDims[configIdx], testAvx2GridDims[configIdx], false, configIdx + 29u);
+		TestShaderTableBind(&testAvx2Table);
+
+		const NvFlowShaderLinearParams& params = testAvx2Table.params;
+		NvFlowUint state = 97u * configIdx;
+		for (NvFlowUint sampleIdx = 0u; sampleIdx < testNumAvx2Samples; sampleIdx += 8u)
+		{
+			NvFlowInt vx[8], vy[8], vz[8], rx[8], ry[8], rz[8];
+			float vxf[8], vyf[8], vzf[8], rxf[8], ryf[8], rzf[8];
+			for (NvFlowUint idx = 0u; idx < 8u; idx++)
+			{
+				NvFlowInt3 vidx = TestShaderRandomCell(params, &state);
+				vx[idx] = vidx.x;
+				vy[idx] = vidx.y;
+				vz[idx] = vidx.z;
+				NvFlowFloat3 vidxf = TestShaderRandomPoint(params, &state);
+				vxf[idx] = vidxf.x;
+				vyf[idx] = vidxf.y;
+				vzf[idx] = vidxf.z;
+			}
+			NvFlowShaderCPUDetail::virtualToReal8(testAvx2Table.table, params, vx, vy, vz, rx, ry, rz);
+			NvFlowShaderCPUDetail::virtualToRealLinear8(testAvx2Table.table, params, vxf, vyf, vzf, rxf, ryf, rzf);
+			for (NvFlowUint idx = 0u; idx < 8u; idx++)
+			{
+				if (!TestShaderSame(NvFlowInt3{ rx[idx], ry[idx], rz[idx] }, hlslVirtualToReal(int3(vx[idx], vy[idx], vz[idx]))))
+				{
+					numMismatched++;
+				}
+				if (!TestShaderSame(NvFlowFloat3{ rxf[idx], ryf[idx], rzf[idx] }, hlslVirtualToRealLinear(float3(vxf[idx], vyf[idx], vzf[idx]))))
+				{
+					numMismatched++;
+				}
+				*numCompared += 2u;
+			}
+		}
+	}
+	return numMismatched;
+#else
+	return ~0u;
+#endif
+}
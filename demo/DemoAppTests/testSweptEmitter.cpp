@@ -0,0 +1,197 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <vector>
+
+#include "test.h"
+#include "testGrid.h"
+#include "emitterSet.h"
+#include "sweptEmitter.h"
+
+namespace
+{
+	const NvFlowFloat3 testSweepBegin = { -1.f, 0.f, 0.25f };
+	const NvFlowFloat3 testSweepEnd = { 1.f, 0.5f, -0.25f };
+	const float testSweepRadius = 0.2f;		//!< World space radius of the swept sphere
+
+	float testDot(const NvFlowFloat4& row, const NvFlowFloat3& v)
+	{
+		return row.x * v.x + row.y * v.y + row.z * v.z;
+	}
+
+	//! Local coordinates of p, the transforms here have orthogonal rows
+	NvFlowFloat3 testToLocal(const NvFlowFloat4x4& m, const NvFlowFloat3& p)
+	{
+		const NvFlowFloat3 d = { p.x - m.w.x, p.y - m.w.y, p.z - m.w.z };
+		const NvFlowFloat3 dx = { m.x.x, m.x.y, m.x.z };
+		const NvFlowFloat3 dy = { m.y.x, m.y.y, m.y.z };
+		const NvFlowFloat3 dz = { m.z.x, m.z.y, m.z.z };
+		return {
+			testDot(m.x, d) / testDot(m.x, dx),
+			testDot(m.y, d) / testDot(m.y, dy),
+			testDot(m.z, d) / testDot(m.z, dz)
+		};
+	}
+
+	//! True if p is inside the emitter shape and its bounds
+	bool testCovers(const NvFlowShapeDesc& shape, const NvFlowGridEmitParams& params, const NvFlowFloat3& p)
+	{
+		NvFlowFloat3 b = testToLocal(params.bounds, p);
+		if (fabsf(b.x) > 1.f || fabsf(b.y) > 1.f || fabsf(b.z) > 1.f)
+		{
+			return false;
+		}
+		NvFlowFloat3 q = testToLocal(params.localToWorld, p);
+		float radius = shape.sphere.radius;
+		if (params.shapeType == eNvFlowShapeTypeCapsule)
+		{
+			const float halfLength = 0.5f * shape.capsule.length;
+			q.x -= fmaxf(-halfLength, fminf(q.x, halfLength));
+			radius = shape.capsule.radius;
+		}
+		return sqrtf(q.x * q.x + q.y * q.y + q.z * q.z) <= radius;
+	}
+
+	//! Sphere of testSweepRadius at local scale 2, swept from testSweepBegin to testSweepEnd
+	void TestSweptEmitDesc(SweptEmitMode mode, SweptEmitDesc* desc)
+	{
+		const float scale = 2.f;
+		TestGridFireBall(0.f, &desc->shape, &desc->params);
+		desc->shape.sphere.radius = testSweepRadius / scale;
+		desc->params.localToWorld.x.x = scale;
+		desc->params.localToWorld.y.y = scale;
+		desc->params.localToWorld.z.z = scale;
+		desc->params.localToWorld.w = { testSweepBegin.x, testSweepBegin.y, testSweepBegin.z, 1.f };
+		desc->params.bounds.x.x = 1.5f * testSweepRadius;
+		desc->params.bounds.y.y = 1.5f * testSweepRadius;
+		desc->params.bounds.z.z = 1.5f * testSweepRadius;
+		desc->params.bounds.w = desc->params.localToWorld.w;
+		desc->localToWorldEnd = desc->params.localToWorld;
+		desc->localToWorldEnd.w = { testSweepEnd.x, testSweepEnd.y, testSweepEnd.z, 1.f };
+		desc->boundsEnd = desc->params.bounds;
+		desc->boundsEnd.w = desc->localToWorldEnd.w;
+		desc->numSubSteps = 12u;
+		desc->deltaTime = 1.f / 30.f;
+		desc->mode = mode;
+	}
+
+	struct TestSweepCoverage
+	{
+		NvFlowUint numEmitters = 0u;
+		NvFlowUint numPathPoints = 0u;
+		NvFlowUint numPathCovered = 0u;
+		NvFlowUint numOuterCovered = 0u;
+		float deltaTimeSum = 0.f;
+	};
+
+	//! Emits the sweep and tests points along the path, inside and outside the swept radius
+	TestSweepCoverage TestSweepCover(const SweptEmitDesc* desc)
+	{
+		EmitterSet emitterSet;
+		TestSweepCoverage coverage;
+		NvFlowUint numAdded = SweptEmit(&emitterSet, desc);
+
+		const NvFlowShapeDesc* shapes = nullptr;
+		const NvFlowGridEmitParams* params = nullptr;
+		coverage.numEmitters = emitterSet.gather(desc->deltaTime, nullptr, &shapes, &params);
+		if (numAdded != coverage.numEmitters)
+		{
+			coverage.numEmitters = 0u;
+		}
+		for (NvFlowUint idx = 0u; idx < coverage.numEmitters; idx++)
+		{
+			coverage.deltaTimeSum += params[idx].deltaTime;
+		}
+
+		// a side direction perpendicular to the path
+		const NvFlowFloat3 delta = { testSweepEnd.x - testSweepBegin.x, testSweepEnd.y - testSweepBegin.y, testSweepEnd.z - testSweepBegin.z };
+		const NvFlowFloat3 side = { 0.f, -delta.z, delta.y };
+		const float sideLength = sqrtf(side.y * side.y + side.z * side.z);
+
+		const NvFlowUint numSamples = 64u;
+		for (NvFlowUint sampleIdx = 0u; sampleIdx <= numSamples; sampleIdx++)
+		{
+			const float t = float(sampleIdx) / float(numSamples);
+			for (float offset : { 0.f, 0.5f * testSweepRadius, -0.5f * testSweepRadius, 1.5f * testSweepRadius })
+			{
+				const float s = offset / sideLength;
+				const NvFlowFloat3 p = {
+					testSweepBegin.x + t * delta.x,
+					testSweepBegin.y + t * delta.y + s * side.y,
+					testSweepBegin.z + t * delta.z + s * side.z
+				};
+				bool covered = false;
+				for (NvFlowUint idx = 0u; idx < coverage.numEmitters && !covered; idx++)
+				{
+					covered = testCovers(shapes[params[idx].shapeRangeOffset], params[idx], p);
+				}
+				if (offset > testSweepRadius)
+				{
+					coverage.numOuterCovered += covered ? 1u : 0u;
+				}
+				else
+				{
+					coverage.numPathPoints++;
+					coverage.numPathCovered += covered ? 1u : 0u;
+				}
+			}
+		}
+
+		emitterSet.release();
+		return coverage;
+	}
+}
+
+TEST_CASE(SweptEmitSubStepsCoverThePath)
+{
+	SweptEmitDesc desc;
+	TestSweptEmitDesc(eSweptEmitModeSubSteps, &desc);
+	TestSweepCoverage coverage = TestSweepCover(&desc);
+	TEST_CHECK(coverage.numEmitters == desc.numSubSteps);
+	TEST_CHECK(coverage.numPathPoints > 0u);
+	TEST_CHECK(coverage.numPathCovered == coverage.numPathPoints);
+	TEST_CHECK(coverage.numOuterCovered == 0u);
+	TEST_CHECK_NEAR(coverage.deltaTimeSum, desc.deltaTime, 1e-6f);
+}
+
+TEST_CASE(SweptEmitCapsuleCoversThePath)
+{
+	SweptEmitDesc desc;
+	TestSweptEmitDesc(eSweptEmitModeCapsule, &desc);
+	TestSweepCoverage coverage = TestSweepCover(&desc);
+	TEST_CHECK(coverage.numEmitters == 1u);
+	TEST_CHECK(coverage.numPathCovered == coverage.numPathPoints);
+	TEST_CHECK(coverage.numOuterCovered == 0u);
+	TEST_CHECK_NEAR(coverage.deltaTimeSum, desc.deltaTime, 1e-6f);
+
+	// a rotating sphere cannot become a capsule, it falls back to sub steps
+	desc.localToWorldEnd.x = { 0.f, 2.f, 0.f, 0.f };
+	desc.localToWorldEnd.y = { -2.f, 0.f, 0.f, 0.f };
+	coverage = TestSweepCover(&desc);
+	TEST_CHECK(coverage.numEmitters == desc.numSubSteps);
+	TEST_CHECK(coverage.numPathCovered == coverage.numPathPoints);
+}
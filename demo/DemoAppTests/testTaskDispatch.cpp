@@ -0,0 +1,225 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#include "test.h"
+#include "testGrid.h"
+#include "taskDispatch.h"
+
+namespace
+{
+	//! Item value, cheap but order sensitive so a missed or doubled item shows
+	NvFlowUint TestTaskValue(NvFlowUint row, NvFlowUint column)
+	{
+		NvFlowUint hash = row * 0x9E3779B1u ^ (column + 0x7F4A7C15u);
+		hash ^= hash >> 15u;
+		hash *= 0x2C1B3C6Du;
+		return hash ^ (hash >> 12u);
+	}
+
+	//! Fills rows by columns values, the rows dispatched and each row dispatching its columns
+	void TestTaskFill(const TaskDispatchInterface* dispatch, NvFlowUint numRows, NvFlowUint numColumns, std::vector<NvFlowUint>& values)
+	{
+		values.assign(numRows * numColumns, 0u);
+		TaskDispatchRange(dispatch, numRows, 1u, [&](NvFlowUint rowBegin, NvFlowUint rowEnd)
+		{
+			for (NvFlowUint row = rowBegin; row < rowEnd; row++)
+			{
+				TaskDispatchRange(dispatch, numColumns, 4u, [&](NvFlowUint begin, NvFlowUint end)
+				{
+					for (NvFlowUint column = begin; column < end; column++)
+					{
+						values[row * numColumns + column] += TestTaskValue(row, column);
+					}
+				});
+			}
+		});
+	}
+}
+
+TEST_CASE(TaskDispatchRangeCoversEveryItemOnce)
+{
+	TaskPool* pool = TaskPoolCreate(4u);
+	TaskDispatchInterface dispatch;
+	TaskPoolGetInterface(pool, &dispatch);
+	TEST_CHECK(dispatch.numThreads == 4u);
+
+	const NvFlowUint itemCounts[] = { 0u, 1u, 7u, 16u, 1000u };
+	const NvFlowUint grainSizes[] = { 1u, 3u, 64u };
+	for (NvFlowUint numItems : itemCounts)
+	{
+		for (NvFlowUint grainSize : grainSizes)
+		{
+			std::vector<std::atomic<NvFlowUint>> counts(numItems);
+			for (auto& count : counts)
+			{
+				count = 0u;
+			}
+			std::atomic<NvFlowUint> numRanges(0u);
+			std::atomic<bool> rangesValid(true);
+			TaskDispatchRange(&dispatch, numItems, grainSize, [&](NvFlowUint begin, NvFlowUint end)
+			{
+				if (begin >= end || end > numItems)
+				{
+					rangesValid = false;
+				}
+				for (NvFlowUint idx = begin; idx < end; idx++)
+				{
+					counts[idx]++;
+				}
+				numRanges++;
+			});
+			TEST_CHECK(rangesValid);
+			for (auto& count : counts)
+			{
+				TEST_CHECK(count == 1u);
+			}
+			// ranges hold at least grainSize items, but the last
+			TEST_CHECK(numRanges <= (numItems + grainSize - 1u) / grainSize);
+		}
+	}
+
+	TaskPoolRelease(pool);
+}
+
+TEST_CASE(TaskPoolNestedDispatchMatchesSerial)
+{
+	const NvFlowUint numRows = 37u;
+	const NvFlowUint numColumns = 129u;
+
+	std::vector<NvFlowUint> serial;
+	TestTaskFill(nullptr, numRows, numColumns, serial);
+
+	const NvFlowUint workerCounts[] = { 1u, 2u, 8u };
+	for (NvFlowUint numWorkers : workerCounts)
+	{
+		TaskPool* pool = TaskPoolCreate(numWorkers);
+		TaskDispatchInterface dispatch;
+		TaskPoolGetInterface(pool, &dispatch);
+
+		std::vector<NvFlowUint> values;
+		TestTaskFill(&dispatch, numRows, numColumns, values);
+		TEST_CHECK(values == serial);
+
+		TaskPoolRelease(pool);
+	}
+}
+
+TEST_CASE(TaskPoolConcurrentDispatchMatchesSerial)
+{
+	const NvFlowUint numRows = 23u;
+	const NvFlowUint numColumns = 65u;
+	const NvFlowUint numCallers = 4u;
+	const NvFlowUint numRepeats = 50u;
+
+	std::vector<NvFlowUint> serial;
+	TestTaskFill(nullptr, numRows, numColumns, serial);
+
+	TaskPool* pool = TaskPoolCreate(4u);
+	TaskDispatchInterface dispatch;
+	TaskPoolGetInterface(pool, &dispatch);
+
+	// callers share the pool, their dispatches queue on each other
+	std::vector<NvFlowUint> numMatched(numCallers, 0u);
+	std::vector<std::thread> callers;
+	for (NvFlowUint callerIdx = 0u; callerIdx < numCallers; callerIdx++)
+	{
+		callers.push_back(std::thread([&, callerIdx]()
+		{
+			std::vector<NvFlowUint> values;
+			for (NvFlowUint repeat = 0u; repeat < numRepeats; repeat++)
+			{
+				TestTaskFill(&dispatch, numRows, numColumns, values);
+				numMatched[callerIdx] += (values == serial) ? 1u : 0u;
+			}
+		}));
+	}
+	for (auto& caller : callers)
+	{
+		caller.join();
+	}
+	for (NvFlowUint callerIdx = 0u; callerIdx < numCallers; callerIdx++)
+	{
+		TEST_CHECK(numMatched[callerIdx] == numRepeats);
+	}
+
+	TaskPoolRelease(pool);
+}
+
+TEST_CASE(TaskPoolSharedByGridsMatchesSerial)
+{
+	const float dt = 1.f / 60.f;
+	const int numFrames = 20;
+
+	CpuGridDesc desc;
+	TestGridDescDefaults(&desc);
+	desc.numWorkers = 1u;
+	CpuGrid* serialGrid = CpuGridCreate(&desc);
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		TestGridStep(serialGrid, float(frame) * dt, dt);
+	}
+	NvFlowUint64 serialVelocity = 0u, serialDensity = 0u;
+	TestGridChecksum(serialGrid, &serialVelocity, &serialDensity);
+	CpuGridRelease(serialGrid);
+
+	// two grids stepped from their own threads on one engine pool
+	TaskPool* pool = TaskPoolCreate(4u);
+	TaskDispatchInterface dispatch;
+	TaskPoolGetInterface(pool, &dispatch);
+	desc.taskDispatch = &dispatch;
+
+	NvFlowUint64 velocity[2] = {}, density[2] = {};
+	std::vector<std::thread> callers;
+	for (int gridIdx = 0; gridIdx < 2; gridIdx++)
+	{
+		callers.push_back(std::thread([&, gridIdx]()
+		{
+			CpuGrid* grid = CpuGridCreate(&desc);
+			for (int frame = 0; frame < numFrames; frame++)
+			{
+				TestGridStep(grid, float(frame) * dt, dt);
+			}
+			TestGridChecksum(grid, &velocity[gridIdx], &density[gridIdx]);
+			CpuGridRelease(grid);
+		}));
+	}
+	for (auto& caller : callers)
+	{
+		caller.join();
+	}
+	for (int gridIdx = 0; gridIdx < 2; gridIdx++)
+	{
+		TEST_CHECK(velocity[gridIdx] == serialVelocity);
+		TEST_CHECK(density[gridIdx] == serialDensity);
+	}
+
+	TaskPoolRelease(pool);
+}
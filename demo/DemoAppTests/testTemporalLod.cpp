@@ -0,0 +1,162 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#include <vector>
+
+#include "test.h"
+#include "temporalLod.h"
+
+namespace
+{
+	//! Summary regions per layer, numQuiet of numRegions below the default speed threshold
+	struct TestLodLayers
+	{
+		std::vector<std::vector<NvFlowGridSummaryResult>> layers;
+
+		void addLayer(NvFlowUint numRegions, NvFlowUint numQuiet)
+		{
+			std::vector<NvFlowGridSummaryResult> results(numRegions);
+			for (NvFlowUint idx = 0u; idx < numRegions; idx++)
+			{
+				results[idx] = {};
+				results[idx].averageSpeed = idx < numQuiet ? 0.1f : 2.f;
+			}
+			layers.push_back(results);
+		}
+
+		NvFlowUint pick(TemporalLod& lod)
+		{
+			std::vector<const NvFlowGridSummaryResult*> layerResults;
+			std::vector<NvFlowUint> layerNumResults;
+			for (const auto& layer : layers)
+			{
+				layerResults.push_back(layer.data());
+				layerNumResults.push_back(NvFlowUint(layer.size()));
+			}
+			lod.updateActivity(layerResults.data(), layerNumResults.data(), NvFlowUint(layers.size()));
+
+			// the divisor is taken on the next step that runs
+			float stepDt = 0.f;
+			bool stepped = false;
+			for (NvFlowUint frame = 0u; frame < 4u && !stepped; frame++)
+			{
+				stepped = lod.step(1.f / 120.f, &stepDt);
+			}
+			return lod.m_divisor;
+		}
+	};
+
+	NvFlowUint TestLodPick(NvFlowUint numRegions, NvFlowUint numQuiet)
+	{
+		TemporalLod lod;
+		lod.m_enabled = true;
+		TestLodLayers layers;
+		layers.addLayer(numRegions, numQuiet);
+		return layers.pick(lod);
+	}
+}
+
+TEST_CASE(TemporalLodPicksEachDivisor)
+{
+	// default fractions, half rate at 0.5 quiescent, quarter rate at 0.85
+	TEST_CHECK(TestLodPick(20u, 0u) == 1u);
+	TEST_CHECK(TestLodPick(20u, 9u) == 1u);
+	TEST_CHECK(TestLodPick(20u, 10u) == 2u);
+	TEST_CHECK(TestLodPick(20u, 16u) == 2u);
+	TEST_CHECK(TestLodPick(20u, 17u) == 4u);
+	TEST_CHECK(TestLodPick(20u, 20u) == 4u);
+
+	// an empty grid has nothing to keep at full rate
+	TEST_CHECK(TestLodPick(0u, 0u) == 4u);
+
+	// quiescent regions are counted over all layers
+	TemporalLod lod;
+	lod.m_enabled = true;
+	TestLodLayers layers;
+	layers.addLayer(10u, 10u);
+	layers.addLayer(10u, 0u);
+	TEST_CHECK(layers.pick(lod) == 2u);
+	TEST_CHECK(lod.m_statQuiescentFraction == 0.5f);
+
+	// a layer limit caps the grid only while the layer has regions
+	lod.m_layerMaxDivisor[1u] = 1u;
+	TEST_CHECK(layers.pick(lod) == 1u);
+	layers.layers[1u].clear();
+	TEST_CHECK(layers.pick(lod) == 4u);
+	lod.m_layerMaxDivisor[0u] = 2u;
+	TEST_CHECK(layers.pick(lod) == 2u);
+}
+
+TEST_CASE(TemporalLodStepsKeepTheTime)
+{
+	TemporalLod lod;
+	lod.m_enabled = true;
+	TestLodLayers layers;
+	layers.addLayer(4u, 4u);
+
+	std::vector<const NvFlowGridSummaryResult*> layerResults = { layers.layers[0u].data() };
+	NvFlowUint numResults = 4u;
+	lod.updateActivity(layerResults.data(), &numResults, 1u);
+
+	// quarter rate, the first step still runs at the old rate
+	const float dt = 1.f / 120.f;
+	float stepDt = 0.f;
+	TEST_CHECK(lod.step(dt, &stepDt) && stepDt == dt);
+	TEST_CHECK(lod.m_divisor == 4u);
+	NvFlowUint numSteps = 0u;
+	float totalDt = 0.f;
+	for (NvFlowUint frame = 0u; frame < 16u; frame++)
+	{
+		if (lod.step(dt, &stepDt))
+		{
+			TEST_CHECK_NEAR(stepDt, 4.f * dt, 1e-6f);
+			totalDt += stepDt;
+			numSteps++;
+		}
+	}
+	TEST_CHECK(numSteps == 4u);
+	TEST_CHECK_NEAR(totalDt, 16.f * dt, 1e-6f);
+	TEST_CHECK(lod.m_statStepsSkipped == 12u);
+
+	// a skipped run never grows past m_maxStepDt
+	const float slowDt = 1.f / 40.f;
+	numSteps = 0u;
+	for (NvFlowUint frame = 0u; frame < 12u; frame++)
+	{
+		if (lod.step(slowDt, &stepDt))
+		{
+			TEST_CHECK(stepDt <= lod.m_maxStepDt);
+			numSteps++;
+		}
+	}
+	TEST_CHECK(numSteps == 6u);
+
+	// disabled steps every frame and forgets the divisor
+	lod.m_enabled = false;
+	TEST_CHECK(lod.step(dt, &stepDt) && stepDt == dt);
+	TEST_CHECK(lod.m_divisor == 1u);
+}
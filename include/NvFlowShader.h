@@ -80,14 +80,127 @@ int3 NvFlow_tableVal_to_coord(uint val)
 			float3 vBlockIdxf = params.blockDimInv.xyz * vidx; \
 			int3 vBlockIdx = int3(floor(vBlockIdxf)); \
 			int3 rBlockIdx = NvFlow_tableVal_to_coord(blockTableSRV[vBlockIdx]); \
-			float3 rBlockIdxf = float3(rBlockIdx); \
 			float3 ridx = float3(params.linearBlockDim.xyz * rBlockIdx) + float3(params.blockDim.xyz) * (vBlockIdxf - float3(vBlockIdx)) + float3(params.linearBlockOffset.xyz); \
 			return ridx; \
 		} \
 	}
 
+int3 NvFlow_tableValWide_to_coord(uint2 val)
+{
+	uint2 valInv = ~val;
+	return int3(
+		valInv.x & 0x1FFFFF,
+		((valInv.x >> 21) | (valInv.y << 11)) & 0x1FFFFF,
+		(valInv.y >> 10) & 0x1FFFFF);
+}
+
+#define NV_FLOW_DISPATCH_ID_TO_VIRTUAL_WIDE(blockListSRV, params) \
+	int3 DispatchIDToVirtual(uint3 tidx) \
+	{ \
+		uint blockID = tidx.x >> params.blockDimBits.x; \
+		int3 vBlockIdx = NvFlow_tableValWide_to_coord(blockListSRV[blockID]); \
+		int3 vidx = (vBlockIdx << params.blockDimBits.xyz) | (tidx & (params.blockDim.xyz - int3(1,1,1))); \
+		return vidx; \
+	}
+
+#define NV_FLOW_VIRTUAL_TO_REAL_WIDE(name, blockTableSRV, params) \
+	int3 name(int3 vidx) \
+	{ \
+		if(params.isVTR.x != 0) \
+		{ \
+			return vidx; \
+		} \
+		else \
+		{ \
+			int3 vBlockIdx = vidx >> params.blockDimBits.xyz; \
+			int3 rBlockIdx = NvFlow_tableValWide_to_coord(blockTableSRV[vBlockIdx]); \
+			int3 ridx = (rBlockIdx << params.blockDimBits.xyz) | (vidx & (params.blockDim.xyz - int3(1, 1, 1))); \
+			return ridx; \
+		} \
+	}
+
+#define NV_FLOW_VIRTUAL_TO_REAL_LINEAR_WIDE(name, blockTableSRV, params) \
+	float3 name(float3 vidx) \
+	{ \
+		if(params.isVTR.x != 0) \
+		{ \
+			return vidx; \
+		} \
+		else \
+		{ \
+			float3 vBlockIdxf = params.blockDimInv.xyz * vidx; \
+			int3 vBlockIdx = int3(floor(vBlockIdxf)); \
+			int3 rBlockIdx = NvFlow_tableValWide_to_coord(blockTableSRV[vBlockIdx]); \
+			float3 ridx = float3(params.linearBlockDim.xyz * rBlockIdx) + float3(params.blockDim.xyz) * (vBlockIdxf - float3(vBlockIdx)) + float3(params.linearBlockOffset.xyz); \
+			return ridx; \
+		} \
+	}
+
+//! Block level of a 32 bit table value, level l blocks store blockDim >> l cells per axis
+uint NvFlow_tableVal_to_level(uint val)
+{
+	return (~val) >> 30;
+}
+
+// Level l blocks are addressed in units of blockDim >> l cells, so a real block coordinate
+// names a sub block of a pool block. Cells of a level l block cover 2^l virtual cells per axis,
+// dispatches over full blocks resolve those virtual cells to the same real cell.
+#define NV_FLOW_VIRTUAL_TO_REAL_LOD(name, blockTableSRV, params) \
+	int3 name(int3 vidx) \
+	{ \
+		if(params.isVTR.x != 0) \
+		{ \
+			return vidx; \
+		} \
+		else \
+		{ \
+			int3 vBlockIdx = vidx >> params.blockDimBits.xyz; \
+			uint tableVal = blockTableSRV[vBlockIdx]; \
+			uint level = NvFlow_tableVal_to_level(tableVal); \
+			int3 rBlockIdx = NvFlow_tableVal_to_coord(tableVal); \
+			int3 ridx = (rBlockIdx << (params.blockDimBits.xyz - level)) | ((vidx & (params.blockDim.xyz - int3(1, 1, 1))) >> level); \
+			return ridx; \
+		} \
+	}
+
+// Level l blocks sit at a pitch of linearBlockDim >> l in the pool, behind the same linearBlockOffset,
+// so level 0 matches NV_FLOW_VIRTUAL_TO_REAL_LINEAR.
+#define NV_FLOW_VIRTUAL_TO_REAL_LINEAR_LOD(name, blockTableSRV, params) \
+	float3 name(float3 vidx) \
+	{ \
+		if(params.isVTR.x != 0) \
+		{ \
+			return vidx; \
+		} \
+		else \
+		{ \
+			float3 vBlockIdxf = params.blockDimInv.xyz * vidx; \
+			int3 vBlockIdx = int3(floor(vBlockIdxf)); \
+			uint tableVal = blockTableSRV[vBlockIdx]; \
+			uint level = NvFlow_tableVal_to_level(tableVal); \
+			int3 rBlockIdx = NvFlow_tableVal_to_coord(tableVal); \
+			float3 ridx = float3((params.linearBlockDim.xyz >> level) * rBlockIdx) + float3(params.blockDim.xyz >> level) * (vBlockIdxf - float3(vBlockIdx)) + float3(params.linearBlockOffset.xyz); \
+			return ridx; \
+		} \
+	}
+
 #endif
 
+//! Block levels, flagged by format.y of NvFlowShaderTableParams
+//! When on, the top 2 bits of a 32 bit table value hold the block level, use the _LOD macros
+//! Level 0 tables are unchanged, so the _LOD macros also read tables without levels
+//! Level 3 is reserved, it only decodes from out of bounds table loads
+#define NV_FLOW_TABLE_LEVELS_OFF 0
+#define NV_FLOW_TABLE_LEVELS_ON 1
+#define NV_FLOW_TABLE_MAX_LEVEL 2
+
+//! Block table formats, selected by format.x of NvFlowShaderTableParams
+//! 32 bit tables are Texture3D<uint> with 10 bits per axis, at most 1024 blocks per axis
+//! Wide tables are Texture3D<uint2> with 21 bits per axis, use the _WIDE macros
+//! Tables filled by the library are always 32 bit
+#define NV_FLOW_TABLE_FORMAT_32 0
+#define NV_FLOW_TABLE_FORMAT_WIDE 1
+
 //! Parameters for shaders using the point format (no linear interpolation)
 struct NvFlowShaderPointParams
 {
@@ -115,6 +228,13 @@ struct NvFlowShaderLinearParams
 	NvFlowFloat4 vdimInv;
 };
 
+//! Parameters of an application built block table, bound next to the point or linear params
+//! The library neither fills nor reads these, a zeroed struct describes a library table
+struct NvFlowShaderTableParams
+{
+	NvFlowUint4 format;		//!< x: NV_FLOW_TABLE_FORMAT_32 or NV_FLOW_TABLE_FORMAT_WIDE, y: NV_FLOW_TABLE_LEVELS_OFF or NV_FLOW_TABLE_LEVELS_ON
+};
+
 ///@}
 
 #endif
\ No newline at end of file
@@ -0,0 +1,593 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2014-2021 NVIDIA Corporation. All rights reserved.
+
+#ifndef NV_FLOW_SHADER_CPU_H
+#define NV_FLOW_SHADER_CPU_H
+
+#include "NvFlowTypes.h"
+#include "NvFlowShader.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define NV_FLOW_SHADER_CPU_SSE2 1
+#include <emmintrin.h>
+#else
+#define NV_FLOW_SHADER_CPU_SSE2 0
+#endif
+
+#if defined(__AVX2__)
+#define NV_FLOW_SHADER_CPU_AVX2 1
+#include <immintrin.h>
+#else
+#define NV_FLOW_SHADER_CPU_AVX2 0
+#endif
+
+// --------------------------- NvFlow Shader CPU Utils -------------------------------
+///@defgroup NvFlowShaderCPU
+///@{
+
+// CPU equivalents of the NV_FLOW_SHADER_UTILS macros, for tools that read exported
+// or build imported grid data on the CPU.
+//
+// Integer paths match the HLSL bit for bit, including D3D out of bounds semantics:
+// block table and block list loads outside the resource return 0.
+// The linear path performs the same IEEE single precision operations in the same order
+// as NV_FLOW_VIRTUAL_TO_REAL_LINEAR, shader compilers may still contract mul/add to mad.
+//
+// Block tables are dense, x fastest, params.gridDim blocks per axis.
+// Batch variants take and return structure of arrays coordinates.
+// Wide tables (NV_FLOW_TABLE_FORMAT_WIDE) have scalar entry points only,
+// the batch and SIMD paths are for the 32 bit format without levels.
+// Levelled tables (NV_FLOW_TABLE_LEVELS_ON) have scalar _Lod entry points only.
+
+//! Decode block table value, matches NvFlow_tableVal_to_coord()
+inline NvFlowInt3 NvFlowCPU_tableVal_to_coord(NvFlowUint val)
+{
+	NvFlowUint valInv = ~val;
+	return NvFlowInt3{
+		int((valInv >> 0) & 0x3FF),
+		int((valInv >> 10) & 0x3FF),
+		int((valInv >> 20) & 0x3FF)
+	};
+}
+
+//! Encode block table value, inverse of NvFlowCPU_tableVal_to_coord()
+inline NvFlowUint NvFlowCPU_coord_to_tableVal(NvFlowUint x, NvFlowUint y, NvFlowUint z)
+{
+	return ~(x | (y << 10) | (z << 20));
+}
+
+//! Texture3D<uint> load with D3D out of bounds behavior
+template <typename Params>
+inline NvFlowUint NvFlowCPU_blockTableLoad(const NvFlowUint* blockTable, const Params& params, int x, int y, int z)
+{
+	if (NvFlowUint(x) >= params.gridDim.x || NvFlowUint(y) >= params.gridDim.y || NvFlowUint(z) >= params.gridDim.z)
+	{
+		return 0u;
+	}
+	return blockTable[(NvFlowUint(z) * params.gridDim.y + NvFlowUint(y)) * params.gridDim.x + NvFlowUint(x)];
+}
+
+//! Matches NV_FLOW_DISPATCH_ID_TO_VIRTUAL
+template <typename Params>
+inline NvFlowInt3 NvFlowCPU_dispatchIDToVirtual(const NvFlowUint* blockList, NvFlowUint blockListDim, const Params& params, NvFlowUint3 tidx)
+{
+	NvFlowUint blockID = tidx.x >> params.blockDimBits.x;
+	NvFlowInt3 vBlockIdx = NvFlowCPU_tableVal_to_coord(blockID < blockListDim ? blockList[blockID] : 0u);
+	return NvFlowInt3{
+		int((NvFlowUint(vBlockIdx.x) << params.blockDimBits.x) | (tidx.x & (params.blockDim.x - 1u))),
+		int((NvFlowUint(vBlockIdx.y) << params.blockDimBits.y) | (tidx.y & (params.blockDim.y - 1u))),
+		int((NvFlowUint(vBlockIdx.z) << params.blockDimBits.z) | (tidx.z & (params.blockDim.z - 1u)))
+	};
+}
+
+//! Matches NV_FLOW_VIRTUAL_TO_REAL
+template <typename Params>
+inline NvFlowInt3 NvFlowCPU_virtualToReal(const NvFlowUint* blockTable, const Params& params, NvFlowInt3 vidx)
+{
+	if (params.isVTR.x != 0)
+	{
+		return vidx;
+	}
+	NvFlowInt3 vBlockIdx = {
+		vidx.x >> int(params.blockDimBits.x),
+		vidx.y >> int(params.blockDimBits.y),
+		vidx.z >> int(params.blockDimBits.z)
+	};
+	NvFlowInt3 rBlockIdx = NvFlowCPU_tableVal_to_coord(NvFlowCPU_blockTableLoad(blockTable, params, vBlockIdx.x, vBlockIdx.y, vBlockIdx.z));
+	return NvFlowInt3{
+		int((NvFlowUint(rBlockIdx.x) << params.blockDimBits.x) | (NvFlowUint(vidx.x) & (params.blockDim.x - 1u))),
+		int((NvFlowUint(rBlockIdx.y) << params.blockDimBits.y) | (NvFlowUint(vidx.y) & (params.blockDim.y - 1u))),
+		int((NvFlowUint(rBlockIdx.z) << params.blockDimBits.z) | (NvFlowUint(vidx.z) & (params.blockDim.z - 1u)))
+	};
+}
+
+namespace NvFlowShaderCPUDetail
+{
+	inline float virtualToRealLinearAxis(float vidx, float blockDimInv, NvFlowUint blockDim, NvFlowUint linearBlockDim, NvFlowUint linearBlockOffset, int vBlockIdx, int rBlockIdx)
+	{
+		float vBlockIdxf = blockDimInv * vidx;
+		float a = float(linearBlockDim * NvFlowUint(rBlockIdx));
+		float b = float(blockDim) * (vBlockIdxf - float(vBlockIdx));
+		float c = float(linearBlockOffset);
+		return a + b + c;
+	}
+
+	inline int floorToInt(float v)
+	{
+		int i = int(v);
+		return (float(i) > v) ? i - 1 : i;
+	}
+}
+
+//! Matches NV_FLOW_VIRTUAL_TO_REAL_LINEAR
+inline NvFlowFloat3 NvFlowCPU_virtualToRealLinear(const NvFlowUint* blockTable, const NvFlowShaderLinearParams& params, NvFlowFloat3 vidx)
+{
+	using namespace NvFlowShaderCPUDetail;
+	if (params.isVTR.x != 0)
+	{
+		return vidx;
+	}
+	NvFlowInt3 vBlockIdx = {
+		floorToInt(params.blockDimInv.x * vidx.x),
+		floorToInt(params.blockDimInv.y * vidx.y),
+		floorToInt(params.blockDimInv.z * vidx.z)
+	};
+	NvFlowInt3 rBlockIdx = NvFlowCPU_tableVal_to_coord(NvFlowCPU_blockTableLoad(blockTable, params, vBlockIdx.x, vBlockIdx.y, vBlockIdx.z));
+	return NvFlowFloat3{
+		virtualToRealLinearAxis(vidx.x, params.blockDimInv.x, params.blockDim.x, params.linearBlockDim.x, params.linearBlockOffset.x, vBlockIdx.x, rBlockIdx.x),
+		virtualToRealLinearAxis(vidx.y, params.blockDimInv.y, params.blockDim.y, params.linearBlockDim.y, params.linearBlockOffset.y, vBlockIdx.y, rBlockIdx.y),
+		virtualToRealLinearAxis(vidx.z, params.blockDimInv.z, params.blockDim.z, params.linearBlockDim.z, params.linearBlockOffset.z, vBlockIdx.z, rBlockIdx.z)
+	};
+}
+
+//! Decode wide block table value, matches NvFlow_tableValWide_to_coord(), (x, y) of the uint2 are (lo, hi)
+inline NvFlowInt3 NvFlowCPU_tableValWide_to_coord(NvFlowUint64 val)
+{
+	NvFlowUint64 valInv = ~val;
+	return NvFlowInt3{
+		int((valInv >> 0) & 0x1FFFFF),
+		int((valInv >> 21) & 0x1FFFFF),
+		int((valInv >> 42) & 0x1FFFFF)
+	};
+}
+
+//! Encode wide block table value, inverse of NvFlowCPU_tableValWide_to_coord()
+inline NvFlowUint64 NvFlowCPU_coord_to_tableValWide(NvFlowUint x, NvFlowUint y, NvFlowUint z)
+{
+	return ~(NvFlowUint64(x) | (NvFlowUint64(y) << 21) | (NvFlowUint64(z) << 42));
+}
+
+inline bool NvFlowCPU_isTableWide(const NvFlowShaderTableParams& tableParams)
+{
+	return tableParams.format.x == NV_FLOW_TABLE_FORMAT_WIDE;
+}
+
+//! Narrowest table format that can address the given virtual and pool block grids
+inline NvFlowUint NvFlowCPU_tableFormatForGrid(NvFlowUint4 gridDim, NvFlowUint4 poolGridDim)
+{
+	const NvFlowUint maxDim = 1024u;
+	bool fits = gridDim.x <= maxDim && gridDim.y <= maxDim && gridDim.z <= maxDim &&
+		poolGridDim.x <= maxDim && poolGridDim.y <= maxDim && poolGridDim.z <= maxDim;
+	return fits ? NV_FLOW_TABLE_FORMAT_32 : NV_FLOW_TABLE_FORMAT_WIDE;
+}
+
+//! Texture3D<uint2> load with D3D out of bounds behavior
+template <typename Params>
+inline NvFlowUint64 NvFlowCPU_blockTableLoadWide(const NvFlowUint64* blockTable, const Params& params, int x, int y, int z)
+{
+	if (NvFlowUint(x) >= params.gridDim.x || NvFlowUint(y) >= params.gridDim.y || NvFlowUint(z) >= params.gridDim.z)
+	{
+		return 0u;
+	}
+	return blockTable[(NvFlowUint64(z) * params.gridDim.y + NvFlowUint(y)) * params.gridDim.x + NvFlowUint(x)];
+}
+
+//! Matches NV_FLOW_DISPATCH_ID_TO_VIRTUAL_WIDE
+template <typename Params>
+inline NvFlowInt3 NvFlowCPU_dispatchIDToVirtualWide(const NvFlowUint64* blockList, NvFlowUint blockListDim, const Params& params, NvFlowUint3 tidx)
+{
+	NvFlowUint blockID = tidx.x >> params.blockDimBits.x;
+	NvFlowInt3 vBlockIdx = NvFlowCPU_tableValWide_to_coord(blockID < blockListDim ? blockList[blockID] : 0u);
+	return NvFlowInt3{
+		int((NvFlowUint(vBlockIdx.x) << params.blockDimBits.x) | (tidx.x & (params.blockDim.x - 1u))),
+		int((NvFlowUint(vBlockIdx.y) << params.blockDimBits.y) | (tidx.y & (params.blockDim.y - 1u))),
+		int((NvFlowUint(vBlockIdx.z) << params.blockDimBits.z) | (tidx.z & (params.blockDim.z - 1u)))
+	};
+}
+
+//! Matches NV_FLOW_VIRTUAL_TO_REAL_WIDE
+template <typename Params>
+inline NvFlowInt3 NvFlowCPU_virtualToRealWide(const NvFlowUint64* blockTable, const Params& params, NvFlowInt3 vidx)
+{
+	if (params.isVTR.x != 0)
+	{
+		return vidx;
+	}
+	NvFlowInt3 vBlockIdx = {
+		vidx.x >> int(params.blockDimBits.x),
+		vidx.y >> int(params.blockDimBits.y),
+		vidx.z >> int(params.blockDimBits.z)
+	};
+	NvFlowInt3 rBlockIdx = NvFlowCPU_tableValWide_to_coord(NvFlowCPU_blockTableLoadWide(blockTable, params, vBlockIdx.x, vBlockIdx.y, vBlockIdx.z));
+	return NvFlowInt3{
+		int((NvFlowUint(rBlockIdx.x) << params.blockDimBits.x) | (NvFlowUint(vidx.x) & (params.blockDim.x - 1u))),
+		int((NvFlowUint(rBlockIdx.y) << params.blockDimBits.y) | (NvFlowUint(vidx.y) & (params.blockDim.y - 1u))),
+		int((NvFlowUint(rBlockIdx.z) << params.blockDimBits.z) | (NvFlowUint(vidx.z) & (params.blockDim.z - 1u)))
+	};
+}
+
+//! Matches NV_FLOW_VIRTUAL_TO_REAL_LINEAR_WIDE
+inline NvFlowFloat3 NvFlowCPU_virtualToRealLinearWide(const NvFlowUint64* blockTable, const NvFlowShaderLinearParams& params, NvFlowFloat3 vidx)
+{
+	using namespace NvFlowShaderCPUDetail;
+	if (params.isVTR.x != 0)
+	{
+		return vidx;
+	}
+	NvFlowInt3 vBlockIdx = {
+		floorToInt(params.blockDimInv.x * vidx.x),
+		floorToInt(params.blockDimInv.y * vidx.y),
+		floorToInt(params.blockDimInv.z * vidx.z)
+	};
+	NvFlowInt3 rBlockIdx = NvFlowCPU_tableValWide_to_coord(NvFlowCPU_blockTableLoadWide(blockTable, params, vBlockIdx.x, vBlockIdx.y, vBlockIdx.z));
+	return NvFlowFloat3{
+		virtualToRealLinearAxis(vidx.x, params.blockDimInv.x, params.blockDim.x, params.linearBlockDim.x, params.linearBlockOffset.x, vBlockIdx.x, rBlockIdx.x),
+		virtualToRealLinearAxis(vidx.y, params.blockDimInv.y, params.blockDim.y, params.linearBlockDim.y, params.linearBlockOffset.y, vBlockIdx.y, rBlockIdx.y),
+		virtualToRealLinearAxis(vidx.z, params.blockDimInv.z, params.blockDim.z, params.linearBlockDim.z, params.linearBlockOffset.z, vBlockIdx.z, rBlockIdx.z)
+	};
+}
+
+//! Block level of a table value, matches NvFlow_tableVal_to_level()
+inline NvFlowUint NvFlowCPU_tableVal_to_level(NvFlowUint val)
+{
+	return (~val) >> 30;
+}
+
+//! Encode levelled block table value, coordinates in units of blockDim >> level cells
+inline NvFlowUint NvFlowCPU_coord_to_tableValLevel(NvFlowUint x, NvFlowUint y, NvFlowUint z, NvFlowUint level)
+{
+	return ~(x | (y << 10) | (z << 20) | (level << 30));
+}
+
+inline bool NvFlowCPU_hasTableLevels(const NvFlowShaderTableParams& tableParams)
+{
+	return tableParams.format.y == NV_FLOW_TABLE_LEVELS_ON;
+}
+
+//! Matches NV_FLOW_VIRTUAL_TO_REAL_LOD
+template <typename Params>
+inline NvFlowInt3 NvFlowCPU_virtualToRealLod(const NvFlowUint* blockTable, const Params& params, NvFlowInt3 vidx)
+{
+	if (params.isVTR.x != 0)
+	{
+		return vidx;
+	}
+	NvFlowInt3 vBlockIdx = {
+		vidx.x >> int(params.blockDimBits.x),
+		vidx.y >> int(params.blockDimBits.y),
+		vidx.z >> int(params.blockDimBits.z)
+	};
+	NvFlowUint tableVal = NvFlowCPU_blockTableLoad(blockTable, params, vBlockIdx.x, vBlockIdx.y, vBlockIdx.z);
+	NvFlowUint level = NvFlowCPU_tableVal_to_level(tableVal);
+	NvFlowInt3 rBlockIdx = NvFlowCPU_tableVal_to_coord(tableVal);
+	return NvFlowInt3{
+		int((NvFlowUint(rBlockIdx.x) << (params.blockDimBits.x - level)) | ((NvFlowUint(vidx.x) & (params.blockDim.x - 1u)) >> level)),
+		int((NvFlowUint(rBlockIdx.y) << (params.blockDimBits.y - level)) | ((NvFlowUint(vidx.y) & (params.blockDim.y - 1u)) >> level)),
+		int((NvFlowUint(rBlockIdx.z) << (params.blockDimBits.z - level)) | ((NvFlowUint(vidx.z) & (params.blockDim.z - 1u)) >> level))
+	};
+}
+
+//! Matches NV_FLOW_VIRTUAL_TO_REAL_LINEAR_LOD
+inline NvFlowFloat3 NvFlowCPU_virtualToRealLinearLod(const NvFlowUint* blockTable, const NvFlowShaderLinearParams& params, NvFlowFloat3 vidx)
+{
+	using namespace NvFlowShaderCPUDetail;
+	if (params.isVTR.x != 0)
+	{
+		return vidx;
+	}
+	NvFlowFloat3 vBlockIdxf = {
+		params.blockDimInv.x * vidx.x,
+		params.blockDimInv.y * vidx.y,
+		params.blockDimInv.z * vidx.z
+	};
+	NvFlowInt3 vBlockIdx = { floorToInt(vBlockIdxf.x), floorToInt(vBlockIdxf.y), floorToInt(vBlockIdxf.z) };
+	NvFlowUint tableVal = NvFlowCPU_blockTableLoad(blockTable, params, vBlockIdx.x, vBlockIdx.y, vBlockIdx.z);
+	NvFlowUint level = NvFlowCPU_tableVal_to_level(tableVal);
+	NvFlowInt3 rBlockIdx = NvFlowCPU_tableVal_to_coord(tableVal);
+	return NvFlowFloat3{
+		virtualToRealLinearAxis(vidx.x, params.blockDimInv.x, params.blockDim.x >> level, params.linearBlockDim.x >> level, params.linearBlockOffset.x, vBlockIdx.x, rBlockIdx.x),
+		virtualToRealLinearAxis(vidx.y, params.blockDimInv.y, params.blockDim.y >> level, params.linearBlockDim.y >> level, params.linearBlockOffset.y, vBlockIdx.y, rBlockIdx.y),
+		virtualToRealLinearAxis(vidx.z, params.blockDimInv.z, params.blockDim.z >> level, params.linearBlockDim.z >> level, params.linearBlockOffset.z, vBlockIdx.z, rBlockIdx.z)
+	};
+}
+
+namespace NvFlowShaderCPUDetail
+{
+	template <typename Params>
+	inline void virtualToRealScalar(const NvFlowUint* blockTable, const Params& params,
+		const NvFlowInt* vx, const NvFlowInt* vy, const NvFlowInt* vz, NvFlowInt* rx, NvFlowInt* ry, NvFlowInt* rz, NvFlowUint count)
+	{
+		for (NvFlowUint idx = 0u; idx < count; idx++)
+		{
+			NvFlowInt3 ridx = NvFlowCPU_virtualToReal(blockTable, params, NvFlowInt3{ vx[idx], vy[idx], vz[idx] });
+			rx[idx] = ridx.x;
+			ry[idx] = ridx.y;
+			rz[idx] = ridx.z;
+		}
+	}
+
+	inline void virtualToRealLinearScalar(const NvFlowUint* blockTable, const NvFlowShaderLinearParams& params,
+		const float* vx, const float* vy, const float* vz, float* rx, float* ry, float* rz, NvFlowUint count)
+	{
+		for (NvFlowUint idx = 0u; idx < count; idx++)
+		{
+			NvFlowFloat3 ridx = NvFlowCPU_virtualToRealLinear(blockTable, params, NvFlowFloat3{ vx[idx], vy[idx], vz[idx] });
+			rx[idx] = ridx.x;
+			ry[idx] = ridx.y;
+			rz[idx] = ridx.z;
+		}
+	}
+
+#if NV_FLOW_SHADER_CPU_AVX2
+	template <typename Params>
+	inline __m256i tableGather8(const NvFlowUint* blockTable, const Params& params, __m256i bx, __m256i by, __m256i bz)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i gx = _mm256_set1_epi32(int(params.gridDim.x));
+		const __m256i gy = _mm256_set1_epi32(int(params.gridDim.y));
+		const __m256i gz = _mm256_set1_epi32(int(params.gridDim.z));
+		__m256i outside = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpgt_epi32(zero, bx), _mm256_cmpgt_epi32(zero, by)),
+			_mm256_cmpgt_epi32(zero, bz));
+		outside = _mm256_or_si256(outside, _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpgt_epi32(bx, _mm256_sub_epi32(gx, _mm256_set1_epi32(1))), _mm256_cmpgt_epi32(by, _mm256_sub_epi32(gy, _mm256_set1_epi32(1)))),
+			_mm256_cmpgt_epi32(bz, _mm256_sub_epi32(gz, _mm256_set1_epi32(1)))));
+		__m256i index = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_add_epi32(_mm256_mullo_epi32(bz, gy), by), gx), bx);
+		__m256i inside = _mm256_xor_si256(outside, _mm256_set1_epi32(-1));
+		return _mm256_mask_i32gather_epi32(zero, (const int*)blockTable, _mm256_and_si256(index, inside), inside, 4);
+	}
+
+	inline __m256i tableValToCoordAxis8(__m256i val, int shift)
+	{
+		__m256i valInv = _mm256_xor_si256(val, _mm256_set1_epi32(-1));
+		return _mm256_and_si256(_mm256_srli_epi32(valInv, shift), _mm256_set1_epi32(0x3FF));
+	}
+
+	template <typename Params>
+	inline void virtualToReal8(const NvFlowUint* blockTable, const Params& params,
+		const NvFlowInt* vx, const NvFlowInt* vy, const NvFlowInt* vz, NvFlowInt* rx, NvFlowInt* ry, NvFlowInt* rz)
+	{
+		__m256i x = _mm256_loadu_si256((const __m256i*)vx);
+		__m256i y = _mm256_loadu_si256((const __m256i*)vy);
+		__m256i z = _mm256_loadu_si256((const __m256i*)vz);
+		__m128i bitsX = _mm_cvtsi32_si128(int(params.blockDimBits.x));
+		__m128i bitsY = _mm_cvtsi32_si128(int(params.blockDimBits.y));
+		__m128i bitsZ = _mm_cvtsi32_si128(int(params.blockDimBits.z));
+		__m256i val = tableGather8(blockTable, params, _mm256_sra_epi32(x, bitsX), _mm256_sra_epi32(y, bitsY), _mm256_sra_epi32(z, bitsZ));
+		x = _mm256_or_si256(_mm256_sll_epi32(tableValToCoordAxis8(val, 0), bitsX), _mm256_and_si256(x, _mm256_set1_epi32(int(params.blockDim.x - 1u))));
+		y = _mm256_or_si256(_mm256_sll_epi32(tableValToCoordAxis8(val, 10), bitsY), _mm256_and_si256(y, _mm256_set1_epi32(int(params.blockDim.y - 1u))));
+		z = _mm256_or_si256(_mm256_sll_epi32(tableValToCoordAxis8(val, 20), bitsZ), _mm256_and_si256(z, _mm256_set1_epi32(int(params.blockDim.z - 1u))));
+		_mm256_storeu_si256((__m256i*)rx, x);
+		_mm256_storeu_si256((__m256i*)ry, y);
+		_mm256_storeu_si256((__m256i*)rz, z);
+	}
+
+	inline __m256 virtualToRealLinearAxis8(__m256 vidx, __m256i vBlockIdx, __m256i rBlockIdx, float blockDimInv, NvFlowUint blockDim, NvFlowUint linearBlockDim, NvFlowUint linearBlockOffset)
+	{
+		__m256 vBlockIdxf = _mm256_mul_ps(_mm256_set1_ps(blockDimInv), vidx);
+		__m256 a = _mm256_cvtepi32_ps(_mm256_mullo_epi32(_mm256_set1_epi32(int(linearBlockDim)), rBlockIdx));
+		__m256 b = _mm256_mul_ps(_mm256_set1_ps(float(blockDim)), _mm256_sub_ps(vBlockIdxf, _mm256_cvtepi32_ps(vBlockIdx)));
+		return _mm256_add_ps(_mm256_add_ps(a, b), _mm256_set1_ps(float(linearBlockOffset)));
+	}
+
+	inline void virtualToRealLinear8(const NvFlowUint* blockTable, const NvFlowShaderLinearParams& params,
+		const float* vx, const float* vy, const float* vz, float* rx, float* ry, float* rz)
+	{
+		__m256 x = _mm256_loadu_ps(vx);
+		__m256 y = _mm256_loadu_ps(vy);
+		__m256 z = _mm256_loadu_ps(vz);
+		__m256i bx = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(_mm256_set1_ps(params.blockDimInv.x), x)));
+		__m256i by = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(_mm256_set1_ps(params.blockDimInv.y), y)));
+		__m256i bz = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(_mm256_set1_ps(params.blockDimInv.z), z)));
+		__m256i val = tableGather8(blockTable, params, bx, by, bz);
+		_mm256_storeu_ps(rx, virtualToRealLinearAxis8(x, bx, tableValToCoordAxis8(val, 0), params.blockDimInv.x, params.blockDim.x, params.linearBlockDim.x, params.linearBlockOffset.x));
+		_mm256_storeu_ps(ry, virtualToRealLinearAxis8(y, by, tableValToCoordAxis8(val, 10), params.blockDimInv.y, params.blockDim.y, params.linearBlockDim.y, params.linearBlockOffset.y));
+		_mm256_storeu_ps(rz, virtualToRealLinearAxis8(z, bz, tableValToCoordAxis8(val, 20), params.blockDimInv.z, params.blockDim.z, params.linearBlockDim.z, params.linearBlockOffset.z));
+	}
+#endif
+
+#if NV_FLOW_SHADER_CPU_SSE2
+	// SSE2 has no gather, table loads stay scalar, the rest is 4 wide
+	template <typename Params>
+	inline __m128i tableGather4(const NvFlowUint* blockTable, const Params& params, __m128i bx, __m128i by, __m128i bz)
+	{
+		NvFlowInt x[4], y[4], z[4];
+		_mm_storeu_si128((__m128i*)x, bx);
+		_mm_storeu_si128((__m128i*)y, by);
+		_mm_storeu_si128((__m128i*)z, bz);
+		return _mm_setr_epi32(
+			int(NvFlowCPU_blockTableLoad(blockTable, params, x[0], y[0], z[0])),
+			int(NvFlowCPU_blockTableLoad(blockTable, params, x[1], y[1], z[1])),
+			int(NvFlowCPU_blockTableLoad(blockTable, params, x[2], y[2], z[2])),
+			int(NvFlowCPU_blockTableLoad(blockTable, params, x[3], y[3], z[3])));
+	}
+
+	inline __m128i tableValToCoordAxis4(__m128i val, int shift)
+	{
+		__m128i valInv = _mm_xor_si128(val, _mm_set1_epi32(-1));
+		return _mm_and_si128(_mm_srl_epi32(valInv, _mm_cvtsi32_si128(shift)), _mm_set1_epi32(0x3FF));
+	}
+
+	template <typename Params>
+	inline void virtualToReal4(const NvFlowUint* blockTable, const Params& params,
+		const NvFlowInt* vx, const NvFlowInt* vy, const NvFlowInt* vz, NvFlowInt* rx, NvFlowInt* ry, NvFlowInt* rz)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)vx);
+		__m128i y = _mm_loadu_si128((const __m128i*)vy);
+		__m128i z = _mm_loadu_si128((const __m128i*)vz);
+		__m128i bitsX = _mm_cvtsi32_si128(int(params.blockDimBits.x));
+		__m128i bitsY = _mm_cvtsi32_si128(int(params.blockDimBits.y));
+		__m128i bitsZ = _mm_cvtsi32_si128(int(params.blockDimBits.z));
+		__m128i val = tableGather4(blockTable, params, _mm_sra_epi32(x, bitsX), _mm_sra_epi32(y, bitsY), _mm_sra_epi32(z, bitsZ));
+		x = _mm_or_si128(_mm_sll_epi32(tableValToCoordAxis4(val, 0), bitsX), _mm_and_si128(x, _mm_set1_epi32(int(params.blockDim.x - 1u))));
+		y = _mm_or_si128(_mm_sll_epi32(tableValToCoordAxis4(val, 10), bitsY), _mm_and_si128(y, _mm_set1_epi32(int(params.blockDim.y - 1u))));
+		z = _mm_or_si128(_mm_sll_epi32(tableValToCoordAxis4(val, 20), bitsZ), _mm_and_si128(z, _mm_set1_epi32(int(params.blockDim.z - 1u))));
+		_mm_storeu_si128((__m128i*)rx, x);
+		_mm_storeu_si128((__m128i*)ry, y);
+		_mm_storeu_si128((__m128i*)rz, z);
+	}
+
+	inline __m128i floorToInt4(__m128 v)
+	{
+		__m128i i = _mm_cvttps_epi32(v);
+		__m128 adjust = _mm_cmpgt_ps(_mm_cvtepi32_ps(i), v);
+		return _mm_add_epi32(i, _mm_castps_si128(adjust));
+	}
+
+	inline __m128i mullo4(__m128i a, __m128i b)
+	{
+		__m128i even = _mm_mul_epu32(a, b);
+		__m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+		return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+	}
+
+	inline __m128 virtualToRealLinearAxis4(__m128 vidx, __m128i vBlockIdx, __m128i rBlockIdx, float blockDimInv, NvFlowUint blockDim, NvFlowUint linearBlockDim, NvFlowUint linearBlockOffset)
+	{
+		__m128 vBlockIdxf = _mm_mul_ps(_mm_set1_ps(blockDimInv), vidx);
+		__m128 a = _mm_cvtepi32_ps(mullo4(_mm_set1_epi32(int(linearBlockDim)), rBlockIdx));
+		__m128 b = _mm_mul_ps(_mm_set1_ps(float(blockDim)), _mm_sub_ps(vBlockIdxf, _mm_cvtepi32_ps(vBlockIdx)));
+		return _mm_add_ps(_mm_add_ps(a, b), _mm_set1_ps(float(linearBlockOffset)));
+	}
+
+	inline void virtualToRealLinear4(const NvFlowUint* blockTable, const NvFlowShaderLinearParams& params,
+		const float* vx, const float* vy, const float* vz, float* rx, float* ry, float* rz)
+	{
+		__m128 x = _mm_loadu_ps(vx);
+		__m128 y = _mm_loadu_ps(vy);
+		__m128 z = _mm_loadu_ps(vz);
+		__m128i bx = floorToInt4(_mm_mul_ps(_mm_set1_ps(params.blockDimInv.x), x));
+		__m128i by = floorToInt4(_mm_mul_ps(_mm_set1_ps(params.blockDimInv.y), y));
+		__m128i bz = floorToInt4(_mm_mul_ps(_mm_set1_ps(params.blockDimInv.z), z));
+		__m128i val = tableGather4(blockTable, params, bx, by, bz);
+		_mm_storeu_ps(rx, virtualToRealLinearAxis4(x, bx, tableValToCoordAxis4(val, 0), params.blockDimInv.x, params.blockDim.x, params.linearBlockDim.x, params.linearBlockOffset.x));
+		_mm_storeu_ps(ry, virtualToRealLinearAxis4(y, by, tableValToCoordAxis4(val, 10), params.blockDimInv.y, params.blockDim.y, params.linearBlockDim.y, params.linearBlockOffset.y));
+		_mm_storeu_ps(rz, virtualToRealLinearAxis4(z, bz, tableValToCoordAxis4(val, 20), params.blockDimInv.z, params.blockDim.z, params.linearBlockDim.z, params.linearBlockOffset.z));
+	}
+#endif
+
+	template <typename Params>
+	inline void virtualToRealN(const NvFlowUint* blockTable, const Params& params,
+		const NvFlowInt* vx, const NvFlowInt* vy, const NvFlowInt* vz, NvFlowInt* rx, NvFlowInt* ry, NvFlowInt* rz, NvFlowUint count)
+	{
+		NvFlowUint idx = 0u;
+		if (params.isVTR.x == 0)
+		{
+#if NV_FLOW_SHADER_CPU_AVX2
+			for (; idx + 8u <= count; idx += 8u)
+			{
+				virtualToReal8(blockTable, params, vx + idx, vy + idx, vz + idx, rx + idx, ry + idx, rz + idx);
+			}
+#elif NV_FLOW_SHADER_CPU_SSE2
+			for (; idx + 4u <= count; idx += 4u)
+			{
+				virtualToReal4(blockTable, params, vx + idx, vy + idx, vz + idx, rx + idx, ry + idx, rz + idx);
+			}
+#endif
+		}
+		virtualToRealScalar(blockTable, params, vx + idx, vy + idx, vz + idx, rx + idx, ry + idx, rz + idx, count - idx);
+	}
+
+	inline void virtualToRealLinearN(const NvFlowUint* blockTable, const NvFlowShaderLinearParams& params,
+		const float* vx, const float* vy, const float* vz, float* rx, float* ry, float* rz, NvFlowUint count)
+	{
+		NvFlowUint idx = 0u;
+		if (params.isVTR.x == 0)
+		{
+#if NV_FLOW_SHADER_CPU_AVX2
+			for (; idx + 8u <= count; idx += 8u)
+			{
+				virtualToRealLinear8(blockTable, params, vx + idx, vy + idx, vz + idx, rx + idx, ry + idx, rz + idx);
+			}
+#elif NV_FLOW_SHADER_CPU_SSE2
+			for (; idx + 4u <= count; idx += 4u)
+			{
+				virtualToRealLinear4(blockTable, params, vx + idx, vy + idx, vz + idx, rx + idx, ry + idx, rz + idx);
+			}
+#endif
+		}
+		virtualToRealLinearScalar(blockTable, params, vx + idx, vy + idx, vz + idx, rx + idx, ry + idx, rz + idx, count - idx);
+	}
+}
+
+//! NvFlowCPU_virtualToReal() for 8 coordinates
+template <typename Params>
+inline void NvFlowCPU_virtualToReal8(const NvFlowUint* blockTable, const Params& params,
+	const NvFlowInt vx[8], const NvFlowInt vy[8], const NvFlowInt vz[8], NvFlowInt rx[8], NvFlowInt ry[8], NvFlowInt rz[8])
+{
+	NvFlowShaderCPUDetail::virtualToRealN(blockTable, params, vx, vy, vz, rx, ry, rz, 8u);
+}
+
+//! NvFlowCPU_virtualToReal() for 16 coordinates
+template <typename Params>
+inline void NvFlowCPU_virtualToReal16(const NvFlowUint* blockTable, const Params& params,
+	const NvFlowInt vx[16], const NvFlowInt vy[16], const NvFlowInt vz[16], NvFlowInt rx[16], NvFlowInt ry[16], NvFlowInt rz[16])
+{
+	NvFlowShaderCPUDetail::virtualToRealN(blockTable, params, vx, vy, vz, rx, ry, rz, 16u);
+}
+
+//! NvFlowCPU_virtualToReal() for any number of coordinates
+template <typename Params>
+inline void NvFlowCPU_virtualToRealBatch(const NvFlowUint* blockTable, const Params& params,
+	const NvFlowInt* vx, const NvFlowInt* vy, const NvFlowInt* vz, NvFlowInt* rx, NvFlowInt* ry, NvFlowInt* rz, NvFlowUint count)
+{
+	NvFlowShaderCPUDetail::virtualToRealN(blockTable, params, vx, vy, vz, rx, ry, rz, count);
+}
+
+//! NvFlowCPU_virtualToRealLinear() for 8 coordinates
+inline void NvFlowCPU_virtualToRealLinear8(const NvFlowUint* blockTable, const NvFlowShaderLinearParams& params,
+	const float vx[8], const float vy[8], const float vz[8], float rx[8], float ry[8], float rz[8])
+{
+	NvFlowShaderCPUDetail::virtualToRealLinearN(blockTable, params, vx, vy, vz, rx, ry, rz, 8u);
+}
+
+//! NvFlowCPU_virtualToRealLinear() for 16 coordinates
+inline void NvFlowCPU_virtualToRealLinear16(const NvFlowUint* blockTable, const NvFlowShaderLinearParams& params,
+	const float vx[16], const float vy[16], const float vz[16], float rx[16], float ry[16], float rz[16])
+{
+	NvFlowShaderCPUDetail::virtualToRealLinearN(blockTable, params, vx, vy, vz, rx, ry, rz, 16u);
+}
+
+//! NvFlowCPU_virtualToRealLinear() for any number of coordinates
+inline void NvFlowCPU_virtualToRealLinearBatch(const NvFlowUint* blockTable, const NvFlowShaderLinearParams& params,
+	const float* vx, const float* vy, const float* vz, float* rx, float* ry, float* rz, NvFlowUint count)
+{
+	NvFlowShaderCPUDetail::virtualToRealLinearN(blockTable, params, vx, vy, vz, rx, ry, rz, count);
+}
+
+///@}
+
+#endif